@@ -0,0 +1,246 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#include "CaveCullingMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/BlockRegistry.h"
+#include "../Source/Core/ChunkConnectivity.h"
+#include "../Source/Core/ChunkCuller.h"
+
+constexpr int32_t DEFAULT_RADIUS = 8;
+constexpr uint32_t DEFAULT_NUM_VIEWS = 64;
+
+// Vertical range of the generated box, around the surface at the origin
+constexpr int32_t CHUNKS_BELOW_SURFACE = 8;
+constexpr int32_t CHUNKS_ABOVE_SURFACE = 3;
+
+// How far the cameras are from the surface at the origin, in blocks
+constexpr int32_t SURFACE_CAMERA_HEIGHT = 2;
+constexpr int32_t UNDERGROUND_CAMERA_DEPTH = 48;
+
+using Snapshot = BasicChunkSnapshot<CHUNK_SIZE>;
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static ChunkFaceMask GetPair(const ChunkNeighbor a, const ChunkNeighbor b)
+{
+	return static_cast<ChunkFaceMask>(1 << ChunkConnectivity::GetFacePairBit(a, b));
+}
+
+// Stone everywhere but where "isOpen" says, with chunk coordinates
+static uint32_t CheckChunk(const char* name, const std::function<bool(int32_t, int32_t, int32_t)>& isOpen, const ChunkFaceMask expected)
+{
+	auto snapshot = std::make_unique<Snapshot>();
+	std::fill(snapshot->blocks, snapshot->blocks + Snapshot::PADDED_VOLUME, BlockType::Stone);
+	for (int32_t x = 0; x < CHUNK_SIZE; x++)
+	{
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+		{
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
+			{
+				if (isOpen(x, y, z)) snapshot->blocks[Snapshot::GetIndex(x + 1, y + 1, z + 1)] = BlockType::Air;
+			}
+		}
+	}
+
+	const ChunkFaceMask connectivity = ChunkConnectivity::Compute(*snapshot);
+	printf("%-22s %04x, expected %04x%s\n", name, connectivity, expected, connectivity == expected ? "" : "  MISMATCH");
+	return connectivity == expected ? 0 : 1;
+}
+
+// Hand-built chunks with known connectivity
+static uint32_t CheckConnectivity()
+{
+	constexpr int32_t mid = CHUNK_SIZE / 2;
+	const ChunkFaceMask leftRight = GetPair(ChunkNeighbor::LEFT, ChunkNeighbor::RIGHT);
+	const ChunkFaceMask frontBack = GetPair(ChunkNeighbor::FRONT, ChunkNeighbor::BACK);
+
+	uint32_t numMismatches = 0;
+	numMismatches += CheckChunk("Air:", [](int32_t, int32_t, int32_t) { return true; }, ALL_FACES_CONNECTED);
+	numMismatches += CheckChunk("Stone:", [](int32_t, int32_t, int32_t) { return false; }, NO_FACES_CONNECTED);
+	numMismatches += CheckChunk("Enclosed cave:", [](int32_t x, int32_t y, int32_t z)
+	{
+		return x > 2 && x < CHUNK_SIZE - 3 && y > 2 && y < CHUNK_SIZE - 3 && z > 2 && z < CHUNK_SIZE - 3;
+	}, NO_FACES_CONNECTED);
+	numMismatches += CheckChunk("Tunnel along X:", [](int32_t, int32_t y, int32_t z) { return y == mid && z == mid; }, leftRight);
+	numMismatches += CheckChunk("Tunnel turning up:", [](int32_t x, int32_t y, int32_t z)
+	{
+		return z == mid && ((y == mid && x <= mid) || (x == mid && y >= mid));
+	}, GetPair(ChunkNeighbor::LEFT, ChunkNeighbor::TOP));
+	numMismatches += CheckChunk("Two separate tunnels:", [](int32_t x, int32_t y, int32_t z)
+	{
+		return (y == 2 && z == mid) || (y == CHUNK_SIZE - 3 && x == mid);
+	}, static_cast<ChunkFaceMask>(leftRight | frontBack));
+	numMismatches += CheckChunk("Corner block:", [](int32_t x, int32_t y, int32_t z) { return x == 0 && y == 0 && z == 0; },
+		static_cast<ChunkFaceMask>(GetPair(ChunkNeighbor::LEFT, ChunkNeighbor::BOTTOM) | GetPair(ChunkNeighbor::LEFT, ChunkNeighbor::FRONT) |
+			GetPair(ChunkNeighbor::BOTTOM, ChunkNeighbor::FRONT)));
+
+	return numMismatches;
+}
+
+class GeneratedWorld : public ConnectivityWorld
+{
+public:
+
+	bool GetConnectivity(const ChunkCoord& chunkPosCS, ChunkFaceMask& outConnectivity) override
+	{
+		auto iter = connectivity.find(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS));
+		if (iter == connectivity.end()) return false;
+
+		outConnectivity = treatAsOpen ? ALL_FACES_CONNECTED : iter->second;
+		return true;
+	}
+
+	std::unordered_map<uint64_t, ChunkFaceMask> connectivity;
+	std::vector<ChunkCoord> chunks;
+
+	// Ignores the blocks, to see how much the search itself leaves out
+	bool treatAsOpen = false;
+};
+
+// Returns the number of chunks the search found outside the frustum
+static uint32_t MeasureSearch(GeneratedWorld& world, const char* name, const DirectX::XMFLOAT3& cameraPos, const std::vector<Headless::FrustumPlanes>& views)
+{
+	const ChunkCoord cameraPosCS = Orange::Math::WorldToChunkSpace(cameraPos);
+
+	uint64_t numInFrustum = 0, numFound = 0;
+	uint32_t numOutsideFrustum = 0;
+	float searchMs = 0.0f;
+
+	std::vector<ChunkCoord> visibleChunks;
+	for (const auto& view : views)
+	{
+		for (const auto& chunkPosCS : world.chunks) numInFrustum += ChunkCuller::IsChunkVisible(view.data(), chunkPosCS) ? 1 : 0;
+
+		auto start = std::chrono::steady_clock::now();
+		if (!ChunkConnectivity::FindVisibleChunks(world, cameraPosCS, view.data(), visibleChunks))
+		{
+			printf("%-12s the camera's chunk isn't loaded\n", name);
+			return 1;
+		}
+		searchMs += GetElapsedMs(start);
+
+		numFound += visibleChunks.size();
+		for (const auto& chunkPosCS : visibleChunks)
+		{
+			if (chunkPosCS != cameraPosCS && !ChunkCuller::IsChunkVisible(view.data(), chunkPosCS)) numOutsideFrustum++;
+		}
+	}
+
+	const float numViews = static_cast<float>(views.size());
+	printf("%-12s %14.1f %14.1f %11.1f%% %13.1f\n", name, numInFrustum / numViews, numFound / numViews,
+		100.0f * numFound / max(numInFrustum, static_cast<uint64_t>(1)), 1000.0f * searchMs / numViews);
+
+	return numOutsideFrustum;
+}
+
+int CaveCullingMode::Run(const std::vector<std::string>& args)
+{
+	const char* radiusArg = Headless::FindArg(args, "--radius");
+	const char* viewsArg = Headless::FindArg(args, "--views");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+
+	const int32_t radius = max(radiusArg ? atoi(radiusArg) : DEFAULT_RADIUS, 1);
+	const uint32_t numViews = max(viewsArg ? static_cast<uint32_t>(atoi(viewsArg)) : DEFAULT_NUM_VIEWS, 1u);
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	TerrainShape terrainShape;
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseTerrainShape(Headless::FindArg(args, "--terrain"), terrainShape) ||
+		!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	BlockRegistry::Initialize("../Source/Data/BlockDefinitions.txt");
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetTerrainShape(terrainShape);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	uint32_t numMismatches = CheckConnectivity();
+
+	int32_t surfaceHeight = 0;
+	TerrainGenerator::QuerySurfaceHeight(0, 0, -1024, surfaceHeight);
+	const int32_t surfaceCS = surfaceHeight >> CHUNK_SIZE_SHIFT;
+
+	// 1. Every chunk of the box, meshed on its own. Only the chunk's own blocks decide its connectivity
+	GeneratedWorld world;
+	auto snapshot = std::make_unique<Snapshot>();
+	std::vector<BlockType> blocks(BLOCKS_PER_CHUNK);
+	uint32_t numFaceMasks[2] = { 0, 0 };
+
+	auto start = std::chrono::steady_clock::now();
+	float connectivityMs = 0.0f;
+	for (int32_t x = -radius; x <= radius; x++)
+	{
+		for (int32_t y = surfaceCS - CHUNKS_BELOW_SURFACE; y <= surfaceCS + CHUNKS_ABOVE_SURFACE; y++)
+		{
+			for (int32_t z = -radius; z <= radius; z++)
+			{
+				const ChunkCoord chunkPosCS(x, y, z);
+				TerrainGenerator::GenerateChunk(chunkPosCS, blocks.data());
+
+				snapshot->posCS = chunkPosCS;
+				for (int32_t bx = 0; bx < CHUNK_SIZE; bx++)
+				{
+					for (int32_t by = 0; by < CHUNK_SIZE; by++)
+					{
+						memcpy(&snapshot->blocks[Snapshot::GetIndex(bx + 1, by + 1, 1)], &blocks[DefaultChunkTraits::GetIndex(bx, by, 0)], CHUNK_SIZE * sizeof(BlockType));
+					}
+				}
+
+				auto connectivityStart = std::chrono::steady_clock::now();
+				const ChunkFaceMask connectivity = ChunkConnectivity::Compute(*snapshot);
+				connectivityMs += GetElapsedMs(connectivityStart);
+
+				world.connectivity[Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)] = connectivity;
+				world.chunks.push_back(chunkPosCS);
+				if (connectivity == NO_FACES_CONNECTED) numFaceMasks[0]++;
+				if (connectivity == ALL_FACES_CONNECTED) numFaceMasks[1]++;
+			}
+		}
+	}
+
+	const uint32_t numChunks = static_cast<uint32_t>(world.chunks.size());
+	printf("\nGenerated %u chunks in %.2f ms, surface at y = %i. %u are closed off entirely, %u are open on every side\n",
+		numChunks, GetElapsedMs(start), surfaceHeight, numFaceMasks[0], numFaceMasks[1]);
+	printf("Connectivity takes %.2f us per chunk\n\n", 1000.0f * connectivityMs / numChunks);
+
+	// 2. Searches from above and below the surface
+	std::mt19937 rng(static_cast<uint32_t>(seed));
+	std::uniform_real_distribution<float> yawDist(0.0f, 2.0f * 3.14159265f);
+	std::uniform_real_distribution<float> pitchDist(-1.4f, 1.4f);
+
+	const DirectX::XMFLOAT3 surfaceCamera = { 0.5f, static_cast<float>(surfaceHeight + SURFACE_CAMERA_HEIGHT), 0.5f };
+	const DirectX::XMFLOAT3 undergroundCamera = { 0.5f, static_cast<float>(surfaceHeight - UNDERGROUND_CAMERA_DEPTH), 0.5f };
+
+	std::vector<Headless::FrustumPlanes> surfaceViews(numViews), undergroundViews(numViews);
+	for (auto& view : surfaceViews) view = Headless::BuildFrustum(surfaceCamera, yawDist(rng), pitchDist(rng));
+	for (auto& view : undergroundViews) view = Headless::BuildFrustum(undergroundCamera, yawDist(rng), pitchDist(rng));
+
+	printf("%-12s %14s %14s %12s %13s\n", "camera", "in frustum", "found", "ratio", "search (us)");
+	numMismatches += MeasureSearch(world, "Surface", surfaceCamera, surfaceViews);
+	numMismatches += MeasureSearch(world, "Underground", undergroundCamera, undergroundViews);
+
+	world.treatAsOpen = true;
+	numMismatches += MeasureSearch(world, "Open", surfaceCamera, surfaceViews);
+
+	printf("\n%u mismatches\n", numMismatches);
+	return numMismatches == 0 ? 0 : 1;
+}
+
+void CaveCullingMode::PrintUsage()
+{
+	printf("  cavecull [--radius N] [--views N] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]\n");
+	printf("      Checks chunk face connectivity on hand-built chunks, then compares the chunks found by searching\n");
+	printf("      through the connectivity with the chunks in the frustum, from above and below the surface.\n");
+}
@@ -0,0 +1,24 @@
+#ifndef _CAVECULLINGMODE_H
+#define _CAVECULLINGMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks and measures culling chunks through their face connectivity:
+//
+//		cavecull [--radius N] [--views N] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]
+//
+// First checks the connectivity of a few hand-built chunks, then generates every chunk within N chunks (horizontally)
+// of the origin and searches for the visible chunks from above and below the surface, from random view directions.
+// Every chunk the search finds has to be inside the frustum
+class CaveCullingMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
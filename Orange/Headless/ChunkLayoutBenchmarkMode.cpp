@@ -0,0 +1,318 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "ChunkLayoutBenchmarkMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/BlockRegistry.h"
+#include "../Source/Core/ChunkLayout.h"
+#include "../Source/Core/ChunkMesher.h"
+#include "../Source/Core/LightEngine.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+constexpr int32_t DEFAULT_CHUNKS_PER_AXIS = 8;
+constexpr uint32_t DEFAULT_NUM_QUERIES = 1000000;
+
+// Roughly the player's AABB, up to a few blocks bigger
+constexpr float MIN_QUERY_EXTENT = 0.3f;
+constexpr float MAX_QUERY_EXTENT = 2.0f;
+
+constexpr float MAX_RAYCAST_DISTANCE = 32.0f;
+
+// The terrain's surface is around y = 80 to 130, so the box is centered vertically on it
+constexpr int32_t BENCHMARK_CENTER_HEIGHT = 105;
+
+struct LayoutResult
+{
+	const char* name = "";
+	uint64_t numInstances = 0;
+	uint64_t numCollidingBlocks = 0;
+	uint64_t numRaycastHits = 0;
+
+	float meshingMs = 0.0f;
+	float collisionMs = 0.0f;
+	float raycastMs = 0.0f;
+};
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A cube of chunks stored in the given layout, indexed like the game's chunks are (through the layout's indexer)
+template<ChunkLayout Layout>
+class BenchmarkWorld
+{
+public:
+
+	using Indexer = ChunkBlockIndexer<Layout>;
+
+	BenchmarkWorld(const std::vector<BlockType>& rowMajorBlocks, const ChunkCoord& minCS, const int32_t chunksPerAxis) :
+		m_blocks(rowMajorBlocks.size()), m_minCS(minCS), m_chunksPerAxis(chunksPerAxis)
+	{
+		for (size_t chunk = 0; chunk < rowMajorBlocks.size() / BLOCKS_PER_CHUNK; chunk++)
+		{
+			for (uint32_t i = 0; i < BLOCKS_PER_CHUNK; i++)
+			{
+				BlockCoord localPos = ChunkBlockIndexer<ChunkLayout::ROW_MAJOR>::GetCoord(i);
+				m_blocks[chunk * BLOCKS_PER_CHUNK + Indexer::GetIndex(localPos.x, localPos.y, localPos.z)] = rowMajorBlocks[chunk * BLOCKS_PER_CHUNK + i];
+			}
+		}
+	}
+
+	// Returns nullptr if the chunk is outside of the world
+	const BlockType* GetChunk(const ChunkCoord& chunkPosCS) const
+	{
+		ChunkCoord offset = chunkPosCS - m_minCS;
+		if (static_cast<uint32_t>(offset.x) >= static_cast<uint32_t>(m_chunksPerAxis) ||
+			static_cast<uint32_t>(offset.y) >= static_cast<uint32_t>(m_chunksPerAxis) ||
+			static_cast<uint32_t>(offset.z) >= static_cast<uint32_t>(m_chunksPerAxis)) return nullptr;
+
+		size_t chunkIndex = (static_cast<size_t>(offset.x) * m_chunksPerAxis + offset.y) * m_chunksPerAxis + offset.z;
+		return &m_blocks[chunkIndex * BLOCKS_PER_CHUNK];
+	}
+
+	// Blocks outside of the world are air
+	BlockType GetBlock(const BlockCoord& blockPos) const
+	{
+		const BlockType* chunk = GetChunk(Orange::Math::BlockToChunkCoord(blockPos));
+		if (!chunk) return BlockType::Air;
+
+		BlockCoord localPos = Orange::Math::BlockToLocalCoord(blockPos);
+		return chunk[Indexer::GetIndex(localPos.x, localPos.y, localPos.z)];
+	}
+
+	// Same as Chunk::TakeSnapshot(), the apron is read through the layout as well
+	void TakeSnapshot(const ChunkCoord& chunkPosCS, ChunkSnapshot& outSnapshot) const
+	{
+		const BlockType* chunk = GetChunk(chunkPosCS);
+		outSnapshot.posCS = chunkPosCS;
+		std::fill(outSnapshot.blocks, outSnapshot.blocks + ChunkSnapshot::PADDED_VOLUME, ChunkSnapshot::MISSING_NEIGHBOR_BLOCK);
+
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			{
+				BlockType* row = &outSnapshot.blocks[ChunkSnapshot::GetIndex(x + 1, y + 1, 1)];
+				for (int32_t z = 0; z < CHUNK_SIZE; z++) row[z] = chunk[Indexer::GetIndex(x, y, z)];
+			}
+		}
+
+		const BlockType* left = GetChunk(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::LEFT)]);
+		const BlockType* right = GetChunk(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::RIGHT)]);
+		const BlockType* bottom = GetChunk(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::BOTTOM)]);
+		const BlockType* top = GetChunk(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::TOP)]);
+		const BlockType* front = GetChunk(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::FRONT)]);
+		const BlockType* back = GetChunk(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::BACK)]);
+
+		for (int32_t a = 0; a < CHUNK_SIZE; a++)
+		{
+			for (int32_t b = 0; b < CHUNK_SIZE; b++)
+			{
+				if (left) outSnapshot.blocks[ChunkSnapshot::GetIndex(0, a + 1, b + 1)] = left[Indexer::GetIndex(CHUNK_SIZE - 1, a, b)];
+				if (right) outSnapshot.blocks[ChunkSnapshot::GetIndex(CHUNK_SIZE + 1, a + 1, b + 1)] = right[Indexer::GetIndex(0, a, b)];
+				if (bottom) outSnapshot.blocks[ChunkSnapshot::GetIndex(a + 1, 0, b + 1)] = bottom[Indexer::GetIndex(a, CHUNK_SIZE - 1, b)];
+				if (top) outSnapshot.blocks[ChunkSnapshot::GetIndex(a + 1, CHUNK_SIZE + 1, b + 1)] = top[Indexer::GetIndex(a, 0, b)];
+				if (front) outSnapshot.blocks[ChunkSnapshot::GetIndex(a + 1, b + 1, 0)] = front[Indexer::GetIndex(a, b, CHUNK_SIZE - 1)];
+				if (back) outSnapshot.blocks[ChunkSnapshot::GetIndex(a + 1, b + 1, CHUNK_SIZE + 1)] = back[Indexer::GetIndex(a, b, 0)];
+			}
+		}
+	}
+
+private:
+
+	std::vector<BlockType> m_blocks;
+	ChunkCoord m_minCS;
+	int32_t m_chunksPerAxis;
+
+};
+
+struct CollisionQuery
+{
+	DirectX::XMFLOAT3 center;
+	DirectX::XMFLOAT3 extent;
+};
+
+struct RaycastQuery
+{
+	DirectX::XMFLOAT3 origin;
+	DirectX::XMFLOAT3 direction;
+};
+
+template<ChunkLayout Layout>
+static LayoutResult RunBenchmark(const char* name, const std::vector<BlockType>& rowMajorBlocks, const ChunkCoord& minCS, const int32_t chunksPerAxis,
+	const std::vector<CollisionQuery>& collisionQueries, const std::vector<RaycastQuery>& raycastQueries)
+{
+	LayoutResult result;
+	result.name = name;
+
+	const BenchmarkWorld<Layout> world(rowMajorBlocks, minCS, chunksPerAxis);
+
+	// 1. Meshing
+	auto snapshot = std::make_unique<ChunkSnapshot>();
+	std::fill(snapshot->light, snapshot->light + ChunkSnapshot::PADDED_VOLUME, static_cast<uint8_t>(MAX_LIGHT_LEVEL << static_cast<uint8_t>(LightChannel::SKY)));	// Lighting isn't benchmarked, everything is in full sky light
+	std::vector<BlockInstanceData> instances;
+	auto start = std::chrono::steady_clock::now();
+	for (int32_t x = 0; x < chunksPerAxis; x++)
+	{
+		for (int32_t y = 0; y < chunksPerAxis; y++)
+		{
+			for (int32_t z = 0; z < chunksPerAxis; z++)
+			{
+				world.TakeSnapshot(minCS + ChunkCoord(x, y, z), *snapshot);
+				instances.clear();
+				result.numInstances += ChunkMesher::BuildMesh(*snapshot, instances);
+			}
+		}
+	}
+	result.meshingMs = GetElapsedMs(start);
+
+	// 2. AABB collision queries, the same block scan as Physics::DetectCollision()
+	start = std::chrono::steady_clock::now();
+	for (const auto& query : collisionQueries)
+	{
+		BlockCoord minBlock = Orange::Math::WorldToBlockCoord({ query.center.x - query.extent.x, query.center.y - query.extent.y, query.center.z - query.extent.z });
+		BlockCoord maxBlock = Orange::Math::WorldToBlockCoord({ query.center.x + query.extent.x, query.center.y + query.extent.y, query.center.z + query.extent.z });
+
+		for (int32_t x = minBlock.x; x <= maxBlock.x; x++)
+		{
+			for (int32_t y = minBlock.y; y <= maxBlock.y; y++)
+			{
+				for (int32_t z = minBlock.z; z <= maxBlock.z; z++)
+				{
+					result.numCollidingBlocks += BlockRegistry::IsCollidable(world.GetBlock(BlockCoord(x, y, z))) ? 1 : 0;
+				}
+			}
+		}
+	}
+	result.collisionMs = GetElapsedMs(start);
+
+	// 3. Raycasts, stepping through every block the ray crosses until it hits a collidable one
+	start = std::chrono::steady_clock::now();
+	for (const auto& query : raycastQueries)
+	{
+		BlockCoord block = Orange::Math::WorldToBlockCoord(query.origin);
+		const float origin[3] = { query.origin.x, query.origin.y, query.origin.z };
+		const float direction[3] = { query.direction.x, query.direction.y, query.direction.z };
+		int32_t* blockAxes[3] = { &block.x, &block.y, &block.z };
+
+		int32_t step[3];
+		float tMax[3], tDelta[3];
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			step[axis] = direction[axis] >= 0.0f ? 1 : -1;
+			tDelta[axis] = direction[axis] != 0.0f ? fabsf(1.0f / direction[axis]) : INFINITY;
+			float boundary = static_cast<float>(*blockAxes[axis] + (step[axis] > 0 ? 1 : 0));
+			tMax[axis] = direction[axis] != 0.0f ? (boundary - origin[axis]) / direction[axis] : INFINITY;
+		}
+
+		float distance = 0.0f;
+		while (distance <= MAX_RAYCAST_DISTANCE)
+		{
+			if (BlockRegistry::IsCollidable(world.GetBlock(block)))
+			{
+				result.numRaycastHits++;
+				break;
+			}
+
+			uint32_t axis = (tMax[0] < tMax[1]) ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+			distance = tMax[axis];
+			tMax[axis] += tDelta[axis];
+			*blockAxes[axis] += step[axis];
+		}
+	}
+	result.raycastMs = GetElapsedMs(start);
+
+	return result;
+}
+
+int ChunkLayoutBenchmarkMode::Run(const std::vector<std::string>& args)
+{
+	const char* chunksArg = Headless::FindArg(args, "--chunks");
+	const char* queriesArg = Headless::FindArg(args, "--queries");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+
+	const int32_t chunksPerAxis = max(chunksArg ? atoi(chunksArg) : DEFAULT_CHUNKS_PER_AXIS, 1);
+	const uint32_t numQueries = max(queriesArg ? static_cast<uint32_t>(atoi(queriesArg)) : DEFAULT_NUM_QUERIES, 1u);
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	BlockRegistry::Initialize("../Source/Data/BlockDefinitions.txt");
+	TerrainGenerator::SetSeed(seed);
+
+	const ChunkCoord minCS = ChunkCoord(-chunksPerAxis / 2, BENCHMARK_CENTER_HEIGHT / CHUNK_SIZE - chunksPerAxis / 2, -chunksPerAxis / 2);
+	const int32_t numChunks = chunksPerAxis * chunksPerAxis * chunksPerAxis;
+
+	printf("Benchmarking %i chunks (%i per axis) with seed %llu, %u collision queries and raycasts, BMI2 %s\n\n",
+		numChunks, chunksPerAxis, seed, numQueries, OG_HAS_BMI2 ? "enabled" : "disabled");
+
+	std::vector<BlockType> rowMajorBlocks(static_cast<size_t>(numChunks) * BLOCKS_PER_CHUNK);
+	for (int32_t x = 0; x < chunksPerAxis; x++)
+	{
+		for (int32_t y = 0; y < chunksPerAxis; y++)
+		{
+			for (int32_t z = 0; z < chunksPerAxis; z++)
+			{
+				size_t chunkIndex = (static_cast<size_t>(x) * chunksPerAxis + y) * chunksPerAxis + z;
+				TerrainGenerator::GenerateChunk(minCS + ChunkCoord(x, y, z), &rowMajorBlocks[chunkIndex * BLOCKS_PER_CHUNK]);
+			}
+		}
+	}
+
+	// The same queries are used for every layout
+	const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(minCS);
+	const float worldSize = static_cast<float>(chunksPerAxis * CHUNK_SIZE);
+	std::mt19937 rng(static_cast<uint32_t>(seed));
+	std::uniform_real_distribution<float> positionDist(0.0f, worldSize);
+	std::uniform_real_distribution<float> extentDist(MIN_QUERY_EXTENT, MAX_QUERY_EXTENT);
+	std::uniform_real_distribution<float> directionDist(-1.0f, 1.0f);
+
+	std::vector<CollisionQuery> collisionQueries(numQueries);
+	std::vector<RaycastQuery> raycastQueries(numQueries);
+	for (uint32_t i = 0; i < numQueries; i++)
+	{
+		collisionQueries[i].center = { minWS.x + positionDist(rng), minWS.y + positionDist(rng), minWS.z + positionDist(rng) };
+		collisionQueries[i].extent = { extentDist(rng), extentDist(rng), extentDist(rng) };
+
+		DirectX::XMFLOAT3 direction = { directionDist(rng), directionDist(rng), directionDist(rng) };
+		float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+		if (length < 0.001f) direction = { 0.0f, -1.0f, 0.0f };
+		else direction = { direction.x / length, direction.y / length, direction.z / length };
+
+		raycastQueries[i].origin = { minWS.x + positionDist(rng), minWS.y + positionDist(rng), minWS.z + positionDist(rng) };
+		raycastQueries[i].direction = direction;
+	}
+
+	const LayoutResult results[] =
+	{
+		RunBenchmark<ChunkLayout::ROW_MAJOR>("row-major", rowMajorBlocks, minCS, chunksPerAxis, collisionQueries, raycastQueries),
+		RunBenchmark<ChunkLayout::MORTON>("morton", rowMajorBlocks, minCS, chunksPerAxis, collisionQueries, raycastQueries)
+	};
+
+	printf("%10s %12s %14s %16s %12s %14s %14s\n", "layout", "mesh (ms)", "collide (ms)", "raycast (ms)", "instances", "colliding", "raycast hits");
+	for (const auto& result : results)
+	{
+		printf("%10s %12.2f %14.2f %16.2f %12llu %14llu %14llu\n", result.name, result.meshingMs, result.collisionMs, result.raycastMs,
+			result.numInstances, result.numCollidingBlocks, result.numRaycastHits);
+	}
+
+	// Every layout has to produce exactly the same results, only the timings may differ
+	for (const auto& result : results)
+	{
+		if (result.numInstances != results[0].numInstances || result.numCollidingBlocks != results[0].numCollidingBlocks || result.numRaycastHits != results[0].numRaycastHits)
+		{
+			printf("\nThe %s layout produced different results than the %s layout\n", result.name, results[0].name);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void ChunkLayoutBenchmarkMode::PrintUsage()
+{
+	printf("  layoutbench [--chunks N] [--queries N] [--seed N]\n");
+	printf("      Times meshing, AABB collision queries and raycasts with every chunk block layout.\n");
+	printf("      The cube of generated chunks is N chunks wide (8 by default).\n");
+}
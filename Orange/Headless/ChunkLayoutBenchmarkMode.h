@@ -0,0 +1,24 @@
+#ifndef _CHUNKLAYOUTBENCHMARKMODE_H
+#define _CHUNKLAYOUTBENCHMARKMODE_H
+
+#include <string>
+#include <vector>
+
+// Stores the same generated chunks in every ChunkLayout and times the workloads that
+// depend on how blocks are laid out in memory:
+//
+//		layoutbench [--chunks N] [--queries N] [--seed N]
+//
+// Meshing (snapshot + mesh), AABB collision queries and block raycasts. "--chunks" is the
+// edge length of the cube of chunks that's generated around the terrain's surface
+class ChunkLayoutBenchmarkMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "ChunkSizeBenchmarkMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/BlockRegistry.h"
+#include "../Source/Core/ChunkMesher.h"
+#include "../Source/Core/LightEngine.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+constexpr int32_t DEFAULT_EXTENT_XZ = 512;
+constexpr int32_t DEFAULT_EXTENT_Y = 192;
+constexpr uint32_t DEFAULT_ITERATIONS = 10;
+
+// Same view distance and field of view for every chunk size, see CullChunks()
+constexpr float BENCHMARK_CAMERA_HEIGHT = 110.0f;
+constexpr float BENCHMARK_FAR_PLANE = 256.0f;
+
+struct ChunkSizeResult
+{
+	int32_t chunkSize = 0;
+	uint32_t numChunks = 0;
+	uint32_t numDrawRanges = 0;
+	uint64_t numInstances = 0;
+	uint32_t numVisibleChunks = 0;
+
+	float generationMs = 0.0f;
+	float meshingMs = 0.0f;
+	float neighborLookupMs = 0.0f;
+	float cullingMs = 0.0f;
+};
+
+struct FrustumPlane
+{
+	float x, y, z, d;
+};
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A 90 degree frustum looking down +X from "cameraPos". The planes point inwards
+static void BuildFrustum(const DirectX::XMFLOAT3& cameraPos, FrustumPlane* outPlanes)
+{
+	const float invSqrt2 = 1.0f / sqrtf(2.0f);
+	const FrustumPlane planes[6] =
+	{
+		{ 1.0f, 0.0f, 0.0f, 0.0f },									// near
+		{ -1.0f, 0.0f, 0.0f, BENCHMARK_FAR_PLANE },					// far
+		{ invSqrt2, -invSqrt2, 0.0f, 0.0f },						// top
+		{ invSqrt2, invSqrt2, 0.0f, 0.0f },							// bottom
+		{ invSqrt2, 0.0f, -invSqrt2, 0.0f },						// +Z side
+		{ invSqrt2, 0.0f, invSqrt2, 0.0f }							// -Z side
+	};
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		outPlanes[i] = planes[i];
+		outPlanes[i].d -= planes[i].x * cameraPos.x + planes[i].y * cameraPos.y + planes[i].z * cameraPos.z;
+	}
+}
+
+template<int32_t Size>
+static ChunkSizeResult RunBenchmark(const int32_t extentXZ, const int32_t extentY, const uint32_t iterations)
+{
+	using Traits = ChunkTraits<Size>;
+	using Snapshot = BasicChunkSnapshot<Size>;
+
+	ChunkSizeResult result;
+	result.chunkSize = Size;
+
+	const ChunkCoord minCS = Orange::Math::BlockToChunkCoord<Size>(BlockCoord(-extentXZ / 2, 0, -extentXZ / 2));
+	const int32_t chunksXZ = extentXZ / Size;
+	const int32_t chunksY = extentY / Size;
+	result.numChunks = static_cast<uint32_t>(chunksXZ * chunksY * chunksXZ);
+
+	auto getChunkPos = [&](const uint32_t index)
+	{
+		return minCS + ChunkCoord(static_cast<int32_t>(index) / (chunksY * chunksXZ), (static_cast<int32_t>(index) / chunksXZ) % chunksY, static_cast<int32_t>(index) % chunksXZ);
+	};
+
+	// 1. Generation. Resetting the seed drops the blocks the previous chunk size's trees left behind
+	TerrainGenerator::SetSeed(TerrainGenerator::GetSeed());
+
+	std::vector<BlockType> blocks(static_cast<size_t>(result.numChunks) * Traits::VOLUME);
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < result.numChunks; i++)
+	{
+		TerrainGenerator::GenerateChunk<Size>(getChunkPos(i), &blocks[static_cast<size_t>(i) * Traits::VOLUME]);
+	}
+
+	// Trees that grew into chunks that were generated before theirs
+	std::vector<PendingBlockWrite> lateWrites;
+	TerrainGenerator::GetPipeline().GetPendingWrites().TakeLateWrites(lateWrites);
+	for (const auto& write : lateWrites)
+	{
+		const ChunkCoord offsetCS = write.targetCS - minCS;
+		const size_t chunkIndex = static_cast<size_t>((offsetCS.x * chunksY + offsetCS.y) * chunksXZ + offsetCS.z);
+		BlockType& block = blocks[chunkIndex * Traits::VOLUME + write.index];
+		block = PendingWriteStore::MergeBlock(block, write.type);
+	}
+	result.generationMs = GetElapsedMs(start);
+
+	// 2. Neighbor lookups through a chunk map, the same way the ChunkManager finds chunks
+	std::unordered_map<uint64_t, uint32_t> chunkMap;
+	chunkMap.reserve(result.numChunks);
+	for (uint32_t i = 0; i < result.numChunks; i++)
+	{
+		chunkMap[Orange::Math::GetHashKeyFromChunkPosition(getChunkPos(i))] = i;
+	}
+
+	uint64_t numNeighborsFound = 0;
+	start = std::chrono::steady_clock::now();
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		for (uint32_t i = 0; i < result.numChunks; i++)
+		{
+			const ChunkCoord chunkPosCS = getChunkPos(i);
+			for (uint32_t j = 0; j < NUM_CHUNK_NEIGHBORS; j++)
+			{
+				numNeighborsFound += chunkMap.count(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[j]));
+			}
+		}
+	}
+	result.neighborLookupMs = GetElapsedMs(start) / iterations;
+
+	// 3. Meshing, including taking the snapshots. Every non-empty mesh is one draw range
+	auto snapshot = std::make_unique<Snapshot>();
+	std::fill(snapshot->light, snapshot->light + Snapshot::PADDED_VOLUME, static_cast<uint8_t>(MAX_LIGHT_LEVEL << static_cast<uint8_t>(LightChannel::SKY)));	// Lighting isn't benchmarked, everything is in full sky light
+	std::vector<BlockInstanceData> instances;
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < result.numChunks; i++)
+	{
+		const ChunkCoord chunkPosCS = getChunkPos(i);
+		const BlockType* chunkBlocks = &blocks[static_cast<size_t>(i) * Traits::VOLUME];
+
+		snapshot->posCS = chunkPosCS;
+		for (int32_t x = 0; x < Size; x++)
+		{
+			for (int32_t y = 0; y < Size; y++)
+			{
+				memcpy(&snapshot->blocks[Snapshot::GetIndex(x + 1, y + 1, 1)], &chunkBlocks[Traits::GetIndex(x, y, 0)], Size * sizeof(BlockType));
+			}
+		}
+
+		const BlockType* neighborBlocks[NUM_CHUNK_NEIGHBORS];
+		for (uint32_t j = 0; j < NUM_CHUNK_NEIGHBORS; j++)
+		{
+			auto neighbor = chunkMap.find(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[j]));
+			neighborBlocks[j] = neighbor != chunkMap.end() ? &blocks[static_cast<size_t>(neighbor->second) * Traits::VOLUME] : nullptr;
+		}
+		ChunkMesher::FillApron<Size>(*snapshot, neighborBlocks);
+
+		instances.clear();
+		uint32_t numChunkInstances = ChunkMesher::BuildMesh<Size>(*snapshot, instances);
+		if (numChunkInstances > 0) result.numDrawRanges++;
+		result.numInstances += numChunkInstances;
+	}
+	result.meshingMs = GetElapsedMs(start);
+
+	// 4. Frustum culling every chunk's AABB
+	FrustumPlane planes[6];
+	BuildFrustum({ static_cast<float>(-extentXZ / 2), BENCHMARK_CAMERA_HEIGHT, 0.0f }, planes);
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		uint32_t numVisibleChunks = 0;
+		for (uint32_t i = 0; i < result.numChunks; i++)
+		{
+			DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace<Size>(getChunkPos(i));
+			DirectX::XMFLOAT3 center = { minWS.x + Traits::HALF_EXTENT, minWS.y + Traits::HALF_EXTENT, minWS.z + Traits::HALF_EXTENT };
+
+			bool isVisible = true;
+			for (const auto& plane : planes)
+			{
+				float radius = Traits::HALF_EXTENT * (fabsf(plane.x) + fabsf(plane.y) + fabsf(plane.z));
+				isVisible &= plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.d + radius >= 0.0f;
+			}
+			numVisibleChunks += isVisible ? 1 : 0;
+		}
+		result.numVisibleChunks = numVisibleChunks;
+	}
+	result.cullingMs = GetElapsedMs(start) / iterations;
+
+	// Keeps the lookups from being optimized away
+	if (numNeighborsFound == 0) printf("No neighbors were found\n");
+
+	return result;
+}
+
+int ChunkSizeBenchmarkMode::Run(const std::vector<std::string>& args)
+{
+	const char* extentXZArg = Headless::FindArg(args, "--extent-xz");
+	const char* extentYArg = Headless::FindArg(args, "--extent-y");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const char* iterationsArg = Headless::FindArg(args, "--iterations");
+
+	// Round up to the largest chunk size, so that every size covers the same blocks
+	auto roundUp = [](const int32_t extent) { return ((max(extent, 1) + ChunkTraits<64>::MASK) / 64) * 64; };
+	const int32_t extentXZ = roundUp(extentXZArg ? atoi(extentXZArg) : DEFAULT_EXTENT_XZ);
+	const int32_t extentY = roundUp(extentYArg ? atoi(extentYArg) : DEFAULT_EXTENT_Y);
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+	const uint32_t iterations = max(iterationsArg ? static_cast<uint32_t>(atoi(iterationsArg)) : DEFAULT_ITERATIONS, 1u);
+
+	BlockRegistry::Initialize("../Source/Data/BlockDefinitions.txt");
+	TerrainGenerator::SetSeed(seed);
+
+	printf("Benchmarking a %i x %i x %i block box with seed %llu, averaging lookups and culling over %u iterations\n\n",
+		extentXZ, extentY, extentXZ, seed, iterations);
+
+	const ChunkSizeResult results[] =
+	{
+		RunBenchmark<16>(extentXZ, extentY, iterations),
+		RunBenchmark<32>(extentXZ, extentY, iterations),
+		RunBenchmark<64>(extentXZ, extentY, iterations)
+	};
+
+	printf("%6s %8s %12s %10s %10s %12s %12s %12s %12s\n", "size", "chunks", "draw ranges", "instances", "visible", "gen (ms)", "mesh (ms)", "lookup (ms)", "cull (ms)");
+	for (const auto& result : results)
+	{
+		printf("%6i %8u %12u %10llu %10u %12.2f %12.2f %12.3f %12.3f\n",
+			result.chunkSize, result.numChunks, result.numDrawRanges, result.numInstances, result.numVisibleChunks,
+			result.generationMs, result.meshingMs, result.neighborLookupMs, result.cullingMs);
+	}
+
+	printf("\nPer chunk:\n");
+	printf("%6s %16s %16s %16s\n", "size", "mesh (us)", "lookups (ns)", "cull (ns)");
+	for (const auto& result : results)
+	{
+		printf("%6i %16.2f %16.1f %16.1f\n", result.chunkSize,
+			result.meshingMs * 1000.0f / result.numChunks,
+			result.neighborLookupMs * 1000000.0f / result.numChunks,
+			result.cullingMs * 1000000.0f / result.numChunks);
+	}
+
+	return 0;
+}
+
+void ChunkSizeBenchmarkMode::PrintUsage()
+{
+	printf("  chunkbench [--extent-xz N] [--extent-y N] [--seed N] [--iterations N]\n");
+	printf("      Generates, meshes and culls the same box of blocks with 16, 32 and 64 block\n");
+	printf("      chunks and prints the per-chunk overheads of each size.\n");
+}
@@ -0,0 +1,23 @@
+#ifndef _CHUNKSIZEBENCHMARKMODE_H
+#define _CHUNKSIZEBENCHMARKMODE_H
+
+#include <string>
+#include <vector>
+
+// Generates and meshes the same box of the world with 16, 32 and 64 block chunks and compares
+// the costs that scale with the number of chunks rather than the number of blocks:
+//
+//		chunkbench [--extent-xz N] [--extent-y N] [--seed N] [--iterations N]
+//
+// The extents are in blocks and are rounded up to a multiple of 64, so every chunk size covers the exact same blocks
+class ChunkSizeBenchmarkMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
@@ -0,0 +1,320 @@
+#include "../Source/Misc/pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "CullBenchmarkMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/ChunkCuller.h"
+
+// 33^3 chunks, about as many as the game keeps loaded at its highest render distance
+constexpr int32_t DEFAULT_RADIUS = 16;
+constexpr uint32_t DEFAULT_NUM_VIEWS = 64;
+constexpr uint32_t DEFAULT_ITERATIONS = 20;
+
+// How many mismatches are printed before only counting them
+constexpr uint32_t MAX_PRINTED_MISMATCHES = 10;
+
+// The camera paths CullCoherent() is measured on, at 60 frames per second
+constexpr uint32_t DEFAULT_NUM_FRAMES = 600;
+constexpr float FRAME_TIME = 1.0f / 60.0f;
+
+struct CameraPath
+{
+	const char* name;
+	float speed;			// units per second
+	float turnRate;			// radians per second of yaw
+	float pitchAmplitude;	// radians, the camera nods up and down once every few seconds
+};
+
+static const CameraPath CAMERA_PATHS[] =
+{
+	{ "Standing", 0.0f, 0.0f, 0.0f },
+	{ "Walking", 4.3f, 0.0f, 0.1f },
+	{ "Walk+turn", 4.3f, 0.8f, 0.2f },
+	{ "Flying+look", 11.0f, 3.0f, 0.6f },
+};
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void SortChunks(std::vector<ChunkCoord>& chunks)
+{
+	std::sort(chunks.begin(), chunks.end(), [](const ChunkCoord& a, const ChunkCoord& b)
+	{
+		return Orange::Math::GetHashKeyFromChunkPosition(a) < Orange::Math::GetHashKeyFromChunkPosition(b);
+	});
+}
+
+// Same as CullScalar(), but only counts how many plane tests it takes
+static uint64_t CountScalarPlaneTests(const std::vector<ChunkCoord>& chunks, const Orange::Plane* planes)
+{
+	uint64_t numTests = 0;
+	for (const auto& chunkPosCS : chunks)
+	{
+		const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+		const DirectX::XMFLOAT3 center = { minWS.x + DefaultChunkTraits::HALF_EXTENT, minWS.y + DefaultChunkTraits::HALF_EXTENT, minWS.z + DefaultChunkTraits::HALF_EXTENT };
+		for (uint32_t i = 0; i < NUM_CULLING_PLANES; i++)
+		{
+			const Orange::Plane& plane = planes[i];
+			const float extent = DefaultChunkTraits::HALF_EXTENT * (fabsf(plane.normal.x) + fabsf(plane.normal.y) + fabsf(plane.normal.z));
+			numTests++;
+			if (plane.normal.z * center.z + (plane.normal.y * center.y + plane.normal.x * center.x) < plane.point - extent) break;
+		}
+	}
+	return numTests;
+}
+
+// Follows the camera path frame by frame, checks CullCoherent() against CullScalar() on every frame and prints the
+// average number of plane tests per chunk and frame with and without what CullCoherent() remembers. Returns the number
+// of frames that differ
+static uint32_t RunCameraPath(ChunkCuller& culler, const std::vector<ChunkCoord>& chunks, const CameraPath& path, const uint32_t numFrames)
+{
+	std::vector<ChunkCoord> visibleChunks, expectedChunks;
+	visibleChunks.reserve(chunks.size());
+	expectedChunks.reserve(chunks.size());
+
+	DirectX::XMFLOAT3 cameraPos = { DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT };
+	std::vector<Headless::FrustumPlanes> frames(numFrames);
+	std::vector<DirectX::XMFLOAT3> cameraPositions(numFrames);
+	for (uint32_t frame = 0; frame < numFrames; frame++)
+	{
+		const float time = frame * FRAME_TIME;
+		const float yaw = path.turnRate * time;
+		const float pitch = path.pitchAmplitude * sinf(time * 1.3f);
+		cameraPos.x += sinf(yaw) * path.speed * FRAME_TIME;
+		cameraPos.z += cosf(yaw) * path.speed * FRAME_TIME;
+		cameraPositions[frame] = cameraPos;
+		frames[frame] = Headless::BuildFrustum(cameraPos, yaw, pitch);
+	}
+
+	uint32_t numMismatches = 0;
+	uint64_t scalarTests = 0, uncachedTests = 0;
+	for (uint32_t frame = 0; frame < numFrames; frame++)
+	{
+		scalarTests += CountScalarPlaneTests(chunks, frames[frame].data());
+
+		culler.ResetCoherence();
+		const uint64_t testsBefore = culler.GetNumCoherentPlaneTests();
+		visibleChunks.clear();
+		culler.CullCoherent(frames[frame].data(), cameraPositions[frame], visibleChunks);
+		uncachedTests += culler.GetNumCoherentPlaneTests() - testsBefore;
+	}
+
+	culler.ResetCoherence();
+	const uint64_t testsBefore = culler.GetNumCoherentPlaneTests();
+	for (uint32_t frame = 0; frame < numFrames; frame++)
+	{
+		visibleChunks.clear();
+		expectedChunks.clear();
+		culler.CullCoherent(frames[frame].data(), cameraPositions[frame], visibleChunks);
+		culler.CullScalar(frames[frame].data(), expectedChunks);
+
+		SortChunks(visibleChunks);
+		SortChunks(expectedChunks);
+		if (visibleChunks == expectedChunks) continue;
+
+		if (numMismatches < MAX_PRINTED_MISMATCHES)
+		{
+			printf("  %s, frame %u: %zu chunks visible with coherence, %zu one at a time\n", path.name, frame, visibleChunks.size(), expectedChunks.size());
+		}
+		numMismatches++;
+	}
+	const uint64_t cachedTests = culler.GetNumCoherentPlaneTests() - testsBefore;
+
+	// Timed separately, without the checks in between
+	culler.ResetCoherence();
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t frame = 0; frame < numFrames; frame++)
+	{
+		visibleChunks.clear();
+		culler.CullCoherent(frames[frame].data(), cameraPositions[frame], visibleChunks);
+	}
+	const float coherentMs = GetElapsedMs(start) / numFrames;
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t frame = 0; frame < numFrames; frame++)
+	{
+		visibleChunks.clear();
+		culler.Cull(frames[frame].data(), visibleChunks);
+	}
+	const float clusterMs = GetElapsedMs(start) / numFrames;
+
+	const float numChunkFrames = static_cast<float>(chunks.size()) * numFrames;
+	printf("%12s %12.3f %12.3f %12.3f %12.2f %12.2f %9u\n", path.name, scalarTests / numChunkFrames, uncachedTests / numChunkFrames,
+		cachedTests / numChunkFrames, clusterMs * 1000.0f, coherentMs * 1000.0f, numMismatches);
+	return numMismatches;
+}
+
+// Returns the number of views whose visible chunks differ between Cull() or CullWithoutClusters() and CullScalar()
+static uint32_t CompareCulling(const ChunkCuller& culler, const std::vector<Headless::FrustumPlanes>& views, const char* stepName)
+{
+	uint32_t numMismatches = 0;
+	std::vector<ChunkCoord> visibleChunks, batchedChunks, expectedChunks;
+	for (uint32_t i = 0; i < views.size(); i++)
+	{
+		visibleChunks.clear();
+		batchedChunks.clear();
+		expectedChunks.clear();
+		culler.Cull(views[i].data(), visibleChunks);
+		culler.CullWithoutClusters(views[i].data(), batchedChunks);
+		culler.CullScalar(views[i].data(), expectedChunks);
+
+		SortChunks(visibleChunks);
+		SortChunks(batchedChunks);
+		SortChunks(expectedChunks);
+		if (visibleChunks == expectedChunks && batchedChunks == expectedChunks) continue;
+
+		if (numMismatches < MAX_PRINTED_MISMATCHES)
+		{
+			printf("  View %u: %zu chunks visible by cluster, %zu in batches, %zu one at a time\n", i,
+				visibleChunks.size(), batchedChunks.size(), expectedChunks.size());
+		}
+		numMismatches++;
+	}
+
+	printf("%-10s %u of %zu views differ (%u chunks in %u clusters)\n", stepName, numMismatches, views.size(),
+		culler.GetNumChunks(), culler.GetNumClusters());
+	return numMismatches;
+}
+
+int CullBenchmarkMode::Run(const std::vector<std::string>& args)
+{
+	const char* radiusArg = Headless::FindArg(args, "--radius");
+	const char* viewsArg = Headless::FindArg(args, "--views");
+	const char* iterationsArg = Headless::FindArg(args, "--iterations");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const char* framesArg = Headless::FindArg(args, "--frames");
+
+	const int32_t radius = max(radiusArg ? atoi(radiusArg) : DEFAULT_RADIUS, 1);
+	const uint32_t numViews = max(viewsArg ? static_cast<uint32_t>(atoi(viewsArg)) : DEFAULT_NUM_VIEWS, 1u);
+	const uint32_t iterations = max(iterationsArg ? static_cast<uint32_t>(atoi(iterationsArg)) : DEFAULT_ITERATIONS, 1u);
+	const uint32_t seed = seedArg ? static_cast<uint32_t>(strtoul(seedArg, nullptr, 10)) : 0;
+	const uint32_t numFrames = max(framesArg ? static_cast<uint32_t>(atoi(framesArg)) : DEFAULT_NUM_FRAMES, 1u);
+
+	// The camera sits in the middle of the center chunk
+	ChunkCuller culler;
+	for (int32_t x = -radius; x <= radius; x++)
+	{
+		for (int32_t y = -radius; y <= radius; y++)
+		{
+			for (int32_t z = -radius; z <= radius; z++)
+			{
+				culler.Add(ChunkCoord(x, y, z));
+			}
+		}
+	}
+
+	const uint32_t numChunks = culler.GetNumChunks();
+	const DirectX::XMFLOAT3 cameraPos = { DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT };
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> yawDist(0.0f, 2.0f * 3.14159265f);
+	std::uniform_real_distribution<float> pitchDist(-1.4f, 1.4f);
+	std::vector<Headless::FrustumPlanes> views(numViews);
+	for (auto& view : views) view = Headless::BuildFrustum(cameraPos, yawDist(rng), pitchDist(rng));
+
+	printf("Culling %u chunks (%i in every direction) from %u views, %u iterations, %u chunks per batch\n\n",
+		numChunks, radius, numViews, iterations, ChunkCuller::BATCH_SIZE);
+
+	uint32_t numMismatches = CompareCulling(culler, views, "Loaded:");
+
+	// Chunks streaming in and out shuffle the arrays around. A third of the chunks go missing here and there, and
+	// every chunk on one side goes away along with its clusters
+	std::vector<ChunkCoord> removedChunks;
+	for (int32_t x = -radius; x <= radius; x++)
+	{
+		for (int32_t y = -radius; y <= radius; y++)
+		{
+			for (int32_t z = -radius; z <= radius; z++)
+			{
+				if (x <= radius / 2 && (rng() % 3) != 0) continue;
+				removedChunks.emplace_back(x, y, z);
+				culler.Remove(removedChunks.back());
+			}
+		}
+	}
+
+	numMismatches += CompareCulling(culler, views, "Removed:");
+
+	for (const auto& chunkPosCS : removedChunks) culler.Add(chunkPosCS);
+	numMismatches += CompareCulling(culler, views, "Re-added:");
+
+	// Both get their output vector's memory ahead of time, like the renderer does after the first frame
+	std::vector<ChunkCoord> visibleChunks;
+	visibleChunks.reserve(numChunks);
+
+	uint64_t numVisibleChunks = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		for (const auto& view : views)
+		{
+			visibleChunks.clear();
+			culler.CullScalar(view.data(), visibleChunks);
+			numVisibleChunks += visibleChunks.size();
+		}
+	}
+	const float scalarMs = GetElapsedMs(start) / (iterations * numViews);
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		for (const auto& view : views)
+		{
+			visibleChunks.clear();
+			culler.CullWithoutClusters(view.data(), visibleChunks);
+			numVisibleChunks += visibleChunks.size();
+		}
+	}
+	const float batchMs = GetElapsedMs(start) / (iterations * numViews);
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		for (const auto& view : views)
+		{
+			visibleChunks.clear();
+			culler.Cull(view.data(), visibleChunks);
+			numVisibleChunks += visibleChunks.size();
+		}
+	}
+	const float clusterMs = GetElapsedMs(start) / (iterations * numViews);
+
+	printf("\n%12s %14s %18s %10s\n", "culling", "per view (us)", "per chunk (ns)", "speedup");
+	printf("%12s %14.2f %18.2f %9.1fx\n", "one by one", scalarMs * 1000.0f, scalarMs * 1000000.0f / numChunks, 1.0f);
+	printf("%12s %14.2f %18.2f %9.1fx\n", "batched", batchMs * 1000.0f, batchMs * 1000000.0f / numChunks, scalarMs / batchMs);
+	printf("%12s %14.2f %18.2f %9.1fx\n", "by cluster", clusterMs * 1000.0f, clusterMs * 1000000.0f / numChunks, scalarMs / clusterMs);
+	printf("\n%.1f%% of the chunks are visible on average\n", 100.0f * numVisibleChunks / (3.0f * iterations * numViews * numChunks));
+
+	// Every chunk is loaded again by now
+	std::vector<ChunkCoord> chunks;
+	for (int32_t x = -radius; x <= radius; x++)
+	{
+		for (int32_t y = -radius; y <= radius; y++)
+		{
+			for (int32_t z = -radius; z <= radius; z++)
+			{
+				chunks.emplace_back(x, y, z);
+			}
+		}
+	}
+
+	printf("\nCoherent culling along camera paths, %u frames each. Plane tests per chunk and frame, and time per frame:\n\n", numFrames);
+	printf("%12s %12s %12s %12s %12s %12s %9s\n", "camera", "one by one", "no memory", "coherent", "cluster (us)", "coherent (us)", "differ");
+	for (const auto& path : CAMERA_PATHS) numMismatches += RunCameraPath(culler, chunks, path, numFrames);
+
+	return numMismatches == 0 ? 0 : 1;
+}
+
+void CullBenchmarkMode::PrintUsage()
+{
+	printf("  cullbench [--radius N] [--views N] [--iterations N] [--seed N] [--frames N]\n");
+	printf("      Frustum culls every chunk within N chunks of the camera from random view directions,\n");
+	printf("      one chunk at a time, in batches and by cluster, and checks that all of them find the same chunks.\n");
+	printf("      Then follows a few camera paths for N frames and counts the plane tests coherent culling saves.\n");
+}
@@ -0,0 +1,24 @@
+#ifndef _CULLBENCHMARKMODE_H
+#define _CULLBENCHMARKMODE_H
+
+#include <string>
+#include <vector>
+
+// Benchmarks frustum culling the chunks around the camera:
+//
+//		cullbench [--radius N] [--views N] [--iterations N] [--seed N] [--frames N]
+//
+// Culls every chunk within N chunks of the camera (in every direction) for a number of random view
+// directions, one chunk at a time, in batches and by cluster, and checks that all of them find the same chunks.
+// Then moves the camera along a few paths and counts how many plane tests coherent culling makes per chunk and frame
+class CullBenchmarkMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "DensityBenchmarkMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/WorldGen/DensityField.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+constexpr int32_t DEFAULT_CHUNKS_PER_AXIS = 6;
+
+// The density terrain's surface is around y = 80 to 130, so the box is centered vertically on it
+constexpr int32_t BENCHMARK_CENTER_HEIGHT = 105;
+
+int DensityBenchmarkMode::Run(const std::vector<std::string>& args)
+{
+	using Samples = DensityField::Samples<CHUNK_SIZE>;
+
+	const char* chunksArg = Headless::FindArg(args, "--chunks");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+
+	const int32_t chunksPerAxis = max(chunksArg ? atoi(chunksArg) : DEFAULT_CHUNKS_PER_AXIS, 1);
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	const NoiseContext noise = { noiseBackend, WorldNoise::GetNoiseSeed(seed) };
+
+	const ChunkCoord minCS = ChunkCoord(-chunksPerAxis / 2, BENCHMARK_CENTER_HEIGHT / CHUNK_SIZE - chunksPerAxis / 2, -chunksPerAxis / 2);
+	const uint32_t numChunks = static_cast<uint32_t>(chunksPerAxis * chunksPerAxis * chunksPerAxis);
+
+	printf("Benchmarking %u chunks (%i per axis) with seed %llu, lattice spacing of %i blocks\n\n",
+		numChunks, chunksPerAxis, seed, DensityField::LATTICE_SPACING);
+
+	std::vector<float> interpolated(static_cast<size_t>(numChunks) * Samples::VOLUME);
+	std::vector<float> fullResolution(static_cast<size_t>(numChunks) * Samples::VOLUME);
+
+	auto getChunkOrigin = [&](const uint32_t i)
+	{
+		ChunkCoord offset(i / (chunksPerAxis * chunksPerAxis), (i / chunksPerAxis) % chunksPerAxis, i % chunksPerAxis);
+		return TerrainGenerator::GetChunkNoiseOrigin(minCS + offset);
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < numChunks; i++)
+	{
+		DensityField::SampleInterpolated<CHUNK_SIZE>(getChunkOrigin(i), noise, &interpolated[static_cast<size_t>(i) * Samples::VOLUME]);
+	}
+	const float interpolatedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < numChunks; i++)
+	{
+		DensityField::SampleFullResolution<CHUNK_SIZE>(getChunkOrigin(i), noise, &fullResolution[static_cast<size_t>(i) * Samples::VOLUME]);
+	}
+	const float fullResolutionMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Only the chunk's own blocks count, the extra layer on top belongs to the chunk above
+	double squaredErrorSum = 0.0;
+	float maxError = 0.0f;
+	uint64_t numSolidMismatches = 0;
+	uint64_t numSolidBlocks = 0;
+	uint64_t numBlocks = 0;
+	for (uint32_t i = 0; i < numChunks; i++)
+	{
+		const size_t chunkOffset = static_cast<size_t>(i) * Samples::VOLUME;
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			{
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				{
+					const size_t index = chunkOffset + Samples::GetIndex(x, y, z);
+					const float error = fabsf(interpolated[index] - fullResolution[index]);
+					squaredErrorSum += static_cast<double>(error) * error;
+					maxError = max(maxError, error);
+
+					const bool isSolid = fullResolution[index] > 0.0f;
+					numSolidBlocks += isSolid ? 1 : 0;
+					numSolidMismatches += (isSolid != (interpolated[index] > 0.0f)) ? 1 : 0;
+					numBlocks++;
+				}
+			}
+		}
+	}
+
+	printf("%16s %14s %16s\n", "sampling", "total (ms)", "per chunk (us)");
+	printf("%16s %14.2f %16.2f\n", "interpolated", interpolatedMs, interpolatedMs * 1000.0f / numChunks);
+	printf("%16s %14.2f %16.2f\n", "full resolution", fullResolutionMs, fullResolutionMs * 1000.0f / numChunks);
+	printf("\nSpeedup: %.1fx\n", fullResolutionMs / max(interpolatedMs, 0.001f));
+	printf("Density error: %.4f RMS, %.4f max\n", sqrt(squaredErrorSum / numBlocks), maxError);
+	printf("Solid blocks: %llu of %llu, %llu (%.3f%%) differ from full resolution\n",
+		numSolidBlocks, numBlocks, numSolidMismatches, 100.0 * numSolidMismatches / numBlocks);
+
+	return 0;
+}
+
+void DensityBenchmarkMode::PrintUsage()
+{
+	printf("  densitybench [--chunks N] [--seed N] [--noise simplex|hash]\n");
+	printf("      Times the interpolated 3D density field against sampling every block and prints\n");
+	printf("      the interpolation error. The cube of chunks is N chunks wide (6 by default).\n");
+}
@@ -0,0 +1,24 @@
+#ifndef _DENSITYBENCHMARKMODE_H
+#define _DENSITYBENCHMARKMODE_H
+
+#include <string>
+#include <vector>
+
+// Compares the interpolated density field against sampling the noise for every block, over a
+// cube of chunks around the terrain's surface:
+//
+//		densitybench [--chunks N] [--seed N] [--noise simplex|hash]
+//
+// Prints the time per chunk of both, the error of the interpolated densities and how many
+// blocks end up solid in one but not the other
+class DensityBenchmarkMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
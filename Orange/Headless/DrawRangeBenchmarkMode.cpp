@@ -0,0 +1,231 @@
+#include "../Source/Misc/pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+
+#include "DrawRangeBenchmarkMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/ChunkCuller.h"
+#include "../Source/Core/ChunkDrawList.h"
+
+// 17^3 chunks, the game's default render distance
+constexpr int32_t DEFAULT_RADIUS = 8;
+constexpr uint32_t DEFAULT_NUM_VIEWS = 64;
+constexpr uint32_t DEFAULT_ITERATIONS = 20;
+
+// Share of the chunks that end up without any visible faces (all air or buried), and how many
+// instances the others have. Roughly what a surface world looks like
+constexpr uint32_t EMPTY_CHUNK_PERCENT = 40;
+constexpr uint32_t MIN_CHUNK_INSTANCES = 64;
+constexpr uint32_t MAX_CHUNK_INSTANCES = 1536;
+
+// Share of the chunks re-meshed (by edits, lighting or neighbors streaming in) in the second step
+constexpr uint32_t REMESHED_CHUNK_PERCENT = 25;
+
+struct ArenaChunk
+{
+	ChunkCoord posCS;
+	uint32_t startInstance;
+	uint32_t numInstances;
+};
+
+// Mirrors the game's instance buffer: a mesh is appended at the end, and removing one moves everything after it down
+class InstanceArena
+{
+public:
+
+	void Append(const ChunkCoord& chunkPosCS, const uint32_t numInstances)
+	{
+		m_indices[Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)] = static_cast<uint32_t>(m_chunks.size());
+		m_chunks.push_back({ chunkPosCS, m_numInstances, numInstances });
+		m_numInstances += numInstances;
+	}
+
+	void Remesh(const ChunkCoord& chunkPosCS)
+	{
+		const uint32_t index = m_indices.at(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS));
+		const ArenaChunk removed = m_chunks[index];
+		m_chunks.erase(m_chunks.begin() + index);
+		m_numInstances -= removed.numInstances;
+		for (uint32_t i = index; i < m_chunks.size(); i++)
+		{
+			m_chunks[i].startInstance -= removed.numInstances;
+			m_indices[Orange::Math::GetHashKeyFromChunkPosition(m_chunks[i].posCS)] = i;
+		}
+
+		Append(removed.posCS, removed.numInstances);
+	}
+
+	const ArenaChunk& Get(const ChunkCoord& chunkPosCS) const { return m_chunks[m_indices.at(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS))]; }
+
+	const uint32_t GetNumInstances() const { return m_numInstances; }
+
+private:
+
+	std::vector<ArenaChunk> m_chunks;
+	std::unordered_map<uint64_t, uint32_t> m_indices;
+	uint32_t m_numInstances = 0;
+};
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static float GetDistanceSq(const ChunkCoord& chunkPosCS, const DirectX::XMFLOAT3& cameraPos)
+{
+	const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+	const float dx = minWS.x + DefaultChunkTraits::HALF_EXTENT - cameraPos.x;
+	const float dy = minWS.y + DefaultChunkTraits::HALF_EXTENT - cameraPos.y;
+	const float dz = minWS.z + DefaultChunkTraits::HALF_EXTENT - cameraPos.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+static void FillDrawList(const InstanceArena& arena, const std::vector<ChunkCoord>& visibleChunks, const DirectX::XMFLOAT3& cameraPos, ChunkDrawList& outDrawList)
+{
+	outDrawList.Clear();
+	for (const auto& chunkPosCS : visibleChunks)
+	{
+		const ArenaChunk& chunk = arena.Get(chunkPosCS);
+		outDrawList.AddChunk(chunk.startInstance, chunk.numInstances, GetDistanceSq(chunkPosCS, cameraPos));
+	}
+	outDrawList.Build(arena.GetNumInstances());
+}
+
+// Returns false if the draws don't cover every visible instance exactly once, or if they aren't
+// sorted by their closest chunk
+static bool CheckDrawList(const InstanceArena& arena, const std::vector<ChunkCoord>& visibleChunks, const DirectX::XMFLOAT3& cameraPos, const ChunkDrawList& drawList)
+{
+	std::vector<uint8_t> numDraws(arena.GetNumInstances(), 0);
+	for (const auto& range : drawList.GetRanges())
+	{
+		for (uint32_t i = range.startInstance; i < range.startInstance + range.numInstances; i++) numDraws[i]++;
+	}
+
+	// Which draw every visible chunk is in, found by the draws' starts
+	const auto& ranges = drawList.GetRanges();
+	std::vector<std::pair<uint32_t, uint32_t>> rangeStarts;
+	for (uint32_t i = 0; i < ranges.size(); i++) rangeStarts.emplace_back(ranges[i].startInstance, i);
+	std::sort(rangeStarts.begin(), rangeStarts.end());
+
+	std::vector<float> closestDistanceSq(ranges.size(), FLT_MAX);
+	for (const auto& chunkPosCS : visibleChunks)
+	{
+		const ArenaChunk& chunk = arena.Get(chunkPosCS);
+		for (uint32_t i = chunk.startInstance; i < chunk.startInstance + chunk.numInstances; i++)
+		{
+			if (numDraws[i] != 1) return false;
+			numDraws[i] = 0;
+		}
+		if (chunk.numInstances == 0) continue;
+
+		const auto it = std::upper_bound(rangeStarts.begin(), rangeStarts.end(), std::make_pair(chunk.startInstance, UINT32_MAX)) - 1;
+		closestDistanceSq[it->second] = min(closestDistanceSq[it->second], GetDistanceSq(chunkPosCS, cameraPos));
+	}
+
+	// Anything left was drawn without being visible
+	if (std::any_of(numDraws.begin(), numDraws.end(), [](const uint8_t count) { return count != 0; })) return false;
+
+	return std::is_sorted(closestDistanceSq.begin(), closestDistanceSq.end());
+}
+
+// Returns the number of views whose draw list was wrong
+static uint32_t RunStep(const char* stepName, const InstanceArena& arena, const ChunkCuller& culler, const std::vector<Headless::FrustumPlanes>& views,
+	const DirectX::XMFLOAT3& cameraPos, const uint32_t iterations)
+{
+	std::vector<std::vector<ChunkCoord>> visibleChunks(views.size());
+	for (uint32_t i = 0; i < views.size(); i++) culler.Cull(views[i].data(), visibleChunks[i]);
+
+	ChunkDrawList drawList;
+	uint32_t numMismatches = 0;
+	uint64_t numChunks = 0, numDraws = 0, numInstances = 0;
+	for (uint32_t i = 0; i < views.size(); i++)
+	{
+		FillDrawList(arena, visibleChunks[i], cameraPos, drawList);
+		numMismatches += CheckDrawList(arena, visibleChunks[i], cameraPos, drawList) ? 0 : 1;
+		numChunks += drawList.GetNumChunks();
+		numDraws += drawList.GetRanges().size();
+		numInstances += drawList.GetNumInstances();
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		for (uint32_t i = 0; i < views.size(); i++) FillDrawList(arena, visibleChunks[i], cameraPos, drawList);
+	}
+	const float buildMs = GetElapsedMs(start) / (iterations * views.size());
+
+	printf("%-12s %10.1f %10.1f %9.1fx %12.0f %12.2f %8u\n", stepName, static_cast<float>(numChunks) / views.size(), static_cast<float>(numDraws) / views.size(),
+		static_cast<float>(numChunks) / max(numDraws, static_cast<uint64_t>(1)), static_cast<float>(numInstances) / views.size(), buildMs * 1000.0f, numMismatches);
+	return numMismatches;
+}
+
+int DrawRangeBenchmarkMode::Run(const std::vector<std::string>& args)
+{
+	const char* radiusArg = Headless::FindArg(args, "--radius");
+	const char* viewsArg = Headless::FindArg(args, "--views");
+	const char* iterationsArg = Headless::FindArg(args, "--iterations");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+
+	const int32_t radius = max(radiusArg ? atoi(radiusArg) : DEFAULT_RADIUS, 1);
+	const uint32_t numViews = max(viewsArg ? static_cast<uint32_t>(atoi(viewsArg)) : DEFAULT_NUM_VIEWS, 1u);
+	const uint32_t iterations = max(iterationsArg ? static_cast<uint32_t>(atoi(iterationsArg)) : DEFAULT_ITERATIONS, 1u);
+	const uint32_t seed = seedArg ? static_cast<uint32_t>(strtoul(seedArg, nullptr, 10)) : 0;
+
+	// The game loads the closest chunks first
+	std::vector<ChunkCoord> chunks;
+	for (int32_t x = -radius; x <= radius; x++)
+	{
+		for (int32_t y = -radius; y <= radius; y++)
+		{
+			for (int32_t z = -radius; z <= radius; z++)
+			{
+				chunks.emplace_back(x, y, z);
+			}
+		}
+	}
+	std::stable_sort(chunks.begin(), chunks.end(), [](const ChunkCoord& a, const ChunkCoord& b)
+	{
+		return a.x * a.x + a.y * a.y + a.z * a.z < b.x * b.x + b.y * b.y + b.z * b.z;
+	});
+
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<uint32_t> instanceDist(MIN_CHUNK_INSTANCES, MAX_CHUNK_INSTANCES);
+	InstanceArena arena;
+	ChunkCuller culler;
+	for (const auto& chunkPosCS : chunks)
+	{
+		arena.Append(chunkPosCS, (rng() % 100) < EMPTY_CHUNK_PERCENT ? 0 : instanceDist(rng));
+		culler.Add(chunkPosCS);
+	}
+
+	const DirectX::XMFLOAT3 cameraPos = { DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT };
+	std::uniform_real_distribution<float> yawDist(0.0f, 2.0f * 3.14159265f);
+	std::uniform_real_distribution<float> pitchDist(-1.4f, 1.4f);
+	std::vector<Headless::FrustumPlanes> views(numViews);
+	for (auto& view : views) view = Headless::BuildFrustum(cameraPos, yawDist(rng), pitchDist(rng));
+
+	printf("Building draw lists for %zu chunks (%i in every direction, %u instances) from %u views, %u iterations\n\n",
+		chunks.size(), radius, arena.GetNumInstances(), numViews, iterations);
+	printf("%-12s %10s %10s %10s %12s %12s %8s\n", "layout", "chunks", "draws", "merged", "instances", "build (us)", "wrong");
+
+	uint32_t numMismatches = RunStep("Load order:", arena, culler, views, cameraPos, iterations);
+
+	for (const auto& chunkPosCS : chunks)
+	{
+		if ((rng() % 100) < REMESHED_CHUNK_PERCENT) arena.Remesh(chunkPosCS);
+	}
+	numMismatches += RunStep("Re-meshed:", arena, culler, views, cameraPos, iterations);
+
+	printf("\n%u views with a wrong draw list\n", numMismatches);
+	return numMismatches == 0 ? 0 : 1;
+}
+
+void DrawRangeBenchmarkMode::PrintUsage()
+{
+	printf("  drawrangebench [--radius N] [--views N] [--iterations N] [--seed N]\n");
+	printf("      Builds the draw ranges of the chunks visible from random view directions, with the meshes laid out\n");
+	printf("      in load order and again after re-meshing some of them, and checks every visible instance is drawn once.\n");
+}
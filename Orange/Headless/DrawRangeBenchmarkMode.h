@@ -0,0 +1,25 @@
+#ifndef _DRAWRANGEBENCHMARKMODE_H
+#define _DRAWRANGEBENCHMARKMODE_H
+
+#include <string>
+#include <vector>
+
+// Benchmarks building the per-frame draw ranges from the visible chunks:
+//
+//		drawrangebench [--radius N] [--views N] [--iterations N] [--seed N]
+//
+// Lays the meshes of every chunk within N chunks of the camera out in an instance buffer in the order the game loads
+// them, culls them from random view directions and builds the draw list for every view. Then re-meshes a share of the
+// chunks (which moves their instances to the end of the buffer) and does it again. Checks that every visible instance
+// is drawn exactly once and that the draws come out front to back
+class DrawRangeBenchmarkMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
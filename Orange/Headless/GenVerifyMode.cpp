@@ -0,0 +1,172 @@
+#include "../Source/Misc/pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include "GenVerifyMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+// Covers the surface of every biome, and so the trees on it, by default
+constexpr ChunkCoord DEFAULT_MIN_CS = ChunkCoord(-4, 3, -4);
+constexpr ChunkCoord DEFAULT_MAX_CS = ChunkCoord(3, 12, 3);
+
+// The shuffle only has to be different from the in-order pass, not random
+constexpr uint32_t SHUFFLE_SEED = 1234;
+
+// Generates every chunk in the box into "outBlockTypes" (BLOCKS_PER_CHUNK per chunk, in the box's
+// x, y, z order), handing out the chunks in "order" to "numThreads" threads
+static void GenerateBox(const ChunkCoord& minCS, const ChunkCoord& maxCS, const std::vector<uint32_t>& order, const uint32_t numThreads, std::vector<BlockType>& outBlockTypes)
+{
+	const int32_t sizeY = maxCS.y - minCS.y + 1;
+	const int32_t sizeZ = maxCS.z - minCS.z + 1;
+	auto toChunkIndex = [&](const ChunkCoord& chunkPosCS)
+	{
+		return static_cast<uint32_t>(((chunkPosCS.x - minCS.x) * sizeY + (chunkPosCS.y - minCS.y)) * sizeZ + (chunkPosCS.z - minCS.z));
+	};
+
+	// Starts from a clean slate, which also drops the writes from the previous pass
+	TerrainGenerator::SetSeed(TerrainGenerator::GetSeed());
+
+	outBlockTypes.assign(order.size() * BLOCKS_PER_CHUNK, BlockType::Air);
+
+	std::atomic<uint32_t> nextOrderIndex = 0;
+	auto generateChunks = [&]()
+	{
+		for (uint32_t i = nextOrderIndex++; i < order.size(); i = nextOrderIndex++)
+		{
+			const uint32_t chunkIndex = order[i];
+			const ChunkCoord chunkPosCS(
+				minCS.x + static_cast<int32_t>(chunkIndex / (sizeY * sizeZ)),
+				minCS.y + static_cast<int32_t>((chunkIndex / sizeZ) % sizeY),
+				minCS.z + static_cast<int32_t>(chunkIndex % sizeZ));
+
+			TerrainGenerator::GenerateChunk(chunkPosCS, &outBlockTypes[static_cast<size_t>(chunkIndex) * BLOCKS_PER_CHUNK]);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		threads.emplace_back(generateChunks);
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Writes to chunks that were generated before the writing chunk, same as ChunkManager does with loaded chunks
+	std::vector<PendingBlockWrite> lateWrites;
+	TerrainGenerator::GetPipeline().GetPendingWrites().TakeLateWrites(lateWrites);
+	for (const auto& write : lateWrites)
+	{
+		BlockType& block = outBlockTypes[static_cast<size_t>(toChunkIndex(write.targetCS)) * BLOCKS_PER_CHUNK + write.index];
+		block = PendingWriteStore::MergeBlock(block, write.type);
+	}
+}
+
+int GenVerifyMode::Run(const std::vector<std::string>& args)
+{
+	ChunkCoord minCS = DEFAULT_MIN_CS;
+	ChunkCoord maxCS = DEFAULT_MAX_CS;
+
+	const char* minArg = Headless::FindArg(args, "--min");
+	const char* maxArg = Headless::FindArg(args, "--max");
+	if ((minArg || maxArg) &&
+		(!Headless::ParseCoord(minArg, minCS.x, minCS.y, minCS.z) || !Headless::ParseCoord(maxArg, maxCS.x, maxCS.y, maxCS.z)))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (minCS.x > maxCS.x) std::swap(minCS.x, maxCS.x);
+	if (minCS.y > maxCS.y) std::swap(minCS.y, maxCS.y);
+	if (minCS.z > maxCS.z) std::swap(minCS.z, maxCS.z);
+
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	TerrainShape terrainShape;
+	if (!Headless::ParseTerrainShape(Headless::FindArg(args, "--terrain"), terrainShape))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const char* threadsArg = Headless::FindArg(args, "--threads");
+	uint32_t numThreads = threadsArg ? static_cast<uint32_t>(atoi(threadsArg)) : std::thread::hardware_concurrency();
+	numThreads = max(numThreads, 2u);
+
+	const uint32_t numChunks = static_cast<uint32_t>((maxCS.x - minCS.x + 1) * (maxCS.y - minCS.y + 1) * (maxCS.z - minCS.z + 1));
+
+	printf("Verifying %u chunks from (%i, %i, %i) to (%i, %i, %i) with seed %llu, 1 thread vs. %u threads\n",
+		numChunks, minCS.x, minCS.y, minCS.z, maxCS.x, maxCS.y, maxCS.z, seed, numThreads);
+
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetTerrainShape(terrainShape);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	std::vector<uint32_t> order(numChunks);
+	for (uint32_t i = 0; i < numChunks; i++) order[i] = i;
+
+	std::vector<BlockType> referenceBlocks;
+	GenerateBox(minCS, maxCS, order, 1, referenceBlocks);
+
+	std::shuffle(order.begin(), order.end(), std::mt19937(SHUFFLE_SEED));
+
+	std::vector<BlockType> shuffledBlocks;
+	GenerateBox(minCS, maxCS, order, numThreads, shuffledBlocks);
+
+	uint32_t numFeatureBlocks = 0;
+	uint32_t numMismatchedBlocks = 0;
+	uint32_t numMismatchedChunks = 0;
+	for (uint32_t chunkIndex = 0; chunkIndex < numChunks; chunkIndex++)
+	{
+		bool isChunkMismatched = false;
+		for (uint32_t i = chunkIndex * BLOCKS_PER_CHUNK; i < (chunkIndex + 1) * BLOCKS_PER_CHUNK; i++)
+		{
+			if (referenceBlocks[i] == BlockType::Leaves || referenceBlocks[i] == BlockType::Wood) numFeatureBlocks++;
+			if (referenceBlocks[i] == shuffledBlocks[i]) continue;
+
+			if (numMismatchedBlocks == 0)
+			{
+				printf("First mismatch in chunk #%u, block #%u: %u vs. %u\n", chunkIndex, i - chunkIndex * BLOCKS_PER_CHUNK,
+					static_cast<uint32_t>(referenceBlocks[i]), static_cast<uint32_t>(shuffledBlocks[i]));
+			}
+
+			numMismatchedBlocks++;
+			isChunkMismatched = true;
+		}
+
+		if (isChunkMismatched) numMismatchedChunks++;
+	}
+
+	printf("%u tree blocks, %u chunks tracked by the pending-write store\n",
+		numFeatureBlocks, TerrainGenerator::GetPipeline().GetPendingWrites().GetNumTargetChunks());
+
+	if (numMismatchedBlocks > 0)
+	{
+		printf("FAILED: %u blocks in %u chunks differ\n", numMismatchedBlocks, numMismatchedChunks);
+		return 1;
+	}
+
+	printf("OK: both passes generated the same blocks\n");
+	return 0;
+}
+
+void GenVerifyMode::PrintUsage()
+{
+	printf("  genverify [--min x,y,z --max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash] [--threads N]\n");
+	printf("      Generates the box on one thread and then shuffled on several, and compares the blocks.\n");
+}
@@ -0,0 +1,24 @@
+#ifndef _GENVERIFYMODE_H
+#define _GENVERIFYMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks that the world doesn't depend on how it's generated. The box of chunks (in CHUNK SPACE) is
+// generated twice, first in order on a single thread and then shuffled across several threads,
+// and the two results are compared block by block:
+//
+//		genverify [--min x,y,z --max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash] [--threads N]
+//
+// Returns 1 if any block differs. Features that cross chunk borders (trees) are what this is for
+class GenVerifyMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
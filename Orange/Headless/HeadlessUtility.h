@@ -0,0 +1,152 @@
+#ifndef _HEADLESSUTILITY_H
+#define _HEADLESSUTILITY_H
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../Source/Core/Physics.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+#if defined(OG_WINDOWS)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Small helpers shared between the headless modes
+
+namespace Headless
+{
+	// Returns the value following "name" (e.g. "--seed 42"), or nullptr if the argument wasn't passed
+	inline const char* FindArg(const std::vector<std::string>& args, const char* name)
+	{
+		for (size_t i = 0; i + 1 < args.size(); i++)
+		{
+			if (args[i] == name) return args[i + 1].c_str();
+		}
+
+		return nullptr;
+	}
+
+	// Returns true if the flag "name" (e.g. "--verbose") was passed
+	inline bool HasFlag(const std::vector<std::string>& args, const char* name)
+	{
+		for (const auto& arg : args)
+		{
+			if (arg == name) return true;
+		}
+
+		return false;
+	}
+
+	// Parses "x,y,z". Returns false if the string isn't three comma-separated integers
+	inline bool ParseCoord(const char* str, int32_t& outX, int32_t& outY, int32_t& outZ)
+	{
+		if (!str) return false;
+
+		int32_t* outValues[3] = { &outX, &outY, &outZ };
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			char* end;
+			*outValues[i] = static_cast<int32_t>(strtol(str, &end, 10));
+			if (end == str || *end != (i < 2 ? ',' : '\0')) return false;
+			str = end + 1;
+		}
+
+		return true;
+	}
+
+	// Parses "heightmap" or "density". A missing argument is the heightmap
+	inline bool ParseTerrainShape(const char* str, TerrainShape& outShape)
+	{
+		const std::string shape = str ? str : "heightmap";
+		if (shape == "heightmap") outShape = TerrainShape::HEIGHTMAP;
+		else if (shape == "density") outShape = TerrainShape::DENSITY;
+		else return false;
+
+		return true;
+	}
+
+	// Parses "simplex" or "hash". A missing argument is simplex
+	inline bool ParseNoiseBackend(const char* str, NoiseBackend& outBackend)
+	{
+		const std::string backend = str ? str : "simplex";
+		if (backend == "simplex") outBackend = NoiseBackend::SIMPLEX;
+		else if (backend == "hash") outBackend = NoiseBackend::HASH;
+		else return false;
+
+		return true;
+	}
+
+	// Same projection as the game's camera (see Graphics)
+	constexpr float CAMERA_FOV = 3.14159265f / 4.0f;
+	constexpr float CAMERA_ASPECT_RATIO = 16.0f / 9.0f;
+	constexpr float CAMERA_NEAR_PLANE = 0.1f;
+	constexpr float CAMERA_FAR_PLANE = 1000.0f;
+
+	// Left, right, top, bottom, front and back, with their normals pointing inwards
+	using FrustumPlanes = std::array<Orange::Plane, 6>;
+
+	inline DirectX::XMFLOAT3 Normalize(const DirectX::XMFLOAT3& v)
+	{
+		const float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+		return { v.x / length, v.y / length, v.z / length };
+	}
+
+	// A plane through "point" whose normal is "forward * forwardScale + side", pointing into the frustum
+	inline Orange::Plane MakePlane(const DirectX::XMFLOAT3& point, const DirectX::XMFLOAT3& forward, const float forwardScale, const DirectX::XMFLOAT3& side)
+	{
+		Orange::Plane plane;
+		plane.normal = Normalize({ forward.x * forwardScale + side.x, forward.y * forwardScale + side.y, forward.z * forwardScale + side.z });
+		plane.point = plane.normal.x * point.x + plane.normal.y * point.y + plane.normal.z * point.z;
+		return plane;
+	}
+
+	// Same frustum FrustumCulling::CalculateFrustum() builds, straight from the view direction
+	inline FrustumPlanes BuildFrustum(const DirectX::XMFLOAT3& cameraPos, const float yaw, const float pitch)
+	{
+		const DirectX::XMFLOAT3 forward = { cosf(pitch) * sinf(yaw), sinf(pitch), cosf(pitch) * cosf(yaw) };
+		const DirectX::XMFLOAT3 right = Normalize({ forward.z, 0.0f, -forward.x });
+		const DirectX::XMFLOAT3 up = { forward.y * right.z - forward.z * right.y, forward.z * right.x - forward.x * right.z, forward.x * right.y - forward.y * right.x };
+		const DirectX::XMFLOAT3 back = { -forward.x, -forward.y, -forward.z };
+		const DirectX::XMFLOAT3 left = { -right.x, -right.y, -right.z };
+		const DirectX::XMFLOAT3 down = { -up.x, -up.y, -up.z };
+		const DirectX::XMFLOAT3 none = { 0.0f, 0.0f, 0.0f };
+
+		const float tanHalfHeight = tanf(CAMERA_FOV / 2.0f);
+		const float tanHalfWidth = tanHalfHeight * CAMERA_ASPECT_RATIO;
+
+		const DirectX::XMFLOAT3 nearPoint = { cameraPos.x + forward.x * CAMERA_NEAR_PLANE, cameraPos.y + forward.y * CAMERA_NEAR_PLANE, cameraPos.z + forward.z * CAMERA_NEAR_PLANE };
+		const DirectX::XMFLOAT3 farPoint = { cameraPos.x + forward.x * CAMERA_FAR_PLANE, cameraPos.y + forward.y * CAMERA_FAR_PLANE, cameraPos.z + forward.z * CAMERA_FAR_PLANE };
+
+		return
+		{
+			MakePlane(cameraPos, forward, tanHalfWidth, right),		// left
+			MakePlane(cameraPos, forward, tanHalfWidth, left),		// right
+			MakePlane(cameraPos, forward, tanHalfHeight, down),		// top
+			MakePlane(cameraPos, forward, tanHalfHeight, up),		// bottom
+			MakePlane(nearPoint, forward, 1.0f, none),				// front
+			MakePlane(farPoint, back, 1.0f, none)					// back
+		};
+	}
+
+	// Returns the process' peak working set, in bytes
+	inline uint64_t GetPeakMemoryUsage()
+	{
+#if defined(OG_WINDOWS)
+		PROCESS_MEMORY_COUNTERS memoryCounters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters))) return 0;
+		return static_cast<uint64_t>(memoryCounters.PeakWorkingSetSize);
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+	}
+}
+
+#endif
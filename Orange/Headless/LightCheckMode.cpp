@@ -0,0 +1,468 @@
+#include "../Source/Misc/pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "LightCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/BlockRegistry.h"
+#include "../Source/Core/ChunkLayout.h"
+#include "../Source/Core/LightEngine.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+// Covers the surface of every biome by default, along with the caves below it
+constexpr ChunkCoord DEFAULT_MIN_CS = ChunkCoord(-3, 2, -3);
+constexpr ChunkCoord DEFAULT_MAX_CS = ChunkCoord(2, 9, 2);
+
+constexpr uint32_t DEFAULT_NUM_EDITS = 2000;
+
+// How many mismatches are printed before only counting them
+constexpr uint32_t MAX_PRINTED_MISMATCHES = 10;
+
+// Every n-th chunk of the loading order is unloaded and loaded back in
+constexpr uint32_t UNLOAD_STRIDE = 4;
+
+// The random edits dig out blocks as often as they place any other kind of block
+static const BlockType EDIT_BLOCK_TYPES[] = { BlockType::Air, BlockType::Air, BlockType::Air, BlockType::Dirt, BlockType::Stone, BlockType::Wood, BlockType::Leaves };
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A box of chunks, any of which can be loaded or not. Blocks and light are laid out as ChunkBlockLayout says, like in Chunk
+class BoxLightWorld : public LightWorld
+{
+public:
+
+	BoxLightWorld(const ChunkCoord& minCS, const ChunkCoord& maxCS) :
+		m_minCS(minCS), m_sizeX(maxCS.x - minCS.x + 1), m_sizeY(maxCS.y - minCS.y + 1), m_sizeZ(maxCS.z - minCS.z + 1),
+		m_blocks(static_cast<size_t>(GetNumChunks()) * BLOCKS_PER_CHUNK), m_light(m_blocks.size(), 0), m_isLoaded(GetNumChunks(), 0)
+	{
+	}
+
+	bool GetChunk(const ChunkCoord& chunkPosCS, LightChunkView& outView) override
+	{
+		uint32_t chunkIndex;
+		if (!GetChunkIndex(chunkPosCS, chunkIndex) || !m_isLoaded[chunkIndex]) return false;
+
+		outView = GetView(chunkIndex);
+		return true;
+	}
+
+	uint32_t GetNumChunks() const { return static_cast<uint32_t>(m_sizeX * m_sizeY * m_sizeZ); }
+
+	// Chunks are numbered in the box's x, y, z order
+	ChunkCoord GetChunkPos(const uint32_t chunkIndex) const
+	{
+		return ChunkCoord(
+			m_minCS.x + static_cast<int32_t>(chunkIndex) / (m_sizeY * m_sizeZ),
+			m_minCS.y + (static_cast<int32_t>(chunkIndex) / m_sizeZ) % m_sizeY,
+			m_minCS.z + static_cast<int32_t>(chunkIndex) % m_sizeZ);
+	}
+
+	// Returns false if the chunk is outside the box
+	bool GetChunkIndex(const ChunkCoord& chunkPosCS, uint32_t& outIndex) const
+	{
+		const int32_t x = chunkPosCS.x - m_minCS.x;
+		const int32_t y = chunkPosCS.y - m_minCS.y;
+		const int32_t z = chunkPosCS.z - m_minCS.z;
+		if (x < 0 || y < 0 || z < 0 || x >= m_sizeX || y >= m_sizeY || z >= m_sizeZ) return false;
+
+		outIndex = static_cast<uint32_t>((x * m_sizeY + y) * m_sizeZ + z);
+		return true;
+	}
+
+	LightChunkView GetView(const uint32_t chunkIndex)
+	{
+		const size_t offset = static_cast<size_t>(chunkIndex) * BLOCKS_PER_CHUNK;
+		return { &m_blocks[offset], &m_light[offset] };
+	}
+
+	bool IsLoaded(const uint32_t chunkIndex) const { return m_isLoaded[chunkIndex] != 0; }
+	void SetLoaded(const uint32_t chunkIndex, const bool isLoaded) { m_isLoaded[chunkIndex] = isLoaded ? 1 : 0; }
+
+	// Returns false if the block's chunk isn't loaded
+	bool FindBlock(const BlockCoord& posBS, size_t& outIndex) const
+	{
+		uint32_t chunkIndex;
+		if (!GetChunkIndex(Orange::Math::BlockToChunkCoord(posBS), chunkIndex) || !m_isLoaded[chunkIndex]) return false;
+
+		const BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+		outIndex = static_cast<size_t>(chunkIndex) * BLOCKS_PER_CHUNK + ChunkBlockLayout::GetIndex(localPos.x, localPos.y, localPos.z);
+		return true;
+	}
+
+	BlockType GetBlockType(const size_t index) const { return m_blocks[index].GetType(); }
+	void SetBlockType(const size_t index, const BlockType type) { m_blocks[index].SetType(type); }
+	uint8_t GetLight(const size_t index) const { return m_light[index]; }
+
+	// Generates the chunk, in [x][y][z] order like the generator hands it out
+	void SetChunkBlocks(const uint32_t chunkIndex, const BlockType* blockTypes)
+	{
+		const LightChunkView view = GetView(chunkIndex);
+		Block* blocks = const_cast<Block*>(view.blocks);
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			{
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				{
+					blocks[ChunkBlockLayout::GetIndex(x, y, z)].SetType(blockTypes[ChunkTraits<CHUNK_SIZE>::GetIndex(x, y, z)]);
+				}
+			}
+		}
+	}
+
+	// Same as Chunk::ComputeLight(). Only touches the chunk's own arrays, so any thread can light any chunk
+	void ComputeLight(const uint32_t chunkIndex)
+	{
+		BlockType blockTypes[BLOCKS_PER_CHUNK];
+		uint8_t light[BLOCKS_PER_CHUNK];
+
+		const LightChunkView view = GetView(chunkIndex);
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			{
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				{
+					blockTypes[ChunkTraits<CHUNK_SIZE>::GetIndex(x, y, z)] = view.blocks[ChunkBlockLayout::GetIndex(x, y, z)].GetType();
+				}
+			}
+		}
+
+		LightEngine::ComputeChunkLight<CHUNK_SIZE>(blockTypes, light);
+
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			{
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				{
+					view.light[ChunkBlockLayout::GetIndex(x, y, z)] = light[ChunkTraits<CHUNK_SIZE>::GetIndex(x, y, z)];
+				}
+			}
+		}
+	}
+
+	int32_t GetSizeX() const { return m_sizeX; }
+	int32_t GetSizeY() const { return m_sizeY; }
+	int32_t GetSizeZ() const { return m_sizeZ; }
+
+private:
+
+	ChunkCoord m_minCS;
+	int32_t m_sizeX;
+	int32_t m_sizeY;
+	int32_t m_sizeZ;
+
+	std::vector<Block> m_blocks;
+	std::vector<uint8_t> m_light;
+	std::vector<uint8_t> m_isLoaded;
+};
+
+// Lights every loaded block of the box from scratch with one flood fill per channel, following the same
+// rules as the light engine but nothing else of it. "outLevels" is indexed like BoxLightWorld's blocks
+static void ComputeReferenceLight(const BoxLightWorld& world, const LightChannel channel, std::vector<uint8_t>& outLevels)
+{
+	static const BlockCoord NEIGHBOR_OFFSETS[] =
+	{
+		BlockCoord(-1, 0, 0), BlockCoord(1, 0, 0), BlockCoord(0, -1, 0),
+		BlockCoord(0, 1, 0), BlockCoord(0, 0, -1), BlockCoord(0, 0, 1)
+	};
+
+	outLevels.assign(static_cast<size_t>(world.GetNumChunks()) * BLOCKS_PER_CHUNK, 0);
+
+	std::vector<BlockCoord> queue;
+	for (uint32_t chunkIndex = 0; chunkIndex < world.GetNumChunks(); chunkIndex++)
+	{
+		if (!world.IsLoaded(chunkIndex)) continue;
+
+		const ChunkCoord chunkPosCS = world.GetChunkPos(chunkIndex);
+		const BlockCoord minBS = Orange::Math::ChunkToBlockCoord(chunkPosCS);
+
+		uint32_t aboveIndex;
+		const bool isOpenToSky = !world.GetChunkIndex(chunkPosCS + ChunkCoord(0, 1, 0), aboveIndex) || !world.IsLoaded(aboveIndex);
+
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			{
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				{
+					const BlockCoord posBS = minBS + BlockCoord(x, y, z);
+					size_t index;
+					world.FindBlock(posBS, index);
+
+					const BlockType type = world.GetBlockType(index);
+					uint8_t level = 0;
+					if (channel == LightChannel::BLOCK) level = BlockRegistry::GetLightEmission(type);
+					else if (isOpenToSky && y == CHUNK_SIZE - 1 && !BlockRegistry::IsOpaque(type)) level = MAX_LIGHT_LEVEL;
+
+					if (level == 0) continue;
+
+					outLevels[index] = level;
+					queue.push_back(posBS);
+				}
+			}
+		}
+	}
+
+	for (size_t head = 0; head < queue.size(); head++)
+	{
+		const BlockCoord posBS = queue[head];
+		size_t index;
+		world.FindBlock(posBS, index);
+		const uint8_t level = outLevels[index];
+
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			const BlockCoord neighborPosBS = posBS + NEIGHBOR_OFFSETS[i];
+			size_t neighborIndex;
+			if (!world.FindBlock(neighborPosBS, neighborIndex) || BlockRegistry::IsOpaque(world.GetBlockType(neighborIndex))) continue;
+
+			// Full strength sky light goes straight down for free
+			const bool isFreeFall = channel == LightChannel::SKY && i == 2 && level == MAX_LIGHT_LEVEL;
+			const uint8_t neighborLevel = isFreeFall ? level : level - 1;
+			if (outLevels[neighborIndex] >= neighborLevel) continue;
+
+			outLevels[neighborIndex] = neighborLevel;
+			queue.push_back(neighborPosBS);
+		}
+	}
+}
+
+// Compares the light of every loaded block against lighting the box from scratch. Returns the number of mismatches
+static uint64_t CompareLight(const BoxLightWorld& world, const char* stepName)
+{
+	const LightChannel channels[] = { LightChannel::SKY, LightChannel::BLOCK };
+	const char* channelNames[] = { "sky", "block" };
+
+	uint64_t numMismatches = 0;
+	std::vector<uint8_t> referenceLevels;
+	for (uint32_t c = 0; c < 2; c++)
+	{
+		ComputeReferenceLight(world, channels[c], referenceLevels);
+
+		for (uint32_t chunkIndex = 0; chunkIndex < world.GetNumChunks(); chunkIndex++)
+		{
+			if (!world.IsLoaded(chunkIndex)) continue;
+
+			const BlockCoord minBS = Orange::Math::ChunkToBlockCoord(world.GetChunkPos(chunkIndex));
+			for (int32_t x = 0; x < CHUNK_SIZE; x++)
+			{
+				for (int32_t y = 0; y < CHUNK_SIZE; y++)
+				{
+					for (int32_t z = 0; z < CHUNK_SIZE; z++)
+					{
+						const BlockCoord posBS = minBS + BlockCoord(x, y, z);
+						size_t index;
+						world.FindBlock(posBS, index);
+
+						const uint8_t level = LightEngine::GetLevel(world.GetLight(index), channels[c]);
+						if (level == referenceLevels[index]) continue;
+
+						if (numMismatches < MAX_PRINTED_MISMATCHES)
+						{
+							printf("  %s light of block (%i, %i, %i) is %u, should be %u\n", channelNames[c],
+								posBS.x, posBS.y, posBS.z, static_cast<uint32_t>(level), static_cast<uint32_t>(referenceLevels[index]));
+						}
+						numMismatches++;
+					}
+				}
+			}
+		}
+	}
+
+	printf("%-10s %llu mismatches\n", stepName, numMismatches);
+	return numMismatches;
+}
+
+int LightCheckMode::Run(const std::vector<std::string>& args)
+{
+	ChunkCoord minCS = DEFAULT_MIN_CS;
+	ChunkCoord maxCS = DEFAULT_MAX_CS;
+
+	const char* minArg = Headless::FindArg(args, "--min");
+	const char* maxArg = Headless::FindArg(args, "--max");
+	if ((minArg && !Headless::ParseCoord(minArg, minCS.x, minCS.y, minCS.z)) ||
+		(maxArg && !Headless::ParseCoord(maxArg, maxCS.x, maxCS.y, maxCS.z)))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (minCS.x > maxCS.x) std::swap(minCS.x, maxCS.x);
+	if (minCS.y > maxCS.y) std::swap(minCS.y, maxCS.y);
+	if (minCS.z > maxCS.z) std::swap(minCS.z, maxCS.z);
+
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	TerrainShape terrainShape;
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseTerrainShape(Headless::FindArg(args, "--terrain"), terrainShape) ||
+		!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const char* definitionsArg = Headless::FindArg(args, "--definitions");
+	const char* editsArg = Headless::FindArg(args, "--edits");
+	const uint32_t numEdits = editsArg ? static_cast<uint32_t>(atoi(editsArg)) : DEFAULT_NUM_EDITS;
+
+	const char* threadsArg = Headless::FindArg(args, "--threads");
+	uint32_t numThreads = threadsArg ? static_cast<uint32_t>(atoi(threadsArg)) : std::thread::hardware_concurrency();
+	numThreads = max(numThreads, 1u);
+
+	BlockRegistry::Initialize(definitionsArg ? definitionsArg : "../Source/Data/BlockDefinitions.txt");
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetTerrainShape(terrainShape);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	BoxLightWorld world(minCS, maxCS);
+	const uint32_t numChunks = world.GetNumChunks();
+
+	printf("Checking %u chunks from (%i, %i, %i) to (%i, %i, %i) with seed %llu, %u edits on %u threads\n",
+		numChunks, minCS.x, minCS.y, minCS.z, maxCS.x, maxCS.y, maxCS.z, seed, numEdits, numThreads);
+
+	bool hasEmitters = false;
+	for (uint32_t i = 0; i < NUM_BLOCKS; i++) hasEmitters |= BlockRegistry::GetLightEmission(static_cast<BlockType>(i)) > 0;
+	if (!hasEmitters) printf("No block emits light, so only sky light is checked\n");
+	printf("\n");
+
+	// 1. Generating and lighting every chunk on its own, like the chunk loader threads do
+	auto runOnThreads = [&](auto&& processChunk)
+	{
+		std::atomic<uint32_t> nextChunkIndex = 0;
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&]()
+			{
+				for (uint32_t i = nextChunkIndex++; i < numChunks; i = nextChunkIndex++) processChunk(i);
+			});
+		}
+
+		for (auto& thread : threads) thread.join();
+	};
+
+	runOnThreads([&](const uint32_t chunkIndex)
+	{
+		BlockType blockTypes[BLOCKS_PER_CHUNK];
+		TerrainGenerator::GenerateChunk(world.GetChunkPos(chunkIndex), blockTypes);
+		world.SetChunkBlocks(chunkIndex, blockTypes);
+	});
+
+	auto start = std::chrono::steady_clock::now();
+	runOnThreads([&](const uint32_t chunkIndex) { world.ComputeLight(chunkIndex); });
+	const float computeMs = GetElapsedMs(start);
+
+	// 2. Loading them in a random order
+	std::mt19937 rng(static_cast<uint32_t>(seed));
+	std::vector<uint32_t> loadOrder(numChunks);
+	for (uint32_t i = 0; i < numChunks; i++) loadOrder[i] = i;
+	std::shuffle(loadOrder.begin(), loadOrder.end(), rng);
+
+	std::vector<ChunkCoord> changedChunks;
+	uint64_t numStitchChanges = 0;
+	start = std::chrono::steady_clock::now();
+	for (const uint32_t chunkIndex : loadOrder)
+	{
+		world.SetLoaded(chunkIndex, true);
+		LightEngine::StitchChunk(world, world.GetChunkPos(chunkIndex), changedChunks);
+		numStitchChanges += changedChunks.size();
+		changedChunks.clear();
+	}
+	const float stitchMs = GetElapsedMs(start);
+
+	uint64_t numMismatches = CompareLight(world, "Stitched:");
+
+	// 3. Editing random blocks
+	const BlockCoord minBS = Orange::Math::ChunkToBlockCoord(minCS);
+	std::uniform_int_distribution<int32_t> distX(0, world.GetSizeX() * CHUNK_SIZE - 1);
+	std::uniform_int_distribution<int32_t> distY(0, world.GetSizeY() * CHUNK_SIZE - 1);
+	std::uniform_int_distribution<int32_t> distZ(0, world.GetSizeZ() * CHUNK_SIZE - 1);
+	std::uniform_int_distribution<uint32_t> distType(0, static_cast<uint32_t>(std::size(EDIT_BLOCK_TYPES)) - 1);
+
+	uint32_t numAppliedEdits = 0;
+	uint64_t numEditChanges = 0;
+	float editMs = 0.0f;
+	for (uint32_t i = 0; i < numEdits; i++)
+	{
+		const BlockCoord posBS = minBS + BlockCoord(distX(rng), distY(rng), distZ(rng));
+		const BlockType type = EDIT_BLOCK_TYPES[distType(rng)];
+
+		size_t index;
+		world.FindBlock(posBS, index);
+		if (world.GetBlockType(index) == type) continue;
+
+		world.SetBlockType(index, type);
+		numAppliedEdits++;
+
+		start = std::chrono::steady_clock::now();
+		LightEngine::UpdateBlock(world, posBS, changedChunks);
+		editMs += GetElapsedMs(start);
+
+		std::sort(changedChunks.begin(), changedChunks.end(), [](const ChunkCoord& a, const ChunkCoord& b)
+		{
+			return Orange::Math::GetHashKeyFromChunkPosition(a) < Orange::Math::GetHashKeyFromChunkPosition(b);
+		});
+		numEditChanges += std::unique(changedChunks.begin(), changedChunks.end()) - changedChunks.begin();
+		changedChunks.clear();
+	}
+
+	numMismatches += CompareLight(world, "Edited:");
+
+	// 4. Unloading some of them...
+	uint32_t numUnloaded = 0;
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < numChunks; i += UNLOAD_STRIDE)
+	{
+		const uint32_t chunkIndex = loadOrder[i];
+		world.SetLoaded(chunkIndex, false);
+		LightEngine::RemoveChunk(world, world.GetChunkPos(chunkIndex), world.GetView(chunkIndex), changedChunks);
+		changedChunks.clear();
+		numUnloaded++;
+	}
+	const float unloadMs = GetElapsedMs(start);
+
+	numMismatches += CompareLight(world, "Unloaded:");
+
+	// 5. ...and loading them back in, with the edits they had
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < numChunks; i += UNLOAD_STRIDE)
+	{
+		const uint32_t chunkIndex = loadOrder[i];
+		world.ComputeLight(chunkIndex);
+		world.SetLoaded(chunkIndex, true);
+		LightEngine::StitchChunk(world, world.GetChunkPos(chunkIndex), changedChunks);
+		changedChunks.clear();
+	}
+	const float reloadMs = GetElapsedMs(start);
+
+	numMismatches += CompareLight(world, "Reloaded:");
+
+	printf("\nLighting:  %10.2f ms, %8.2f us per chunk per thread\n", computeMs, computeMs * 1000.0f * numThreads / numChunks);
+	printf("Stitching: %10.2f ms, %8.2f us per chunk (%.1f changed chunks each, before removing duplicates)\n",
+		stitchMs, stitchMs * 1000.0f / numChunks, static_cast<float>(numStitchChanges) / numChunks);
+	printf("Editing:   %10.2f ms, %8.2f us per edit (%.1f chunks to remesh each)\n",
+		editMs, editMs * 1000.0f / max(numAppliedEdits, 1u), static_cast<float>(numEditChanges) / max(numAppliedEdits, 1u));
+	printf("Unloading: %10.2f ms, %8.2f us per chunk\n", unloadMs, unloadMs * 1000.0f / max(numUnloaded, 1u));
+	printf("Reloading: %10.2f ms, %8.2f us per chunk, including lighting it\n", reloadMs, reloadMs * 1000.0f / max(numUnloaded, 1u));
+
+	return numMismatches == 0 ? 0 : 1;
+}
+
+void LightCheckMode::PrintUsage()
+{
+	printf("  lightcheck [--min x,y,z] [--max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]\n");
+	printf("             [--definitions FILE] [--edits N] [--threads N]\n");
+	printf("      Stitches, edits, unloads and reloads lit chunks and compares their light against lighting\n");
+	printf("      the box from scratch after every step. Only blocks that FILE says emit light are checked for block light.\n");
+}
@@ -0,0 +1,25 @@
+#ifndef _LIGHTCHECKMODE_H
+#define _LIGHTCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks the light engine's incremental updates against lighting the whole box from scratch:
+//
+//		lightcheck [--min x,y,z] [--max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]
+//		           [--definitions FILE] [--edits N] [--threads N]
+//
+// Lights every chunk of the box on its own, stitches them together in a random order, edits random
+// blocks, unloads some chunks and loads them back in, comparing the light after every step. Blocks
+// only emit light if the definitions say so, so pass a file with an emitter to check block light
+class LightCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "NoiseCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Utility/HashNoise.h"
+#include "../Source/Utility/SimplexNoise.h"
+
+struct HashReference
+{
+	uint32_t seed;
+	int32_t x, y, z;
+	uint32_t hash;
+};
+
+struct Noise2DReference
+{
+	uint32_t seed;
+	float x, y;
+	float value;
+};
+
+struct Noise3DReference
+{
+	uint32_t seed;
+	float x, y, z;
+	float value;
+};
+
+// The hashes are exact on every platform. The noise only has to be within NOISE_TOLERANCE, which
+// leaves room for compilers that fuse multiplies and adds but catches any change to the noise itself
+constexpr float NOISE_TOLERANCE = 1e-5f;
+
+constexpr HashReference HASH_REFERENCES[] =
+{
+	{ 0u, 0, 0, 0, 0xC7922D58u },
+	{ 0u, 1, 0, 0, 0x482298B9u },
+	{ 1337u, -5, 17, 42, 0x423BED73u },
+	{ 3735928559u, 123456, -7890, 3, 0x686823F5u }
+};
+
+constexpr Noise2DReference NOISE_2D_REFERENCES[] =
+{
+	{ 0u, 0.5f, 0.5f, 0.284999996f },
+	{ 0u, -3.25f, 7.75f, -0.042876549f },
+	{ 1337u, 12.3f, -4.56f, 0.722523332f },
+	{ 42u, 1000.75f, -2000.25f, 0.714635253f }
+};
+
+constexpr Noise3DReference NOISE_3D_REFERENCES[] =
+{
+	{ 0u, 0.5f, 0.5f, 0.5f, 0.197500005f },
+	{ 0u, -3.25f, 7.75f, 1.125f, -0.428527325f },
+	{ 1337u, 12.3f, -4.56f, 78.9f, -0.601915359f },
+	{ 42u, 1000.125f, -2000.375f, 64.5f, 0.541320205f }
+};
+
+// 4 octaves of HashNoise(0.012, 1, 2, 0.5), the same parameters as the density terrain
+constexpr Noise3DReference FRACTAL_REFERENCES[] =
+{
+	{ 0u, 18.5f, 18.5f, 1.5f, 0.134481326f },
+	{ 0u, -120.25f, 286.75f, 3.375f, 0.013573315f },
+	{ 1337u, 455.1f, -168.72f, 236.7f, -0.010820089f },
+	{ 42u, 37004.625f, -74013.875f, 193.5f, -0.101968415f }
+};
+
+constexpr uint32_t FRACTAL_NUM_OCTAVES = 4;
+
+// Samples for the seed, thread and timing checks, spread over a cube of SAMPLE_GRID_SIZE^3
+constexpr int32_t SAMPLE_GRID_SIZE = 48;
+constexpr float SAMPLE_SPACING = 0.37f;
+
+// Different seeds are expected to be uncorrelated
+constexpr float MAX_SEED_CORRELATION = 0.1f;
+
+static bool CheckReferences(const HashNoise& fractalNoise)
+{
+	bool passed = true;
+
+	for (const auto& reference : HASH_REFERENCES)
+	{
+		const uint32_t hash = HashNoise::Hash(reference.seed, reference.x, reference.y, reference.z);
+		if (hash == reference.hash) continue;
+
+		printf("  Hash(%u, %i, %i, %i) is 0x%08X, expected 0x%08X\n", reference.seed, reference.x, reference.y, reference.z, hash, reference.hash);
+		passed = false;
+	}
+
+	for (const auto& reference : NOISE_2D_REFERENCES)
+	{
+		const float value = HashNoise::Noise(reference.seed, reference.x, reference.y);
+		if (fabsf(value - reference.value) <= NOISE_TOLERANCE) continue;
+
+		printf("  Noise(%u, %g, %g) is %.9f, expected %.9f\n", reference.seed, reference.x, reference.y, value, reference.value);
+		passed = false;
+	}
+
+	for (const auto& reference : NOISE_3D_REFERENCES)
+	{
+		const float value = HashNoise::Noise(reference.seed, reference.x, reference.y, reference.z);
+		if (fabsf(value - reference.value) <= NOISE_TOLERANCE) continue;
+
+		printf("  Noise(%u, %g, %g, %g) is %.9f, expected %.9f\n", reference.seed, reference.x, reference.y, reference.z, value, reference.value);
+		passed = false;
+	}
+
+	for (const auto& reference : FRACTAL_REFERENCES)
+	{
+		const float value = fractalNoise.Fractal(reference.seed, FRACTAL_NUM_OCTAVES, reference.x, reference.y, reference.z);
+		if (fabsf(value - reference.value) <= NOISE_TOLERANCE) continue;
+
+		printf("  Fractal(%u, %g, %g, %g) is %.9f, expected %.9f\n", reference.seed, reference.x, reference.y, reference.z, value, reference.value);
+		passed = false;
+	}
+
+	// Gradient noise is 0 on the lattice, whatever the gradients are
+	for (int32_t i = -3; i <= 3; i++)
+	{
+		if (HashNoise::Noise(1234u, static_cast<float>(i), static_cast<float>(i * 7)) != 0.0f ||
+			HashNoise::Noise(1234u, static_cast<float>(i), static_cast<float>(i * 7), static_cast<float>(-i * 3)) != 0.0f)
+		{
+			printf("  Noise isn't 0 at the lattice point (%i, %i, %i)\n", i, i * 7, -i * 3);
+			passed = false;
+		}
+	}
+
+	return passed;
+}
+
+// Fills "outValues" with the fractal noise at every point of the sample grid, split over "numThreads" threads.
+// Every thread takes every numThreads-th slice, so the threads interleave as much as possible
+static void SampleGrid(const HashNoise& fractalNoise, const uint32_t seed, const uint32_t numThreads, std::vector<float>& outValues)
+{
+	outValues.resize(static_cast<size_t>(SAMPLE_GRID_SIZE) * SAMPLE_GRID_SIZE * SAMPLE_GRID_SIZE);
+
+	auto sampleSlices = [&](const uint32_t firstSlice)
+	{
+		for (int32_t x = static_cast<int32_t>(firstSlice); x < SAMPLE_GRID_SIZE; x += static_cast<int32_t>(numThreads))
+		{
+			for (int32_t y = 0; y < SAMPLE_GRID_SIZE; y++)
+			{
+				for (int32_t z = 0; z < SAMPLE_GRID_SIZE; z++)
+				{
+					outValues[(static_cast<size_t>(x) * SAMPLE_GRID_SIZE + y) * SAMPLE_GRID_SIZE + z] =
+						fractalNoise.Fractal(seed, FRACTAL_NUM_OCTAVES, x * SAMPLE_SPACING, y * SAMPLE_SPACING, z * SAMPLE_SPACING);
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		threads.emplace_back(sampleSlices, i);
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+static float GetCorrelation(const std::vector<float>& a, const std::vector<float>& b)
+{
+	double sumA = 0.0, sumB = 0.0, sumAB = 0.0, sumAA = 0.0, sumBB = 0.0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		sumA += a[i];
+		sumB += b[i];
+		sumAB += static_cast<double>(a[i]) * b[i];
+		sumAA += static_cast<double>(a[i]) * a[i];
+		sumBB += static_cast<double>(b[i]) * b[i];
+	}
+
+	const double n = static_cast<double>(a.size());
+	const double covariance = sumAB / n - (sumA / n) * (sumB / n);
+	const double varianceA = sumAA / n - (sumA / n) * (sumA / n);
+	const double varianceB = sumBB / n - (sumB / n) * (sumB / n);
+	return static_cast<float>(covariance / sqrt(varianceA * varianceB));
+}
+
+int NoiseCheckMode::Run(const std::vector<std::string>& args)
+{
+	const char* threadsArg = Headless::FindArg(args, "--threads");
+	uint32_t numThreads = threadsArg ? static_cast<uint32_t>(atoi(threadsArg)) : std::thread::hardware_concurrency();
+	numThreads = max(numThreads, 2u);
+
+	const HashNoise fractalNoise(0.012f, 1.0f, 2.0f, 0.5f);
+	bool passed = true;
+
+	printf("Reference values\n");
+	if (!CheckReferences(fractalNoise)) passed = false;
+
+	// The grid is scaled up, so that it covers a few noise features at the fractal noise's frequency
+	printf("Seeds\n");
+	const HashNoise gridNoise(1.0f, 1.0f, 2.0f, 0.5f);
+	std::vector<float> seedA, seedB;
+	SampleGrid(gridNoise, 1u, 1, seedA);
+	SampleGrid(gridNoise, 2u, 1, seedB);
+	const float correlation = GetCorrelation(seedA, seedB);
+	if (fabsf(correlation) > MAX_SEED_CORRELATION)
+	{
+		printf("  Seeds 1 and 2 are correlated (%.3f)\n", correlation);
+		passed = false;
+	}
+
+	printf("Threads\n");
+	std::vector<float> multiThreaded;
+	SampleGrid(gridNoise, 1u, numThreads, multiThreaded);
+	if (memcmp(seedA.data(), multiThreaded.data(), seedA.size() * sizeof(float)) != 0)
+	{
+		printf("  1 and %u threads sampled different values\n", numThreads);
+		passed = false;
+	}
+
+	// Not a check, but the reason to care about the hash noise's cost at all
+	const SimplexNoise simplexNoise(1.0f, 1.0f, 2.0f, 0.5f);
+	const int32_t numSamples = SAMPLE_GRID_SIZE * SAMPLE_GRID_SIZE * SAMPLE_GRID_SIZE;
+	float simplexSum = 0.0f;
+	float hashSum = 0.0f;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int32_t i = 0; i < numSamples; i++)
+	{
+		simplexSum += simplexNoise.fractal(FRACTAL_NUM_OCTAVES, (i >> 12) * SAMPLE_SPACING, ((i >> 6) & 63) * SAMPLE_SPACING, (i & 63) * SAMPLE_SPACING);
+	}
+	const float simplexNs = std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - start).count() / numSamples;
+
+	start = std::chrono::steady_clock::now();
+	for (int32_t i = 0; i < numSamples; i++)
+	{
+		hashSum += gridNoise.Fractal(1u, FRACTAL_NUM_OCTAVES, (i >> 12) * SAMPLE_SPACING, ((i >> 6) & 63) * SAMPLE_SPACING, (i & 63) * SAMPLE_SPACING);
+	}
+	const float hashNs = std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - start).count() / numSamples;
+
+	printf("\n%u-octave 3D noise: simplex %.1f ns, hash %.1f ns per sample (checksums %.3f, %.3f)\n",
+		FRACTAL_NUM_OCTAVES, simplexNs, hashNs, simplexSum, hashSum);
+
+	printf(passed ? "OK: all checks passed\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
+
+void NoiseCheckMode::PrintUsage()
+{
+	printf("  noisecheck [--threads N]\n");
+	printf("      Checks the seeded hash noise against reference values and across seeds and threads.\n");
+}
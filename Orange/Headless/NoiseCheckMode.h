@@ -0,0 +1,25 @@
+#ifndef _NOISECHECKMODE_H
+#define _NOISECHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks HashNoise against reference values, so that changes to it (or a compiler or platform that
+// computes it differently) are caught before they change every world. Also checks that different
+// seeds give unrelated noise and that the result doesn't depend on the number of threads, and
+// times it against SimplexNoise:
+//
+//		noisecheck [--threads N]
+//
+// Returns 1 if any check fails
+class NoiseCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
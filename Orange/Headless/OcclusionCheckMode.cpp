@@ -0,0 +1,220 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "OcclusionCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/OcclusionCuller.h"
+
+constexpr uint32_t DEFAULT_NUM_OCCLUDERS = OcclusionCuller::MAX_OCCLUDERS;
+constexpr uint32_t DEFAULT_NUM_CHUNKS = 4096;
+constexpr uint32_t DEFAULT_ITERATIONS = 20;
+
+struct Box
+{
+	DirectX::XMFLOAT3 min, max;
+};
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Looks along "yaw" (0 is +Z, PI / 2 is +X) from "position", with the game's projection squeezed into the occlusion buffer
+static OcclusionView MakeView(const DirectX::XMFLOAT3& position, const float yaw)
+{
+	OcclusionView view;
+	view.position = position;
+	view.forward = { sinf(yaw), 0.0f, cosf(yaw) };
+	view.right = { cosf(yaw), 0.0f, -sinf(yaw) };
+	view.up = { 0.0f, 1.0f, 0.0f };
+	view.tanHalfFov = tanf(Headless::CAMERA_FOV / 2.0f);
+	view.aspectRatio = static_cast<float>(OCCLUSION_BUFFER_WIDTH) / OCCLUSION_BUFFER_HEIGHT;
+	return view;
+}
+
+static Box MakeChunkBox(const ChunkCoord& chunkPosCS)
+{
+	const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+	return { minWS, { minWS.x + CHUNK_SIZE, minWS.y + CHUNK_SIZE, minWS.z + CHUNK_SIZE } };
+}
+
+struct SceneTest
+{
+	const char* name;
+	Box box;
+	bool isVisible;
+};
+
+// Returns the number of boxes that weren't as visible as expected
+static uint32_t CheckScene(const char* sceneName, const OcclusionView& view, const std::vector<Box>& occluders, const std::vector<SceneTest>& tests)
+{
+	OcclusionRasterizer rasterizer;
+	rasterizer.Begin(view);
+	for (const auto& occluder : occluders) rasterizer.DrawOccluder(occluder.min, occluder.max);
+	rasterizer.End();
+
+	uint32_t numCoveredPixels = 0;
+	for (const float depth : rasterizer.GetDepthBuffer()) numCoveredPixels += depth > 0.0f ? 1 : 0;
+	printf("%s (%.1f%% of the buffer covered)\n", sceneName, 100.0f * numCoveredPixels / (OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT));
+
+	uint32_t numMismatches = 0;
+	for (const auto& test : tests)
+	{
+		const bool isVisible = rasterizer.IsBoxVisible(test.box.min, test.box.max);
+		printf("  %-28s %-8s%s\n", test.name, isVisible ? "visible" : "hidden", isVisible == test.isVisible ? "" : "  MISMATCH");
+		numMismatches += isVisible == test.isVisible ? 0 : 1;
+	}
+
+	return numMismatches;
+}
+
+static uint32_t CheckScenes()
+{
+	const OcclusionView forwardView = MakeView({ 0.0f, 0.0f, 0.0f }, 0.0f);
+	const Box wall = { { -8.0f, -4.0f, 20.0f }, { 8.0f, 4.0f, 21.0f } };
+
+	uint32_t numMismatches = 0;
+	numMismatches += CheckScene("Nothing drawn", forwardView, {},
+	{
+		{ "Ahead", { { -2.0f, -1.0f, 40.0f }, { 2.0f, 1.0f, 44.0f } }, true }
+	});
+
+	numMismatches += CheckScene("Wall ahead", forwardView, { wall },
+	{
+		{ "Behind the wall", { { -2.0f, -1.0f, 40.0f }, { 2.0f, 1.0f, 44.0f } }, false },
+		{ "Far behind the wall", { { -20.0f, -10.0f, 300.0f }, { 20.0f, 10.0f, 320.0f } }, false },
+		{ "Peeking over the wall", { { -2.0f, 6.0f, 40.0f }, { 2.0f, 10.0f, 44.0f } }, true },
+		{ "Next to the wall", { { 20.0f, -1.0f, 40.0f }, { 22.0f, 1.0f, 44.0f } }, true },
+		{ "In front of the wall", { { -1.0f, -1.0f, 10.0f }, { 1.0f, 1.0f, 12.0f } }, true },
+		{ "The wall itself", wall, true },
+		{ "Around the camera", { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } }, true },
+		{ "Behind the camera", { { -2.0f, -1.0f, -44.0f }, { 2.0f, 1.0f, -40.0f } }, true }
+	});
+
+	numMismatches += CheckScene("Wall behind the camera", forwardView, { { { -8.0f, -4.0f, -21.0f }, { 8.0f, 4.0f, -20.0f } } },
+	{
+		{ "Ahead", { { -2.0f, -1.0f, 40.0f }, { 2.0f, 1.0f, 44.0f } }, true }
+	});
+
+	numMismatches += CheckScene("Gap between two walls", forwardView,
+		{ { { -8.0f, -4.0f, 20.0f }, { -1.0f, 4.0f, 21.0f } }, { { 1.0f, -4.0f, 20.0f }, { 8.0f, 4.0f, 21.0f } } },
+	{
+		{ "Behind the gap", { { -0.2f, -0.2f, 40.0f }, { 0.2f, 0.2f, 41.0f } }, true },
+		{ "Behind the left wall", { { -6.0f, -1.0f, 40.0f }, { -4.0f, 1.0f, 44.0f } }, false }
+	});
+
+	// The floor reaches behind the camera, so it has to be clipped against the near plane
+	numMismatches += CheckScene("Floor under the camera", forwardView, { { { -200.0f, -3.0f, -50.0f }, { 200.0f, -1.0f, 400.0f } } },
+	{
+		{ "Under the floor", { { -2.0f, -10.0f, 30.0f }, { 2.0f, -6.0f, 34.0f } }, false },
+		{ "On the floor", { { -2.0f, -1.0f, 30.0f }, { 2.0f, 1.0f, 34.0f } }, true }
+	});
+
+	numMismatches += CheckScene("Wall to the right, looking right", MakeView({ 0.0f, 0.0f, 0.0f }, 3.14159265f / 2.0f), { { { 20.0f, -4.0f, -8.0f }, { 21.0f, 4.0f, 8.0f } } },
+	{
+		{ "Behind the wall", { { 40.0f, -1.0f, -2.0f }, { 44.0f, 1.0f, 2.0f } }, false },
+		{ "Beside the wall", { { 40.0f, -1.0f, 20.0f }, { 44.0f, 1.0f, 22.0f } }, true }
+	});
+
+	return numMismatches;
+}
+
+// A wall of chunks two chunks ahead of the camera's chunk, through the worker thread
+static uint32_t CheckWorker()
+{
+	std::vector<ChunkCoord> occluders, chunks;
+	for (int32_t x = -2; x <= 1; x++)
+	{
+		for (int32_t y = -1; y <= 0; y++)
+		{
+			occluders.emplace_back(x, y, 2);
+			chunks.emplace_back(x, y, 2);
+			chunks.emplace_back(x, y, 4);
+		}
+	}
+	const uint32_t numBehindWall = static_cast<uint32_t>(occluders.size());
+
+	const OcclusionView view = MakeView({ 0.5f, 0.5f, 0.5f }, 0.0f);
+	OcclusionCuller culler;
+	culler.Start();
+
+	uint32_t numMismatches = 0;
+	auto checkFrame = [&](const char* name, const std::vector<ChunkCoord>& frameOccluders, const uint32_t expectedHidden)
+	{
+		culler.Submit(view, frameOccluders, chunks);
+		culler.WaitForResults();
+
+		std::vector<ChunkCoord> visibleChunks = chunks;
+		const uint32_t numHidden = culler.RemoveHiddenChunks(visibleChunks);
+		printf("  %-28s %u of %zu chunks hidden, expected %u%s\n", name, numHidden, chunks.size(), expectedHidden, numHidden == expectedHidden ? "" : "  MISMATCH");
+		numMismatches += numHidden == expectedHidden ? 0 : 1;
+	};
+
+	printf("Worker thread\n");
+	checkFrame("With the wall", occluders, numBehindWall);
+	checkFrame("Without the wall", {}, 0);
+	checkFrame("With the wall again", occluders, numBehindWall);
+
+	culler.Stop();
+	return numMismatches;
+}
+
+int OcclusionCheckMode::Run(const std::vector<std::string>& args)
+{
+	const char* occludersArg = Headless::FindArg(args, "--occluders");
+	const char* chunksArg = Headless::FindArg(args, "--chunks");
+	const char* iterationsArg = Headless::FindArg(args, "--iterations");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+
+	const uint32_t numOccluders = occludersArg ? static_cast<uint32_t>(atoi(occludersArg)) : DEFAULT_NUM_OCCLUDERS;
+	const uint32_t numChunks = max(chunksArg ? static_cast<uint32_t>(atoi(chunksArg)) : DEFAULT_NUM_CHUNKS, 1u);
+	const uint32_t iterations = max(iterationsArg ? static_cast<uint32_t>(atoi(iterationsArg)) : DEFAULT_ITERATIONS, 1u);
+	const uint32_t seed = seedArg ? static_cast<uint32_t>(strtoul(seedArg, nullptr, 10)) : 0;
+
+	uint32_t numMismatches = CheckScenes();
+	numMismatches += CheckWorker();
+
+	// Random chunks in front of the camera, the occluders closer than the rest on average
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int32_t> sideDist(-12, 12);
+	std::uniform_int_distribution<int32_t> occluderDepthDist(1, 12);
+	std::uniform_int_distribution<int32_t> chunkDepthDist(1, 24);
+
+	std::vector<Box> occluders(numOccluders), chunks(numChunks);
+	for (auto& occluder : occluders) occluder = MakeChunkBox(ChunkCoord(sideDist(rng), sideDist(rng) / 2, occluderDepthDist(rng)));
+	for (auto& chunk : chunks) chunk = MakeChunkBox(ChunkCoord(sideDist(rng), sideDist(rng) / 2, chunkDepthDist(rng)));
+
+	const OcclusionView view = MakeView({ 8.0f, 8.0f, 8.0f }, 0.0f);
+	OcclusionRasterizer rasterizer;
+	uint32_t numHidden = 0;
+	float drawMs = 0.0f, testMs = 0.0f;
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		rasterizer.Begin(view);
+		for (const auto& occluder : occluders) rasterizer.DrawOccluder(occluder.min, occluder.max);
+		rasterizer.End();
+		drawMs += GetElapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		numHidden = 0;
+		for (const auto& chunk : chunks) numHidden += rasterizer.IsBoxVisible(chunk.min, chunk.max) ? 0 : 1;
+		testMs += GetElapsedMs(start);
+	}
+
+	printf("\nDrawing %u occluders: %.3f ms, testing %u chunks: %.3f ms (%.1f ns per chunk), %u hidden\n", numOccluders, drawMs / iterations,
+		numChunks, testMs / iterations, 1000000.0f * testMs / (iterations * numChunks), numHidden);
+
+	printf("\n%u mismatches\n", numMismatches);
+	return numMismatches == 0 ? 0 : 1;
+}
+
+void OcclusionCheckMode::PrintUsage()
+{
+	printf("  occlusioncheck [--occluders N] [--chunks N] [--iterations N] [--seed N]\n");
+	printf("      Checks the occlusion rasterizer against synthetic scenes and through its worker thread,\n");
+	printf("      then times drawing N random chunk occluders and testing chunks against them.\n");
+}
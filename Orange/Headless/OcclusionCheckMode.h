@@ -0,0 +1,23 @@
+#ifndef _OCCLUSIONCHECKMODE_H
+#define _OCCLUSIONCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks and measures the occlusion rasterizer on synthetic scenes:
+//
+//		occlusioncheck [--occluders N] [--chunks N] [--iterations N] [--seed N]
+//
+// Tests boxes in front of, behind, next to and around hand-placed occluders against what they're expected to be,
+// runs a few frames through the worker thread, then times drawing N random chunk occluders and testing chunks against them
+class OcclusionCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include "../Source/Misc/pch.h"
+
+#include <random>
+
+#include "PoolCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Utility/SortedPool.h"
+
+constexpr uint32_t DEFAULT_NUM_OBJECTS = 2000;
+constexpr uint32_t DEFAULT_NUM_ROUNDS = 50;
+
+// Roughly what a chunk's mesh looks like, scaled down
+constexpr uint32_t MAX_MESH_INSTANCES = 64;
+
+// How many failures are printed before only counting them
+constexpr uint32_t MAX_PRINTED_FAILURES = 10;
+
+class PooledMesh;
+
+// Stands in for the vertex array, every instance holds the ID of the object it belongs to
+static std::vector<uint32_t> g_instances;
+static Orange::SortedPool<PooledMesh>* g_pool = nullptr;
+static bool g_isShuttingDown = false;
+
+// Shutdowns that erased instances that weren't their own, or a range past the end of the array
+static uint32_t g_numBadShutdowns = 0;
+
+// Keeps its range of g_instances the same way Chunk keeps its range of the vertex array (see Chunk::ShutdownVertexBuffer())
+class PooledMesh
+{
+public:
+
+	PooledMesh(const uint32_t id = 0) : m_id(id) {}
+
+	PooledMesh(const PooledMesh& other) { *this = other; }
+
+	~PooledMesh()
+	{
+		if (!g_isShuttingDown) Shutdown();
+	}
+
+	PooledMesh& operator=(const PooledMesh& other)
+	{
+		m_id = other.m_id;
+		m_startIndex = other.m_startIndex;
+		m_count = other.m_count;
+		return *this;
+	}
+
+	PooledMesh& operator=(PooledMesh&& other)
+	{
+		*this = static_cast<const PooledMesh&>(other);
+		other.m_startIndex = other.m_count = 0;
+		return *this;
+	}
+
+	void SetMesh(const uint32_t count)
+	{
+		Shutdown();
+		if (count == 0) return;
+
+		m_startIndex = static_cast<uint32_t>(g_instances.size());
+		m_count = count;
+		g_instances.insert(g_instances.end(), count, m_id);
+	}
+
+	void Shutdown()
+	{
+		if (m_count > 0)
+		{
+			if (!HasValidRange())
+			{
+				g_numBadShutdowns++;
+				m_startIndex = m_count = 0;
+				return;
+			}
+
+			g_instances.erase(g_instances.begin() + m_startIndex, g_instances.begin() + m_startIndex + m_count);
+
+			for (uint32_t i = 0; i < g_pool->Size(); i++)
+			{
+				PooledMesh* mesh = (*g_pool)[i];
+				if (mesh->m_startIndex < m_startIndex || mesh->m_count == 0 || mesh == this) continue;
+				mesh->m_startIndex -= m_count;
+			}
+		}
+
+		m_startIndex = m_count = 0;
+	}
+
+	// Whether the object's range is inside the array and only holds its own instances
+	bool HasValidRange() const
+	{
+		if (m_count == 0) return true;
+		if (static_cast<uint64_t>(m_startIndex) + m_count > g_instances.size()) return false;
+
+		for (uint32_t i = m_startIndex; i < m_startIndex + m_count; i++)
+		{
+			if (g_instances[i] != m_id) return false;
+		}
+
+		return true;
+	}
+
+	uint32_t GetID() const { return m_id; }
+	uint32_t GetCount() const { return m_count; }
+
+private:
+
+	uint32_t m_id;
+	uint32_t m_startIndex = 0;
+	uint32_t m_count = 0;
+};
+
+// Returns a description of the first problem with the pool's ranges, or nullptr
+static const char* CheckPool(Orange::SortedPool<PooledMesh>& pool)
+{
+	if (g_numBadShutdowns > 0) return "an object erased instances that weren't its own";
+
+	uint64_t numInstances = 0;
+	for (uint32_t i = 0; i < pool.Size(); i++)
+	{
+		if (!pool[i]->HasValidRange()) return "an object's range holds instances that aren't its own";
+		numInstances += pool[i]->GetCount();
+	}
+
+	if (numInstances != g_instances.size()) return "the array holds instances no object owns";
+	return nullptr;
+}
+
+void PoolCheckMode::PrintUsage()
+{
+	printf("  poolcheck [--seed N] [--objects N] [--rounds N]\n");
+	printf("      Checks that unloading, resizing and releasing the chunk pool leaves every other chunk's mesh alone\n");
+}
+
+int PoolCheckMode::Run(const std::vector<std::string>& args)
+{
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	const char* objectsArg = Headless::FindArg(args, "--objects");
+	const uint32_t numObjects = max(objectsArg ? static_cast<uint32_t>(atoi(objectsArg)) : DEFAULT_NUM_OBJECTS, 4u);
+
+	const char* roundsArg = Headless::FindArg(args, "--rounds");
+	const uint32_t numRounds = max(roundsArg ? static_cast<uint32_t>(atoi(roundsArg)) : DEFAULT_NUM_ROUNDS, 1u);
+
+	std::mt19937 rng(static_cast<uint32_t>(seed));
+	std::uniform_int_distribution<uint32_t> meshDist(0, MAX_MESH_INSTANCES);
+	std::uniform_int_distribution<uint32_t> capacityDist(numObjects / 2, numObjects * 2);
+
+	g_instances.clear();
+	g_numBadShutdowns = 0;
+	g_isShuttingDown = false;
+
+	Orange::SortedPool<PooledMesh> pool(numObjects);
+	g_pool = &pool;
+
+	uint32_t nextID = 1;
+	uint32_t numFailures = 0;
+	uint32_t numRemoved = 0;
+	uint32_t numResizes = 0;
+
+	// Fills the pool back up, the way the updater loads and then meshes new chunks
+	auto loadUntilFull = [&]()
+	{
+		while (pool.Size() < pool.Capacity())
+		{
+			PooledMesh* mesh = pool.Insert_Move(PooledMesh(nextID++));
+			mesh->SetMesh(meshDist(rng));
+		}
+	};
+
+	auto unload = [&](const uint32_t numToUnload)
+	{
+		for (uint32_t i = 0; i < numToUnload && pool.Size() > 0; i++)
+		{
+			pool.Remove(rng() % pool.Size());
+			numRemoved++;
+		}
+	};
+
+	auto check = [&](const uint32_t round, const char* step)
+	{
+		const char* failure = CheckPool(pool);
+		if (!failure) return;
+
+		if (numFailures++ < MAX_PRINTED_FAILURES) printf("  Round %u, after %s: %s\n", round, step, failure);
+
+		// Start over from a clean array, so that one failure isn't counted again every step after it
+		g_instances.clear();
+		for (uint32_t i = 0; i < pool.Size(); i++) pool[i]->SetMesh(0);
+		g_numBadShutdowns = 0;
+	};
+
+	loadUntilFull();
+	check(0, "loading");
+
+	for (uint32_t round = 1; round <= numRounds; round++)
+	{
+		unload(1 + rng() % (pool.Size() / 4 + 1));
+		check(round, "unloading");
+
+		// Re-meshing moves every range after the re-meshed one
+		for (uint32_t i = 0; i < pool.Size() / 8; i++) pool[rng() % pool.Size()]->SetMesh(meshDist(rng));
+		check(round, "re-meshing");
+
+		const uint32_t newCapacity = capacityDist(rng);
+		if (pool.Size() > newCapacity) unload(pool.Size() - newCapacity);
+		pool.Resize(newCapacity);
+		numResizes++;
+		check(round, "resizing");
+
+		pool.ReleaseRetiredPools();
+		check(round, "releasing the retired pool");
+
+		loadUntilFull();
+		check(round, "loading");
+	}
+
+	printf("Ran %u rounds over %u objects: %u removed, %u resizes, %u failures\n", numRounds, numObjects, numRemoved, numResizes, numFailures);
+
+	// The pool's objects are freed with it, which mustn't touch the array anymore (see Chunk::~Chunk())
+	g_isShuttingDown = true;
+
+	return numFailures == 0 ? 0 : 1;
+}
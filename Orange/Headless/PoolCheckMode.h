@@ -0,0 +1,26 @@
+#ifndef _POOLCHECKMODE_H
+#define _POOLCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks that removing objects from an Orange::SortedPool and resizing it never leaves anything behind that frees
+// memory it doesn't own anymore:
+//
+//		poolcheck [--seed N] [--objects N] [--rounds N]
+//
+// The pooled objects own a range of a shared instance array the same way chunks own theirs in the vertex array: copies
+// share the range, moved-from objects give it up, and destroying one erases its range and moves the ranges after it
+// down. Every round unloads random objects, loads new ones, resizes the pool and releases the retired pools, checking
+// after every step that each object's range still holds its own instances
+class PoolCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "../Source/Misc/pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <tuple>
+
+#include "PregenMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/ChunkSerializer.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+uint32_t PregenMode::ApplyLateWrites(const std::string& outDirectory, std::atomic<uint64_t>& numFailedWrites)
+{
+	std::vector<PendingBlockWrite> lateWrites;
+	TerrainGenerator::GetPipeline().GetPendingWrites().TakeLateWrites(lateWrites);
+
+	// Group the writes by chunk, so that every file is only rewritten once
+	std::sort(lateWrites.begin(), lateWrites.end(), [](const PendingBlockWrite& a, const PendingBlockWrite& b)
+	{
+		return std::tie(a.targetCS.x, a.targetCS.y, a.targetCS.z) < std::tie(b.targetCS.x, b.targetCS.y, b.targetCS.z);
+	});
+
+	uint32_t numPatchedChunks = 0;
+	BlockType blockTypes[BLOCKS_PER_CHUNK];
+	std::vector<uint8_t> compressedData;
+	for (size_t first = 0; first < lateWrites.size();)
+	{
+		const ChunkCoord chunkPosCS = lateWrites[first].targetCS;
+		size_t last = first;
+		while (last < lateWrites.size() && lateWrites[last].targetCS == chunkPosCS) last++;
+
+		const std::string filePath = outDirectory + "/" + ChunkSerializer::GetFileName(chunkPosCS);
+		ChunkCoord filePosCS;
+		if (!ChunkSerializer::ReadFromFile(filePath, filePosCS, compressedData) || filePosCS != chunkPosCS || !ChunkSerializer::Decompress(compressedData, blockTypes))
+		{
+			numFailedWrites++;
+			first = last;
+			continue;
+		}
+
+		for (size_t i = first; i < last; i++)
+		{
+			blockTypes[lateWrites[i].index] = PendingWriteStore::MergeBlock(blockTypes[lateWrites[i].index], lateWrites[i].type);
+		}
+
+		ChunkSerializer::Compress(blockTypes, compressedData);
+		if (ChunkSerializer::WriteToFile(filePath, chunkPosCS, compressedData)) numPatchedChunks++;
+		else numFailedWrites++;
+
+		first = last;
+	}
+
+	return numPatchedChunks;
+}
+
+int PregenMode::Run(const std::vector<std::string>& args)
+{
+	int32_t minX, minY, minZ, maxX, maxY, maxZ;
+	if (!Headless::ParseCoord(Headless::FindArg(args, "--min"), minX, minY, minZ) ||
+		!Headless::ParseCoord(Headless::FindArg(args, "--max"), maxX, maxY, maxZ))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (minX > maxX) std::swap(minX, maxX);
+	if (minY > maxY) std::swap(minY, maxY);
+	if (minZ > maxZ) std::swap(minZ, maxZ);
+
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	TerrainShape terrainShape;
+	if (!Headless::ParseTerrainShape(Headless::FindArg(args, "--terrain"), terrainShape))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const char* threadsArg = Headless::FindArg(args, "--threads");
+	uint32_t numThreads = threadsArg ? static_cast<uint32_t>(atoi(threadsArg)) : std::thread::hardware_concurrency();
+	numThreads = max(numThreads, 1u);
+
+	const char* outArg = Headless::FindArg(args, "--out");
+	const std::string outDirectory = outArg ? outArg : "";
+	if (!outDirectory.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(outDirectory, error);
+		if (error)
+		{
+			printf("Failed to create output directory %s\n", outDirectory.c_str());
+			return 1;
+		}
+	}
+
+	const uint32_t sizeX = static_cast<uint32_t>(maxX - minX + 1);
+	const uint32_t sizeY = static_cast<uint32_t>(maxY - minY + 1);
+	const uint32_t sizeZ = static_cast<uint32_t>(maxZ - minZ + 1);
+	const uint64_t numChunks = static_cast<uint64_t>(sizeX) * sizeY * sizeZ;
+
+	printf("Generating %llu chunks from (%i, %i, %i) to (%i, %i, %i) with seed %llu on %u threads\n",
+		numChunks, minX, minY, minZ, maxX, maxY, maxZ, seed, numThreads);
+
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetTerrainShape(terrainShape);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	// Every thread grabs the next chunk index until they run out, so uneven chunks
+	// (e.g. air vs. terrain) don't leave some threads idle at the end
+	std::atomic<uint64_t> nextChunkIndex = 0;
+	std::atomic<uint64_t> bytesWritten = 0;
+	std::atomic<uint64_t> numFailedWrites = 0;
+
+	auto generateChunks = [&]()
+	{
+		BlockType blockTypes[BLOCKS_PER_CHUNK];
+		std::vector<uint8_t> compressedData;
+
+		for (uint64_t i = nextChunkIndex++; i < numChunks; i = nextChunkIndex++)
+		{
+			ChunkCoord chunkPosCS(
+				minX + static_cast<int32_t>(i / (static_cast<uint64_t>(sizeY) * sizeZ)),
+				minY + static_cast<int32_t>((i / sizeZ) % sizeY),
+				minZ + static_cast<int32_t>(i % sizeZ));
+
+			TerrainGenerator::GenerateChunk(chunkPosCS, blockTypes);
+			ChunkSerializer::Compress(blockTypes, compressedData);
+
+			if (outDirectory.empty()) continue;
+
+			if (ChunkSerializer::WriteToFile(outDirectory + "/" + ChunkSerializer::GetFileName(chunkPosCS), chunkPosCS, compressedData))
+			{
+				bytesWritten += compressedData.size();
+			}
+			else
+			{
+				numFailedWrites++;
+			}
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		threads.emplace_back(generateChunks);
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Trees that grew into chunks that were already written have to be patched into their files
+	uint32_t numPatchedChunks = 0;
+	if (!outDirectory.empty()) numPatchedChunks = ApplyLateWrites(outDirectory, numFailedWrites);
+
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Generated %llu chunks in %2.3f s (%.1f chunks/s, %.1f chunks/s per thread)\n",
+		numChunks, seconds, numChunks / seconds, numChunks / seconds / numThreads);
+	if (!outDirectory.empty())
+	{
+		printf("Wrote %2.2f MB of chunk data to %s, patched %u chunks with blocks from their neighbors\n",
+			bytesWritten / (1024.0f * 1024.0f), outDirectory.c_str(), numPatchedChunks);
+	}
+	printf("Peak memory: %2.2f MB\n", Headless::GetPeakMemoryUsage() / (1024.0f * 1024.0f));
+
+	// Region stages only run once per region, so their time is spread over every chunk in the region
+	printf("\n%10s %8s %14s %12s %18s\n", "stage", "scope", "invocations", "total (ms)", "per chunk (us)");
+	for (const auto& stats : TerrainGenerator::GetPipeline().GetStageStats())
+	{
+		printf("%10s %8s %14llu %12.2f %18.2f\n", stats.name, stats.scope == WorldGenStageScope::REGION ? "region" : "chunk",
+			stats.numInvocations, stats.totalMs, stats.totalMs * 1000.0f / numChunks);
+	}
+
+	if (numFailedWrites > 0)
+	{
+		printf("Failed to write %llu chunks\n", numFailedWrites.load());
+		return 1;
+	}
+
+	return 0;
+}
+
+void PregenMode::PrintUsage()
+{
+	printf("  pregen --min x,y,z --max x,y,z [--seed N] [--terrain heightmap|density] [--noise simplex|hash] [--threads N] [--out DIR]\n");
+	printf("      Generates every chunk in the box (in chunk space) and writes them to DIR.\n");
+	printf("      Without --out the chunks are only generated, to measure throughput.\n");
+}
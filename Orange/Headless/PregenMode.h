@@ -0,0 +1,31 @@
+#ifndef _PREGENMODE_H
+#define _PREGENMODE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Generates every chunk in a box (in CHUNK SPACE) across several threads and writes
+// them out in the chunk file format, the same one the chunk cache uses
+//
+//		pregen --min x,y,z --max x,y,z [--seed N] [--terrain heightmap|density] [--noise simplex|hash] [--threads N] [--out DIR]
+//
+// Without "--out" the chunks are generated and compressed but never written,
+// which is useful for measuring the generation throughput alone
+class PregenMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+private:
+
+	// Merges the blocks that chunks placed in neighbors which were already written into their files.
+	// Returns the number of files that were rewritten
+	static uint32_t ApplyLateWrites(const std::string& outDirectory, std::atomic<uint64_t>& numFailedWrites);
+
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+
+#include "QueryCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+
+// Covers the surface of every biome by default, along with the caves below it
+constexpr ChunkCoord DEFAULT_MIN_CS = ChunkCoord(-3, 2, -3);
+constexpr ChunkCoord DEFAULT_MAX_CS = ChunkCoord(2, 9, 2);
+
+// How many mismatches are printed before only counting them
+constexpr uint32_t MAX_PRINTED_MISMATCHES = 10;
+
+static bool IsTreeBlock(const BlockType type) { return type == BlockType::Wood || type == BlockType::Leaves; }
+
+int QueryCheckMode::Run(const std::vector<std::string>& args)
+{
+	ChunkCoord minCS = DEFAULT_MIN_CS;
+	ChunkCoord maxCS = DEFAULT_MAX_CS;
+
+	const char* minArg = Headless::FindArg(args, "--min");
+	const char* maxArg = Headless::FindArg(args, "--max");
+	if ((minArg && !Headless::ParseCoord(minArg, minCS.x, minCS.y, minCS.z)) ||
+		(maxArg && !Headless::ParseCoord(maxArg, maxCS.x, maxCS.y, maxCS.z)))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (minCS.x > maxCS.x) std::swap(minCS.x, maxCS.x);
+	if (minCS.y > maxCS.y) std::swap(minCS.y, maxCS.y);
+	if (minCS.z > maxCS.z) std::swap(minCS.z, maxCS.z);
+
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	TerrainShape terrainShape;
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseTerrainShape(Headless::FindArg(args, "--terrain"), terrainShape) ||
+		!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetTerrainShape(terrainShape);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	const int32_t sizeX = maxCS.x - minCS.x + 1;
+	const int32_t sizeY = maxCS.y - minCS.y + 1;
+	const int32_t sizeZ = maxCS.z - minCS.z + 1;
+	const uint32_t numChunks = static_cast<uint32_t>(sizeX * sizeY * sizeZ);
+
+	printf("Checking %u chunks from (%i, %i, %i) to (%i, %i, %i) with seed %llu\n\n",
+		numChunks, minCS.x, minCS.y, minCS.z, maxCS.x, maxCS.y, maxCS.z, seed);
+
+	// Every chunk of the box, in the box's x, y, z order
+	std::vector<BlockType> blockTypes(static_cast<size_t>(numChunks) * BLOCKS_PER_CHUNK);
+	auto getChunkBlocks = [&](const ChunkCoord& chunkPosCS)
+	{
+		const uint32_t chunkIndex = static_cast<uint32_t>(((chunkPosCS.x - minCS.x) * sizeY + (chunkPosCS.y - minCS.y)) * sizeZ + (chunkPosCS.z - minCS.z));
+		return &blockTypes[static_cast<size_t>(chunkIndex) * BLOCKS_PER_CHUNK];
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	for (int32_t x = minCS.x; x <= maxCS.x; x++)
+	{
+		for (int32_t y = minCS.y; y <= maxCS.y; y++)
+		{
+			for (int32_t z = minCS.z; z <= maxCS.z; z++)
+			{
+				TerrainGenerator::GenerateChunk(ChunkCoord(x, y, z), getChunkBlocks(ChunkCoord(x, y, z)));
+			}
+		}
+	}
+	const float generateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Starts over, so that the queries don't find the regions the chunks cached
+	TerrainGenerator::SetSeed(seed);
+
+	const BlockCoord minBS = Orange::Math::ChunkToBlockCoord(minCS);
+	const BlockCoord maxBS = Orange::Math::ChunkToBlockCoord(maxCS + ChunkCoord(1, 1, 1)) - BlockCoord(1, 1, 1);
+
+	uint64_t numQueries = 0;
+	uint64_t numSkippedBlocks = 0;
+	uint64_t numBlockMismatches = 0;
+	start = std::chrono::steady_clock::now();
+	for (int32_t x = minBS.x; x <= maxBS.x; x++)
+	{
+		for (int32_t y = minBS.y; y <= maxBS.y; y++)
+		{
+			for (int32_t z = minBS.z; z <= maxBS.z; z++)
+			{
+				const BlockCoord posBS(x, y, z);
+				const BlockType queried = TerrainGenerator::QueryBlock(posBS);
+				numQueries++;
+
+				const BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+				const BlockType generated = getChunkBlocks(Orange::Math::BlockToChunkCoord(posBS))[ChunkTraits<CHUNK_SIZE>::GetIndex(localPos.x, localPos.y, localPos.z)];
+				if (IsTreeBlock(generated))
+				{
+					numSkippedBlocks++;
+					continue;
+				}
+
+				if (queried != generated)
+				{
+					if (numBlockMismatches < MAX_PRINTED_MISMATCHES)
+					{
+						printf("Block (%i, %i, %i) is %u in its chunk but the query returned %u\n", x, y, z,
+							static_cast<uint32_t>(generated), static_cast<uint32_t>(queried));
+					}
+					numBlockMismatches++;
+				}
+			}
+		}
+	}
+	const float queryMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Only columns whose surface is inside the box can be checked
+	uint64_t numColumns = 0;
+	uint64_t numHeightMismatches = 0;
+	for (int32_t x = minBS.x; x <= maxBS.x; x++)
+	{
+		for (int32_t z = minBS.z; z <= maxBS.z; z++)
+		{
+			int32_t generatedHeight = INT32_MIN;
+			for (int32_t y = maxBS.y; y >= minBS.y; y--)
+			{
+				const BlockCoord posBS(x, y, z);
+				const BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+				const BlockType generated = getChunkBlocks(Orange::Math::BlockToChunkCoord(posBS))[ChunkTraits<CHUNK_SIZE>::GetIndex(localPos.x, localPos.y, localPos.z)];
+				if (generated != BlockType::Air && !IsTreeBlock(generated))
+				{
+					generatedHeight = y;
+					break;
+				}
+			}
+
+			if (generatedHeight == INT32_MIN || generatedHeight == maxBS.y) continue;
+
+			int32_t queriedHeight;
+			if (!TerrainGenerator::QuerySurfaceHeight(x, z, minBS.y, queriedHeight)) queriedHeight = INT32_MIN;
+
+			numColumns++;
+			if (queriedHeight != generatedHeight)
+			{
+				if (numHeightMismatches < MAX_PRINTED_MISMATCHES)
+				{
+					printf("Column (%i, %i) has its surface at %i but the query returned %i\n", x, z, generatedHeight, queriedHeight);
+				}
+				numHeightMismatches++;
+			}
+		}
+	}
+
+	printf("Generating: %10.2f ms, %8.2f us per chunk\n", generateMs, generateMs * 1000.0f / numChunks);
+	printf("Querying:   %10.2f ms, %8.2f ns per block (%llu blocks, %llu tree blocks skipped)\n",
+		queryMs, queryMs * 1000000.0f / numQueries, numQueries, numSkippedBlocks);
+	printf("Block mismatches:   %llu\n", numBlockMismatches);
+	printf("Surface mismatches: %llu of %llu columns\n", numHeightMismatches, numColumns);
+
+	return (numBlockMismatches == 0 && numHeightMismatches == 0) ? 0 : 1;
+}
+
+void QueryCheckMode::PrintUsage()
+{
+	printf("  querycheck [--min x,y,z] [--max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]\n");
+	printf("      Compares the terrain generator's block and surface queries against generated chunks,\n");
+	printf("      leaving out trees. Also times a query per block against generating the chunks.\n");
+}
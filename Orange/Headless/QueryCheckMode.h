@@ -0,0 +1,23 @@
+#ifndef _QUERYCHECKMODE_H
+#define _QUERYCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks the terrain generator's block and surface queries against fully generated chunks:
+//
+//		querycheck [--min x,y,z] [--max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]
+//
+// Every block in the box (in chunk space) is queried and compared, except for trees, which the
+// queries leave out. Prints the mismatches and the time per query next to the time per chunk
+class QueryCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
@@ -0,0 +1,441 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "RaycastCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/BlockRegistry.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+#include "../Source/Utility/VoxelRaycast.h"
+
+// The surface of every biome, along with the caves below it and plenty of sky above it
+constexpr ChunkCoord DEFAULT_MIN_CS = ChunkCoord(-4, 2, -4);
+constexpr ChunkCoord DEFAULT_MAX_CS = ChunkCoord(3, 11, 3);
+constexpr uint32_t DEFAULT_NUM_RAYS = 5000;
+
+// Checked rays are kept short, since every block around them is intersected with them. Timed rays go as far as a
+// ray from the middle of the box usually can
+constexpr float CHECKED_RAY_LENGTH = 32.0f;
+constexpr float TIMED_RAY_LENGTH = 96.0f;
+constexpr uint32_t NUM_TIMED_RAYS_PER_RAY = 4;
+
+// Every this many rays goes straight along an axis, which never crosses a boundary on the other two
+constexpr uint32_t AXIS_ALIGNED_RAY_INTERVAL = 16;
+
+// Hits this close to each other (in world units) are ambiguous, the ray goes through an edge or corner
+constexpr float TIE_TOLERANCE = 1e-3f;
+
+// How many mismatches are printed before only counting them
+constexpr uint32_t MAX_PRINTED_MISMATCHES = 10;
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The box's chunks as plain block arrays. Everything outside of the box is air
+class BoxRaycastWorld
+{
+public:
+
+	BoxRaycastWorld(const ChunkCoord& minCS, const ChunkCoord& maxCS) :
+		m_minCS(minCS), m_maxCS(maxCS),
+		m_sizeY(maxCS.y - minCS.y + 1), m_sizeZ(maxCS.z - minCS.z + 1)
+	{
+		const uint32_t numChunks = static_cast<uint32_t>((maxCS.x - minCS.x + 1) * m_sizeY * m_sizeZ);
+		m_blocks.resize(static_cast<size_t>(numChunks) * BLOCKS_PER_CHUNK);
+		m_isEmpty.resize(numChunks);
+	}
+
+	void Generate()
+	{
+		for (int32_t x = m_minCS.x; x <= m_maxCS.x; x++)
+		{
+			for (int32_t y = m_minCS.y; y <= m_maxCS.y; y++)
+			{
+				for (int32_t z = m_minCS.z; z <= m_maxCS.z; z++)
+				{
+					const uint32_t index = GetChunkIndex(ChunkCoord(x, y, z));
+					BlockType* blocks = &m_blocks[static_cast<size_t>(index) * BLOCKS_PER_CHUNK];
+					TerrainGenerator::GenerateChunk(ChunkCoord(x, y, z), blocks);
+
+					m_isEmpty[index] = 1;
+					for (uint32_t i = 0; i < BLOCKS_PER_CHUNK; i++)
+					{
+						if (BlockRegistry::IsVisible(blocks[i])) { m_isEmpty[index] = 0; break; }
+					}
+				}
+			}
+		}
+	}
+
+	// Returns the chunk's blocks, or nullptr if it's outside of the box
+	const BlockType* GetChunk(const ChunkCoord& chunkPosCS) const
+	{
+		if (!IsInside(chunkPosCS)) return nullptr;
+		return &m_blocks[static_cast<size_t>(GetChunkIndex(chunkPosCS)) * BLOCKS_PER_CHUNK];
+	}
+
+	bool IsChunkEmpty(const ChunkCoord& chunkPosCS) const { return !IsInside(chunkPosCS) || m_isEmpty[GetChunkIndex(chunkPosCS)] != 0; }
+
+	bool IsVisible(const BlockCoord& posBS) const
+	{
+		const BlockType* blocks = GetChunk(Orange::Math::BlockToChunkCoord(posBS));
+		if (!blocks) return false;
+
+		const BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+		return BlockRegistry::IsVisible(blocks[DefaultChunkTraits::GetIndex(localPos.x, localPos.y, localPos.z)]);
+	}
+
+	uint32_t GetNumEmptyChunks() const
+	{
+		uint32_t numEmpty = 0;
+		for (const uint8_t isEmpty : m_isEmpty) numEmpty += isEmpty;
+		return numEmpty;
+	}
+
+	const ChunkCoord& GetMin() const { return m_minCS; }
+	const ChunkCoord& GetMax() const { return m_maxCS; }
+
+private:
+
+	bool IsInside(const ChunkCoord& chunkPosCS) const
+	{
+		return chunkPosCS.x >= m_minCS.x && chunkPosCS.x <= m_maxCS.x &&
+			chunkPosCS.y >= m_minCS.y && chunkPosCS.y <= m_maxCS.y &&
+			chunkPosCS.z >= m_minCS.z && chunkPosCS.z <= m_maxCS.z;
+	}
+
+	uint32_t GetChunkIndex(const ChunkCoord& chunkPosCS) const
+	{
+		return static_cast<uint32_t>(((chunkPosCS.x - m_minCS.x) * m_sizeY + (chunkPosCS.y - m_minCS.y)) * m_sizeZ + (chunkPosCS.z - m_minCS.z));
+	}
+
+	ChunkCoord m_minCS, m_maxCS;
+	int32_t m_sizeY, m_sizeZ;
+
+	std::vector<BlockType> m_blocks;
+	std::vector<uint8_t> m_isEmpty;
+};
+
+// Hits the box's visible blocks, holding on to the chunk the ray is in like TerrainRaycastQuery does
+class BoxRaycastQuery
+{
+public:
+
+	BoxRaycastQuery(const BoxRaycastWorld& world, const bool skipEmptyChunks) : m_world(&world), m_skipEmptyChunks(skipEmptyChunks) {}
+
+	bool IsChunkEmpty(const ChunkCoord& chunkPosCS)
+	{
+		m_chunk = m_world->GetChunk(chunkPosCS);
+		return m_skipEmptyChunks && m_world->IsChunkEmpty(chunkPosCS);
+	}
+
+	bool IsHit(const BlockCoord& posBS)
+	{
+		if (!m_chunk) return false;
+
+		const BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+		return BlockRegistry::IsVisible(m_chunk[DefaultChunkTraits::GetIndex(localPos.x, localPos.y, localPos.z)]);
+	}
+
+private:
+
+	const BoxRaycastWorld* m_world;
+	const BlockType* m_chunk = nullptr;
+	bool m_skipEmptyChunks;
+};
+
+// Looks the chunk up for every block through a callback, the way rays were cast before they kept their chunk
+class CallbackRaycastQuery
+{
+public:
+
+	CallbackRaycastQuery(std::function<bool(const BlockCoord&)> isHit) : m_isHit(isHit) {}
+
+	bool IsChunkEmpty(const ChunkCoord&) { return false; }
+	bool IsHit(const BlockCoord& posBS) { return m_isHit(posBS); }
+
+private:
+
+	std::function<bool(const BlockCoord&)> m_isHit;
+};
+
+// Intersects the ray with every visible block it could reach and keeps the closest. "outIsTie" is set if another block
+// (or another face of the same block) is within TIE_TOLERANCE of it
+static bool ReferenceRaycast(const BoxRaycastWorld& world, const Orange::Math::Ray& ray, Orange::Math::RaycastHit& outHit, bool& outIsTie)
+{
+	const float length = sqrtf(ray.direction.x * ray.direction.x + ray.direction.y * ray.direction.y + ray.direction.z * ray.direction.z);
+	const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+	const float direction[3] = { ray.direction.x / length, ray.direction.y / length, ray.direction.z / length };
+
+	int32_t minBlock[3], maxBlock[3];
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const float end = origin[i] + direction[i] * ray.maxDistance;
+		minBlock[i] = static_cast<int32_t>(floorf(min(origin[i], end)));
+		maxBlock[i] = static_cast<int32_t>(floorf(max(origin[i], end)));
+	}
+
+	bool isHit = false;
+	float secondDistance = std::numeric_limits<float>::infinity();
+	outIsTie = false;
+	for (int32_t x = minBlock[0]; x <= maxBlock[0]; x++)
+	{
+		for (int32_t y = minBlock[1]; y <= maxBlock[1]; y++)
+		{
+			for (int32_t z = minBlock[2]; z <= maxBlock[2]; z++)
+			{
+				if (!world.IsVisible(BlockCoord(x, y, z))) continue;
+
+				// Slabs, keeping the axis the ray goes in through last
+				const int32_t block[3] = { x, y, z };
+				float enter = 0.0f, exit = ray.maxDistance;
+				float enterByAxis[3] = { -1.0f, -1.0f, -1.0f };
+				bool isMissed = false;
+				for (uint32_t i = 0; i < 3 && !isMissed; i++)
+				{
+					if (direction[i] == 0.0f)
+					{
+						isMissed = origin[i] < block[i] || origin[i] >= block[i] + 1.0f;
+						continue;
+					}
+
+					float near = (block[i] - origin[i]) / direction[i];
+					float far = (block[i] + 1.0f - origin[i]) / direction[i];
+					if (near > far) std::swap(near, far);
+					enterByAxis[i] = near;
+					enter = max(enter, near);
+					exit = min(exit, far);
+					isMissed = enter > exit;
+				}
+
+				if (isMissed) continue;
+
+				if (isHit && enter >= outHit.distance)
+				{
+					secondDistance = min(secondDistance, enter);
+					continue;
+				}
+
+				if (isHit) secondDistance = outHit.distance;
+				isHit = true;
+				outHit.blockPosBS = BlockCoord(x, y, z);
+				outHit.distance = enter;
+
+				// Zero if the ray starts inside, otherwise the face of the slab it went in through last. Going in through
+				// two at once is a tie
+				int32_t normal[3] = { 0, 0, 0 };
+				if (enter > 0.0f)
+				{
+					int32_t axis = 0;
+					for (uint32_t i = 1; i < 3; i++) if (enterByAxis[i] > enterByAxis[axis]) axis = static_cast<int32_t>(i);
+					normal[axis] = direction[axis] > 0.0f ? -1 : 1;
+
+					for (uint32_t i = 0; i < 3; i++)
+					{
+						if (static_cast<int32_t>(i) != axis && enterByAxis[i] > enter - TIE_TOLERANCE) secondDistance = enter;
+					}
+				}
+				outHit.normal = BlockCoord(normal[0], normal[1], normal[2]);
+			}
+		}
+	}
+
+	if (isHit && secondDistance < outHit.distance + TIE_TOLERANCE) outIsTie = true;
+	return isHit;
+}
+
+static bool IsSameHit(const bool isHitA, const Orange::Math::RaycastHit& a, const bool isHitB, const Orange::Math::RaycastHit& b)
+{
+	if (isHitA != isHitB) return false;
+	return !isHitA || (a.blockPosBS == b.blockPosBS && a.normal == b.normal && fabsf(a.distance - b.distance) < TIE_TOLERANCE);
+}
+
+static void PrintHit(const char* name, const bool isHit, const Orange::Math::RaycastHit& hit)
+{
+	if (!isHit) printf("    %s: no hit\n", name);
+	else printf("    %s: block (%i, %i, %i), normal (%i, %i, %i), distance %.4f\n", name,
+		hit.blockPosBS.x, hit.blockPosBS.y, hit.blockPosBS.z, hit.normal.x, hit.normal.y, hit.normal.z, hit.distance);
+}
+
+// Random rays starting in the air inside the box, one in every AXIS_ALIGNED_RAY_INTERVAL going along an axis
+static std::vector<Orange::Math::Ray> MakeRays(const BoxRaycastWorld& world, std::mt19937& rng, const uint32_t numRays, const float length)
+{
+	const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(world.GetMin());
+	const DirectX::XMFLOAT3 maxWS = Orange::Math::ChunkToWorldSpace(world.GetMax() + ChunkCoord(1, 1, 1));
+	std::uniform_real_distribution<float> xDist(minWS.x, maxWS.x), yDist(minWS.y, maxWS.y), zDist(minWS.z, maxWS.z);
+	std::normal_distribution<float> directionDist(0.0f, 1.0f);
+
+	std::vector<Orange::Math::Ray> rays(numRays);
+	for (uint32_t i = 0; i < numRays; i++)
+	{
+		Orange::Math::Ray& ray = rays[i];
+
+		// Mostly in the air, the rest start inside a block
+		for (uint32_t attempt = 0; attempt < 16; attempt++)
+		{
+			ray.origin = { xDist(rng), yDist(rng), zDist(rng) };
+			if (!world.IsVisible(Orange::Math::WorldToBlockCoord(ray.origin))) break;
+		}
+
+		if (i % AXIS_ALIGNED_RAY_INTERVAL == 0)
+		{
+			const float sign = (rng() & 1) ? 1.0f : -1.0f;
+			const uint32_t axis = rng() % 3;
+			ray.direction = { axis == 0 ? sign : 0.0f, axis == 1 ? sign : 0.0f, axis == 2 ? sign : 0.0f };
+		}
+		else
+		{
+			do { ray.direction = { directionDist(rng), directionDist(rng), directionDist(rng) }; }
+			while (ray.direction.x == 0.0f && ray.direction.y == 0.0f && ray.direction.z == 0.0f);
+		}
+
+		ray.maxDistance = length;
+	}
+
+	return rays;
+}
+
+// Casts every ray and returns how long it took, in nanoseconds per ray. "outNumHits" is set to the number of rays that hit something
+template<typename Query>
+static float TimeRaycasts(const std::vector<Orange::Math::Ray>& rays, Query query, uint32_t& outNumHits)
+{
+	outNumHits = 0;
+	Orange::Math::RaycastHit hit;
+	const auto start = std::chrono::steady_clock::now();
+	for (const auto& ray : rays) outNumHits += Orange::Math::Raycast(ray, query, hit) ? 1 : 0;
+	return GetElapsedMs(start) * 1e6f / rays.size();
+}
+
+void RaycastCheckMode::PrintUsage()
+{
+	printf("  raycheck [--min x,y,z] [--max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]\n");
+	printf("           [--definitions FILE] [--rays N] [--threads N]\n");
+	printf("      Checks and times raycasts on the terrain of the box (in CHUNK SPACE, inclusive)\n");
+}
+
+int RaycastCheckMode::Run(const std::vector<std::string>& args)
+{
+	ChunkCoord minCS = DEFAULT_MIN_CS;
+	ChunkCoord maxCS = DEFAULT_MAX_CS;
+
+	const char* minArg = Headless::FindArg(args, "--min");
+	const char* maxArg = Headless::FindArg(args, "--max");
+	if ((minArg && !Headless::ParseCoord(minArg, minCS.x, minCS.y, minCS.z)) ||
+		(maxArg && !Headless::ParseCoord(maxArg, maxCS.x, maxCS.y, maxCS.z)))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (minCS.x > maxCS.x) std::swap(minCS.x, maxCS.x);
+	if (minCS.y > maxCS.y) std::swap(minCS.y, maxCS.y);
+	if (minCS.z > maxCS.z) std::swap(minCS.z, maxCS.z);
+
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	TerrainShape terrainShape;
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseTerrainShape(Headless::FindArg(args, "--terrain"), terrainShape) ||
+		!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const char* definitionsArg = Headless::FindArg(args, "--definitions");
+	const char* raysArg = Headless::FindArg(args, "--rays");
+	const uint32_t numRays = max(raysArg ? static_cast<uint32_t>(atoi(raysArg)) : DEFAULT_NUM_RAYS, 1u);
+
+	const char* threadsArg = Headless::FindArg(args, "--threads");
+	uint32_t numThreads = threadsArg ? static_cast<uint32_t>(atoi(threadsArg)) : std::thread::hardware_concurrency();
+	numThreads = max(numThreads, 1u);
+
+	BlockRegistry::Initialize(definitionsArg ? definitionsArg : "../Source/Data/BlockDefinitions.txt");
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetTerrainShape(terrainShape);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	BoxRaycastWorld world(minCS, maxCS);
+	world.Generate();
+
+	const uint32_t numChunks = static_cast<uint32_t>((maxCS.x - minCS.x + 1) * (maxCS.y - minCS.y + 1) * (maxCS.z - minCS.z + 1));
+	printf("Casting rays through %u chunks from (%i, %i, %i) to (%i, %i, %i) with seed %llu, %u of them empty\n\n",
+		numChunks, minCS.x, minCS.y, minCS.z, maxCS.x, maxCS.y, maxCS.z, seed, world.GetNumEmptyChunks());
+
+	std::mt19937 rng(static_cast<uint32_t>(seed));
+	const std::vector<Orange::Math::Ray> checkedRays = MakeRays(world, rng, numRays, CHECKED_RAY_LENGTH);
+
+	uint32_t numMismatches = 0;
+	uint32_t numTies = 0;
+	uint32_t numHits = 0;
+	for (const auto& ray : checkedRays)
+	{
+		Orange::Math::RaycastHit expectedHit = {}, hit = {}, skippedHit = {};
+		bool isTie;
+		const bool isExpectedHit = ReferenceRaycast(world, ray, expectedHit, isTie);
+
+		BoxRaycastQuery query(world, false), skippingQuery(world, true);
+		const bool isHit = Orange::Math::Raycast(ray, query, hit);
+		const bool isSkippedHit = Orange::Math::Raycast(ray, skippingQuery, skippedHit);
+
+		numHits += isExpectedHit ? 1 : 0;
+
+		// Where the ray grazes an edge or corner either block (or face) is right, as long as they're as far away
+		const bool isMatch = IsSameHit(isExpectedHit, expectedHit, isHit, hit) ||
+			(isTie && isHit && fabsf(hit.distance - expectedHit.distance) < TIE_TOLERANCE);
+		const bool isSkippedMatch = IsSameHit(isHit, hit, isSkippedHit, skippedHit) ||
+			(isTie && isSkippedHit && fabsf(skippedHit.distance - expectedHit.distance) < TIE_TOLERANCE);
+		numTies += isTie ? 1 : 0;
+
+		if (isMatch && isSkippedMatch) continue;
+
+		if (numMismatches++ < MAX_PRINTED_MISMATCHES)
+		{
+			printf("  Ray from (%.4f, %.4f, %.4f) towards (%.4f, %.4f, %.4f)\n", ray.origin.x, ray.origin.y, ray.origin.z, ray.direction.x, ray.direction.y, ray.direction.z);
+			PrintHit("Expected", isExpectedHit, expectedHit);
+			PrintHit("Raycast", isHit, hit);
+			PrintHit("Skipping empty chunks", isSkippedHit, skippedHit);
+		}
+	}
+
+	printf("Checked %u rays of %.0f blocks: %u hit something, %u through an edge or corner, %u mismatches\n\n",
+		numRays, CHECKED_RAY_LENGTH, numHits, numTies, numMismatches);
+
+	// The same number of rays per test, long enough to cross a few chunks
+	const std::vector<Orange::Math::Ray> timedRays = MakeRays(world, rng, numRays * NUM_TIMED_RAYS_PER_RAY, TIMED_RAY_LENGTH);
+	uint32_t numLookupHits, numKeptHits, numSkippingHits;
+	const float lookupNs = TimeRaycasts(timedRays, CallbackRaycastQuery([&world](const BlockCoord& posBS) { return world.IsVisible(posBS); }), numLookupHits);
+	const float keptNs = TimeRaycasts(timedRays, BoxRaycastQuery(world, false), numKeptHits);
+	const float skippingNs = TimeRaycasts(timedRays, BoxRaycastQuery(world, true), numSkippingHits);
+
+	std::unique_ptr<bool[]> isBatchHit(new bool[timedRays.size()]);
+	std::vector<Orange::Math::RaycastHit> batchHits(timedRays.size());
+	const auto batchStart = std::chrono::steady_clock::now();
+	Orange::Math::RaycastBatch(timedRays.data(), static_cast<uint32_t>(timedRays.size()), BoxRaycastQuery(world, true), isBatchHit.get(), batchHits.data(), numThreads);
+	const float batchNs = GetElapsedMs(batchStart) * 1e6f / timedRays.size();
+
+	uint32_t numBatchHits = 0;
+	for (size_t i = 0; i < timedRays.size(); i++) numBatchHits += isBatchHit[i] ? 1 : 0;
+
+	printf("Casting %u rays of %.0f blocks, in ns per ray:\n", static_cast<uint32_t>(timedRays.size()), TIMED_RAY_LENGTH);
+	printf("  Chunk lookup for every block:     %8.1f (%u hits)\n", lookupNs, numLookupHits);
+	printf("  Chunk kept between blocks:        %8.1f (%u hits)\n", keptNs, numKeptHits);
+	printf("  Empty chunks skipped:             %8.1f (%u hits)\n", skippingNs, numSkippingHits);
+	printf("  Batch on %2u threads:              %8.1f (%u hits)\n", numThreads, batchNs, numBatchHits);
+
+	// Skipping empty chunks mustn't change what's hit
+	if (numLookupHits != numKeptHits || numKeptHits != numSkippingHits || numSkippingHits != numBatchHits)
+	{
+		printf("\nThe number of hits differs\n");
+		numMismatches++;
+	}
+
+	return numMismatches == 0 ? 0 : 1;
+}
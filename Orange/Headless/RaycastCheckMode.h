@@ -0,0 +1,25 @@
+#ifndef _RAYCASTCHECKMODE_H
+#define _RAYCASTCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks and times Orange::Math::Raycast() on generated terrain:
+//
+//		raycheck [--min x,y,z] [--max x,y,z] [--seed N] [--terrain heightmap|density] [--noise simplex|hash]
+//		         [--definitions FILE] [--rays N] [--threads N]
+//
+// Generates every chunk of the box and casts random rays through it, checking the blocks and faces they hit against
+// intersecting the ray with every block around it, with and without skipping empty chunks. Then times long rays with
+// a chunk lookup for every block, with the chunk kept between blocks, with empty chunks skipped and in batches
+class RaycastCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
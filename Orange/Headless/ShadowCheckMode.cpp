@@ -0,0 +1,366 @@
+#include "../Source/Misc/pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+
+#include "ShadowCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/ChunkDrawList.h"
+#include "../Source/Core/ShadowCascades.h"
+
+// 17^3 chunks, the game's default render distance
+constexpr int32_t DEFAULT_RADIUS = 8;
+constexpr uint32_t DEFAULT_NUM_VIEWS = 64;
+constexpr uint32_t DEFAULT_ITERATIONS = 20;
+constexpr float DEFAULT_SHADOW_DISTANCE = 128.0f;
+constexpr uint32_t SHADOW_MAP_RESOLUTION = 2048;
+
+// Instances every chunk gets in the timed draw lists
+constexpr uint32_t INSTANCES_PER_CHUNK = 256;
+
+// Slack for rounding, in world units
+constexpr float TOLERANCE = 1e-3f;
+
+// How many failures are printed before only counting them
+constexpr uint32_t MAX_PRINTED_FAILURES = 10;
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Same camera basis Headless::BuildFrustum() uses
+static ShadowCameraView BuildCameraView(const DirectX::XMFLOAT3& cameraPos, const float yaw, const float pitch)
+{
+	ShadowCameraView view;
+	view.position = cameraPos;
+	view.forward = { cosf(pitch) * sinf(yaw), sinf(pitch), cosf(pitch) * cosf(yaw) };
+	view.right = Headless::Normalize({ view.forward.z, 0.0f, -view.forward.x });
+	view.up = { view.forward.y * view.right.z - view.forward.z * view.right.y, view.forward.z * view.right.x - view.forward.x * view.right.z, view.forward.x * view.right.y - view.forward.y * view.right.x };
+	view.tanHalfFov = tanf(Headless::CAMERA_FOV / 2.0f);
+	view.aspectRatio = Headless::CAMERA_ASPECT_RATIO;
+	view.nearDepth = Headless::CAMERA_NEAR_PLANE;
+	return view;
+}
+
+static DirectX::XMFLOAT3 GetChunkCenter(const ChunkCoord& chunkPosCS)
+{
+	const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+	return { minWS.x + DefaultChunkTraits::HALF_EXTENT, minWS.y + DefaultChunkTraits::HALF_EXTENT, minWS.z + DefaultChunkTraits::HALF_EXTENT };
+}
+
+static float GetExtentAlong(const DirectX::XMFLOAT3& axis)
+{
+	return DefaultChunkTraits::HALF_EXTENT * (fabsf(axis.x) + fabsf(axis.y) + fabsf(axis.z));
+}
+
+// How far the chunk's light-space AABB is inside the cascade's box, open towards the light. Negative if it's outside
+static float GetCasterMargin(const ShadowCascades& cascades, const ShadowCascade& cascade, const ChunkCoord& chunkPosCS)
+{
+	const DirectX::XMFLOAT3 centerLS = cascades.ToLightSpace(GetChunkCenter(chunkPosCS));
+	const float extentX = GetExtentAlong(cascades.GetLightRight());
+	const float extentY = GetExtentAlong(cascades.GetLightUp());
+	const float extentZ = GetExtentAlong(cascades.GetLightForward());
+
+	float margin = centerLS.x + extentX - cascade.minLS.x;
+	margin = min(margin, cascade.maxLS.x - (centerLS.x - extentX));
+	margin = min(margin, centerLS.y + extentY - cascade.minLS.y);
+	margin = min(margin, cascade.maxLS.y - (centerLS.y - extentY));
+	margin = min(margin, cascade.maxLS.z - (centerLS.z - extentZ));
+	return margin;
+}
+
+static uint32_t ReportFailure(uint32_t& numPrinted, const char* what, const uint32_t viewIndex, const uint32_t cascadeIndex)
+{
+	if (numPrinted++ < MAX_PRINTED_FAILURES) printf("  View %u, cascade %u: %s\n", viewIndex, cascadeIndex, what);
+	return 1;
+}
+
+// Checks every cascade fitted to "view" against its slice of the camera frustum, and the chunks its caster planes find
+// against GetCasterMargin(). Returns the number of failed checks
+static uint32_t CheckCascades(const ShadowCascades& cascades, const ShadowCameraView& view, const float shadowDistance, const ChunkCuller& culler,
+	const std::vector<ChunkCoord>& chunks, const uint32_t viewIndex, uint32_t& numPrinted)
+{
+	uint32_t numFailures = 0;
+	std::vector<ChunkCoord> casters;
+
+	const float tanHalfWidth = view.tanHalfFov * view.aspectRatio;
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+	{
+		const ShadowCascade& cascade = cascades.GetCascade(i);
+		const float expectedNear = i == 0 ? view.nearDepth : cascades.GetCascade(i - 1).splitFar;
+		if (cascade.splitNear != expectedNear || cascade.splitFar <= cascade.splitNear) numFailures += ReportFailure(numPrinted, "splits aren't contiguous", viewIndex, i);
+		if (i == NUM_SHADOW_CASCADES - 1 && cascade.splitFar != shadowDistance) numFailures += ReportFailure(numPrinted, "splits don't end at the shadow distance", viewIndex, i);
+
+		// The box only ever grows by whole texels around the snapped center
+		const float centerX = (cascade.minLS.x + cascade.maxLS.x) / 2.0f / cascade.texelSize;
+		const float centerY = (cascade.minLS.y + cascade.maxLS.y) / 2.0f / cascade.texelSize;
+		if (fabsf(centerX - roundf(centerX)) > 1e-2f || fabsf(centerY - roundf(centerY)) > 1e-2f) numFailures += ReportFailure(numPrinted, "center isn't on a texel", viewIndex, i);
+
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			const float depth = (corner & 1) ? cascade.splitFar : cascade.splitNear;
+			const float x = ((corner & 2) ? 1.0f : -1.0f) * depth * tanHalfWidth;
+			const float y = ((corner & 4) ? 1.0f : -1.0f) * depth * view.tanHalfFov;
+			const DirectX::XMFLOAT3 cornerWS =
+			{
+				view.position.x + view.forward.x * depth + view.right.x * x + view.up.x * y,
+				view.position.y + view.forward.y * depth + view.right.y * x + view.up.y * y,
+				view.position.z + view.forward.z * depth + view.right.z * x + view.up.z * y
+			};
+
+			const DirectX::XMFLOAT3 cornerLS = cascades.ToLightSpace(cornerWS);
+			if (cornerLS.x < cascade.minLS.x - TOLERANCE || cornerLS.x > cascade.maxLS.x + TOLERANCE ||
+				cornerLS.y < cascade.minLS.y - TOLERANCE || cornerLS.y > cascade.maxLS.y + TOLERANCE ||
+				cornerLS.z < cascade.minLS.z - TOLERANCE || cornerLS.z > cascade.maxLS.z + TOLERANCE)
+			{
+				numFailures += ReportFailure(numPrinted, "box doesn't cover the slice", viewIndex, i);
+				break;
+			}
+		}
+
+		casters.clear();
+		culler.Cull(cascade.casterPlanes.data(), casters);
+
+		std::unordered_map<uint64_t, bool> found;
+		for (const auto& chunkPosCS : casters) found[Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)] = true;
+
+		// Chunks right on the box's sides can go either way
+		for (const auto& chunkPosCS : chunks)
+		{
+			const float margin = GetCasterMargin(cascades, cascade, chunkPosCS);
+			const bool isFound = found.count(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)) != 0;
+			if ((margin > TOLERANCE && !isFound) || (margin < -TOLERANCE && isFound))
+			{
+				numFailures += ReportFailure(numPrinted, isFound ? "found a chunk outside the box" : "missed a caster", viewIndex, i);
+				break;
+			}
+		}
+	}
+
+	return numFailures;
+}
+
+// A pillar of chunks behind the camera and above it, with the sun behind it too, so its shadow falls in front of the
+// camera. None of it is in view, all of it has to be drawn into the shadow map
+static uint32_t CheckOffscreenCaster(const float shadowDistance)
+{
+	const DirectX::XMFLOAT3 cameraPos = { DefaultChunkTraits::HALF_EXTENT, 2.0f, DefaultChunkTraits::HALF_EXTENT };
+	const Headless::FrustumPlanes frustum = Headless::BuildFrustum(cameraPos, 0.0f, 0.0f);
+
+	ShadowCascades cascades;
+	cascades.SetLightDirection({ 0.0f, -1.0f, 1.0f });
+	cascades.Fit(BuildCameraView(cameraPos, 0.0f, 0.0f), shadowDistance, SHADOW_MAP_RESOLUTION);
+
+	ChunkCuller culler;
+	const int32_t pillarHeight = 4;
+	for (int32_t y = 1; y <= pillarHeight; y++) culler.Add(ChunkCoord(0, y, -2));
+
+	uint32_t numFailures = 0;
+	for (int32_t y = 1; y <= pillarHeight; y++)
+	{
+		const ChunkCoord chunkPosCS(0, y, -2);
+		if (ChunkCuller::IsChunkVisible(frustum.data(), chunkPosCS))
+		{
+			printf("  Pillar chunk %i is in view\n", y);
+			numFailures++;
+		}
+	}
+
+	std::unordered_map<uint64_t, uint32_t> numCascades;
+	std::vector<ChunkCoord> casters;
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+	{
+		casters.clear();
+		culler.Cull(cascades.GetCascade(i).casterPlanes.data(), casters);
+		for (const auto& chunkPosCS : casters) numCascades[Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)]++;
+	}
+
+	for (int32_t y = 1; y <= pillarHeight; y++)
+	{
+		const uint32_t count = numCascades[Orange::Math::GetHashKeyFromChunkPosition(ChunkCoord(0, y, -2))];
+		printf("  Pillar chunk at height %i casts into %u cascade(s)\n", y, count);
+		if (count == 0) numFailures++;
+	}
+
+	return numFailures;
+}
+
+// Pulls the near Z of every cascade in to its casters and checks that every one of them is behind it
+static uint32_t CheckCasterDepth(ShadowCascades& cascades, const ChunkCuller& culler, const uint32_t viewIndex, uint32_t& numPrinted)
+{
+	uint32_t numFailures = 0;
+	std::vector<ChunkCoord> casters;
+	const float extent = GetExtentAlong(cascades.GetLightForward());
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+	{
+		const float fittedMinZ = cascades.GetCascade(i).minLS.z;
+
+		casters.clear();
+		culler.Cull(cascades.GetCascade(i).casterPlanes.data(), casters);
+		cascades.FitCasterDepth(i, casters);
+
+		const ShadowCascade& cascade = cascades.GetCascade(i);
+		if (cascade.minLS.z > fittedMinZ) numFailures += ReportFailure(numPrinted, "caster depth shrank the box", viewIndex, i);
+
+		for (const auto& chunkPosCS : casters)
+		{
+			if (cascades.ToLightSpace(GetChunkCenter(chunkPosCS)).z - extent < cascade.minLS.z - TOLERANCE)
+			{
+				numFailures += ReportFailure(numPrinted, "caster in front of the near plane", viewIndex, i);
+				break;
+			}
+		}
+	}
+
+	return numFailures;
+}
+
+void ShadowCheckMode::PrintUsage()
+{
+	printf("  shadowcheck [--radius N] [--views N] [--iterations N] [--seed N] [--distance N]\n");
+	printf("      Checks and times fitting cascaded shadow maps to the camera and culling their casters\n");
+}
+
+int ShadowCheckMode::Run(const std::vector<std::string>& args)
+{
+	const char* radiusArg = Headless::FindArg(args, "--radius");
+	const char* viewsArg = Headless::FindArg(args, "--views");
+	const char* iterationsArg = Headless::FindArg(args, "--iterations");
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const char* distanceArg = Headless::FindArg(args, "--distance");
+
+	const int32_t radius = max(radiusArg ? atoi(radiusArg) : DEFAULT_RADIUS, 1);
+	const uint32_t numViews = max(viewsArg ? static_cast<uint32_t>(atoi(viewsArg)) : DEFAULT_NUM_VIEWS, 1u);
+	const uint32_t iterations = max(iterationsArg ? static_cast<uint32_t>(atoi(iterationsArg)) : DEFAULT_ITERATIONS, 1u);
+	const uint32_t seed = seedArg ? static_cast<uint32_t>(strtoul(seedArg, nullptr, 10)) : 0;
+	const float shadowDistance = max(distanceArg ? static_cast<float>(atof(distanceArg)) : DEFAULT_SHADOW_DISTANCE, 1.0f);
+
+	// Every chunk gets the same number of instances, one after the other, like a freshly loaded world
+	ChunkCuller culler;
+	std::vector<ChunkCoord> chunks;
+	std::unordered_map<uint64_t, uint32_t> startInstances;
+	for (int32_t x = -radius; x <= radius; x++)
+	{
+		for (int32_t y = -radius; y <= radius; y++)
+		{
+			for (int32_t z = -radius; z <= radius; z++)
+			{
+				chunks.emplace_back(x, y, z);
+				culler.Add(chunks.back());
+				startInstances[Orange::Math::GetHashKeyFromChunkPosition(chunks.back())] = static_cast<uint32_t>(startInstances.size()) * INSTANCES_PER_CHUNK;
+			}
+		}
+	}
+
+	const std::array<float, NUM_SHADOW_CASCADES> splitDepths = ShadowCascades::GetSplitDepths(Headless::CAMERA_NEAR_PLANE, shadowDistance);
+	printf("%u cascades up to %.1f units, split at", NUM_SHADOW_CASCADES, shadowDistance);
+	for (const float depth : splitDepths) printf(" %.2f", depth);
+	printf("\n\n");
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * 3.14159265f);
+	std::uniform_real_distribution<float> pitchDist(-1.4f, 1.4f);
+	std::uniform_real_distribution<float> offsetDist(-24.0f, 24.0f);
+
+	struct View
+	{
+		ShadowCameraView camera;
+		DirectX::XMFLOAT3 lightDirection;
+	};
+
+	std::vector<View> views(numViews);
+	for (auto& view : views)
+	{
+		const DirectX::XMFLOAT3 cameraPos = { DefaultChunkTraits::HALF_EXTENT + offsetDist(rng), DefaultChunkTraits::HALF_EXTENT + offsetDist(rng), DefaultChunkTraits::HALF_EXTENT + offsetDist(rng) };
+		view.camera = BuildCameraView(cameraPos, angleDist(rng), pitchDist(rng));
+
+		// Anywhere from straight down to just above the horizon
+		const float lightYaw = angleDist(rng);
+		const float lightPitch = std::uniform_real_distribution<float>(0.1f, 3.14159265f / 2.0f)(rng);
+		view.lightDirection = { cosf(lightPitch) * sinf(lightYaw), -sinf(lightPitch), cosf(lightPitch) * cosf(lightYaw) };
+	}
+
+	printf("Checking %u views against %u chunks (%i in every direction)\n", numViews, static_cast<uint32_t>(chunks.size()), radius);
+
+	uint32_t numFailures = 0;
+	uint32_t numPrinted = 0;
+	ShadowCascades cascades;
+	std::array<float, NUM_SHADOW_CASCADES> boxSizes = {};
+	for (uint32_t v = 0; v < numViews; v++)
+	{
+		cascades.SetLightDirection(views[v].lightDirection);
+		cascades.Fit(views[v].camera, shadowDistance, SHADOW_MAP_RESOLUTION);
+		numFailures += CheckCascades(cascades, views[v].camera, shadowDistance, culler, chunks, v, numPrinted);
+
+		// Turning the camera or the light mustn't change how big the cascades are
+		for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+		{
+			const ShadowCascade& cascade = cascades.GetCascade(i);
+			const float size = cascade.maxLS.x - cascade.minLS.x;
+			if (v == 0) boxSizes[i] = size;
+			else if (fabsf(size - boxSizes[i]) > TOLERANCE || fabsf(cascade.maxLS.y - cascade.minLS.y - size) > TOLERANCE)
+			{
+				numFailures += ReportFailure(numPrinted, "box changed size", v, i);
+			}
+		}
+
+		numFailures += CheckCasterDepth(cascades, culler, v, numPrinted);
+	}
+
+	printf("  Cascade sizes:");
+	for (const float size : boxSizes) printf(" %.2f", size);
+	printf(" units\n\nChecking a caster behind the camera\n");
+	numFailures += CheckOffscreenCaster(shadowDistance);
+
+	// What the game would do every frame: fit, cull the casters from every loaded chunk, and build a draw list per cascade
+	std::array<ChunkDrawList, NUM_SHADOW_CASCADES> drawLists;
+	std::array<uint64_t, NUM_SHADOW_CASCADES> numCasters = {};
+	std::array<uint64_t, NUM_SHADOW_CASCADES> numDraws = {};
+	std::vector<ChunkCoord> casters;
+	casters.reserve(chunks.size());
+
+	const uint32_t numInstances = static_cast<uint32_t>(chunks.size()) * INSTANCES_PER_CHUNK;
+	const auto start = std::chrono::steady_clock::now();
+	for (uint32_t iteration = 0; iteration < iterations; iteration++)
+	{
+		for (const auto& view : views)
+		{
+			cascades.SetLightDirection(view.lightDirection);
+			cascades.Fit(view.camera, shadowDistance, SHADOW_MAP_RESOLUTION);
+			for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+			{
+				casters.clear();
+				culler.Cull(cascades.GetCascade(i).casterPlanes.data(), casters);
+				cascades.FitCasterDepth(i, casters);
+
+				const DirectX::XMFLOAT3 lightPosWS = cascades.GetLightPosition(i);
+				ChunkDrawList& drawList = drawLists[i];
+				drawList.Clear();
+				for (const auto& chunkPosCS : casters)
+				{
+					const DirectX::XMFLOAT3 centerWS = GetChunkCenter(chunkPosCS);
+					const float dx = centerWS.x - lightPosWS.x, dy = centerWS.y - lightPosWS.y, dz = centerWS.z - lightPosWS.z;
+					drawList.AddChunk(startInstances[Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)], INSTANCES_PER_CHUNK, dx * dx + dy * dy + dz * dz);
+				}
+				drawList.Build(numInstances);
+
+				numCasters[i] += casters.size();
+				numDraws[i] += drawList.GetRanges().size();
+			}
+		}
+	}
+	const float elapsedMs = GetElapsedMs(start);
+	const uint32_t numFrames = iterations * numViews;
+
+	printf("\nFitting, culling and building the draw lists of %u cascades: %.3f ms per frame\n", NUM_SHADOW_CASCADES, elapsedMs / numFrames);
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+	{
+		printf("  Cascade %u: %.1f casters, %.1f draws\n", i, static_cast<double>(numCasters[i]) / numFrames, static_cast<double>(numDraws[i]) / numFrames);
+	}
+
+	printf("\n%u failed checks\n", numFailures);
+	return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#ifndef _SHADOWCHECKMODE_H
+#define _SHADOWCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks and times fitting cascaded shadow maps and culling their casters:
+//
+//		shadowcheck [--radius N] [--views N] [--iterations N] [--seed N] [--distance N]
+//
+// Fits the cascades to a number of random views and light directions and checks that the splits cover the shadow
+// distance, that every cascade covers its slice of the camera frustum without changing size or moving by less than a
+// texel, and that the casters found by culling every chunk within N chunks of the camera match a test in light space.
+// Then checks that a chunk behind the camera still casts into the view, and times fitting, culling and building the
+// draw lists for every cascade
+class ShadowCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
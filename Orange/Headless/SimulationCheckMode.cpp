@@ -0,0 +1,305 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <functional>
+#include <random>
+
+#include "SimulationCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/BlockRegistry.h"
+#include "../Source/Core/Physics.h"
+#include "../Source/Core/WorldGen/TerrainGenerator.h"
+#include "../Source/Utility/FixedTimestep.h"
+
+constexpr uint32_t DEFAULT_SECONDS = 600;
+
+// How long every frame rate is checked for, in simulated seconds
+constexpr uint32_t CHECKED_SECONDS = 30;
+
+// The player's hitbox and movement (see Player and PlayerController)
+constexpr DirectX::XMFLOAT3 BODY_EXTENT = { 0.25f, 1.0f, 0.25f };
+constexpr float WALK_SPEED = 7.0f;
+constexpr float JUMP_HEIGHT = 1.1f;
+constexpr float JUMP_TIME = 0.32f;
+constexpr float GRAVITY = (-2.0f * JUMP_HEIGHT) / (JUMP_TIME * JUMP_TIME);
+constexpr float INITIAL_JUMP_VELOCITY = (2.0f * JUMP_HEIGHT) / JUMP_TIME;
+constexpr float TERMINAL_VELOCITY = 4.0f * -GRAVITY;
+
+// The body turns this often (in seconds), by the golden angle so it doesn't keep walking over the same ground
+constexpr double TURN_INTERVAL = 2.0;
+constexpr float TURN_ANGLE = 2.39996323f;
+
+// How far along X (in blocks) the body looks for dry land to start on, and how far apart the columns it tries are
+constexpr int32_t MAX_SPAWN_SEARCH_DISTANCE = 4096;
+constexpr int32_t SPAWN_SEARCH_STEP = 8;
+
+// What Application::Update() used to clamp frame times with
+constexpr float OLD_MAX_FRAME_TIME = 0.5f;
+constexpr float OLD_CLAMPED_FRAME_TIME = 0.016666f;
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Collides with the generated terrain, without any chunks
+class GeneratedTerrainQuery
+{
+public:
+
+	bool IsSolid(const BlockCoord& posBS) { return BlockRegistry::IsCollidable(TerrainGenerator::QueryBlock(posBS)); }
+};
+
+struct Body
+{
+	Orange::AABB box;
+	DirectX::XMFLOAT3 velocity;
+	bool isGrounded;
+};
+
+// Walks the body for "dt" seconds from "time", jumping whenever it lands
+static void StepBody(Body& body, const double time, const float dt, GeneratedTerrainQuery& query)
+{
+	const float heading = static_cast<float>(floor(time / TURN_INTERVAL)) * TURN_ANGLE;
+	body.velocity.x = cosf(heading) * WALK_SPEED;
+	body.velocity.z = sinf(heading) * WALK_SPEED;
+
+	if (body.isGrounded) body.velocity.y = INITIAL_JUMP_VELOCITY;
+	body.velocity.y = max(body.velocity.y + GRAVITY * dt, -TERMINAL_VELOCITY);
+
+	Orange::SweepResult result;
+	Orange::Physics::SweepAABB(body.box, { body.velocity.x * dt, body.velocity.y * dt, body.velocity.z * dt }, query, result);
+
+	body.box.center = { body.box.center.x + result.motion.x, body.box.center.y + result.motion.y, body.box.center.z + result.motion.z };
+	body.isGrounded = result.normal.y > 0;
+	if (result.normal.y != 0) body.velocity.y = 0.0f;
+}
+
+static bool IsSameBody(const Body& a, const Body& b)
+{
+	return a.box.center.x == b.box.center.x && a.box.center.y == b.box.center.y && a.box.center.z == b.box.center.z &&
+		a.velocity.x == b.velocity.x && a.velocity.y == b.velocity.y && a.velocity.z == b.velocity.z && a.isGrounded == b.isGrounded;
+}
+
+static float GetDistance(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+{
+	return sqrtf((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+}
+
+struct FramePattern
+{
+	const char* name;
+
+	// Returns the time of the frame with the given index, in seconds
+	std::function<float(uint32_t)> getFrameTime;
+};
+
+struct FixedRunResult
+{
+	Body body;
+	uint32_t numFrames = 0;
+	uint32_t maxTicksInFrame = 0;
+	double droppedTime = 0.0;
+	bool isTimeConsistent = true;
+};
+
+// Feeds the pattern's frames to a fixed timestep until it's simulated "numTicks" ticks, and checks on every frame that
+// the time handed over adds up to the ticks simulated, what's left over and what was dropped
+static FixedRunResult RunFixed(const Body& start, const FramePattern& pattern, const float tickRate, const uint64_t numTicks)
+{
+	GeneratedTerrainQuery query;
+	FixedTimestep timestep(tickRate);
+	FixedRunResult result;
+	result.body = start;
+
+	double totalFrameTime = 0.0;
+	uint64_t tick = 0;
+	while (tick < numTicks)
+	{
+		const uint32_t frameTicks = timestep.Advance(pattern.getFrameTime(result.numFrames++));
+		totalFrameTime += timestep.GetFrameTime();
+		result.maxTicksInFrame = max(result.maxTicksInFrame, frameTicks);
+
+		for (uint32_t i = 0; i < frameTicks && tick < numTicks; i++, tick++)
+		{
+			StepBody(result.body, tick * static_cast<double>(timestep.GetTickDuration()), timestep.GetTickDuration(), query);
+		}
+
+		const double accountedTime = (timestep.GetNumTicks() + timestep.GetInterpolationAlpha()) * static_cast<double>(timestep.GetTickDuration());
+		if (fabs(accountedTime - totalFrameTime) > 1e-3 || timestep.GetInterpolationAlpha() < 0.0f || timestep.GetInterpolationAlpha() > 1.0f)
+		{
+			result.isTimeConsistent = false;
+		}
+	}
+
+	result.droppedTime = timestep.GetDroppedTime();
+	return result;
+}
+
+// Steps the body by every frame's time, clamped the way it used to be, for "seconds" seconds
+static Body RunVariable(const Body& start, const FramePattern& pattern, const double seconds)
+{
+	GeneratedTerrainQuery query;
+	Body body = start;
+
+	double time = 0.0;
+	for (uint32_t frame = 0; time < seconds; frame++)
+	{
+		float dt = pattern.getFrameTime(frame);
+		dt = dt > OLD_MAX_FRAME_TIME ? OLD_CLAMPED_FRAME_TIME : dt;
+		dt = static_cast<float>(min(static_cast<double>(dt), seconds - time));
+
+		StepBody(body, time, dt, query);
+		time += dt;
+	}
+
+	return body;
+}
+
+void SimulationCheckMode::PrintUsage()
+{
+	printf("  simcheck [--seed N] [--terrain heightmap|density] [--noise simplex|hash] [--definitions FILE] [--rate N] [--seconds N]\n");
+	printf("      Checks that fixed ticks at N per second don't depend on the frame rate, then simulates N seconds as fast as possible\n");
+}
+
+int SimulationCheckMode::Run(const std::vector<std::string>& args)
+{
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	TerrainShape terrainShape;
+	NoiseBackend noiseBackend;
+	if (!Headless::ParseTerrainShape(Headless::FindArg(args, "--terrain"), terrainShape) ||
+		!Headless::ParseNoiseBackend(Headless::FindArg(args, "--noise"), noiseBackend))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const char* definitionsArg = Headless::FindArg(args, "--definitions");
+
+	const char* rateArg = Headless::FindArg(args, "--rate");
+	const float tickRate = rateArg ? static_cast<float>(atof(rateArg)) : FixedTimestep::DEFAULT_TICK_RATE;
+	if (tickRate <= 0.0f)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const char* secondsArg = Headless::FindArg(args, "--seconds");
+	const uint32_t seconds = max(secondsArg ? static_cast<uint32_t>(atoi(secondsArg)) : DEFAULT_SECONDS, 1u);
+
+	BlockRegistry::Initialize(definitionsArg ? definitionsArg : "../Source/Data/BlockDefinitions.txt");
+	TerrainGenerator::SetSeed(seed);
+	TerrainGenerator::SetTerrainShape(terrainShape);
+	TerrainGenerator::SetNoiseBackend(noiseBackend);
+
+	// Dropped right above the first column along X that's dry land, water doesn't hold anything up
+	int32_t spawnX = 0;
+	int32_t surfaceHeight = 0;
+	for (int32_t x = 0; x < MAX_SPAWN_SEARCH_DISTANCE; x += SPAWN_SEARCH_STEP)
+	{
+		spawnX = x;
+		if (TerrainGenerator::QuerySurfaceHeight(x, 0, -1024, surfaceHeight) &&
+			BlockRegistry::IsCollidable(TerrainGenerator::QueryBlock(BlockCoord(x, surfaceHeight, 0)))) break;
+	}
+
+	Body start;
+	start.box = { { spawnX + 0.5f, static_cast<float>(surfaceHeight) + 1.0f + BODY_EXTENT.y + 0.5f, 0.5f }, BODY_EXTENT };
+	start.velocity = { 0.0f, 0.0f, 0.0f };
+	start.isGrounded = false;
+
+	std::mt19937 rng(static_cast<uint32_t>(seed));
+	std::uniform_real_distribution<float> jitterDist(0.004f, 0.040f);
+	std::vector<float> jitteryFrames(static_cast<size_t>(CHECKED_SECONDS / 0.004f) + 1);
+	for (float& frameTime : jitteryFrames) frameTime = jitterDist(rng);
+
+	const FramePattern patterns[] =
+	{
+		{ "60 fps", [](uint32_t) { return 1.0f / 60.0f; } },
+		{ "144 fps", [](uint32_t) { return 1.0f / 144.0f; } },
+		{ "30 fps", [](uint32_t) { return 1.0f / 30.0f; } },
+		{ "Jittery, 4 to 40 ms", [&jitteryFrames](uint32_t frame) { return jitteryFrames[frame % jitteryFrames.size()]; } },
+		{ "60 fps, 0.4 s hitch every 5 s", [](uint32_t frame) { return (frame % 300 == 299) ? 0.4f : 1.0f / 60.0f; } },
+		{ "60 fps, 2 s hitch every 10 s", [](uint32_t frame) { return (frame % 600 == 599) ? 2.0f : 1.0f / 60.0f; } },
+	};
+
+	const uint64_t numCheckedTicks = static_cast<uint64_t>(CHECKED_SECONDS * tickRate);
+	const double checkedSeconds = numCheckedTicks / static_cast<double>(tickRate);
+	printf("Simulating %llu ticks at %.0f per second (%.1f s) from (%.1f, %.1f, %.1f) with seed %llu\n\n",
+		numCheckedTicks, tickRate, checkedSeconds, start.box.center.x, start.box.center.y, start.box.center.z, seed);
+
+	uint32_t numFailures = 0;
+	FixedRunResult reference;
+	Body variableReference;
+	printf("  %-30s %8s %10s %12s %22s\n", "Frames", "Count", "Max ticks", "Dropped (s)", "Per-frame steps off by");
+	for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++)
+	{
+		const FixedRunResult fixed = RunFixed(start, patterns[i], tickRate, numCheckedTicks);
+		const Body variable = RunVariable(start, patterns[i], checkedSeconds);
+		if (i == 0)
+		{
+			reference = fixed;
+			variableReference = variable;
+		}
+
+		printf("  %-30s %8u %10u %12.3f %20.3f m\n", patterns[i].name, fixed.numFrames, fixed.maxTicksInFrame, fixed.droppedTime,
+			GetDistance(variable.box.center, variableReference.box.center));
+
+		if (!IsSameBody(fixed.body, reference.body))
+		{
+			printf("    Ended up at (%.4f, %.4f, %.4f) instead of (%.4f, %.4f, %.4f)\n",
+				fixed.body.box.center.x, fixed.body.box.center.y, fixed.body.box.center.z,
+				reference.body.box.center.x, reference.body.box.center.y, reference.body.box.center.z);
+			numFailures++;
+		}
+
+		if (!fixed.isTimeConsistent)
+		{
+			printf("    The frames' time doesn't add up to the ticks simulated\n");
+			numFailures++;
+		}
+	}
+
+	printf("\nFixed ticks ended at (%.4f, %.4f, %.4f) at every frame rate: %s\n\n",
+		reference.body.box.center.x, reference.body.box.center.y, reference.body.box.center.z, numFailures == 0 ? "yes" : "no");
+
+	// A single long frame only gets so many ticks, and leaves less than a tick over
+	{
+		FixedTimestep timestep(tickRate);
+		const uint32_t hitchTicks = timestep.Advance(2.0f);
+		const bool isClamped = hitchTicks == timestep.GetMaxTicksPerFrame() && timestep.GetInterpolationAlpha() < 1.0f &&
+			fabsf(timestep.GetFrameTime() - hitchTicks * timestep.GetTickDuration() - timestep.GetInterpolationAlpha() * timestep.GetTickDuration()) < 1e-4f;
+
+		printf("A 2 s frame: %u ticks, %.3f s dropped, %.3f s passed on to the rest of the frame\n\n", hitchTicks, timestep.GetDroppedTime(), timestep.GetFrameTime());
+		if (!isClamped)
+		{
+			printf("  The frame wasn't clamped to %u ticks\n\n", timestep.GetMaxTicksPerFrame());
+			numFailures++;
+		}
+	}
+
+	// As fast as it goes: a second of time a frame, with room for all of its ticks
+	{
+		GeneratedTerrainQuery query;
+		FixedTimestep timestep(tickRate, static_cast<uint32_t>(ceilf(tickRate)) + 1);
+		Body body = start;
+
+		const auto startTime = std::chrono::steady_clock::now();
+		for (uint32_t second = 0; second < seconds; second++)
+		{
+			const uint32_t frameTicks = timestep.Advance(1.0f);
+			for (uint32_t i = 0; i < frameTicks; i++)
+			{
+				const uint64_t tick = timestep.GetNumTicks() - frameTicks + i;
+				StepBody(body, tick * static_cast<double>(timestep.GetTickDuration()), timestep.GetTickDuration(), query);
+			}
+		}
+		const float elapsedMs = GetElapsedMs(startTime);
+
+		printf("Simulated %u s (%llu ticks) in %.1f ms: %.1f us per tick, %.0fx real time\n",
+			seconds, timestep.GetNumTicks(), elapsedMs, elapsedMs * 1000.0f / max(timestep.GetNumTicks(), static_cast<uint64_t>(1)), seconds * 1000.0f / max(elapsedMs, 1e-3f));
+	}
+
+	return numFailures == 0 ? 0 : 1;
+}
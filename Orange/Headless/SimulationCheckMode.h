@@ -0,0 +1,25 @@
+#ifndef _SIMULATIONCHECKMODE_H
+#define _SIMULATIONCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks and times running a simulation in fixed ticks (see FixedTimestep):
+//
+//		simcheck [--seed N] [--terrain heightmap|density] [--noise simplex|hash] [--definitions FILE] [--rate N] [--seconds N]
+//
+// Walks and jumps a player-sized box around the generated terrain, feeding the frames of a few frame rates (steady,
+// jittery and with hitches) to a FixedTimestep. The box has to end up in exactly the same place after the same number
+// of ticks at every frame rate, and is compared against stepping it by every frame's time instead. Then checks how far
+// a long hitch catches up, and runs the simulation for N seconds as fast as it goes
+class SimulationCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
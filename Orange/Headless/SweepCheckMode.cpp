@@ -0,0 +1,246 @@
+#include "../Source/Misc/pch.h"
+
+#include <chrono>
+#include <random>
+
+#include "SweepCheckMode.h"
+#include "HeadlessUtility.h"
+#include "../Source/Core/Physics.h"
+
+constexpr uint32_t DEFAULT_DENSITY = 20;
+constexpr uint32_t DEFAULT_NUM_SWEEPS = 20000;
+
+// The player's hitbox (see Player)
+constexpr DirectX::XMFLOAT3 BOX_EXTENT = { 0.25f, 1.0f, 0.25f };
+
+// Random boxes start inside this cube around the origin and move up to this far along every axis
+constexpr float FIELD_SIZE = 64.0f;
+constexpr float MAX_MOTION = 12.0f;
+
+// How many positions along every axis' motion are checked for overlapping a block
+constexpr uint32_t NUM_PATH_SAMPLES = 64;
+
+// How far past where the box stopped it's pushed to check that it stopped at a block
+constexpr float PUSH_DISTANCE = 0.01f;
+
+// How many failures are printed before only counting them
+constexpr uint32_t MAX_PRINTED_FAILURES = 10;
+
+static float GetElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Every block is solid or not by a hash of its position, so the field goes on forever without storing anything
+class RandomBlockQuery
+{
+public:
+
+	RandomBlockQuery(const uint64_t seed, const uint32_t density) : m_seed(seed), m_density(density) {}
+
+	bool IsSolid(const BlockCoord& posBS)
+	{
+		m_numQueries++;
+
+		uint64_t hash = m_seed ^ (static_cast<uint64_t>(static_cast<uint32_t>(posBS.x)) * 0x9E3779B97F4A7C15ull);
+		hash ^= static_cast<uint64_t>(static_cast<uint32_t>(posBS.y)) * 0xC2B2AE3D27D4EB4Full;
+		hash ^= static_cast<uint64_t>(static_cast<uint32_t>(posBS.z)) * 0x165667B19E3779F9ull;
+		hash ^= hash >> 31;
+		hash *= 0xBF58476D1CE4E5B9ull;
+		hash ^= hash >> 29;
+		return hash % 100 < m_density;
+	}
+
+	uint64_t GetNumQueries() const { return m_numQueries; }
+
+private:
+
+	uint64_t m_seed;
+	uint32_t m_density;
+	uint64_t m_numQueries = 0;
+};
+
+// A single wall of blocks, one block thick, filling the layer at "wallX"
+class WallQuery
+{
+public:
+
+	WallQuery(const int32_t wallX) : m_wallX(wallX) {}
+
+	bool IsSolid(const BlockCoord& posBS) { return posBS.x == m_wallX; }
+
+private:
+
+	int32_t m_wallX;
+};
+
+static Orange::AABB Offset(const Orange::AABB& aabb, const uint32_t axis, const float distance)
+{
+	Orange::AABB result = aabb;
+	float* center[3] = { &result.center.x, &result.center.y, &result.center.z };
+	*center[axis] += distance;
+	return result;
+}
+
+static float GetAxis(const DirectX::XMFLOAT3& v, const uint32_t axis)
+{
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// Checks that the box never overlapped a block on its way, along the axes in the order SweepAABB() moves it, and that
+// it can't go any further on the axes it hit something on. Returns a description of the first problem, or nullptr
+template<typename Query>
+static const char* CheckSweep(const Orange::AABB& start, const DirectX::XMFLOAT3& motion, const Orange::SweepResult& result, Query& query)
+{
+	constexpr uint32_t axisOrder[3] = { 1, 0, 2 };
+	const int32_t normal[3] = { result.normal.x, result.normal.y, result.normal.z };
+
+	Orange::AABB box = start;
+	for (const uint32_t axis : axisOrder)
+	{
+		const float distance = GetAxis(motion, axis);
+		const float moved = GetAxis(result.motion, axis);
+
+		if (normal[axis] == 0 && moved != distance) return "stopped without a normal";
+		if (normal[axis] != 0 && (distance > 0.0f ? -1 : 1) != normal[axis]) return "normal points the wrong way";
+		if (normal[axis] != 0 && fabsf(GetAxis(result.timeOfImpact, axis) * distance - moved) > 1e-4f) return "time of impact doesn't match the motion";
+		if (fabsf(moved) > fabsf(distance) || (moved * distance < 0.0f && fabsf(moved) > COLLISION_SKIN)) return "moved past the motion or backwards";
+
+		for (uint32_t i = 1; i <= NUM_PATH_SAMPLES; i++)
+		{
+			if (Orange::Physics::OverlapsSolid(Offset(box, axis, moved * i / NUM_PATH_SAMPLES), query)) return "went into a block";
+		}
+
+		if (normal[axis] != 0 && !Orange::Physics::OverlapsSolid(Offset(box, axis, moved - normal[axis] * PUSH_DISTANCE), query))
+		{
+			return "stopped short of the block";
+		}
+
+		box = Offset(box, axis, moved);
+	}
+
+	return nullptr;
+}
+
+void SweepCheckMode::PrintUsage()
+{
+	printf("  sweepcheck [--seed N] [--density N] [--sweeps N]\n");
+	printf("      Checks and times sweeping AABBs through a field of random blocks, N percent of them solid\n");
+}
+
+int SweepCheckMode::Run(const std::vector<std::string>& args)
+{
+	const char* seedArg = Headless::FindArg(args, "--seed");
+	const uint64_t seed = seedArg ? strtoull(seedArg, nullptr, 10) : TerrainGenerator::DEFAULT_SEED;
+
+	const char* densityArg = Headless::FindArg(args, "--density");
+	const uint32_t density = min(densityArg ? static_cast<uint32_t>(atoi(densityArg)) : DEFAULT_DENSITY, 90u);
+
+	const char* sweepsArg = Headless::FindArg(args, "--sweeps");
+	const uint32_t numSweeps = max(sweepsArg ? static_cast<uint32_t>(atoi(sweepsArg)) : DEFAULT_NUM_SWEEPS, 1u);
+
+	uint32_t numFailures = 0;
+
+	// A box moving 40 blocks in one step, towards a wall 10 blocks away. Its end position is well past the wall,
+	// so only checking where it ends up misses the wall entirely
+	{
+		WallQuery wall(10);
+		const Orange::AABB box = { { 0.5f, 1.0f, 0.5f }, BOX_EXTENT };
+		const DirectX::XMFLOAT3 motion = { 40.0f, 0.0f, 0.0f };
+
+		const bool isEndColliding = Orange::Physics::OverlapsSolid(Offset(box, 0, motion.x), wall);
+
+		Orange::SweepResult result;
+		Orange::Physics::SweepAABB(box, motion, wall, result);
+		const float endMaxX = box.center.x + BOX_EXTENT.x + result.motion.x;
+		const bool isStopped = result.normal.x == -1 && fabsf(endMaxX - 10.0f) <= COLLISION_SKIN;
+
+		printf("Moving 40 blocks into a wall 1 block thick:\n");
+		printf("  End position collides: %s\n", isEndColliding ? "yes" : "no");
+		printf("  Sweep: stopped at x = %.4f, normal (%i, %i, %i), time of impact %.4f\n",
+			endMaxX, result.normal.x, result.normal.y, result.normal.z, result.timeOfImpact.x);
+
+		if (!isStopped)
+		{
+			printf("  The sweep went through the wall\n");
+			numFailures++;
+		}
+		printf("\n");
+	}
+
+	// Random boxes starting in the air, moving in random directions
+	std::mt19937 rng(static_cast<uint32_t>(seed));
+	std::uniform_real_distribution<float> posDist(-FIELD_SIZE * 0.5f, FIELD_SIZE * 0.5f);
+	std::uniform_real_distribution<float> motionDist(-MAX_MOTION, MAX_MOTION);
+
+	RandomBlockQuery field(seed, density);
+	std::vector<Orange::AABB> boxes;
+	std::vector<DirectX::XMFLOAT3> motions;
+	boxes.reserve(numSweeps);
+	motions.reserve(numSweeps);
+	while (boxes.size() < numSweeps)
+	{
+		const Orange::AABB box = { { posDist(rng), posDist(rng), posDist(rng) }, BOX_EXTENT };
+		if (Orange::Physics::OverlapsSolid(box, field)) continue;
+
+		// Some of them along a single axis
+		DirectX::XMFLOAT3 motion = { motionDist(rng), motionDist(rng), motionDist(rng) };
+		if (boxes.size() % 8 == 0)
+		{
+			const uint32_t axis = rng() % 3;
+			motion = { axis == 0 ? motion.x : 0.0f, axis == 1 ? motion.y : 0.0f, axis == 2 ? motion.z : 0.0f };
+		}
+
+		boxes.push_back(box);
+		motions.push_back(motion);
+	}
+
+	uint32_t numSweepFailures = 0;
+	uint32_t numHits = 0;
+	for (uint32_t i = 0; i < numSweeps; i++)
+	{
+		Orange::SweepResult result;
+		Orange::Physics::SweepAABB(boxes[i], motions[i], field, result);
+		numHits += (result.normal.x != 0 || result.normal.y != 0 || result.normal.z != 0) ? 1 : 0;
+
+		const char* failure = CheckSweep(boxes[i], motions[i], result, field);
+
+		// Sweeping again from where it stopped, the other way, starts right against the block it hit
+		if (!failure)
+		{
+			const Orange::AABB stopped = { { boxes[i].center.x + result.motion.x, boxes[i].center.y + result.motion.y, boxes[i].center.z + result.motion.z }, BOX_EXTENT };
+			const DirectX::XMFLOAT3 back = { -motions[i].x, -motions[i].y, -motions[i].z };
+			Orange::SweepResult backResult;
+			Orange::Physics::SweepAABB(stopped, back, field, backResult);
+			failure = CheckSweep(stopped, back, backResult, field);
+		}
+
+		if (!failure) continue;
+
+		if (numSweepFailures++ < MAX_PRINTED_FAILURES)
+		{
+			printf("  Box at (%.4f, %.4f, %.4f) moving (%.4f, %.4f, %.4f): %s\n",
+				boxes[i].center.x, boxes[i].center.y, boxes[i].center.z, motions[i].x, motions[i].y, motions[i].z, failure);
+		}
+	}
+
+	printf("Checked %u sweeps through %u%% solid blocks: %u hit something, %u failures\n\n", numSweeps, density, numHits, numSweepFailures);
+	numFailures += numSweepFailures;
+
+	RandomBlockQuery timedField(seed, density);
+	Orange::SweepResult result;
+	float totalMoved = 0.0f;
+	const auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < numSweeps; i++)
+	{
+		Orange::Physics::SweepAABB(boxes[i], motions[i], timedField, result);
+		totalMoved += fabsf(result.motion.x) + fabsf(result.motion.y) + fabsf(result.motion.z);
+	}
+	const float sweepNs = GetElapsedMs(start) * 1e6f / numSweeps;
+
+	printf("Sweeping %u boxes up to %.0f blocks along every axis:\n", numSweeps, MAX_MOTION);
+	printf("  %.1f ns and %.1f block queries per sweep, %.2f blocks moved on average\n",
+		sweepNs, static_cast<double>(timedField.GetNumQueries()) / numSweeps, totalMoved / numSweeps);
+
+	return numFailures == 0 ? 0 : 1;
+}
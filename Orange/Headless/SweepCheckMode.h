@@ -0,0 +1,24 @@
+#ifndef _SWEEPCHECKMODE_H
+#define _SWEEPCHECKMODE_H
+
+#include <string>
+#include <vector>
+
+// Checks and times Orange::Physics::SweepAABB():
+//
+//		sweepcheck [--seed N] [--density N] [--sweeps N]
+//
+// Throws a player-sized box at a one block thick wall fast enough to end up past it, then sweeps random boxes through a
+// field of random blocks (N percent of them solid), checking that they never go into a block along the way and that
+// they stop right at the block they hit. Then times the sweeps
+class SweepCheckMode
+{
+public:
+
+	static int Run(const std::vector<std::string>& args);
+
+	static void PrintUsage();
+
+};
+
+#endif
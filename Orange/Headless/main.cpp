@@ -0,0 +1,81 @@
+#include "../Source/Misc/pch.h"
+
+#include <string>
+#include <vector>
+
+#include "CaveCullingMode.h"
+#include "ChunkLayoutBenchmarkMode.h"
+#include "ChunkSizeBenchmarkMode.h"
+#include "CullBenchmarkMode.h"
+#include "DensityBenchmarkMode.h"
+#include "DrawRangeBenchmarkMode.h"
+#include "GenVerifyMode.h"
+#include "LightCheckMode.h"
+#include "NoiseCheckMode.h"
+#include "OcclusionCheckMode.h"
+#include "PoolCheckMode.h"
+#include "PregenMode.h"
+#include "QueryCheckMode.h"
+#include "RaycastCheckMode.h"
+#include "ShadowCheckMode.h"
+#include "SimulationCheckMode.h"
+#include "SweepCheckMode.h"
+
+// GPU-free entry point for the tools that only need the world generation code.
+// The first argument picks the mode, the rest are passed on to it
+
+void PrintUsage()
+{
+	printf("Usage: OrangeHeadless <mode> [options]\n\n");
+	PregenMode::PrintUsage();
+	ChunkSizeBenchmarkMode::PrintUsage();
+	ChunkLayoutBenchmarkMode::PrintUsage();
+	DensityBenchmarkMode::PrintUsage();
+	GenVerifyMode::PrintUsage();
+	NoiseCheckMode::PrintUsage();
+	QueryCheckMode::PrintUsage();
+	LightCheckMode::PrintUsage();
+	CullBenchmarkMode::PrintUsage();
+	CaveCullingMode::PrintUsage();
+	OcclusionCheckMode::PrintUsage();
+	DrawRangeBenchmarkMode::PrintUsage();
+	ShadowCheckMode::PrintUsage();
+	RaycastCheckMode::PrintUsage();
+	SweepCheckMode::PrintUsage();
+	SimulationCheckMode::PrintUsage();
+	PoolCheckMode::PrintUsage();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const std::string mode = argv[1];
+	const std::vector<std::string> args(argv + 2, argv + argc);
+
+	if (mode == "pregen") return PregenMode::Run(args);
+	if (mode == "chunkbench") return ChunkSizeBenchmarkMode::Run(args);
+	if (mode == "layoutbench") return ChunkLayoutBenchmarkMode::Run(args);
+	if (mode == "densitybench") return DensityBenchmarkMode::Run(args);
+	if (mode == "genverify") return GenVerifyMode::Run(args);
+	if (mode == "noisecheck") return NoiseCheckMode::Run(args);
+	if (mode == "querycheck") return QueryCheckMode::Run(args);
+	if (mode == "lightcheck") return LightCheckMode::Run(args);
+	if (mode == "cullbench") return CullBenchmarkMode::Run(args);
+	if (mode == "cavecull") return CaveCullingMode::Run(args);
+	if (mode == "occlusioncheck") return OcclusionCheckMode::Run(args);
+	if (mode == "drawrangebench") return DrawRangeBenchmarkMode::Run(args);
+	if (mode == "shadowcheck") return ShadowCheckMode::Run(args);
+	if (mode == "raycheck") return RaycastCheckMode::Run(args);
+	if (mode == "sweepcheck") return SweepCheckMode::Run(args);
+	if (mode == "simcheck") return SimulationCheckMode::Run(args);
+	if (mode == "poolcheck") return PoolCheckMode::Run(args);
+
+	printf("Unknown mode \"%s\"\n\n", mode.c_str());
+	PrintUsage();
+	return 1;
+}
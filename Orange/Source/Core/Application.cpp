@@ -1,10 +1,12 @@
 #include "../Misc/pch.h"
 
 #include "Application.h"
+#include "BlockRegistry.h"
 #include "../Utility/FileSystem/FileSystem.h"
 #include "../Utility/FontManager.h"
 #include "Game.h"
 #include "../Utility/HeapOverrides.h"
+#include "../Utility/ImGuiDrawData.h"
 #include "../Utility/ImGuiLayer.h"
 #include "./Events/KeyCodes.h"
 #include "UI/UIHelper.h"
@@ -39,6 +41,9 @@ namespace Orange
 		// Initialize the FileSystem module
 		FileSystem::Initialize();
 
+		// Block properties have to be known before any chunks are generated or meshed
+		BlockRegistry::Initialize("../Source/Data/BlockDefinitions.txt");
+
 		// Populate the window parameters
 		WindowParameters params;
 		params.fullScreen = false;
@@ -144,14 +149,22 @@ namespace Orange
 
 		UI::BeginFrame();
 
-		// Store the frame's delta time in dt
-		float dt = m_Clock->GetDeltaTime(Clock::TimePrecision::SECONDS);
-		// HACK! Prevent delta time from giving bad results after moving game window
-		dt = dt > 0.5f ? 0.016666f : dt;
+		// Simulate as many ticks as fit in the frame's time. A frame that took too long (e.g. while the window was being
+		// moved) only catches up so far, and the rest of its time is dropped
+		m_simulationStep.SetTickRate(Simulation_Data::tickRate);
+		m_simulationStep.SetMaxTicksPerFrame(Simulation_Data::maxTicksPerFrame);
+		const uint32_t numTicks = m_simulationStep.Advance(m_Clock->GetDeltaTime(Clock::TimePrecision::SECONDS));
+		for (uint32_t i = 0; i < numTicks; i++) Game::Tick(m_simulationStep.GetTickDuration());
+
+		Simulation_Data::numTicks = numTicks;
+		Simulation_Data::interpolationAlpha = m_simulationStep.GetInterpolationAlpha();
+
+		// Everything else moves by the frame's time, less whatever the simulation dropped
+		const float dt = m_simulationStep.GetFrameTime();
 
 		UI::Update(dt);
 
-		Game::Update(dt);
+		Game::Update(dt, m_simulationStep.GetInterpolationAlpha());
 
 		// We should consider using a switch case to check which layer is active
 		EditorLayer::Update(dt);
@@ -5,6 +5,7 @@
 #include "../Utility/Input.h"
 #include "Graphics.h"
 #include "../Utility/Clock.h"
+#include "../Utility/FixedTimestep.h"
 #include "./Events/IEvent.h"
 #include "./Events/KeyboardEvent.h"
 #include "./Events/MouseEvent.h"
@@ -42,6 +43,9 @@ namespace Orange
 		Graphics* m_Graphics;
 		Clock* m_Clock;
 
+		// The game is simulated in fixed ticks, independently of the frame rate
+		FixedTimestep m_simulationStep;
+
 	};
 }
 
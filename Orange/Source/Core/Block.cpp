@@ -12,4 +12,4 @@ Block::Block(BlockType type) : m_type(type) {}
 Block::~Block(){ /* Destructor is not necessary */}
 
 void Block::SetType(const BlockType type) { m_type = type; }
-const BlockType Block::GetType() { return m_type; }
\ No newline at end of file
+const BlockType Block::GetType() const { return m_type; }
\ No newline at end of file
@@ -10,6 +10,10 @@ struct BlockInstanceData
 	uint32_t blockType;
 	uint32_t blockFaces;
 
+	// Light level of the block in front of every face, 4 bits per face in BlockFace bit order
+	uint32_t skyLight;
+	uint32_t blockLight;
+
 };
 
 struct BlockVertexData
@@ -99,7 +103,8 @@ enum class BlockType : uint8_t
 	Dirt,
 	Stone,
 	Grass,
-	Wood
+	Wood,
+	Leaves
 };
 
 
@@ -113,7 +118,7 @@ public:
 	~Block();
 
 	void SetType(const BlockType type);
-	const BlockType GetType();
+	const BlockType GetType() const;
 
 private:
 
@@ -0,0 +1,194 @@
+#include "../Misc/pch.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "BlockRegistry.h"
+#include "../Utility/Utility.h"
+
+using namespace DirectX;
+
+constexpr uint8_t MAX_LIGHT_EMISSION = 15;
+
+BlockDefinition BlockRegistry::m_definitions[MAX_BLOCK_TYPE_IDS];
+uint8_t BlockRegistry::m_isOpaque[MAX_BLOCK_TYPE_IDS] = {};
+uint8_t BlockRegistry::m_isCollidable[MAX_BLOCK_TYPE_IDS] = {};
+uint8_t BlockRegistry::m_isTransparent[MAX_BLOCK_TYPE_IDS] = {};
+uint8_t BlockRegistry::m_isVisible[MAX_BLOCK_TYPE_IDS] = {};
+uint8_t BlockRegistry::m_lightEmission[MAX_BLOCK_TYPE_IDS] = {};
+XMFLOAT4 BlockRegistry::m_uvs[NUM_BLOCKS][36] = {};
+bool BlockRegistry::m_isInitialized = false;
+
+// Parses "x,y"
+static bool ParseTile(const std::string& token, BlockTile& outTile)
+{
+	unsigned int x, y;
+	char separator;
+	std::istringstream stream(token);
+	if (!(stream >> x >> separator >> y) || separator != ',' || x > 255 || y > 255) return false;
+
+	outTile = { static_cast<uint8_t>(x), static_cast<uint8_t>(y) };
+	return true;
+}
+
+void BlockRegistry::Initialize(const std::string& definitionsFilePath)
+{
+	if (!LoadDefinitions(definitionsFilePath))
+	{
+		OG_LOG_WARNING("Failed to load block definitions from %s, using the built-in ones instead", definitionsFilePath.c_str());
+		LoadDefaultDefinitions();
+	}
+
+	BakeTables();
+
+	m_isInitialized = true;
+}
+
+const bool BlockRegistry::IsInitialized() { return m_isInitialized; }
+
+const BlockDefinition& BlockRegistry::GetDefinition(const BlockType type) { return m_definitions[static_cast<uint8_t>(type)]; }
+
+const XMFLOAT4* BlockRegistry::GetUVTable() { return &m_uvs[0][0]; }
+
+bool BlockRegistry::LoadDefinitions(const std::string& definitionsFilePath)
+{
+	std::ifstream file(definitionsFilePath);
+	if (!file.is_open()) return false;
+
+	BlockDefinition definitions[MAX_BLOCK_TYPE_IDS];
+	bool isDefined[MAX_BLOCK_TYPE_IDS] = {};
+
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		std::istringstream stream(line);
+		std::string firstToken;
+		if (!(stream >> firstToken) || firstToken[0] == '#') continue;
+
+		unsigned int id, isOpaque, isCollidable, isTransparent, lightEmission;
+		std::string name;
+		std::string tiles[NUM_BLOCK_FACES];
+
+		std::istringstream lineStream(line);
+		lineStream >> id >> name >> isOpaque >> isCollidable >> isTransparent >> lightEmission;
+		for (auto& tile : tiles) lineStream >> tile;
+
+		if (!lineStream || id >= MAX_BLOCK_TYPE_IDS || lightEmission > MAX_LIGHT_EMISSION)
+		{
+			OG_LOG_ERROR("Invalid block definition on line %u of %s", lineNumber, definitionsFilePath.c_str());
+			return false;
+		}
+
+		if (isDefined[id])
+		{
+			OG_LOG_ERROR("Block type %u is defined more than once in %s", id, definitionsFilePath.c_str());
+			return false;
+		}
+
+		BlockDefinition& definition = definitions[id];
+		definition.name = name;
+		definition.isOpaque = isOpaque != 0;
+		definition.isCollidable = isCollidable != 0;
+		definition.isTransparent = isTransparent != 0;
+		definition.isVisible = static_cast<BlockType>(id) != BlockType::Air;
+		definition.lightEmission = static_cast<uint8_t>(lightEmission);
+
+		for (uint32_t face = 0; face < NUM_BLOCK_FACES; face++)
+		{
+			if (!ParseTile(tiles[face], definition.faceTiles[face]))
+			{
+				OG_LOG_ERROR("Invalid atlas tile \"%s\" on line %u of %s", tiles[face].c_str(), lineNumber, definitionsFilePath.c_str());
+				return false;
+			}
+		}
+
+		isDefined[id] = true;
+	}
+
+	// Every block the game can place has to be defined, otherwise it would silently turn invisible
+	const BlockType requiredTypes[] = { BlockType::Air, BlockType::Dirt, BlockType::Stone, BlockType::Grass, BlockType::Wood, BlockType::Leaves };
+	for (const BlockType type : requiredTypes)
+	{
+		if (!isDefined[static_cast<uint8_t>(type)])
+		{
+			OG_LOG_ERROR("Block type %u is missing from %s", static_cast<uint32_t>(type), definitionsFilePath.c_str());
+			return false;
+		}
+	}
+
+	std::copy(definitions, definitions + MAX_BLOCK_TYPE_IDS, m_definitions);
+	return true;
+}
+
+void BlockRegistry::LoadDefaultDefinitions()
+{
+	for (auto& definition : m_definitions) definition = BlockDefinition();
+
+	auto define = [](const BlockType type, const char* name, const bool isOpaque, const bool isCollidable, const BlockTile top, const BlockTile bottom, const BlockTile sides)
+	{
+		BlockDefinition& definition = m_definitions[static_cast<uint8_t>(type)];
+		definition.name = name;
+		definition.isOpaque = isOpaque;
+		definition.isCollidable = isCollidable;
+		definition.isVisible = type != BlockType::Air;
+		definition.faceTiles[0] = top;
+		definition.faceTiles[1] = bottom;
+		for (uint32_t face = 2; face < NUM_BLOCK_FACES; face++) definition.faceTiles[face] = sides;
+	};
+
+	define(BlockType::Air,		"Air",		false,	false,	{ 0, 0 }, { 0, 0 }, { 0, 0 });
+	define(BlockType::Dirt,		"Dirt",		true,	true,	{ 0, 1 }, { 0, 1 }, { 0, 1 });
+	define(BlockType::Stone,	"Stone",	true,	true,	{ 1, 1 }, { 1, 1 }, { 1, 1 });
+	define(BlockType::Grass,	"Grass",	true,	true,	{ 0, 0 }, { 0, 1 }, { 1, 0 });
+
+	// There's no wood texture in the atlas yet
+	define(BlockType::Wood,		"Wood",		true,	true,	{ 1, 1 }, { 1, 1 }, { 1, 1 });
+
+	// Nor a leaves texture
+	define(BlockType::Leaves,	"Leaves",	true,	true,	{ 0, 0 }, { 0, 0 }, { 0, 0 });
+}
+
+void BlockRegistry::BakeTables()
+{
+	for (uint32_t id = 0; id < MAX_BLOCK_TYPE_IDS; id++)
+	{
+		const BlockDefinition& definition = m_definitions[id];
+		m_isOpaque[id] = definition.isOpaque ? 1 : 0;
+		m_isCollidable[id] = definition.isCollidable ? 1 : 0;
+		m_isTransparent[id] = definition.isTransparent ? 1 : 0;
+		m_isVisible[id] = definition.isVisible ? 1 : 0;
+		m_lightEmission[id] = definition.lightEmission;
+	}
+
+	for (uint32_t id = 0; id < NUM_BLOCKS; id++)
+	{
+		const BlockDefinition& definition = m_definitions[id];
+		if (!definition.isVisible)
+		{
+			for (auto& uv : m_uvs[id]) uv = { 0.0f, 0.0f, 0.0f, 0.0f };
+			continue;
+		}
+
+		const float size = static_cast<float>(ATLAS_TILE_SIZE);
+		float left[NUM_BLOCK_FACES], top[NUM_BLOCK_FACES];
+		for (uint32_t face = 0; face < NUM_BLOCK_FACES; face++)
+		{
+			left[face] = static_cast<float>(definition.faceTiles[face].x * ATLAS_TILE_SIZE);
+			top[face] = static_cast<float>(definition.faceTiles[face].y * ATLAS_TILE_SIZE);
+		}
+
+		const XMFLOAT4 uvs[36] =
+		{
+			TOP_FACE(left[0], top[0], size, size),
+			BOTTOM_FACE(left[1], top[1], size, size),
+			LEFT_FACE(left[2], top[2], size, size),
+			RIGHT_FACE(left[3], top[3], size, size),
+			FRONT_FACE(left[4], top[4], size, size),
+			BACK_FACE(left[5], top[5], size, size)
+		};
+		std::copy(uvs, uvs + 36, m_uvs[id]);
+	}
+}
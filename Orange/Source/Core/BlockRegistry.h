@@ -0,0 +1,98 @@
+#ifndef _BLOCKREGISTRY_H
+#define _BLOCKREGISTRY_H
+
+#include <string>
+#include <DirectXMath.h>
+
+#include "Block.h"
+#include "BlockUVs.h"
+
+// Every possible BlockType value has an entry in the property tables, so they can be indexed with any
+// block type without checking it first. Only the first NUM_BLOCKS types fit into the shader's UV table
+constexpr uint32_t MAX_BLOCK_TYPE_IDS = 256;
+
+// Face tiles are ordered by BlockFace bit, i.e. top, bottom, left, right, front, back
+constexpr uint32_t NUM_BLOCK_FACES = 6;
+
+// Position of a tile in the texture atlas, in tiles (not pixels)
+struct BlockTile
+{
+	uint8_t x, y;
+};
+
+struct BlockDefinition
+{
+	std::string name;
+
+	// Hides the faces of neighboring blocks
+	bool isOpaque = false;
+
+	// Physics collides with the block
+	bool isCollidable = false;
+
+	// Rendered in the transparent pass. Faces between two transparent blocks of the same type are hidden
+	bool isTransparent = false;
+
+	// Air is the only block that's not rendered at all
+	bool isVisible = false;
+
+	// [0, 15]
+	uint8_t lightEmission = 0;
+
+	BlockTile faceTiles[NUM_BLOCK_FACES] = {};
+};
+
+// Loads the block definitions on startup and bakes them into flat tables indexed by block type,
+// so that meshing, physics and lighting can look up a block's properties without branching on its type
+class BlockRegistry
+{
+public:
+
+	// Size of a tile in the texture atlas, in pixels
+	static constexpr uint32_t ATLAS_TILE_SIZE = 16;
+
+	// Falls back to the built-in definitions if the file is missing or malformed. Must be called
+	// before any chunks are meshed, since the tables are empty until then
+	static void Initialize(const std::string& definitionsFilePath);
+
+	static const bool IsInitialized();
+
+	static const BlockDefinition& GetDefinition(const BlockType type);
+
+	// Per-vertex UVs of the first NUM_BLOCKS block types, laid out as the shader's UV constant buffer expects
+	static const DirectX::XMFLOAT4* GetUVTable();
+
+	static inline bool IsOpaque(const BlockType type) { return m_isOpaque[static_cast<uint8_t>(type)] != 0; }
+	static inline bool IsCollidable(const BlockType type) { return m_isCollidable[static_cast<uint8_t>(type)] != 0; }
+	static inline bool IsTransparent(const BlockType type) { return m_isTransparent[static_cast<uint8_t>(type)] != 0; }
+	static inline bool IsVisible(const BlockType type) { return m_isVisible[static_cast<uint8_t>(type)] != 0; }
+	static inline uint8_t GetLightEmission(const BlockType type) { return m_lightEmission[static_cast<uint8_t>(type)]; }
+
+private:
+
+	// Each line is "<id> <name> <opaque> <collidable> <transparent> <light emission> <top> <bottom> <left> <right> <front> <back>",
+	// where the faces are atlas tiles written as "x,y". Empty lines and lines starting with '#' are skipped
+	static bool LoadDefinitions(const std::string& definitionsFilePath);
+
+	static void LoadDefaultDefinitions();
+
+	// Fills the property tables and the UV table from m_definitions
+	static void BakeTables();
+
+private:
+
+	static BlockDefinition m_definitions[MAX_BLOCK_TYPE_IDS];
+
+	static uint8_t m_isOpaque[MAX_BLOCK_TYPE_IDS];
+	static uint8_t m_isCollidable[MAX_BLOCK_TYPE_IDS];
+	static uint8_t m_isTransparent[MAX_BLOCK_TYPE_IDS];
+	static uint8_t m_isVisible[MAX_BLOCK_TYPE_IDS];
+	static uint8_t m_lightEmission[MAX_BLOCK_TYPE_IDS];
+
+	static DirectX::XMFLOAT4 m_uvs[NUM_BLOCKS][36];
+
+	static bool m_isInitialized;
+
+};
+
+#endif
@@ -5,8 +5,10 @@
 #include "Game.h"
 #include "../Utility/Math.h"
 #include "Player.h"
+#include "TerrainQuery.h"
 #include "ShaderBufferManagers/QuadBufferManager.h"
 #include "../Utility/ImGuiDrawData.h"
+#include "../Utility/VoxelRaycast.h"
 
 using namespace DirectX;
 
@@ -22,44 +24,23 @@ namespace Orange
 	{
 
 		Player* player = Game::GetPrimaryPlayer();
-		float epsilon = 0.001f;
 
 		// Check if we're selecting a new block
-		XMFLOAT3 rayPos = { 0.0f, 0.0f, 0.0f };
-		XMFLOAT3 rayDir = { 0.0f, 0.0f, 0.0f };
-		XMFLOAT3 rayHit = { 0.0f, 0.0f, 0.0f };
-		XMStoreFloat3(&rayPos, player->GetCamera(CameraType::FirstPerson)->GetWorldMatrix().r[3]);
-		for (uint32_t i = 0; i < 3; i++) { XMFLOAT3_BRACKET_OP_32(rayPos, i) += epsilon; }
-		XMStoreFloat3(&rayDir, DirectX::XMVector3Normalize(player->GetCamera(CameraType::FirstPerson)->GetWorldMatrix().r[2]));
-		if (Orange::Math::Raycast(rayPos, rayDir, player->GetInteractionRange(), ChunkManager::CheckBlockRaycast, &rayHit))
+		Orange::Math::Ray ray;
+		XMStoreFloat3(&ray.origin, player->GetCamera(CameraType::FirstPerson)->GetWorldMatrix().r[3]);
+		XMStoreFloat3(&ray.direction, player->GetCamera(CameraType::FirstPerson)->GetWorldMatrix().r[2]);
+		ray.maxDistance = player->GetInteractionRange();
+
+		TerrainRaycastQuery query;
+		Orange::Math::RaycastHit hit;
+		if (Orange::Math::Raycast(ray, query, hit))
 		{
 			// We're selecting a new block, move indicator towards it
-			XMFLOAT3 newBlock = 
-			{ 
-				static_cast<float>(static_cast<int>((static_cast<int>(rayHit.x) != rayHit.x) && rayHit.x < 0.0f ? rayHit.x - 1.0f : rayHit.x)),
-				static_cast<float>(static_cast<int>((static_cast<int>(rayHit.y) != rayHit.y) && rayHit.y < 0.0f ? rayHit.y - 1.0f : rayHit.y)),
-				static_cast<float>(static_cast<int>((static_cast<int>(rayHit.z) != rayHit.z) && rayHit.z < 0.0f ? rayHit.z - 1.0f : rayHit.z))
-			};
+			XMFLOAT3 newBlock = hit.blockPosBS.ToFloat3();
 			if (!XMFLOAT3_IS_EQUAL(newBlock, m_selectedBlockPos))
 			{
 				m_targetIndicatorPos = { newBlock.x + 0.5f, newBlock.y + 0.5f, newBlock.z + 0.5f };
 				m_selectedBlockPos = newBlock;
-
-				// New target position when hitting block face
-				for (uint32_t i = 0; i < 3; i++)
-				{
-					if (XMFLOAT3_BRACKET_OP_32(rayHit, i) == XMFLOAT3_BRACKET_OP_32(newBlock, i))
-					{
-						if (XMFLOAT3_BRACKET_OP_32(rayDir, i) < 0)
-						{
-							XMFLOAT3_BRACKET_OP_32(m_targetIndicatorPos, i) -= 1.0f;
-							XMFLOAT3_BRACKET_OP_32(m_selectedBlockPos, i) -= 1.0f;
-						}
-
-						break;
-					}
-				}
-
 			}
 
 			// Update indicator towards target if we haven't reached it, whether target is new or not
@@ -93,10 +74,10 @@ namespace Orange
 
 			// DEBUG INFO
 
-			Chunk* selectedChunk = ChunkManager::GetChunkAtPos(Orange::Math::WorldToChunkSpace(m_targetIndicatorPos));
-			XMFLOAT3 selectedBlockPosCS = Orange::Math::ChunkToWorldSpace(Orange::Math::WorldToChunkSpace(m_targetIndicatorPos)); 
-			XMFLOAT3 selectedBlockPosLocal = { m_targetIndicatorPos.x - selectedBlockPosCS.x, m_targetIndicatorPos.y - selectedBlockPosCS.y, m_targetIndicatorPos.z - selectedBlockPosCS.z};
-			BlockType currentBlock = selectedChunk->GetBlock(static_cast<unsigned int>(selectedBlockPosLocal.x), static_cast<unsigned int>(selectedBlockPosLocal.y), static_cast<unsigned int>(selectedBlockPosLocal.z))->GetType();
+			BlockCoord selectedBlockPos = Orange::Math::WorldToBlockCoord(m_targetIndicatorPos);
+			Chunk* selectedChunk = ChunkManager::GetChunkAtPos(Orange::Math::BlockToChunkCoord(selectedBlockPos));
+			BlockCoord selectedBlockPosLocal = Orange::Math::BlockToLocalCoord(selectedBlockPos);
+			BlockType currentBlock = selectedChunk->GetBlock(selectedBlockPosLocal.x, selectedBlockPosLocal.y, selectedBlockPosLocal.z)->GetType();
 			Renderer_Data::playerLookAt = { m_targetIndicatorPos.x - 0.5f, m_targetIndicatorPos.y - 0.5f , m_targetIndicatorPos.z - 0.5f };
 			Renderer_Data::blockType = static_cast<uint8_t>(currentBlock);
 			//
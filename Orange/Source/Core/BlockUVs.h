@@ -1,12 +1,13 @@
 #ifndef _BLOCK_UVS_H
 #define _BLOCK_UVS_H
 
-#define NUM_BLOCKS 4
+// Number of block types the shader has UVs for, has to match BlockUVs.hlsli
+#define NUM_BLOCKS 8
 
 constexpr auto TEX_WIDTH = 1024;
 constexpr auto TEX_HEIGHT = 512;
 
-#include <DirectXMath.h>
+// The face macros expand to the UVs of the face's six vertices. BlockRegistry bakes them into the UV table
 
 //                                                              TRB(2)                                                                 TRF(1)                                                             TLF(0)                                                       TLF(0)                                                      TLB(3)                                                       TRB(2)
 #define TOP_FACE(left, top, width, height) { (left + width) / TEX_WIDTH, top / TEX_HEIGHT, 0.0f, 0.0f }, { (left + width) / TEX_WIDTH, (top + height) / TEX_HEIGHT, 0.0f, 0.0f }, { left / TEX_WIDTH, (top + height) / TEX_HEIGHT, 0.0f, 0.0f }, { left / TEX_WIDTH, (top + height) / TEX_HEIGHT, 0.0f, 0.0f }, { left / TEX_WIDTH, top / TEX_HEIGHT, 0.0f, 0.0f }, { (left + width) / TEX_WIDTH, top / TEX_HEIGHT, 0.0f, 0.0f }
@@ -26,52 +27,4 @@ constexpr auto TEX_HEIGHT = 512;
 //                                                              BLB(20)                                                                     BRB(21)                                                    TRB(22)                                                         BLB(20)                                                  TRB(22)                                                   TLB(23)
 #define BACK_FACE(left, top, width, height) { (left + width) / TEX_WIDTH, (top + height) / TEX_HEIGHT, 0.0f, 0.0f }, { left / TEX_WIDTH, (top + height) / TEX_HEIGHT, 0.0f, 0.0f }, { left / TEX_WIDTH, top / TEX_HEIGHT, 0.0f, 0.0f }, { (left + width) / TEX_WIDTH, (top + height) / TEX_HEIGHT, 0.0f, 0.0f }, { left / TEX_WIDTH, top / TEX_HEIGHT, 0.0f, 0.0f }, { (left + width) / TEX_WIDTH, top / TEX_HEIGHT, 0.0f, 0.0f }
 
-// They have to be float4's to abide by HLSL's packing optimization
-// This is a design decision. Instead of forcing HLSL to pack an array
-// into 8-byte vectors, we trade off memory for speed
-static constexpr DirectX::XMFLOAT4 uvs[NUM_BLOCKS][36]
-{
-    // AIR
-    { 
-        TOP_FACE(0.0f, 0.0f, 0.0f, 0.0f),
-        BOTTOM_FACE(0.0f, 0.0f, 0.0f, 0.0f),
-        LEFT_FACE(0.0f, 0.0f, 0.0f, 0.0f),
-        RIGHT_FACE(0.0f, 0.0f, 0.0f, 0.0f),
-        FRONT_FACE(0.0f, 0.0f, 0.0f, 0.0f),
-        BACK_FACE(0.0f, 0.0f, 0.0f, 0.0f)
-    },
-
-    // DIRT
-    { 
-        TOP_FACE(0.0f, 16.0f, 16.0f, 16.0f),
-        BOTTOM_FACE(0.0f, 16.0f, 16.0f, 16.0f),
-        LEFT_FACE(0.0f, 16.0f, 16.0f, 16.0f),
-        RIGHT_FACE(0.0f, 16.0f, 16.0f, 16.0f),
-        FRONT_FACE(0.0f, 16.0f, 16.0f, 16.0f),
-        BACK_FACE(0.0f, 16.0f, 16.0f, 16.0f)
-    },
-
-    // STONE
-    { 
-        TOP_FACE(16.0f, 16.0f, 16.0f, 16.0f),
-        BOTTOM_FACE(16.0f, 16.0f, 16.0f, 16.0f),
-        LEFT_FACE(16.0f, 16.0f, 16.0f, 16.0f),
-        RIGHT_FACE(16.0f, 16.0f, 16.0f, 16.0f),
-        FRONT_FACE(16.0f, 16.0f, 16.0f, 16.0f),
-        BACK_FACE(16.0f, 16.0f, 16.0f, 16.0f)
-    },
-
-    // GRASS
-    {
-        TOP_FACE(0.0f, 0.0f, 16.0f, 16.0f),
-        BOTTOM_FACE(0.0f, 16.0f, 16.0f, 16.0f),
-        LEFT_FACE(16.0f, 0.0f, 16.0f, 16.0f),
-        RIGHT_FACE(16.0f, 0.0f, 16.0f, 16.0f),
-        FRONT_FACE(16.0f, 0.0f, 16.0f, 16.0f),
-        BACK_FACE(16.0f, 0.0f, 16.0f, 16.0f)
-    },
-};
-
-
-
 #endif
\ No newline at end of file
@@ -7,29 +7,31 @@
 #include "../Core/ShaderBufferManagers/ChunkBufferManager.h"
 
 #include "FrustumCulling.h"
+#include "WorldGen/TerrainGenerator.h"
 
 #include "D3D.h"
 
 #include "../Utility/Utility.h"
 #include "../Utility/ImGuiLayer.h"
 #include "../Utility/Math.h"
-#include "../Utility/SimplexNoise.h"
 
 
 using namespace DirectX;
 
 constexpr uint32_t BUFFER_SIZE = static_cast<uint32_t>(6 * 6 * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 0.1f);
 
-constexpr int32_t TERRAIN_STARTING_HEIGHT = 80;
-constexpr int32_t TERRAIN_HEIGHT_RANGE = 50;
-
 constexpr int32_t LOW_CHUNK_LIMIT = -256;
 constexpr int32_t HIGH_CHUNK_LIMIT = -LOW_CHUNK_LIMIT;
 
 
-Chunk::Chunk(const DirectX::XMFLOAT3 pos) : m_pos(pos), m_vertexBufferStartIndex(0), m_blockCount(0) 
+Chunk::Chunk(const ChunkCoord pos) : m_pos(pos), m_vertexBufferStartIndex(0), m_blockCount(0), m_connectivity(ALL_FACES_CONNECTED), m_isOccluder(false), m_isEmpty(false)
 {
+	for (auto& neighbor : m_neighbors) neighbor = nullptr;
+}
 
+Chunk::Chunk(const Chunk& other)
+{
+	*this = other;
 }
 
 Chunk::~Chunk()
@@ -44,9 +46,38 @@ Chunk::~Chunk()
 	}
 }
 
-Block* Chunk::GetBlock(unsigned int x, unsigned int y, unsigned int z) { return &m_chunk[x][y][z]; }
+Chunk& Chunk::operator=(const Chunk& other)
+{
+	m_pos = other.m_pos;
+	std::copy(other.m_blocks, other.m_blocks + BLOCKS_PER_CHUNK, m_blocks);
+	std::copy(other.m_light, other.m_light + BLOCKS_PER_CHUNK, m_light);
+	m_vertexBufferStartIndex = other.m_vertexBufferStartIndex;
+	m_blockCount = other.m_blockCount;
+	m_connectivity.store(other.m_connectivity.load(std::memory_order_acquire), std::memory_order_release);
+	m_isOccluder.store(other.m_isOccluder.load(std::memory_order_acquire), std::memory_order_release);
+	m_isEmpty.store(other.m_isEmpty.load(std::memory_order_acquire), std::memory_order_release);
+
+	// The neighbors still point back at "other", the ChunkManager re-links them once the copy is in place
+	for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+	{
+		m_neighbors[i].store(other.m_neighbors[i].load(std::memory_order_acquire), std::memory_order_release);
+	}
 
-const DirectX::XMFLOAT3 Chunk::GetPosition() { return m_pos; }
+	return *this;
+}
+
+Chunk& Chunk::operator=(Chunk&& other)
+{
+	*this = static_cast<const Chunk&>(other);
+
+	other.m_vertexBufferStartIndex = other.m_blockCount = 0;
+
+	return *this;
+}
+
+Block* Chunk::GetBlock(unsigned int x, unsigned int y, unsigned int z) { return &m_blocks[ChunkBlockLayout::GetIndex(x, y, z)]; }
+
+const ChunkCoord Chunk::GetPosition() { return m_pos; }
 
 const uint32_t Chunk::GetFaceCount() { return static_cast<uint32_t>(m_blockCount * 6); }
 
@@ -54,7 +85,7 @@ void Chunk::DrawChunkBorder()
 {
 	XMFLOAT4 color = { 1.0f, 0.0f, 0.0f, 1.0f };
 
-	XMFLOAT3 posWS = { m_pos.x * CHUNK_SIZE, m_pos.y * CHUNK_SIZE, m_pos.z * CHUNK_SIZE };
+	XMFLOAT3 posWS = Orange::Math::ChunkToWorldSpace(m_pos);
 	XMFLOAT3 tlf = { posWS.x, posWS.y, posWS.z };
 	XMFLOAT3 trf = { posWS.x + CHUNK_SIZE, posWS.y, posWS.z };
 	XMFLOAT3 blf = { posWS.x, posWS.y - CHUNK_SIZE, posWS.z };
@@ -93,163 +124,157 @@ void Chunk::SetVertexCount(const uint32_t vertexCount) { m_blockCount = vertexCo
 
 void Chunk::Init()
 {
-	OG_ASSERT(TERRAIN_HEIGHT_RANGE > 0);
+	BlockType blockTypes[BLOCKS_PER_CHUNK];
+	TerrainGenerator::GenerateChunk(m_pos, blockTypes);
+	SetBlockTypes(blockTypes);
+}
 
-	XMFLOAT3 posWS = { m_pos.x * CHUNK_SIZE, m_pos.y * CHUNK_SIZE, m_pos.z * CHUNK_SIZE };
+void Chunk::ApplyPendingWrites()
+{
+	BlockType blockTypes[BLOCKS_PER_CHUNK];
+	GetBlockTypes(blockTypes);
+	if (TerrainGenerator::GetPipeline().GetPendingWrites().ApplyAndMarkResident(m_pos, CHUNK_SIZE, blockTypes) > 0)
+	{
+		SetBlockTypes(blockTypes);
+	}
+}
+
+ChunkFaceMask Chunk::GetConnectivity() { return m_connectivity.load(std::memory_order_acquire); }
+
+void Chunk::SetConnectivity(const ChunkFaceMask connectivity) { m_connectivity.store(connectivity, std::memory_order_release); }
+
+bool Chunk::IsOccluder() { return m_isOccluder.load(std::memory_order_acquire); }
 
-	// Populate the chunk array
-	// For now we'll just initialize all blocks to "DIRT" blocks
-	for(int64_t x = 0; x < CHUNK_SIZE; x++)
+void Chunk::SetOccluder(const bool isOccluder) { m_isOccluder.store(isOccluder, std::memory_order_release); }
+
+bool Chunk::IsEmpty() { return m_isEmpty.load(std::memory_order_acquire); }
+
+void Chunk::SetEmpty(const bool isEmpty) { m_isEmpty.store(isEmpty, std::memory_order_release); }
+
+Chunk* Chunk::GetNeighbor(const ChunkNeighbor neighbor) { return m_neighbors[static_cast<uint8_t>(neighbor)].load(std::memory_order_acquire); }
+
+void Chunk::SetNeighbor(const ChunkNeighbor neighbor, Chunk* chunk) { m_neighbors[static_cast<uint8_t>(neighbor)].store(chunk, std::memory_order_release); }
+
+void Chunk::GetBlockTypes(BlockType* outBlockTypes)
+{
+	for (int32_t x = 0; x < CHUNK_SIZE; x++)
 	{
-		for (int64_t z = 0; z < CHUNK_SIZE; z++)
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
 		{
-			// Returns a values between MAXIMUM_TERRAIN_HEIGHT and MINIMUM_TERRAIN_HEIGHT
-			SimplexNoise noiseGenerator( 0.010f, 1.0f, 2.0f, 0.3f );
-			float sampledNoise = noiseGenerator.fractal(4, static_cast<float>(x + posWS.x), static_cast<float>(z + posWS.z));
-			float height = ((sampledNoise * 0.5f + 0.5f) * TERRAIN_HEIGHT_RANGE) + TERRAIN_STARTING_HEIGHT;
-			for(int64_t y = 0; y < CHUNK_SIZE; y++)
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
 			{
-				float yWS = posWS.y + y;
-				if(yWS <= static_cast<int32_t>(height))
-					m_chunk[x][y][z] = Block(BlockType::Grass);
-				else 
-					m_chunk[x][y][z] = Block(BlockType::Air);
+				outBlockTypes[(x * CHUNK_SIZE + y) * CHUNK_SIZE + z] = m_blocks[ChunkBlockLayout::GetIndex(x, y, z)].GetType();
 			}
 		}
 	}
 }
 
-void Chunk::InitializeVertexBuffer()
+void Chunk::SetBlockTypes(const BlockType* blockTypes)
 {
-	// We need this here because the chunk will not necessarily
-	// be deleted if it's being used by other system because
-	// of the shared_ptr
-	ShutdownVertexBuffer();
+	for (int32_t x = 0; x < CHUNK_SIZE; x++)
+	{
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+		{
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
+			{
+				m_blocks[ChunkBlockLayout::GetIndex(x, y, z)].SetType(blockTypes[(x * CHUNK_SIZE + y) * CHUNK_SIZE + z]);
+			}
+		}
+	}
+}
 
-	XMFLOAT3 posWS = { m_pos.x * CHUNK_SIZE, m_pos.y * CHUNK_SIZE, m_pos.z * CHUNK_SIZE };
+void Chunk::ComputeLight()
+{
+	BlockType blockTypes[BLOCKS_PER_CHUNK];
+	uint8_t light[BLOCKS_PER_CHUNK];
+	GetBlockTypes(blockTypes);
+	LightEngine::ComputeChunkLight<CHUNK_SIZE>(blockTypes, light);
 
-	// Get start index
-	uint32_t initialArraySize = static_cast<uint32_t>(ChunkBufferManager::GetVertexArray().size());
+	for (int32_t x = 0; x < CHUNK_SIZE; x++)
+	{
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+		{
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
+			{
+				m_light[ChunkBlockLayout::GetIndex(x, y, z)] = light[(x * CHUNK_SIZE + y) * CHUNK_SIZE + z];
+			}
+		}
+	}
+}
 
-	// Retrieve neighboring chunks
-	Chunk* leftChunk = ChunkManager::GetChunkAtPos({ m_pos.x - 1, m_pos.y, m_pos.z });
-	Chunk* rightChunk = ChunkManager::GetChunkAtPos({ m_pos.x + 1, m_pos.y, m_pos.z });
-	Chunk* topChunk = ChunkManager::GetChunkAtPos({ m_pos.x, m_pos.y + 1, m_pos.z });
-	Chunk* bottomChunk = ChunkManager::GetChunkAtPos({ m_pos.x, m_pos.y - 1, m_pos.z });
-	Chunk* frontChunk = ChunkManager::GetChunkAtPos({ m_pos.x, m_pos.y, m_pos.z - 1 });
-	Chunk* backChunk = ChunkManager::GetChunkAtPos({ m_pos.x, m_pos.y, m_pos.z + 1 });
+LightChunkView Chunk::GetLightView() { return { m_blocks, m_light }; }
 
-	// Retrieve a reference to the vertex array
-	auto& vertexArray = ChunkBufferManager::GetVertexArray();
+void Chunk::TakeSnapshot(ChunkSnapshot& outSnapshot)
+{
+	outSnapshot.posCS = m_pos;
+	std::fill(outSnapshot.blocks, outSnapshot.blocks + ChunkSnapshot::PADDED_VOLUME, ChunkSnapshot::MISSING_NEIGHBOR_BLOCK);
 
-	for (int x = 0; x < CHUNK_SIZE; x++)
+	// Faces bordering missing neighbors are culled, so their light is never read
+	std::fill(outSnapshot.light, outSnapshot.light + ChunkSnapshot::PADDED_VOLUME, static_cast<uint8_t>(0));
+
+	// Own blocks, one Z row at a time
+	for (int32_t x = 0; x < CHUNK_SIZE; x++)
 	{
-		for (int y = CHUNK_SIZE - 1; y >= 0; y--)
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
 		{
-			for (int z = 0; z < CHUNK_SIZE; z++)
+			const uint32_t rowIndex = ChunkSnapshot::GetIndex(x + 1, y + 1, 1);
+			BlockType* row = &outSnapshot.blocks[rowIndex];
+			uint8_t* lightRow = &outSnapshot.light[rowIndex];
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
 			{
-				XMFLOAT3 blockPos = 
-				{ 
-					static_cast<float>(x) + posWS.x,
-					static_cast<float>(y) + posWS.y,
-					static_cast<float>(z) + posWS.z
-				};
-
-				unsigned int blockFaces = 0;
-
-				// Only append new block if the block type is not an air block
-				BlockType blockType = m_chunk[x][y][z].GetType();
-				if (blockType != BlockType::Air)
-				{
-					// left limit 
-					if (x - 1 < 0)
-					{
-						if (leftChunk && leftChunk->GetBlock(CHUNK_SIZE - 1, y, z)->GetType() == BlockType::Air)
-							blockFaces |= static_cast<unsigned int>(BlockFace::LEFT);
-					}
-					// left neighbor
-					else if (m_chunk[x - 1][y][z].GetType() == BlockType::Air)
-						blockFaces |= static_cast<unsigned int>(BlockFace::LEFT);
-
-					// right limit
-					if (x + 1 > CHUNK_SIZE - 1)
-					{
-						if (rightChunk && rightChunk->GetBlock(0, y, z)->GetType() == BlockType::Air)
-							blockFaces |= static_cast<unsigned int>(BlockFace::RIGHT);
-					}
-					// right neighbor
-					else if (m_chunk[x + 1][y][z].GetType() == BlockType::Air)
-						blockFaces |= static_cast<unsigned int>(BlockFace::RIGHT);
-
-					// top neighbor
-					if (y + 1 > CHUNK_SIZE - 1)
-					{
-						if (topChunk && topChunk->GetBlock(x, 0, z)->GetType() == BlockType::Air)
-							blockFaces |= static_cast<unsigned int>(BlockFace::TOP);
-					}
-					else if (m_chunk[x][y + 1][z].GetType() == BlockType::Air)
-						blockFaces |= static_cast<unsigned int>(BlockFace::TOP);
-
-					// bottom neighbor
-					if (y - 1 < 0)
-					{
-						if (bottomChunk && bottomChunk->GetBlock(x, CHUNK_SIZE - 1, z)->GetType() == BlockType::Air)
-							blockFaces |= static_cast<unsigned int>(BlockFace::BOTTOM);
-					}
-					else if (m_chunk[x][y - 1][z].GetType() == BlockType::Air)
-						blockFaces |= static_cast<unsigned int>(BlockFace::BOTTOM);
-
-					// front neighbor
-					if (z - 1 < 0)
-					{
-						if (frontChunk && frontChunk->GetBlock(x, y, CHUNK_SIZE - 1)->GetType() == BlockType::Air)
-							blockFaces |= static_cast<unsigned int>(BlockFace::FRONT);
-					}
-					else if (m_chunk[x][y][z - 1].GetType() == BlockType::Air)
-						blockFaces |= static_cast<unsigned int>(BlockFace::FRONT);
-
-
-					// back neighbor
-					if (z + 1 > CHUNK_SIZE - 1)
-					{
-						if (backChunk && backChunk->GetBlock(x, y, 0)->GetType() == BlockType::Air)
-							blockFaces |= static_cast<unsigned int>(BlockFace::BACK);
-					}
-					else if (m_chunk[x][y][z + 1].GetType() == BlockType::Air)
-						blockFaces |= static_cast<unsigned int>(BlockFace::BACK);
-
-
-					// Add the new block to the ChunkBufferManager vertex array if we can render faces
-					if(blockFaces != 0)
-					{
-						BlockInstanceData currBlock;
-						currBlock.blockFaces = blockFaces;
-						currBlock.blockType = static_cast<unsigned int>(blockType);
-						currBlock.worldPos = blockPos;
-
-						vertexArray.emplace_back(currBlock);
-
-						m_blockCount++;
-					}
-				}
+				const uint32_t index = ChunkBlockLayout::GetIndex(x, y, z);
+				row[z] = m_blocks[index].GetType();
+				lightRow[z] = m_light[index];
 			}
 		}
 	}
 
+	// The face of every neighbor that touches this chunk. Padded coordinate 0 is the neighbor's last
+	// layer and CHUNK_SIZE + 1 is its first one
+	Chunk* leftChunk = GetNeighbor(ChunkNeighbor::LEFT);
+	Chunk* rightChunk = GetNeighbor(ChunkNeighbor::RIGHT);
+	Chunk* bottomChunk = GetNeighbor(ChunkNeighbor::BOTTOM);
+	Chunk* topChunk = GetNeighbor(ChunkNeighbor::TOP);
+	Chunk* frontChunk = GetNeighbor(ChunkNeighbor::FRONT);
+	Chunk* backChunk = GetNeighbor(ChunkNeighbor::BACK);
 
-	// If vertices were allocated, populate the starting index
-	if(m_blockCount > 0) 
+	auto copyFromNeighbor = [&](Chunk* neighbor, const uint32_t snapshotIndex, const uint32_t neighborIndex)
 	{
-		m_vertexBufferStartIndex = initialArraySize;
+		if (!neighbor) return;
+		outSnapshot.blocks[snapshotIndex] = neighbor->m_blocks[neighborIndex].GetType();
+		outSnapshot.light[snapshotIndex] = neighbor->m_light[neighborIndex];
+	};
+
+	for (int32_t a = 0; a < CHUNK_SIZE; a++)
+	{
+		for (int32_t b = 0; b < CHUNK_SIZE; b++)
+		{
+			// a = y, b = z
+			copyFromNeighbor(leftChunk, ChunkSnapshot::GetIndex(0, a + 1, b + 1), ChunkBlockLayout::GetIndex(CHUNK_SIZE - 1, a, b));
+			copyFromNeighbor(rightChunk, ChunkSnapshot::GetIndex(CHUNK_SIZE + 1, a + 1, b + 1), ChunkBlockLayout::GetIndex(0, a, b));
+
+			// a = x, b = z
+			copyFromNeighbor(bottomChunk, ChunkSnapshot::GetIndex(a + 1, 0, b + 1), ChunkBlockLayout::GetIndex(a, CHUNK_SIZE - 1, b));
+			copyFromNeighbor(topChunk, ChunkSnapshot::GetIndex(a + 1, CHUNK_SIZE + 1, b + 1), ChunkBlockLayout::GetIndex(a, 0, b));
 
-		//OG_LOG("[%2.2f, %2.2f, %2.2f] Added %i blocks at index %i (to %i) NS %i",
-		//	m_pos.x, m_pos.y, m_pos.z, m_blockCount, 
-		//	m_vertexBufferStartIndex, m_vertexBufferStartIndex + m_blockCount, vertexArray.size());
+			// a = x, b = y
+			copyFromNeighbor(frontChunk, ChunkSnapshot::GetIndex(a + 1, b + 1, 0), ChunkBlockLayout::GetIndex(a, b, CHUNK_SIZE - 1));
+			copyFromNeighbor(backChunk, ChunkSnapshot::GetIndex(a + 1, b + 1, CHUNK_SIZE + 1), ChunkBlockLayout::GetIndex(a, b, 0));
+		}
 	}
+}
 
+void Chunk::SetMesh(const std::vector<BlockInstanceData>& instances)
+{
+	ShutdownVertexBuffer();
 
-	
+	if (instances.empty()) return;
+
+	auto& vertexArray = ChunkBufferManager::GetVertexArray();
+	m_vertexBufferStartIndex = static_cast<uint32_t>(vertexArray.size());
+	m_blockCount = static_cast<uint32_t>(instances.size());
 
+	vertexArray.insert(vertexArray.end(), instances.begin(), instances.end());
 }
 
 void Chunk::ShutdownVertexBuffer()
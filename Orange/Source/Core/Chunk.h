@@ -1,27 +1,38 @@
 #ifndef _CHUNK_H
 #define _CHUNK_H
 
+#include <atomic>
+#include <vector>
+
 #include "Block.h"
+#include "ChunkConnectivity.h"
+#include "ChunkCoord.h"
+#include "ChunkLayout.h"
+#include "ChunkMesher.h"
+#include "LightEngine.h"
+#include "OcclusionCuller.h"
 #include <d3d11.h>
 
-// Macros
-constexpr int32_t CHUNK_SIZE = 16;
-constexpr int32_t DOUBLE_CHUNK_SIZE = (CHUNK_SIZE << 1);
-
 class Chunk
 {
 public:
 
 	friend class ChunkManager;
 
-	Chunk(const DirectX::XMFLOAT3 pos = { 0.0f, 0.0f, 0.0f });
-	Chunk(const Chunk& other) = default; // I don't know why you would even do this, but I do it just in case
+	Chunk(const ChunkCoord pos = ChunkCoord());
+	Chunk(const Chunk& other); // I don't know why you would even do this, but I do it just in case
 	~Chunk();
 
+	Chunk& operator=(const Chunk& other);
+
+	// Takes over "other"'s range in the vertex array, so that destroying "other" afterwards
+	// doesn't remove this chunk's vertices. Used when the chunk pool is reallocated
+	Chunk& operator=(Chunk&& other);
+
 	Block* GetBlock(unsigned int x, unsigned int y, unsigned int z);
 
 	// Returns chunks' position in CHUNK SPACE
-	const DirectX::XMFLOAT3 GetPosition();
+	const ChunkCoord GetPosition();
 
 	const uint32_t GetFaceCount();
 
@@ -33,25 +44,73 @@ public:
 	const uint32_t GetBlockCount();
 	void SetVertexCount(const uint32_t vertexCount);
 
-	// TODO: Work on optimizing this function!!
-	void InitializeVertexBuffer();
+	// Copies the chunk and the bordering blocks of its neighbors into "outSnapshot". This is the only step
+	// of meshing that reads other chunks, ChunkMesher::BuildMesh() only ever reads the snapshot
+	void TakeSnapshot(ChunkSnapshot& outSnapshot);
+
+	// Replaces the chunk's range in the vertex array with "instances". This moves the other chunks' ranges, so
+	// the ChunkManager only calls it while holding the lock the render thread uploads the vertex array under
+	void SetMesh(const std::vector<BlockInstanceData>& instances);
 
 	void ShutdownVertexBuffer();
 
+	// Which of the chunk's faces are connected to each other (see ChunkConnectivity), as of the last time it was meshed
+	ChunkFaceMask GetConnectivity();
+	void SetConnectivity(const ChunkFaceMask connectivity);
+
+	// Whether the chunk can hide other chunks as a solid box (see OcclusionRasterizer::IsOccluder()), as of the last time it was meshed
+	bool IsOccluder();
+	void SetOccluder(const bool isOccluder);
+
+	// Whether none of the chunk's blocks are visible (see ChunkMesher::IsEmpty()), as of the last time it was meshed.
+	// Raycasts go straight through empty chunks
+	bool IsEmpty();
+	void SetEmpty(const bool isEmpty);
+
 	void Init();
 
+	// Merges in the blocks other chunks' features placed in this one (see PendingWriteStore). Init() already
+	// does this, it's for chunks whose blocks were restored instead, or that received writes while loaded
+	void ApplyPendingWrites();
+
+	// Returns the loaded chunk sharing the given face with this one, or nullptr. The links are kept
+	// up to date by the ChunkManager whenever chunks are loaded, unloaded or moved around in the pool
+	Chunk* GetNeighbor(const ChunkNeighbor neighbor);
+	void SetNeighbor(const ChunkNeighbor neighbor, Chunk* chunk);
+
+	// Copies the block types in [x][y][z] order. "blockTypes" must hold BLOCKS_PER_CHUNK elements
+	void GetBlockTypes(BlockType* outBlockTypes);
+	void SetBlockTypes(const BlockType* blockTypes);
+
+	// Lights the chunk on its own (see LightEngine::ComputeChunkLight()). It only touches this chunk, so chunks
+	// can be lit on any thread before they're loaded. The ChunkManager stitches them into the world afterwards
+	void ComputeLight();
+
+	LightChunkView GetLightView();
+
 private:
 
 	// The chunk's position stored in CHUNK SPACE
-	DirectX::XMFLOAT3 m_pos;
+	ChunkCoord m_pos;
 	
-	// Currently defines a 3D array of 16x16x16 blocks
-	Block m_chunk[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
+	// CHUNK_SIZE^3 blocks, laid out as CHUNK_BLOCK_LAYOUT says. Always index it through ChunkBlockLayout
+	Block m_blocks[BLOCKS_PER_CHUNK];
+
+	// Sky and block light of every block, packed as LightEngine says and laid out like m_blocks
+	uint8_t m_light[BLOCKS_PER_CHUNK];
 
 	// Variables used for ChunkBufferManager
 	uint32_t m_vertexBufferStartIndex;
 	uint32_t m_blockCount;
 
+	// Written by the updater thread while other threads (e.g. physics) may be following them
+	std::atomic<Chunk*> m_neighbors[NUM_CHUNK_NEIGHBORS];
+
+	// Written along with the mesh, read by the render thread's visibility search and occlusion culling
+	std::atomic<ChunkFaceMask> m_connectivity;
+	std::atomic<bool> m_isOccluder;
+	std::atomic<bool> m_isEmpty;
+
 };
 
 #endif
\ No newline at end of file
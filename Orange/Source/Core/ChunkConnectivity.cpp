@@ -0,0 +1,166 @@
+#include "../Misc/pch.h"
+
+#include <unordered_set>
+
+#include "ChunkConnectivity.h"
+#include "BlockRegistry.h"
+#include "ChunkCuller.h"
+
+// Faces of the chunk the block lies on, one bit per ChunkNeighbor
+template<int32_t Size>
+static inline uint32_t GetBorderFaces(const int32_t x, const int32_t y, const int32_t z)
+{
+	constexpr int32_t last = Size - 1;
+	return (x == 0 ? (1u << static_cast<uint32_t>(ChunkNeighbor::LEFT)) : 0) | (x == last ? (1u << static_cast<uint32_t>(ChunkNeighbor::RIGHT)) : 0) |
+		(y == 0 ? (1u << static_cast<uint32_t>(ChunkNeighbor::BOTTOM)) : 0) | (y == last ? (1u << static_cast<uint32_t>(ChunkNeighbor::TOP)) : 0) |
+		(z == 0 ? (1u << static_cast<uint32_t>(ChunkNeighbor::FRONT)) : 0) | (z == last ? (1u << static_cast<uint32_t>(ChunkNeighbor::BACK)) : 0);
+}
+
+// Every pair of the faces in "faces" is connected
+static ChunkFaceMask GetConnectedPairs(const uint32_t faces)
+{
+	ChunkFaceMask connectivity = NO_FACES_CONNECTED;
+	for (uint32_t a = 0; a < NUM_CHUNK_NEIGHBORS; a++)
+	{
+		if (!(faces & (1u << a))) continue;
+
+		for (uint32_t b = a + 1; b < NUM_CHUNK_NEIGHBORS; b++)
+		{
+			if (faces & (1u << b)) connectivity |= 1 << ChunkConnectivity::GetFacePairBit(static_cast<ChunkNeighbor>(a), static_cast<ChunkNeighbor>(b));
+		}
+	}
+
+	return connectivity;
+}
+
+template<int32_t Size>
+ChunkFaceMask ChunkConnectivity::Compute(const BasicChunkSnapshot<Size>& snapshot)
+{
+	using Traits = ChunkTraits<Size>;
+	using Snapshot = BasicChunkSnapshot<Size>;
+
+	// Reused between chunks, meshing runs on more than one thread. Blocks are laid out as [x][y][z]
+	thread_local std::vector<uint8_t> isOpen;
+	thread_local std::vector<uint32_t> stack;
+	isOpen.resize(Traits::VOLUME);
+	stack.reserve(Traits::VOLUME);
+
+	uint32_t numOpenBlocks = 0;
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t y = 0; y < Size; y++)
+		{
+			const BlockType* row = &snapshot.blocks[Snapshot::GetIndex(x + 1, y + 1, 1)];
+			uint8_t* openRow = &isOpen[Traits::GetIndex(x, y, 0)];
+			for (int32_t z = 0; z < Size; z++)
+			{
+				openRow[z] = BlockRegistry::IsOpaque(row[z]) ? 0 : 1;
+				numOpenBlocks += openRow[z];
+			}
+		}
+	}
+
+	if (numOpenBlocks == 0) return NO_FACES_CONNECTED;
+	if (numOpenBlocks == Traits::VOLUME) return ALL_FACES_CONNECTED;
+
+	// Every open region that hasn't been visited yet connects all the faces it touches. Visited blocks are closed
+	ChunkFaceMask connectivity = NO_FACES_CONNECTED;
+	for (uint32_t start = 0; start < Traits::VOLUME && connectivity != ALL_FACES_CONNECTED; start++)
+	{
+		if (!isOpen[start]) continue;
+
+		isOpen[start] = 0;
+		stack.push_back(start);
+
+		uint32_t faces = 0;
+		while (!stack.empty())
+		{
+			const uint32_t index = stack.back();
+			stack.pop_back();
+
+			const int32_t x = static_cast<int32_t>(index >> (2 * Traits::SHIFT));
+			const int32_t y = static_cast<int32_t>((index >> Traits::SHIFT) & Traits::MASK);
+			const int32_t z = static_cast<int32_t>(index & Traits::MASK);
+			faces |= GetBorderFaces<Size>(x, y, z);
+
+			auto visit = [&](const bool isInside, const uint32_t neighborIndex)
+			{
+				if (!isInside || !isOpen[neighborIndex]) return;
+				isOpen[neighborIndex] = 0;
+				stack.push_back(neighborIndex);
+			};
+
+			visit(x > 0, index - Traits::GetIndex(1, 0, 0));
+			visit(x < Size - 1, index + Traits::GetIndex(1, 0, 0));
+			visit(y > 0, index - Traits::GetIndex(0, 1, 0));
+			visit(y < Size - 1, index + Traits::GetIndex(0, 1, 0));
+			visit(z > 0, index - 1);
+			visit(z < Size - 1, index + 1);
+		}
+
+		connectivity |= GetConnectedPairs(faces);
+	}
+
+	stack.clear();
+	return connectivity;
+}
+
+bool ChunkConnectivity::FindVisibleChunks(ConnectivityWorld& world, const ChunkCoord& cameraPosCS, const Orange::Plane* frustumPlanes,
+	std::vector<ChunkCoord>& outVisibleChunks)
+{
+	// A chunk the search reached, and the face it came in through
+	struct SearchStep
+	{
+		ChunkCoord chunkPosCS;
+		ChunkFaceMask connectivity;
+		uint8_t entryFace;
+
+		// One bit per direction (ChunkNeighbor) the search moved in to get here
+		uint8_t directions;
+	};
+
+	outVisibleChunks.clear();
+
+	ChunkFaceMask cameraConnectivity;
+	if (!world.GetConnectivity(cameraPosCS, cameraConnectivity)) return false;
+
+	thread_local std::vector<SearchStep> queue;
+	thread_local std::unordered_set<uint64_t> visited;
+	queue.clear();
+	visited.clear();
+
+	// The camera can look out through any face of its own chunk, whatever is inside it
+	constexpr uint8_t NO_ENTRY_FACE = NUM_CHUNK_NEIGHBORS;
+	queue.push_back({ cameraPosCS, ALL_FACES_CONNECTED, NO_ENTRY_FACE, 0 });
+	visited.insert(Orange::Math::GetHashKeyFromChunkPosition(cameraPosCS));
+	outVisibleChunks.push_back(cameraPosCS);
+
+	for (size_t i = 0; i < queue.size(); i++)
+	{
+		const SearchStep step = queue[i];
+		for (uint8_t face = 0; face < NUM_CHUNK_NEIGHBORS; face++)
+		{
+			const ChunkNeighbor exitFace = static_cast<ChunkNeighbor>(face);
+			if (step.directions & (1 << static_cast<uint8_t>(GetOppositeNeighbor(exitFace)))) continue;
+			if (step.entryFace != NO_ENTRY_FACE &&
+				(face == step.entryFace || !AreFacesConnected(step.connectivity, static_cast<ChunkNeighbor>(step.entryFace), exitFace))) continue;
+
+			const ChunkCoord neighborPosCS = step.chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[face];
+			if (!visited.insert(Orange::Math::GetHashKeyFromChunkPosition(neighborPosCS)).second) continue;
+			if (!ChunkCuller::IsChunkVisible(frustumPlanes, neighborPosCS)) continue;
+
+			ChunkFaceMask neighborConnectivity;
+			if (!world.GetConnectivity(neighborPosCS, neighborConnectivity)) continue;
+
+			outVisibleChunks.push_back(neighborPosCS);
+			queue.push_back({ neighborPosCS, neighborConnectivity, static_cast<uint8_t>(GetOppositeNeighbor(exitFace)),
+				static_cast<uint8_t>(step.directions | (1 << face)) });
+		}
+	}
+
+	return true;
+}
+
+template ChunkFaceMask ChunkConnectivity::Compute<16>(const BasicChunkSnapshot<16>& snapshot);
+template ChunkFaceMask ChunkConnectivity::Compute<32>(const BasicChunkSnapshot<32>& snapshot);
+template ChunkFaceMask ChunkConnectivity::Compute<64>(const BasicChunkSnapshot<64>& snapshot);
@@ -0,0 +1,63 @@
+#ifndef _CHUNKCONNECTIVITY_H
+#define _CHUNKCONNECTIVITY_H
+
+#include <vector>
+
+#include "ChunkCoord.h"
+#include "ChunkMesher.h"
+#include "Physics.h"
+
+// One bit for every pair of a chunk's faces (15 of them), set if the two faces are connected through
+// blocks that aren't opaque. Chunks that haven't been meshed yet are treated as entirely open
+using ChunkFaceMask = uint16_t;
+constexpr ChunkFaceMask NO_FACES_CONNECTED = 0;
+constexpr ChunkFaceMask ALL_FACES_CONNECTED = 0x7FFF;
+
+// The chunks the visibility search walks through
+class ConnectivityWorld
+{
+public:
+
+	virtual ~ConnectivityWorld() = default;
+
+	// Returns false if the chunk isn't loaded
+	virtual bool GetConnectivity(const ChunkCoord& chunkPosCS, ChunkFaceMask& outConnectivity) = 0;
+
+};
+
+// Finds the chunks that may be visible from the camera by walking from the camera's chunk to its neighbors, but only
+// through faces that are connected to the face the walk came in through. Enclosed caves and the chunks behind solid
+// ground are never reached, so they aren't drawn even if they're inside the frustum
+class ChunkConnectivity
+{
+public:
+
+	// Index of the bit for a pair of different faces, in any order
+	static constexpr uint32_t GetFacePairBit(const ChunkNeighbor a, const ChunkNeighbor b)
+	{
+		const uint32_t low = static_cast<uint32_t>(a) < static_cast<uint32_t>(b) ? static_cast<uint32_t>(a) : static_cast<uint32_t>(b);
+		const uint32_t high = static_cast<uint32_t>(a) < static_cast<uint32_t>(b) ? static_cast<uint32_t>(b) : static_cast<uint32_t>(a);
+
+		// Pairs are numbered row by row, (0, 1) ... (0, 5), (1, 2) ... (4, 5)
+		return low * (2 * NUM_CHUNK_NEIGHBORS - low - 1) / 2 + (high - low - 1);
+	}
+
+	static inline bool AreFacesConnected(const ChunkFaceMask connectivity, const ChunkNeighbor a, const ChunkNeighbor b)
+	{
+		return (connectivity >> GetFacePairBit(a, b)) & 1;
+	}
+
+	// Flood fills the snapshot's own blocks (not the apron) and returns which faces are connected. Only reads
+	// the snapshot, so it's computed along with the mesh on any thread. Instantiated for every size ChunkTraits supports
+	template<int32_t Size>
+	static ChunkFaceMask Compute(const BasicChunkSnapshot<Size>& snapshot);
+
+	// Breadth first search from "cameraPosCS". A chunk is only entered if it's inside the frustum and loaded, and the
+	// search never turns back along an axis it already moved along in the other direction, so it spreads away from the
+	// camera. Replaces the contents of "outVisibleChunks". Returns false if the camera's chunk isn't loaded
+	static bool FindVisibleChunks(ConnectivityWorld& world, const ChunkCoord& cameraPosCS, const Orange::Plane* frustumPlanes,
+		std::vector<ChunkCoord>& outVisibleChunks);
+
+};
+
+#endif
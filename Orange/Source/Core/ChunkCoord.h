@@ -0,0 +1,184 @@
+#ifndef _CHUNKCOORD_H
+#define _CHUNKCOORD_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <DirectXMath.h>
+
+#include "../Utility/Utility.h"
+
+// Everything that depends on a chunk's edge length, resolved at compile time. The generation and meshing
+// kernels are templated on the edge length, so every supported size gets its own specialised loops
+template<int32_t Size>
+struct ChunkTraits
+{
+	static_assert(Size == 16 || Size == 32 || Size == 64, "Chunks have to be 16, 32 or 64 blocks wide");
+
+	static constexpr int32_t SIZE = Size;
+	static constexpr int32_t SHIFT = (Size == 16) ? 4 : (Size == 32) ? 5 : 6;
+	static constexpr int32_t MASK = Size - 1;
+	static constexpr uint32_t VOLUME = static_cast<uint32_t>(Size * Size * Size);
+
+	// Half of the chunk's edge length in WORLD SPACE, i.e. the extent of its AABB
+	static constexpr float HALF_EXTENT = Size * 0.5f;
+
+	// Blocks are laid out as [x][y][z]
+	static constexpr uint32_t GetIndex(const int32_t x, const int32_t y, const int32_t z)
+	{
+		return static_cast<uint32_t>((x << (2 * SHIFT)) | (y << SHIFT) | z);
+	}
+};
+
+// Chunk dimensions used by the game. Changing the shift to 5 or 6 switches everything over to 32 or 64 block chunks
+constexpr int32_t CHUNK_SIZE_SHIFT = 4;
+constexpr int32_t CHUNK_SIZE = (1 << CHUNK_SIZE_SHIFT);
+constexpr int32_t CHUNK_SIZE_MASK = (CHUNK_SIZE - 1);
+constexpr int32_t DOUBLE_CHUNK_SIZE = (CHUNK_SIZE << 1);
+constexpr uint32_t BLOCKS_PER_CHUNK = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+using DefaultChunkTraits = ChunkTraits<CHUNK_SIZE>;
+static_assert(DefaultChunkTraits::SHIFT == CHUNK_SIZE_SHIFT, "CHUNK_SIZE_SHIFT doesn't match the chunk traits");
+
+// Chunk coordinates are packed into 21 bits per axis for hashing, so every chunk
+// within [MIN_CHUNK_COORD, MAX_CHUNK_COORD] on all axes gets a unique key. That's
+// roughly +-16M blocks in every direction
+constexpr uint32_t CHUNK_COORD_BITS = 21;
+constexpr int32_t MIN_CHUNK_COORD = -(1 << (CHUNK_COORD_BITS - 1));
+constexpr int32_t MAX_CHUNK_COORD = (1 << (CHUNK_COORD_BITS - 1)) - 1;
+
+// A position in CHUNK SPACE
+struct ChunkCoord
+{
+	int32_t x, y, z;
+
+	constexpr ChunkCoord() : x(0), y(0), z(0) {}
+	constexpr ChunkCoord(const int32_t _x, const int32_t _y, const int32_t _z) : x(_x), y(_y), z(_z) {}
+
+	constexpr bool operator==(const ChunkCoord& other) const { return x == other.x && y == other.y && z == other.z; }
+	constexpr bool operator!=(const ChunkCoord& other) const { return !(*this == other); }
+
+	constexpr ChunkCoord operator+(const ChunkCoord& other) const { return ChunkCoord(x + other.x, y + other.y, z + other.z); }
+	constexpr ChunkCoord operator-(const ChunkCoord& other) const { return ChunkCoord(x - other.x, y - other.y, z - other.z); }
+
+	// Still in CHUNK SPACE, for debug output and rendering
+	DirectX::XMFLOAT3 ToFloat3() const { return { static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) }; }
+};
+
+// A position in BLOCK SPACE, either in world space or local to a chunk ([0, CHUNK_SIZE) on every axis)
+struct BlockCoord
+{
+	int32_t x, y, z;
+
+	constexpr BlockCoord() : x(0), y(0), z(0) {}
+	constexpr BlockCoord(const int32_t _x, const int32_t _y, const int32_t _z) : x(_x), y(_y), z(_z) {}
+
+	constexpr bool operator==(const BlockCoord& other) const { return x == other.x && y == other.y && z == other.z; }
+	constexpr bool operator!=(const BlockCoord& other) const { return !(*this == other); }
+
+	constexpr BlockCoord operator+(const BlockCoord& other) const { return BlockCoord(x + other.x, y + other.y, z + other.z); }
+	constexpr BlockCoord operator-(const BlockCoord& other) const { return BlockCoord(x - other.x, y - other.y, z - other.z); }
+
+	DirectX::XMFLOAT3 ToFloat3() const { return { static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) }; }
+};
+
+// The six chunks that share a face with a chunk. Opposite directions only differ in the lowest bit
+enum class ChunkNeighbor : uint8_t
+{
+	LEFT	= 0,
+	RIGHT	= 1,
+	BOTTOM	= 2,
+	TOP		= 3,
+	FRONT	= 4,
+	BACK	= 5
+};
+
+constexpr uint32_t NUM_CHUNK_NEIGHBORS = 6;
+
+// Offset of every neighbor in CHUNK SPACE, indexed by ChunkNeighbor
+constexpr ChunkCoord CHUNK_NEIGHBOR_OFFSETS[NUM_CHUNK_NEIGHBORS] =
+{
+	ChunkCoord(-1, 0, 0), ChunkCoord(1, 0, 0),
+	ChunkCoord(0, -1, 0), ChunkCoord(0, 1, 0),
+	ChunkCoord(0, 0, -1), ChunkCoord(0, 0, 1)
+};
+
+inline constexpr ChunkNeighbor GetOppositeNeighbor(const ChunkNeighbor neighbor) { return static_cast<ChunkNeighbor>(static_cast<uint8_t>(neighbor) ^ 1); }
+
+namespace Orange
+{
+	namespace Math
+	{
+		// Returns the block that contains "posWS", rounding towards negative infinity
+		inline BlockCoord WorldToBlockCoord(const DirectX::XMFLOAT3& posWS)
+		{
+			return BlockCoord(static_cast<int32_t>(floorf(posWS.x)), static_cast<int32_t>(floorf(posWS.y)), static_cast<int32_t>(floorf(posWS.z)));
+		}
+
+		// Right shifting a negative number is an arithmetic shift (since C++20), so this rounds towards negative infinity as well
+		template<int32_t Size = CHUNK_SIZE>
+		inline constexpr ChunkCoord BlockToChunkCoord(const BlockCoord& block)
+		{
+			constexpr int32_t shift = ChunkTraits<Size>::SHIFT;
+			return ChunkCoord(block.x >> shift, block.y >> shift, block.z >> shift);
+		}
+
+		// Returns the block's coordinates inside its chunk
+		template<int32_t Size = CHUNK_SIZE>
+		inline constexpr BlockCoord BlockToLocalCoord(const BlockCoord& block)
+		{
+			constexpr int32_t mask = ChunkTraits<Size>::MASK;
+			return BlockCoord(block.x & mask, block.y & mask, block.z & mask);
+		}
+
+		// Returns the chunk's minimum corner in BLOCK SPACE
+		template<int32_t Size = CHUNK_SIZE>
+		inline constexpr BlockCoord ChunkToBlockCoord(const ChunkCoord& chunk)
+		{
+			constexpr int32_t shift = ChunkTraits<Size>::SHIFT;
+			return BlockCoord(chunk.x << shift, chunk.y << shift, chunk.z << shift);
+		}
+
+		template<int32_t Size = CHUNK_SIZE>
+		inline ChunkCoord WorldToChunkSpace(const DirectX::XMFLOAT3& posWS)
+		{
+			return BlockToChunkCoord<Size>(WorldToBlockCoord(posWS));
+		}
+
+		// Returns the chunk's minimum corner in WORLD SPACE
+		template<int32_t Size = CHUNK_SIZE>
+		inline DirectX::XMFLOAT3 ChunkToWorldSpace(const ChunkCoord& chunk)
+		{
+			return ChunkToBlockCoord<Size>(chunk).ToFloat3();
+		}
+
+		// Returns a unique key for every chunk within [MIN_CHUNK_COORD, MAX_CHUNK_COORD]. The packed
+		// coordinates are run through the splitmix64 finalizer, which is a bijection, so that nearby
+		// chunks don't end up with nearby keys (and in the same hash buckets)
+		inline uint64_t GetHashKeyFromChunkPosition(const ChunkCoord& chunk)
+		{
+			OG_ASSERT_MSG(chunk.x >= MIN_CHUNK_COORD && chunk.x <= MAX_CHUNK_COORD &&
+				chunk.y >= MIN_CHUNK_COORD && chunk.y <= MAX_CHUNK_COORD &&
+				chunk.z >= MIN_CHUNK_COORD && chunk.z <= MAX_CHUNK_COORD, "Chunk coordinate out of range");
+
+			constexpr uint64_t axisMask = (1ull << CHUNK_COORD_BITS) - 1;
+			uint64_t key =
+				((static_cast<uint64_t>(chunk.x) & axisMask) << (2 * CHUNK_COORD_BITS)) |
+				((static_cast<uint64_t>(chunk.y) & axisMask) << CHUNK_COORD_BITS) |
+				(static_cast<uint64_t>(chunk.z) & axisMask);
+
+			key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+			key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+			return key ^ (key >> 31);
+		}
+
+		// Returns the number of chunks between two chunks along the axis where they are furthest apart.
+		// Chunks are loaded in a cube around the player, so this is the distance that matches the render distance
+		inline int32_t ChunkDistance(const ChunkCoord& a, const ChunkCoord& b)
+		{
+			return max(max(abs(a.x - b.x), abs(a.y - b.y)), abs(a.z - b.z));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,490 @@
+#include "../Misc/pch.h"
+
+#include <cmath>
+#include <limits>
+
+#include "ChunkCuller.h"
+
+using namespace Orange::Simd;
+
+// Extent of a cluster's AABB, which covers all of its chunks whether they're loaded or not
+constexpr float CLUSTER_HALF_EXTENT = DefaultChunkTraits::HALF_EXTENT * CULLING_CLUSTER_SIZE;
+
+// What CullCoherent() remembers. Anything below NUM_CULLING_PLANES is the index of the plane that rejected it
+constexpr uint8_t CLASSIFIED_VISIBLE = NUM_CULLING_PLANES;
+constexpr uint8_t CLASSIFIED_INSIDE = NUM_CULLING_PLANES + 1;
+constexpr uint8_t CLASSIFIED_STRADDLING = NUM_CULLING_PLANES + 2;
+
+// Added to the drift on every call, so that rounding never lets a classification live past the point it could change
+constexpr double COHERENCE_EPSILON = 1e-3;
+
+// Every plane, broadcast to a whole batch
+struct BatchPlanes
+{
+	FloatBatch normalX[NUM_CULLING_PLANES];
+	FloatBatch normalY[NUM_CULLING_PLANES];
+	FloatBatch normalZ[NUM_CULLING_PLANES];
+
+	// A chunk is visible from a plane if its center is no further than this behind it
+	FloatBatch chunkMinDistance[NUM_CULLING_PLANES];
+
+	// Same for a cluster, which is entirely inside if its center is at least this far in front of it
+	FloatBatch clusterMinDistance[NUM_CULLING_PLANES];
+	FloatBatch clusterInsideDistance[NUM_CULLING_PLANES];
+};
+
+static inline float GetProjectedExtent(const Orange::Plane& plane, const float halfExtent)
+{
+	return halfExtent * (fabsf(plane.normal.x) + fabsf(plane.normal.y) + fabsf(plane.normal.z));
+}
+
+static inline float GetMinDistance(const Orange::Plane& plane)
+{
+	return plane.point - GetProjectedExtent(plane, DefaultChunkTraits::HALF_EXTENT);
+}
+
+static BatchPlanes BroadcastPlanes(const Orange::Plane* planes)
+{
+	BatchPlanes batchPlanes;
+	for (uint32_t i = 0; i < NUM_CULLING_PLANES; i++)
+	{
+		const float clusterExtent = GetProjectedExtent(planes[i], CLUSTER_HALF_EXTENT);
+		batchPlanes.normalX[i] = Broadcast(planes[i].normal.x);
+		batchPlanes.normalY[i] = Broadcast(planes[i].normal.y);
+		batchPlanes.normalZ[i] = Broadcast(planes[i].normal.z);
+		batchPlanes.chunkMinDistance[i] = Broadcast(GetMinDistance(planes[i]));
+		batchPlanes.clusterMinDistance[i] = Broadcast(planes[i].point - clusterExtent);
+		batchPlanes.clusterInsideDistance[i] = Broadcast(planes[i].point + clusterExtent);
+	}
+	return batchPlanes;
+}
+
+// Signed distance from the plane to a batch of centers, added up in the same order as CullScalar() does
+static inline FloatBatch GetDistance(const BatchPlanes& planes, const uint32_t i, const FloatBatch centerX, const FloatBatch centerY, const FloatBatch centerZ)
+{
+	return MultiplyAdd(planes.normalZ[i], centerZ, MultiplyAdd(planes.normalY[i], centerY, Multiply(planes.normalX[i], centerX)));
+}
+
+// Appends the chunks that are on the inner side of every plane in "planeMask"
+static void CullChunkBatches(const BatchPlanes& planes, const uint32_t planeMask, const std::vector<float>& centerX, const std::vector<float>& centerY,
+	const std::vector<float>& centerZ, const std::vector<ChunkCoord>& chunks, std::vector<ChunkCoord>& outVisibleChunks)
+{
+	if (planeMask == 0)
+	{
+		outVisibleChunks.insert(outVisibleChunks.end(), chunks.begin(), chunks.end());
+		return;
+	}
+
+	uint32_t planeIndices[NUM_CULLING_PLANES];
+	uint32_t numPlanes = 0;
+	for (uint32_t mask = planeMask; mask != 0; mask &= mask - 1) planeIndices[numPlanes++] = CountTrailingZeros(mask);
+
+	const uint32_t numPaddedChunks = static_cast<uint32_t>(centerX.size());
+	for (uint32_t batchIndex = 0; batchIndex < numPaddedChunks; batchIndex += ChunkCuller::BATCH_SIZE)
+	{
+		const FloatBatch x = LoadBatch(&centerX[batchIndex]);
+		const FloatBatch y = LoadBatch(&centerY[batchIndex]);
+		const FloatBatch z = LoadBatch(&centerZ[batchIndex]);
+
+		MaskBatch isVisible = GreaterEqual(GetDistance(planes, planeIndices[0], x, y, z), planes.chunkMinDistance[planeIndices[0]]);
+		for (uint32_t i = 1; i < numPlanes; i++)
+		{
+			isVisible = And(isVisible, GreaterEqual(GetDistance(planes, planeIndices[i], x, y, z), planes.chunkMinDistance[planeIndices[i]]));
+		}
+
+		for (uint32_t laneMask = GetLaneMask(isVisible); laneMask != 0; laneMask &= laneMask - 1)
+		{
+			outVisibleChunks.push_back(chunks[batchIndex + CountTrailingZeros(laneMask)]);
+		}
+	}
+}
+
+static inline ChunkCoord GetClusterPos(const ChunkCoord& chunkPosCS)
+{
+	return ChunkCoord(chunkPosCS.x >> CULLING_CLUSTER_SHIFT, chunkPosCS.y >> CULLING_CLUSTER_SHIFT, chunkPosCS.z >> CULLING_CLUSTER_SHIFT);
+}
+
+static inline DirectX::XMFLOAT3 GetChunkCenter(const ChunkCoord& chunkPosCS)
+{
+	const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+	return { minWS.x + DefaultChunkTraits::HALF_EXTENT, minWS.y + DefaultChunkTraits::HALF_EXTENT, minWS.z + DefaultChunkTraits::HALF_EXTENT };
+}
+
+static inline DirectX::XMFLOAT3 GetClusterCenter(const ChunkCoord& clusterPos)
+{
+	const ChunkCoord firstChunkCS(clusterPos.x << CULLING_CLUSTER_SHIFT, clusterPos.y << CULLING_CLUSTER_SHIFT, clusterPos.z << CULLING_CLUSTER_SHIFT);
+	const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(firstChunkCS);
+	return { minWS.x + CLUSTER_HALF_EXTENT, minWS.y + CLUSTER_HALF_EXTENT, minWS.z + CLUSTER_HALF_EXTENT };
+}
+
+void ChunkCuller::CenterArrays::Set(const uint32_t index, const DirectX::XMFLOAT3& center)
+{
+	OG_ASSERT_MSG(index <= x.size(), "Centers have to be added right after the last one");
+	if (index >= x.size())
+	{
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		x.resize(x.size() + BATCH_SIZE, nan);
+		y.resize(y.size() + BATCH_SIZE, nan);
+		z.resize(z.size() + BATCH_SIZE, nan);
+	}
+
+	x[index] = center.x;
+	y[index] = center.y;
+	z[index] = center.z;
+}
+
+void ChunkCuller::CenterArrays::Remove(const uint32_t index, const uint32_t lastIndex)
+{
+	if (index != lastIndex)
+	{
+		x[index] = x[lastIndex];
+		y[index] = y[lastIndex];
+		z[index] = z[lastIndex];
+	}
+
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	x[lastIndex] = y[lastIndex] = z[lastIndex] = nan;
+
+	// Drops the last batch once it's only padding
+	if (x.size() - lastIndex >= BATCH_SIZE)
+	{
+		x.resize(x.size() - BATCH_SIZE);
+		y.resize(y.size() - BATCH_SIZE);
+		z.resize(z.size() - BATCH_SIZE);
+	}
+}
+
+void ChunkCuller::CenterArrays::Clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+}
+
+void ChunkCuller::Add(const ChunkCoord& chunkPosCS)
+{
+	const uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS);
+	OG_ASSERT_MSG(m_chunkIndices.find(hashKey) == m_chunkIndices.end(), "The chunk was already added to the culler");
+
+	const ChunkCoord clusterPos = GetClusterPos(chunkPosCS);
+	const uint64_t clusterKey = Orange::Math::GetHashKeyFromChunkPosition(clusterPos);
+
+	uint32_t clusterIndex;
+	auto iter = m_clusterIndices.find(clusterKey);
+	if (iter == m_clusterIndices.end())
+	{
+		clusterIndex = static_cast<uint32_t>(m_clusters.size());
+		m_clusters.emplace_back();
+		m_clusters.back().clusterPos = clusterPos;
+		m_clusterCenters.Set(clusterIndex, GetClusterCenter(clusterPos));
+		m_clusterIndices[clusterKey] = clusterIndex;
+	}
+	else
+	{
+		clusterIndex = iter->second;
+	}
+
+	Cluster& cluster = m_clusters[clusterIndex];
+	const uint32_t index = static_cast<uint32_t>(cluster.chunks.size());
+	cluster.chunks.push_back(chunkPosCS);
+	cluster.chunkClassifications.emplace_back();
+	cluster.centers.Set(index, GetChunkCenter(chunkPosCS));
+	m_chunkIndices[hashKey] = index;
+}
+
+void ChunkCuller::Remove(const ChunkCoord& chunkPosCS)
+{
+	auto chunkIter = m_chunkIndices.find(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS));
+	if (chunkIter == m_chunkIndices.end()) return;
+
+	auto clusterIter = m_clusterIndices.find(Orange::Math::GetHashKeyFromChunkPosition(GetClusterPos(chunkPosCS)));
+	OG_ASSERT_MSG(clusterIter != m_clusterIndices.end(), "A chunk was added to the culler without its cluster");
+
+	const uint32_t clusterIndex = clusterIter->second;
+	Cluster& cluster = m_clusters[clusterIndex];
+
+	const uint32_t index = chunkIter->second;
+	const uint32_t lastIndex = static_cast<uint32_t>(cluster.chunks.size()) - 1;
+	m_chunkIndices.erase(chunkIter);
+
+	if (index != lastIndex)
+	{
+		cluster.chunks[index] = cluster.chunks[lastIndex];
+		cluster.chunkClassifications[index] = cluster.chunkClassifications[lastIndex];
+		m_chunkIndices[Orange::Math::GetHashKeyFromChunkPosition(cluster.chunks[index])] = index;
+	}
+	cluster.chunks.pop_back();
+	cluster.chunkClassifications.pop_back();
+	cluster.centers.Remove(index, lastIndex);
+
+	if (!cluster.chunks.empty()) return;
+
+	// The cluster is gone along with its last chunk
+	const uint32_t lastClusterIndex = static_cast<uint32_t>(m_clusters.size()) - 1;
+	m_clusterIndices.erase(clusterIter);
+
+	if (clusterIndex != lastClusterIndex)
+	{
+		m_clusters[clusterIndex] = std::move(m_clusters[lastClusterIndex]);
+		m_clusterIndices[Orange::Math::GetHashKeyFromChunkPosition(m_clusters[clusterIndex].clusterPos)] = clusterIndex;
+	}
+	m_clusters.pop_back();
+	m_clusterCenters.Remove(clusterIndex, lastClusterIndex);
+}
+
+void ChunkCuller::Clear()
+{
+	m_clusterCenters.Clear();
+	m_clusters.clear();
+	m_clusterIndices.clear();
+	m_chunkIndices.clear();
+}
+
+const uint32_t ChunkCuller::GetNumChunks() const { return static_cast<uint32_t>(m_chunkIndices.size()); }
+
+const uint32_t ChunkCuller::GetNumClusters() const { return static_cast<uint32_t>(m_clusters.size()); }
+
+void ChunkCuller::Cull(const Orange::Plane* planes, std::vector<ChunkCoord>& outVisibleChunks) const
+{
+	const BatchPlanes batchPlanes = BroadcastPlanes(planes);
+
+	// Every chunk may be visible, so there's room for all of them. Resizing instead would clear all of it on every call
+	outVisibleChunks.reserve(outVisibleChunks.size() + m_chunkIndices.size());
+
+	const uint32_t numPaddedClusters = static_cast<uint32_t>(m_clusterCenters.x.size());
+	for (uint32_t batchIndex = 0; batchIndex < numPaddedClusters; batchIndex += BATCH_SIZE)
+	{
+		const FloatBatch x = LoadBatch(&m_clusterCenters.x[batchIndex]);
+		const FloatBatch y = LoadBatch(&m_clusterCenters.y[batchIndex]);
+		const FloatBatch z = LoadBatch(&m_clusterCenters.z[batchIndex]);
+
+		// Which lanes are entirely in front of each plane
+		uint32_t insideLaneMasks[NUM_CULLING_PLANES];
+
+		FloatBatch distance = GetDistance(batchPlanes, 0, x, y, z);
+		MaskBatch isVisible = GreaterEqual(distance, batchPlanes.clusterMinDistance[0]);
+		insideLaneMasks[0] = GetLaneMask(GreaterEqual(distance, batchPlanes.clusterInsideDistance[0]));
+		for (uint32_t i = 1; i < NUM_CULLING_PLANES; i++)
+		{
+			distance = GetDistance(batchPlanes, i, x, y, z);
+			isVisible = And(isVisible, GreaterEqual(distance, batchPlanes.clusterMinDistance[i]));
+			insideLaneMasks[i] = GetLaneMask(GreaterEqual(distance, batchPlanes.clusterInsideDistance[i]));
+		}
+
+		for (uint32_t laneMask = GetLaneMask(isVisible); laneMask != 0; laneMask &= laneMask - 1)
+		{
+			const uint32_t lane = CountTrailingZeros(laneMask);
+
+			// The chunks only need to be tested against the planes the cluster straddles
+			uint32_t planeMask = 0;
+			for (uint32_t i = 0; i < NUM_CULLING_PLANES; i++)
+			{
+				planeMask |= (((insideLaneMasks[i] >> lane) & 1) ^ 1) << i;
+			}
+
+			const Cluster& cluster = m_clusters[batchIndex + lane];
+			CullChunkBatches(batchPlanes, planeMask, cluster.centers.x, cluster.centers.y, cluster.centers.z, cluster.chunks, outVisibleChunks);
+		}
+	}
+}
+
+void ChunkCuller::CullWithoutClusters(const Orange::Plane* planes, std::vector<ChunkCoord>& outVisibleChunks) const
+{
+	const BatchPlanes batchPlanes = BroadcastPlanes(planes);
+	outVisibleChunks.reserve(outVisibleChunks.size() + m_chunkIndices.size());
+
+	for (const auto& cluster : m_clusters)
+	{
+		CullChunkBatches(batchPlanes, ALL_CULLING_PLANES, cluster.centers.x, cluster.centers.y, cluster.centers.z, cluster.chunks, outVisibleChunks);
+	}
+}
+
+void ChunkCuller::CullScalar(const Orange::Plane* planes, std::vector<ChunkCoord>& outVisibleChunks) const
+{
+	for (const auto& cluster : m_clusters)
+	{
+		for (uint32_t chunkIndex = 0; chunkIndex < cluster.chunks.size(); chunkIndex++)
+		{
+			bool isVisible = true;
+			for (uint32_t i = 0; i < NUM_CULLING_PLANES && isVisible; i++)
+			{
+				const Orange::Plane& plane = planes[i];
+				const float distance = plane.normal.z * cluster.centers.z[chunkIndex] + (plane.normal.y * cluster.centers.y[chunkIndex] + plane.normal.x * cluster.centers.x[chunkIndex]);
+				isVisible = distance >= GetMinDistance(plane);
+			}
+
+			if (isVisible) outVisibleChunks.push_back(cluster.chunks[chunkIndex]);
+		}
+	}
+}
+
+void ChunkCuller::CullCoherent(const Orange::Plane* planes, const DirectX::XMFLOAT3& cameraPosWS, std::vector<ChunkCoord>& outVisibleChunks)
+{
+	AdvanceDrift(planes, cameraPosWS);
+	outVisibleChunks.reserve(outVisibleChunks.size() + m_chunkIndices.size());
+
+	// The planes are tested in this order, after the one that rejected the cluster or chunk last time
+	auto getPlaneOrder = [](const uint32_t planeMask, const uint8_t lastResult, uint32_t* outPlaneIndices)
+	{
+		uint32_t numPlanes = 0;
+		if (lastResult < NUM_CULLING_PLANES && ((planeMask >> lastResult) & 1)) outPlaneIndices[numPlanes++] = lastResult;
+		for (uint32_t mask = planeMask; mask != 0; mask &= mask - 1)
+		{
+			const uint32_t i = CountTrailingZeros(mask);
+			if (i != lastResult) outPlaneIndices[numPlanes++] = i;
+		}
+		return numPlanes;
+	};
+
+	for (uint32_t clusterIndex = 0; clusterIndex < m_clusters.size(); clusterIndex++)
+	{
+		Cluster& cluster = m_clusters[clusterIndex];
+		Classification& clusterClassification = cluster.classification;
+		if (m_drift < clusterClassification.validUntil)
+		{
+			if (clusterClassification.result == CLASSIFIED_INSIDE) outVisibleChunks.insert(outVisibleChunks.end(), cluster.chunks.begin(), cluster.chunks.end());
+			continue;
+		}
+
+		uint32_t planeIndices[NUM_CULLING_PLANES];
+		uint32_t numPlanes = getPlaneOrder(ALL_CULLING_PLANES, clusterClassification.result, planeIndices);
+
+		// How far the cluster is inside the planes it's entirely inside of. Its chunks are at least as far from being rejected by them
+		float insideMargin = FLT_MAX;
+		uint32_t straddledPlanes = 0;
+		bool isRejected = false;
+		for (uint32_t i = 0; i < numPlanes; i++)
+		{
+			const uint32_t planeIndex = planeIndices[i];
+			const Orange::Plane& plane = planes[planeIndex];
+			const float extent = GetProjectedExtent(plane, CLUSTER_HALF_EXTENT);
+			const float distance = plane.normal.z * m_clusterCenters.z[clusterIndex] + (plane.normal.y * m_clusterCenters.y[clusterIndex] + plane.normal.x * m_clusterCenters.x[clusterIndex]);
+			m_numCoherentPlaneTests++;
+
+			if (distance < plane.point - extent)
+			{
+				clusterClassification = { m_drift + (plane.point - extent - distance), static_cast<uint8_t>(planeIndex) };
+				isRejected = true;
+				break;
+			}
+
+			if (distance >= plane.point + extent) insideMargin = min(insideMargin, distance - (plane.point + extent));
+			else straddledPlanes |= 1u << planeIndex;
+		}
+
+		if (isRejected) continue;
+
+		if (straddledPlanes == 0)
+		{
+			clusterClassification = { m_drift + insideMargin, CLASSIFIED_INSIDE };
+			outVisibleChunks.insert(outVisibleChunks.end(), cluster.chunks.begin(), cluster.chunks.end());
+			continue;
+		}
+
+		// Straddling clusters are tested again on every call, their chunks may not be
+		clusterClassification = { -1.0, CLASSIFIED_STRADDLING };
+
+		for (uint32_t chunkIndex = 0; chunkIndex < cluster.chunks.size(); chunkIndex++)
+		{
+			Classification& chunkClassification = cluster.chunkClassifications[chunkIndex];
+			if (m_drift < chunkClassification.validUntil)
+			{
+				if (chunkClassification.result == CLASSIFIED_VISIBLE) outVisibleChunks.push_back(cluster.chunks[chunkIndex]);
+				continue;
+			}
+
+			// Tested exactly like CullScalar(), so they always agree
+			numPlanes = getPlaneOrder(straddledPlanes, chunkClassification.result, planeIndices);
+			float visibleMargin = insideMargin;
+			isRejected = false;
+			for (uint32_t i = 0; i < numPlanes; i++)
+			{
+				const uint32_t planeIndex = planeIndices[i];
+				const Orange::Plane& plane = planes[planeIndex];
+				const float distance = plane.normal.z * cluster.centers.z[chunkIndex] + (plane.normal.y * cluster.centers.y[chunkIndex] + plane.normal.x * cluster.centers.x[chunkIndex]);
+				const float minDistance = GetMinDistance(plane);
+				m_numCoherentPlaneTests++;
+
+				if (distance < minDistance)
+				{
+					chunkClassification = { m_drift + (minDistance - distance), static_cast<uint8_t>(planeIndex) };
+					isRejected = true;
+					break;
+				}
+
+				visibleMargin = min(visibleMargin, distance - minDistance);
+			}
+
+			if (isRejected) continue;
+
+			chunkClassification = { m_drift + visibleMargin, CLASSIFIED_VISIBLE };
+			outVisibleChunks.push_back(cluster.chunks[chunkIndex]);
+		}
+	}
+}
+
+void ChunkCuller::ResetCoherence()
+{
+	for (auto& cluster : m_clusters)
+	{
+		cluster.classification = Classification();
+		for (auto& chunkClassification : cluster.chunkClassifications) chunkClassification = Classification();
+	}
+
+	m_drift = 0.0;
+	m_hasPreviousPlanes = false;
+}
+
+const uint64_t ChunkCuller::GetNumCoherentPlaneTests() const { return m_numCoherentPlaneTests; }
+
+void ChunkCuller::AdvanceDrift(const Orange::Plane* planes, const DirectX::XMFLOAT3& cameraPosWS)
+{
+	if (m_hasPreviousPlanes)
+	{
+		// A center's distance to a plane is n.(c - o) + (n.o - point) for any point "o". Measured from the camera, it
+		// can change by no more than |n - n'| * |c - o| plus the change of the second term. The projected extent
+		// changes by no more than |n - n'| * halfExtent * sqrt(3)
+		float maxNormalChange = 0.0f, maxOffsetChange = 0.0f;
+		for (uint32_t i = 0; i < NUM_CULLING_PLANES; i++)
+		{
+			const Orange::Plane& plane = planes[i];
+			const Orange::Plane& previousPlane = m_previousPlanes[i];
+			const float dx = plane.normal.x - previousPlane.normal.x;
+			const float dy = plane.normal.y - previousPlane.normal.y;
+			const float dz = plane.normal.z - previousPlane.normal.z;
+			const float offset = plane.normal.x * cameraPosWS.x + plane.normal.y * cameraPosWS.y + plane.normal.z * cameraPosWS.z - plane.point;
+			const float previousOffset = previousPlane.normal.x * cameraPosWS.x + previousPlane.normal.y * cameraPosWS.y + previousPlane.normal.z * cameraPosWS.z - previousPlane.point;
+			maxNormalChange = max(maxNormalChange, sqrtf(dx * dx + dy * dy + dz * dz));
+			maxOffsetChange = max(maxOffsetChange, fabsf(offset - previousOffset));
+		}
+
+		// Every chunk and its extent is within its cluster's, so the farthest cluster bounds them all
+		float maxDistanceSq = 0.0f;
+		for (uint32_t i = 0; i < m_clusters.size(); i++)
+		{
+			const float dx = m_clusterCenters.x[i] - cameraPosWS.x;
+			const float dy = m_clusterCenters.y[i] - cameraPosWS.y;
+			const float dz = m_clusterCenters.z[i] - cameraPosWS.z;
+			maxDistanceSq = max(maxDistanceSq, dx * dx + dy * dy + dz * dz);
+		}
+		const float reach = sqrtf(maxDistanceSq) + CLUSTER_HALF_EXTENT * 1.7320508f;
+
+		m_drift += static_cast<double>(maxNormalChange) * reach + maxOffsetChange + COHERENCE_EPSILON;
+	}
+
+	std::copy(planes, planes + NUM_CULLING_PLANES, m_previousPlanes.begin());
+	m_hasPreviousPlanes = true;
+}
+
+bool ChunkCuller::IsChunkVisible(const Orange::Plane* planes, const ChunkCoord& chunkPosCS)
+{
+	const DirectX::XMFLOAT3 center = GetChunkCenter(chunkPosCS);
+	for (uint32_t i = 0; i < NUM_CULLING_PLANES; i++)
+	{
+		const Orange::Plane& plane = planes[i];
+		const float distance = plane.normal.z * center.z + (plane.normal.y * center.y + plane.normal.x * center.x);
+		if (distance < GetMinDistance(plane)) return false;
+	}
+
+	return true;
+}
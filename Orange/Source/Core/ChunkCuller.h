@@ -0,0 +1,128 @@
+#ifndef _CHUNKCULLER_H
+#define _CHUNKCULLER_H
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include "ChunkCoord.h"
+#include "Physics.h"
+#include "../Utility/SimdBatch.h"
+
+// Number of frustum planes Cull() expects, in any order
+constexpr uint32_t NUM_CULLING_PLANES = 6;
+constexpr uint32_t ALL_CULLING_PLANES = (1u << NUM_CULLING_PLANES) - 1;
+
+// Chunks are grouped into clusters of 4x4x4 chunks, aligned to multiples of 4 in CHUNK SPACE
+constexpr int32_t CULLING_CLUSTER_SHIFT = 2;
+constexpr int32_t CULLING_CLUSTER_SIZE = 1 << CULLING_CLUSTER_SHIFT;
+
+// Frustum culls the chunks it was given, Orange::Simd::BATCH_SIZE at a time. Every chunk has the same extent, so only
+// the centers are kept, one array per axis, and a plane is tested against a whole batch of chunks in a few instructions.
+//
+// The chunks are grouped by cluster, and the clusters' bounds are tested first. Chunks in a cluster that's entirely
+// outside the frustum are skipped, chunks in a cluster that's entirely inside are visible without any tests, and the
+// rest are only tested against the planes their cluster straddles. Chunks and clusters are added and removed as chunks
+// are loaded and unloaded, which keeps every array packed
+class ChunkCuller
+{
+public:
+
+	static constexpr uint32_t BATCH_SIZE = Orange::Simd::BATCH_SIZE;
+
+	void Add(const ChunkCoord& chunkPosCS);
+
+	// Moves the last chunk of the cluster into the removed one's place, and the last cluster into the
+	// cluster's place once it's empty
+	void Remove(const ChunkCoord& chunkPosCS);
+
+	void Clear();
+
+	const uint32_t GetNumChunks() const;
+
+	const uint32_t GetNumClusters() const;
+
+	// Appends every chunk whose AABB is at least partially on the inner side of all the planes (whose normals point
+	// inwards, like FrustumCulling's) to "outVisibleChunks". The chunks come out in no particular order
+	void Cull(const Orange::Plane* planes, std::vector<ChunkCoord>& outVisibleChunks) const;
+
+	// Same as Cull(), without testing the clusters first
+	void CullWithoutClusters(const Orange::Plane* planes, std::vector<ChunkCoord>& outVisibleChunks) const;
+
+	// Same as Cull(), one chunk and one plane at a time. Kept around to check and benchmark Cull() against
+	void CullScalar(const Orange::Plane* planes, std::vector<ChunkCoord>& outVisibleChunks) const;
+
+	// Same as Cull(), but remembers how every cluster and chunk was classified and how far it was from changing. The
+	// planes can only have moved so far since the last call (bounded by how much their normals turned and their offsets
+	// from the camera changed, over the farthest chunk), so anything that was further than that from changing is taken
+	// as it was without being tested. Whatever is tested starts with the plane that rejected it last time. The planes
+	// have to come in the same order on every call. It makes far fewer plane tests than Cull(), but makes them one at a
+	// time, so Cull() is still quicker with planes this cheap to test (see the "cullbench" headless mode)
+	void CullCoherent(const Orange::Plane* planes, const DirectX::XMFLOAT3& cameraPosWS, std::vector<ChunkCoord>& outVisibleChunks);
+
+	// Forgets everything CullCoherent() remembered, so the next call tests everything again
+	void ResetCoherence();
+
+	// Number of plane tests CullCoherent() made, clusters and chunks alike, since the culler was created
+	const uint64_t GetNumCoherentPlaneTests() const;
+
+	// Tests a single chunk the same way CullScalar() does
+	static bool IsChunkVisible(const Orange::Plane* planes, const ChunkCoord& chunkPosCS);
+
+private:
+
+	// Centers of a set of AABBs, one array per axis. The arrays are padded to a multiple of BATCH_SIZE
+	// with NaN, which fails every comparison and so is never visible
+	struct CenterArrays
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+
+		// "index" is either an existing element or the one right after the last
+		void Set(const uint32_t index, const DirectX::XMFLOAT3& center);
+
+		// Moves "lastIndex" into "index"
+		void Remove(const uint32_t index, const uint32_t lastIndex);
+
+		void Clear();
+	};
+
+	// What CullCoherent() found the last time it tested a cluster or chunk. It's taken as is while the planes have
+	// drifted less than "validUntil" (see m_drift)
+	struct Classification
+	{
+		double validUntil = -1.0;
+		uint8_t result = 0;
+	};
+
+	struct Cluster
+	{
+		ChunkCoord clusterPos;
+		CenterArrays centers;
+		std::vector<ChunkCoord> chunks;
+
+		Classification classification;
+		std::vector<Classification> chunkClassifications;
+	};
+
+	// Adds up how far the planes could have moved any chunk's classification since the last call
+	void AdvanceDrift(const Orange::Plane* planes, const DirectX::XMFLOAT3& cameraPosWS);
+
+	CenterArrays m_clusterCenters;
+	std::vector<Cluster> m_clusters;
+
+	// Index of every cluster in m_clusters, by the cluster's hash key
+	std::unordered_map<uint64_t, uint32_t> m_clusterIndices;
+
+	// Index of every chunk in its cluster, by the chunk's hash key
+	std::unordered_map<uint64_t, uint32_t> m_chunkIndices;
+
+	// How far (in the planes' units) the planes have moved, at most, over all the CullCoherent() calls so far
+	double m_drift = 0.0;
+	std::array<Orange::Plane, NUM_CULLING_PLANES> m_previousPlanes;
+	bool m_hasPreviousPlanes = false;
+	uint64_t m_numCoherentPlaneTests = 0;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "../Misc/pch.h"
+
+#include <algorithm>
+
+#include "ChunkDrawList.h"
+
+void ChunkDrawList::Clear()
+{
+	m_chunks.clear();
+	m_mergedChunks.clear();
+	m_ranges.clear();
+	m_numInstances = 0;
+}
+
+void ChunkDrawList::AddChunk(const uint32_t startInstance, const uint32_t numInstances, const float distanceSq)
+{
+	if (numInstances == 0) return;
+	m_chunks.push_back({ startInstance, numInstances, distanceSq });
+}
+
+void ChunkDrawList::Build(const uint32_t numUploadedInstances)
+{
+	m_mergedChunks.clear();
+	m_ranges.clear();
+	m_numInstances = 0;
+
+	// In instance buffer order first, so that every chunk that continues the previous one's run is right after it
+	std::sort(m_chunks.begin(), m_chunks.end(), [](const ChunkRange& a, const ChunkRange& b)
+	{
+		return a.startInstance < b.startInstance;
+	});
+
+	for (const auto& chunk : m_chunks)
+	{
+		if (chunk.startInstance >= numUploadedInstances) break;
+		const uint32_t numInstances = min(chunk.numInstances, numUploadedInstances - chunk.startInstance);
+
+		if (!m_mergedChunks.empty())
+		{
+			ChunkRange& last = m_mergedChunks.back();
+			if (last.startInstance + last.numInstances == chunk.startInstance)
+			{
+				last.numInstances += numInstances;
+				last.distanceSq = min(last.distanceSq, chunk.distanceSq);
+				continue;
+			}
+		}
+
+		m_mergedChunks.push_back({ chunk.startInstance, numInstances, chunk.distanceSq });
+	}
+
+	std::sort(m_mergedChunks.begin(), m_mergedChunks.end(), [](const ChunkRange& a, const ChunkRange& b)
+	{
+		return a.distanceSq < b.distanceSq;
+	});
+
+	m_ranges.reserve(m_mergedChunks.size());
+	for (const auto& range : m_mergedChunks)
+	{
+		m_ranges.push_back({ range.startInstance, range.numInstances });
+		m_numInstances += range.numInstances;
+	}
+}
+
+const std::vector<InstanceRange>& ChunkDrawList::GetRanges() const { return m_ranges; }
+
+const uint32_t ChunkDrawList::GetNumChunks() const { return static_cast<uint32_t>(m_chunks.size()); }
+
+const uint32_t ChunkDrawList::GetNumInstances() const { return m_numInstances; }
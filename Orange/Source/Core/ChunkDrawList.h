@@ -0,0 +1,54 @@
+#ifndef _CHUNKDRAWLIST_H
+#define _CHUNKDRAWLIST_H
+
+#include <vector>
+
+// A run of block instances in the instance buffer, drawn with a single call
+struct InstanceRange
+{
+	uint32_t startInstance;
+	uint32_t numInstances;
+};
+
+// Turns the visible chunks into the instance ranges the renderer draws. Every chunk's mesh is a contiguous run of the
+// instance buffer, so the runs of visible chunks that end where another one starts are merged into one range, and the
+// ranges are sorted front to back (by their closest chunk) so that the depth test rejects as many pixels as it can.
+// The ranges are plain (start, count) pairs, the same layout a batched or indirect draw would take
+class ChunkDrawList
+{
+public:
+
+	void Clear();
+
+	// Adds "numInstances" instances starting at "startInstance", from a chunk whose center is "distanceSq"
+	// (squared) away from the camera. Chunks without any instances are skipped
+	void AddChunk(const uint32_t startInstance, const uint32_t numInstances, const float distanceSq);
+
+	// Builds the ranges from the chunks added since the last Clear(). Instances at or past "numUploadedInstances"
+	// never made it into the instance buffer, so they're left out
+	void Build(const uint32_t numUploadedInstances);
+
+	const std::vector<InstanceRange>& GetRanges() const;
+
+	const uint32_t GetNumChunks() const;
+
+	// Number of instances in all the ranges
+	const uint32_t GetNumInstances() const;
+
+private:
+
+	struct ChunkRange
+	{
+		uint32_t startInstance;
+		uint32_t numInstances;
+		float distanceSq;
+	};
+
+	std::vector<ChunkRange> m_chunks;
+	std::vector<ChunkRange> m_mergedChunks;
+	std::vector<InstanceRange> m_ranges;
+
+	uint32_t m_numInstances = 0;
+};
+
+#endif
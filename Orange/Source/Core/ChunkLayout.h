@@ -0,0 +1,123 @@
+#ifndef _CHUNKLAYOUT_H
+#define _CHUNKLAYOUT_H
+
+#include <cstdint>
+
+#include "ChunkCoord.h"
+
+// BMI2's pdep/pext interleave and de-interleave bits in a single instruction. MSVC doesn't
+// define __BMI2__, but every CPU that supports AVX2 supports BMI2 as well
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define OG_HAS_BMI2 1
+#include <immintrin.h>
+#else
+#define OG_HAS_BMI2 0
+#endif
+
+// How a chunk's blocks are laid out in memory
+enum class ChunkLayout : uint8_t
+{
+	// [x][y][z], neighbors along X are CHUNK_SIZE^2 blocks apart
+	ROW_MAJOR = 0,
+
+	// Z-order curve, neighbors on every axis are mostly within the same few cache lines
+	MORTON
+};
+
+// The layout used by Chunk. Switching it doesn't change anything outside of Chunk's storage,
+// the blocks are always passed around in [x][y][z] order
+#define CHUNK_BLOCK_LAYOUT ChunkLayout::ROW_MAJOR
+
+namespace Orange
+{
+	namespace Math
+	{
+		// Bit masks for the interleaved coordinates. Z goes in the lowest bit so that
+		// consecutive Z values stay as close together as they are in the row-major layout
+		constexpr uint32_t MORTON_MASK_X = 0x24924924;
+		constexpr uint32_t MORTON_MASK_Y = 0x12492492;
+		constexpr uint32_t MORTON_MASK_Z = 0x09249249;
+
+		// Spreads the lowest 10 bits of "value" out so there are two zero bits between each of them
+		inline constexpr uint32_t SpreadBitsBy3(uint32_t value)
+		{
+			value &= 0x000003FF;
+			value = (value | (value << 16)) & 0x030000FF;
+			value = (value | (value << 8)) & 0x0300F00F;
+			value = (value | (value << 4)) & 0x030C30C3;
+			value = (value | (value << 2)) & 0x09249249;
+			return value;
+		}
+
+		// Inverse of SpreadBitsBy3()
+		inline constexpr uint32_t CompactBitsBy3(uint32_t value)
+		{
+			value &= 0x09249249;
+			value = (value | (value >> 2)) & 0x030C30C3;
+			value = (value | (value >> 4)) & 0x0300F00F;
+			value = (value | (value >> 8)) & 0x030000FF;
+			value = (value | (value >> 16)) & 0x000003FF;
+			return value;
+		}
+
+		// Every coordinate has to be within [0, 1024)
+		inline uint32_t MortonEncode3D(const uint32_t x, const uint32_t y, const uint32_t z)
+		{
+#if OG_HAS_BMI2
+			return _pdep_u32(x, MORTON_MASK_X) | _pdep_u32(y, MORTON_MASK_Y) | _pdep_u32(z, MORTON_MASK_Z);
+#else
+			return (SpreadBitsBy3(x) << 2) | (SpreadBitsBy3(y) << 1) | SpreadBitsBy3(z);
+#endif
+		}
+
+		inline void MortonDecode3D(const uint32_t code, uint32_t& outX, uint32_t& outY, uint32_t& outZ)
+		{
+#if OG_HAS_BMI2
+			outX = _pext_u32(code, MORTON_MASK_X);
+			outY = _pext_u32(code, MORTON_MASK_Y);
+			outZ = _pext_u32(code, MORTON_MASK_Z);
+#else
+			outX = CompactBitsBy3(code >> 2);
+			outY = CompactBitsBy3(code >> 1);
+			outZ = CompactBitsBy3(code);
+#endif
+		}
+	}
+}
+
+// Maps local block coordinates to an index into a chunk's block array, and back
+template<ChunkLayout Layout, int32_t Size = CHUNK_SIZE>
+struct ChunkBlockIndexer;
+
+template<int32_t Size>
+struct ChunkBlockIndexer<ChunkLayout::ROW_MAJOR, Size>
+{
+	static inline uint32_t GetIndex(const int32_t x, const int32_t y, const int32_t z) { return ChunkTraits<Size>::GetIndex(x, y, z); }
+
+	static inline BlockCoord GetCoord(const uint32_t index)
+	{
+		using Traits = ChunkTraits<Size>;
+		return BlockCoord(static_cast<int32_t>(index >> (2 * Traits::SHIFT)), static_cast<int32_t>(index >> Traits::SHIFT) & Traits::MASK, static_cast<int32_t>(index) & Traits::MASK);
+	}
+};
+
+// The chunk's edge length is a power of two, so its Morton codes fill [0, VOLUME) without gaps
+template<int32_t Size>
+struct ChunkBlockIndexer<ChunkLayout::MORTON, Size>
+{
+	static inline uint32_t GetIndex(const int32_t x, const int32_t y, const int32_t z)
+	{
+		return Orange::Math::MortonEncode3D(static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(z));
+	}
+
+	static inline BlockCoord GetCoord(const uint32_t index)
+	{
+		uint32_t x, y, z;
+		Orange::Math::MortonDecode3D(index, x, y, z);
+		return BlockCoord(static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(z));
+	}
+};
+
+using ChunkBlockLayout = ChunkBlockIndexer<CHUNK_BLOCK_LAYOUT>;
+
+#endif
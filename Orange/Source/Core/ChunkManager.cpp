@@ -1,7 +1,15 @@
 #include "../Misc/pch.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <tuple>
+
 #include "ChunkManager.h"
 #include "Chunk.h"
+#include "ChunkResidencyManager.h"
+#include "LightEngine.h"
+#include "ShaderBufferManagers/ChunkBufferManager.h"
+#include "WorldGen/TerrainGenerator.h"
 #include "../Utility/HeapOverrides.h"
 #include "../Utility/ImGuiLayer.h"
 #include "../Utility/Math.h"
@@ -10,21 +18,57 @@
 using namespace DirectX;
 
 // Static variable definitions
-Orange::SortedPool<Chunk> ChunkManager::m_activeChunks = Orange::SortedPool<Chunk>((2 * RENDER_DIST + 1) * (2 * RENDER_DIST + 1) * (2 * RENDER_DIST + 1));
+Orange::SortedPool<Chunk> ChunkManager::m_activeChunks = Orange::SortedPool<Chunk>((2 * DEFAULT_RENDER_DIST + 1) * (2 * DEFAULT_RENDER_DIST + 1) * (2 * DEFAULT_RENDER_DIST + 1));
 bool ChunkManager::m_runThreads = true;
 XMFLOAT3 ChunkManager::m_playerPos = { 0.0f, 0.0f, 0.0f };
-std::vector<XMFLOAT3> ChunkManager::m_newChunkList = std::vector<XMFLOAT3>();
-std::vector<XMFLOAT3> ChunkManager::m_deletedChunkList = std::vector<XMFLOAT3>();
+std::vector<ChunkCoord> ChunkManager::m_newChunkList = std::vector<ChunkCoord>();
+std::vector<ChunkCoord> ChunkManager::m_deletedChunkList = std::vector<ChunkCoord>();
 std::thread* ChunkManager::m_updaterThread = nullptr;
 std::mutex ChunkManager::m_canAccessVec;
 bool ChunkManager::m_isShuttingDown = false;
+std::atomic<int32_t> ChunkManager::m_renderDist = DEFAULT_RENDER_DIST;
+std::atomic<int32_t> ChunkManager::m_pendingRenderDist = DEFAULT_RENDER_DIST;
 
 #define ALLOW_HARD_CODED_MAX_INIT_THREADS 1
 #define USE_DEFAULT_SEED 1
 #define USE_SEED_BASED_ON_SYSTEM_TIME 1
 
+// Generates 3D terrain with overhangs from a density field instead of a heightmap
+#define USE_DENSITY_TERRAIN 0
+
+// Samples the seeded hash noise instead of simplex noise, which only gets a seed by sampling somewhere else. See NoiseBackend
+#define USE_HASH_NOISE 0
+
+// Validates all neighbor links at the end of every update in debug builds. It's a hash lookup per link, so it's off by default
+#define VALIDATE_NEIGHBOR_LINKS_EVERY_UPDATE 0
+
 constexpr int CHUNK_GENERATION_SEED = 12346;
 
+// Upper bound on the memory used by chunks, including the compressed tier. The render distance is capped so that
+// the chunk pool and the instance buffer only take up part of it (see ChunkResidencyManager::GetMaxRenderDistance()).
+// Hitting the budget demotes the furthest chunks first, but never the ones within MIN_RESIDENT_DIST of the player
+constexpr uint64_t DEFAULT_CHUNK_MEMORY_BUDGET = 512ull * 1024ull * 1024ull;
+constexpr int32_t MIN_RESIDENT_DIST = 2;
+
+// Upper bound on the chunks spilled to disk. Past it the furthest ones are deleted and generated again if they're needed
+constexpr uint64_t DEFAULT_CHUNK_DISK_BUDGET = 1024ull * 1024ull * 1024ull;
+
+// Demoted chunks that nothing asked for are only promoted back while we're under this fraction of the
+// budget, so that we don't keep demoting and promoting the same chunks every update
+constexpr float PROMOTION_BUDGET_THRESHOLD = 0.85f;
+
+// Caps how many chunks are demoted or promoted per update so that one update can't stall for too long
+constexpr uint32_t MAX_RESIDENCY_CHANGES_PER_UPDATE = 32;
+
+const char* CHUNK_CACHE_DIRECTORY_NAME = "OrangeChunkCache";
+
+// Bytes the vertex array holds on to past its meshes, i.e. what ChunkManager::ShrinkVertexArray() would give back
+static uint64_t GetVertexArraySlack()
+{
+	const auto& vertexArray = ChunkBufferManager::GetVertexArray();
+	return static_cast<uint64_t>(vertexArray.capacity() - vertexArray.size()) * sizeof(BlockInstanceData);
+}
+
 #if ALLOW_HARD_CODED_MAX_INIT_THREADS == 1
 const uint32_t g_maxNumThreadsForInit = 5;
 #else
@@ -34,6 +78,55 @@ uint32_t g_maxNumThreadsForInit;
 
 std::unordered_map<uint64_t, Chunk*> ChunkManager::m_chunkMap = std::unordered_map<uint64_t, Chunk*>();
 std::unordered_map<uint64_t, uint32_t> ChunkManager::m_poolMap = std::unordered_map<uint64_t, uint32_t>();
+ChunkCuller ChunkManager::m_culler;
+std::unordered_map<uint64_t, ChunkCoord> ChunkManager::m_demotedChunks = std::unordered_map<uint64_t, ChunkCoord>();
+std::vector<ChunkCoord> ChunkManager::m_relitChunks = std::vector<ChunkCoord>();
+std::mutex ChunkManager::m_promotionRequestMutex;
+std::unordered_map<uint64_t, ChunkCoord> ChunkManager::m_promotionRequests = std::unordered_map<uint64_t, ChunkCoord>();
+std::mutex ChunkManager::m_blockEditMutex;
+std::vector<std::pair<BlockCoord, BlockType>> ChunkManager::m_pendingBlockEdits = std::vector<std::pair<BlockCoord, BlockType>>();
+
+// The chunks in the pool as the light engine sees them. Only lives for as long as one light update, since
+// it holds on to the last chunk it found and chunks move around in the pool when others are unloaded
+class PoolLightWorld : public LightWorld
+{
+public:
+
+	bool GetChunk(const ChunkCoord& chunkPosCS, LightChunkView& outView) override
+	{
+		// Light mostly moves between neighbors, which are a link away from the last chunk
+		Chunk* chunk = ChunkManager::GetChunkAtPos(chunkPosCS, m_lastChunk);
+		if (!chunk) return false;
+
+		m_lastChunk = chunk;
+		outView = chunk->GetLightView();
+		return true;
+	}
+
+private:
+
+	Chunk* m_lastChunk = nullptr;
+};
+
+class PoolConnectivityWorld : public ConnectivityWorld
+{
+public:
+
+	bool GetConnectivity(const ChunkCoord& chunkPosCS, ChunkFaceMask& outConnectivity) override
+	{
+		// The search moves from neighbor to neighbor, but not always from the chunk it looked at last
+		Chunk* chunk = ChunkManager::GetChunkAtPos(chunkPosCS, m_lastChunk);
+		if (!chunk) return false;
+
+		m_lastChunk = chunk;
+		outConnectivity = chunk->GetConnectivity();
+		return true;
+	}
+
+private:
+
+	Chunk* m_lastChunk = nullptr;
+};
 
 
 void ChunkManager::Initialize(const XMFLOAT3 playerPosWS)
@@ -41,21 +134,48 @@ void ChunkManager::Initialize(const XMFLOAT3 playerPosWS)
 	// Isn't strictly necessary b/c it's inited as a static variable
 	m_runThreads = true;
 
-	Renderer_Data::renderDist = RENDER_DIST;
+	// The memory budget caps the render distance, so the residency manager has to be set up first
+	std::error_code tempDirectoryError;
+	std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path(tempDirectoryError) / CHUNK_CACHE_DIRECTORY_NAME;
+	ChunkResidencyManager::Initialize(DEFAULT_CHUNK_MEMORY_BUDGET, DEFAULT_CHUNK_DISK_BUDGET, cacheDirectory.string());
+
+	// Pick up any render distance that was requested before initializing
+	m_renderDist = min(m_pendingRenderDist.load(), ChunkResidencyManager::GetMaxRenderDistance());
+	const int32_t renderDist = m_renderDist;
+	if (renderDist < m_pendingRenderDist)
+	{
+		OG_LOG_WARNING("Render distance %i doesn't fit in the chunk memory budget, using %i instead", m_pendingRenderDist.load(), renderDist);
+	}
+	m_activeChunks.Resize(GetNumChunksInRenderDistance(renderDist));
+
+	// Nothing has looked at the chunks yet
+	m_activeChunks.ReleaseRetiredPools();
+
+	Renderer_Data::renderDist = renderDist;
 
 #if USE_DEFAULT_SEED == 0
 #if USE_SEED_BASED_ON_SYSTEM_TIME == 0
-	Noise3D::Init(CHUNK_GENERATION_SEED);
+	TerrainGenerator::SetSeed(CHUNK_GENERATION_SEED);
 #else
-	Noise3D::Init(static_cast<int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+	TerrainGenerator::SetSeed(static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
 #endif // USE_SEED_BASED_ON_SYSTEM_TIME
 #else
-	//Noise3D::Init(CHUNK_GENERATION_SEED);
+	TerrainGenerator::SetSeed(TerrainGenerator::DEFAULT_SEED);
 #endif // USE_DEFAULT_SEED
 
+#if USE_DENSITY_TERRAIN == 1
+	TerrainGenerator::SetTerrainShape(TerrainShape::DENSITY);
+#else
+	TerrainGenerator::SetTerrainShape(TerrainShape::HEIGHTMAP);
+#endif // USE_DENSITY_TERRAIN
+
+#if USE_HASH_NOISE == 1
+	TerrainGenerator::SetNoiseBackend(NoiseBackend::HASH);
+#endif // USE_HASH_NOISE
+
 	m_playerPos = playerPosWS;
 
-	XMFLOAT3 playerPosCS = Orange::Math::WorldToChunkSpace(playerPosWS);
+	ChunkCoord playerPosCS = Orange::Math::WorldToChunkSpace(playerPosWS);
 
 #if ALLOW_HARD_CODED_MAX_INIT_THREADS == 0
 	// hardware_concurrency() will only work for Windows builds...not particularly important
@@ -65,7 +185,7 @@ void ChunkManager::Initialize(const XMFLOAT3 playerPosWS)
 
 	uint32_t desiredDepthSlicesPerThread, actualDepthSlicesPerThread;
 	desiredDepthSlicesPerThread = actualDepthSlicesPerThread = 2;
-	uint32_t numThreadsToRun = static_cast<uint32_t>(floor((2 * RENDER_DIST + 1) / desiredDepthSlicesPerThread));
+	uint32_t numThreadsToRun = static_cast<uint32_t>(floor((2 * renderDist + 1) / desiredDepthSlicesPerThread));
 	OG_ASSERT(numThreadsToRun > 0);
 
 	// If we need more threads to run desired depth slices per thread, cap at map threads and recalculate
@@ -73,7 +193,7 @@ void ChunkManager::Initialize(const XMFLOAT3 playerPosWS)
 	if (numThreadsToRun > g_maxNumThreadsForInit)
 	{
 		numThreadsToRun = g_maxNumThreadsForInit;
-		actualDepthSlicesPerThread = static_cast<uint32_t>(floor((2 * RENDER_DIST + 1) / numThreadsToRun));
+		actualDepthSlicesPerThread = static_cast<uint32_t>(floor((2 * renderDist + 1) / numThreadsToRun));
 	}
 
 
@@ -86,8 +206,8 @@ void ChunkManager::Initialize(const XMFLOAT3 playerPosWS)
 		std::vector<std::thread*> chunkLoaderThreads(numThreadsToRun);
 		for (int16_t threadID = 0; threadID < static_cast<int16_t>(numThreadsToRun); threadID++)
 		{
-			int32_t startingChunk = threadID * actualDepthSlicesPerThread - RENDER_DIST;
-			int32_t numChunksToInit = threadID == static_cast<int16_t>(numThreadsToRun) - 1 ? actualDepthSlicesPerThread + ((2 * RENDER_DIST + 1) - numThreadsToRun * actualDepthSlicesPerThread) : actualDepthSlicesPerThread;
+			int32_t startingChunk = threadID * actualDepthSlicesPerThread - renderDist;
+			int32_t numChunksToInit = threadID == static_cast<int16_t>(numThreadsToRun) - 1 ? actualDepthSlicesPerThread + ((2 * renderDist + 1) - numThreadsToRun * actualDepthSlicesPerThread) : actualDepthSlicesPerThread;
 			std::thread* currThread = OG_NEW std::thread(InitChunksMultithreaded, startingChunk, numChunksToInit, playerPosCS);
 			chunkLoaderThreads[threadID] = currThread;
 
@@ -98,6 +218,22 @@ void ChunkManager::Initialize(const XMFLOAT3 playerPosWS)
 		for (auto thread : chunkLoaderThreads) thread->join();
 		chunkLoaderThreads.clear();
 
+#ifdef OG_DEBUG
+		OG_ASSERT_MSG(ValidateNeighborLinks(), "Chunk neighbor links are out of sync after the initial load");
+#endif
+
+		// Every chunk was lit on its own by the loader threads, light can only cross into the neighbors now that they're all there
+		PoolLightWorld lightWorld;
+		for (uint32_t i = 0; i < m_activeChunks.Size(); i++)
+		{
+			LightEngine::StitchChunk(lightWorld, m_activeChunks[i]->GetPosition(), m_relitChunks);
+		}
+
+		// Every chunk is meshed right after this anyway
+		m_relitChunks.clear();
+
+		TerrainGenerator::GetPipeline().LogStageStats();
+
 	}
 
 	{
@@ -121,6 +257,11 @@ void ChunkManager::Initialize(const XMFLOAT3 playerPosWS)
 		vertexBufferThreads.clear();
 	}
 
+	if (ChunkResidencyManager::GetReclaimableMemory() > ChunkResidencyManager::GetReclaimableBudget())
+	{
+		OG_LOG_WARNING("Initial chunks use more memory than the chunk memory budget allows, the furthest chunks will be demoted");
+	}
+
 	// Start the updater thread
 	m_updaterThread = OG_NEW std::thread(UpdaterEntryPoint);
 
@@ -143,8 +284,16 @@ void ChunkManager::Shutdown()
 
 	m_chunkMap.clear();
 	m_poolMap.clear();
+	m_culler.Clear();
+	m_demotedChunks.clear();
+	m_relitChunks.clear();
+	m_pendingBlockEdits.clear();
+	m_promotionRequests.clear();
 
 	m_activeChunks.Clear();
+	m_activeChunks.ReleaseRetiredPools();
+
+	ChunkResidencyManager::Shutdown();
 
 	m_newChunkList.clear();
 	m_deletedChunkList.clear();
@@ -158,11 +307,25 @@ void ChunkManager::Update()
 
 	// Keep track of the previous chunk pos of the player to know how many chunks to check
 	// this frame!
-	static XMFLOAT3 prevPosChunkSpace = Orange::Math::WorldToChunkSpace(m_playerPos);
+	static ChunkCoord prevPosChunkSpace = Orange::Math::WorldToChunkSpace(m_playerPos);
 
 	OG_PROFILE_OUT(&ChunkManager_Data::updateTimer);
 
-	XMFLOAT3 playerPosChunkSpace = Orange::Math::WorldToChunkSpace(m_playerPos);
+	// Resize everything around the chunks we loaded last update before looking at where the player moved. The
+	// memory budget may not fit the requested render distance, or may have shrunk since the last update
+	const int32_t renderDist = min(m_pendingRenderDist.load(), ChunkResidencyManager::GetMaxRenderDistance());
+	if (renderDist != m_renderDist)
+	{
+		ApplyRenderDistance(prevPosChunkSpace, renderDist);
+	}
+
+	ChunkCoord playerPosChunkSpace = Orange::Math::WorldToChunkSpace(m_playerPos);
+
+	// Chunks within render distance that were demoted are holes in the world, so they're filled back in before
+	// streaming anything. The ones the game looked up or edited come first
+	std::unordered_map<uint64_t, ChunkCoord> requestedChunks;
+	TakePromotionRequests(requestedChunks);
+	PromoteDemotedChunks(playerPosChunkSpace, requestedChunks);
 
 	int32_t numChunksUnloaded = 0;
 
@@ -219,34 +382,7 @@ void ChunkManager::Update()
 				OG_LOG_WARNING("Potential new chunk skipped");
 				continue;
 			}
-			XMFLOAT3 chunkPosCS = newChunk->GetPosition();
-
-			// Left neighbor
-			Chunk* leftNeighbor = GetChunkAtPos({ chunkPosCS.x - 1, chunkPosCS.y, chunkPosCS.z });
-			if (leftNeighbor) leftNeighbor->InitializeVertexBuffer();
-
-			// Right neighbor
-			Chunk* rightNeighbor = GetChunkAtPos({ chunkPosCS.x + 1, chunkPosCS.y, chunkPosCS.z });
-			if (rightNeighbor) rightNeighbor->InitializeVertexBuffer();
-
-			// Top neighbor
-			Chunk* topNeighbor = GetChunkAtPos({ chunkPosCS.x, chunkPosCS.y + 1, chunkPosCS.z });
-			if (topNeighbor) topNeighbor->InitializeVertexBuffer();
-
-			// Bottom neighbor
-			Chunk* bottomNeighbor = GetChunkAtPos({ chunkPosCS.x, chunkPosCS.y - 1, chunkPosCS.z });
-			if (bottomNeighbor) bottomNeighbor->InitializeVertexBuffer();
-
-			// Front neighbor
-			Chunk* frontNeighbor = GetChunkAtPos({ chunkPosCS.x, chunkPosCS.y, chunkPosCS.z - 1 });
-			if (frontNeighbor) frontNeighbor->InitializeVertexBuffer();
-
-			// Back neighbor
-			Chunk* backNeighbor = GetChunkAtPos({ chunkPosCS.x, chunkPosCS.y, chunkPosCS.z + 1 });
-			if (backNeighbor) backNeighbor->InitializeVertexBuffer();
-
-			// Current chunk
-			newChunk->InitializeVertexBuffer();
+			InitializeChunkAndNeighborVertexBuffers(newChunk);
 		}
 
 		//if(m_newChunkList.size() > 0)
@@ -255,7 +391,15 @@ void ChunkManager::Update()
 		//}
 	}
 	
-	OG_ASSERT(m_activeChunks.Size() == pow((2 * RENDER_DIST + 1), 3));
+	ApplyBlockEdits();
+
+	ApplyLateBlockWrites();
+
+	EnforceMemoryBudget(playerPosChunkSpace, requestedChunks);
+
+	MeshRelitChunks();
+
+	OG_ASSERT(m_activeChunks.Size() + m_demotedChunks.size() == GetNumChunksInRenderDistance(m_renderDist));
 
 	// Clear the temporary vectors
 	m_newChunkList.clear();
@@ -270,25 +414,43 @@ void ChunkManager::Update()
 		sumOfBlocks += m_activeChunks[i]->GetBlockCount();
 	}
 
+#if defined(OG_DEBUG) && VALIDATE_NEIGHBOR_LINKS_EVERY_UPDATE == 1
+	OG_ASSERT_MSG(ValidateNeighborLinks(), "Chunk neighbor links are out of sync");
+#endif
+
 }
 
-Chunk* ChunkManager::LoadChunk(const XMFLOAT3 chunkCS) 
+Chunk* ChunkManager::LoadChunk(const ChunkCoord chunkCS) 
 {
 	Chunk chunk(chunkCS);
-	chunk.Init();
+	if (ChunkResidencyManager::Promote(&chunk)) chunk.ApplyPendingWrites();
+	else chunk.Init();
+	chunk.ComputeLight();
+
+	// The render thread's visibility search walks the pool, the chunk map and the neighbor links
+	m_canAccessVec.lock();
 	Chunk* chunkPtr = m_activeChunks.Insert_Move(std::move(chunk));
-	if (!chunkPtr) return nullptr;
+	if (!chunkPtr)
+	{
+		m_canAccessVec.unlock();
+		return nullptr;
+	}
 
 	uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkCS);
 	OG_ASSERT(m_chunkMap.find(hashKey) == m_chunkMap.end());
-	OG_ASSERT(m_chunkMap.size() <= pow((2 * RENDER_DIST + 1), 3));
+	OG_ASSERT(m_chunkMap.size() <= GetNumChunksInRenderDistance(m_renderDist));
 	m_chunkMap[hashKey] = chunkPtr;
+	LinkChunkNeighbors(chunkPtr);
+	m_culler.Add(chunkCS);
+	m_canAccessVec.unlock();
+
+	PoolLightWorld lightWorld;
+	LightEngine::StitchChunk(lightWorld, chunkCS, m_relitChunks);
 
 	//DEBUG
-	XMFLOAT3 wackPos = chunkPtr->GetPosition();
-	OG_ASSERT(chunkCS.x == wackPos.x && chunkCS.y == wackPos.y && chunkCS.z == wackPos.z);
+	OG_ASSERT(chunkPtr->GetPosition() == chunkCS);
 
-	//OG_LOG("Loaded chunk (%2.2f, %2.2f, %2.2f)", chunkCS.x, chunkCS.y, chunkCS.z);
+	//OG_LOG("Loaded chunk (%i, %i, %i)", chunkCS.x, chunkCS.y, chunkCS.z);
 
 	m_poolMap[hashKey] = m_activeChunks.GetIndexFromPointer(chunkPtr);
 
@@ -320,8 +482,8 @@ void ChunkManager::UnloadChunk(const uint32_t& index)
 	Chunk* chunkToUnload = m_activeChunks[index];
 
 
-	XMFLOAT3 CTUPos = chunkToUnload->GetPosition();
-	//OG_LOG("Unloaded chunk (%2.2f, %2.2f, %2.2f)", CTUPos.x, CTUPos.y, CTUPos.z);
+	ChunkCoord CTUPos = chunkToUnload->GetPosition();
+	//OG_LOG("Unloaded chunk (%i, %i, %i)", CTUPos.x, CTUPos.y, CTUPos.z);
 
 	uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkToUnload->GetPosition());
 
@@ -329,7 +491,21 @@ void ChunkManager::UnloadChunk(const uint32_t& index)
 	OG_ASSERT(chunkFromMap != nullptr && (chunkToUnload == chunkFromMap));
 
 
+	// Keep the blocks around in the cold tier, it's much cheaper than generating the chunk again
+	ChunkResidencyManager::Demote(chunkToUnload);
+	TerrainGenerator::GetPipeline().GetPendingWrites().MarkEvicted(CTUPos, CHUNK_SIZE);
+
+	m_canAccessVec.lock();
+	UnlinkChunkNeighbors(chunkToUnload);
 	m_chunkMap.erase(hashKey);
+	m_culler.Remove(CTUPos);
+	m_canAccessVec.unlock();
+
+	// The chunk can't be found anymore, but its light is still there to tell which of its neighbors' light came from it
+	PoolLightWorld lightWorld;
+	LightEngine::RemoveChunk(lightWorld, CTUPos, chunkToUnload->GetLightView(), m_relitChunks);
+
+	m_canAccessVec.lock();
 	Chunk* chunkPtr = m_activeChunks.Remove(index);
 
 	// Only update the pool map with the new index if we're not removing the Chunk
@@ -343,7 +519,11 @@ void ChunkManager::UnloadChunk(const uint32_t& index)
 		// invalidates the chunk ptr that was swapped from the end of the pool
 		uint64_t swappedHash = Orange::Math::GetHashKeyFromChunkPosition(chunkPtr->GetPosition());
 		m_chunkMap[swappedHash] = chunkPtr;
+
+		// Same goes for its neighbors, which still point to the slot it was swapped from
+		LinkChunkNeighbors(chunkPtr);
 	}
+	m_canAccessVec.unlock();
 
 }
 
@@ -365,7 +545,7 @@ Chunk* ChunkManager::GetChunkAtIndex(const uint16_t index)
 	}
 }
 
-Chunk* ChunkManager::GetChunkAtPos(const DirectX::XMFLOAT3 posCS)
+Chunk* ChunkManager::GetChunkAtPos(const ChunkCoord posCS)
 {
 	uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(posCS);
 	auto val = m_chunkMap.find(hashKey);
@@ -374,6 +554,52 @@ Chunk* ChunkManager::GetChunkAtPos(const DirectX::XMFLOAT3 posCS)
 	else return val->second;
 }
 
+Chunk* ChunkManager::GetChunkAtPos(const ChunkCoord posCS, Chunk* nearChunk)
+{
+	if (nearChunk)
+	{
+		ChunkCoord offset = posCS - nearChunk->GetPosition();
+		if (offset == ChunkCoord(0, 0, 0)) return nearChunk;
+
+		for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+		{
+			if (offset == CHUNK_NEIGHBOR_OFFSETS[i]) return nearChunk->GetNeighbor(static_cast<ChunkNeighbor>(i));
+		}
+	}
+
+	return GetChunkAtPos(posCS);
+}
+
+const bool ChunkManager::ValidateNeighborLinks()
+{
+	uint32_t numInvalidLinks = 0;
+	for (uint32_t i = 0; i < m_activeChunks.Size(); i++)
+	{
+		Chunk* chunk = m_activeChunks[i];
+		ChunkCoord chunkPosCS = chunk->GetPosition();
+
+		for (uint32_t j = 0; j < NUM_CHUNK_NEIGHBORS; j++)
+		{
+			const ChunkNeighbor direction = static_cast<ChunkNeighbor>(j);
+			Chunk* linkedNeighbor = chunk->GetNeighbor(direction);
+			Chunk* actualNeighbor = GetChunkAtPos(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[j]);
+
+			if (linkedNeighbor != actualNeighbor)
+			{
+				OG_LOG_ERROR("Chunk (%i, %i, %i) has a stale link to its neighbor %u", chunkPosCS.x, chunkPosCS.y, chunkPosCS.z, j);
+				numInvalidLinks++;
+			}
+			else if (linkedNeighbor && linkedNeighbor->GetNeighbor(GetOppositeNeighbor(direction)) != chunk)
+			{
+				OG_LOG_ERROR("Neighbor %u of chunk (%i, %i, %i) doesn't link back to it", j, chunkPosCS.x, chunkPosCS.y, chunkPosCS.z);
+				numInvalidLinks++;
+			}
+		}
+	}
+
+	return numInvalidLinks == 0;
+}
+
 Orange::SortedPool<Chunk>& ChunkManager::GetChunkPool()
 {
 	return m_activeChunks;
@@ -390,30 +616,454 @@ void ChunkManager::UpdaterEntryPoint()
 
 void ChunkManager::SetPlayerPos(DirectX::XMFLOAT3 playerPos) { m_playerPos = playerPos; }
 
+void ChunkManager::SetRenderDistance(const int32_t renderDist)
+{
+	int32_t clampedRenderDist = renderDist;
+	Orange::Math::Clamp(clampedRenderDist, MIN_RENDER_DIST, MAX_RENDER_DIST);
+	m_pendingRenderDist = clampedRenderDist;
+}
+
+const int32_t ChunkManager::GetRenderDistance() { return m_renderDist; }
+
+const uint32_t ChunkManager::GetNumChunksInRenderDistance(const int32_t renderDist)
+{
+	const uint32_t chunksPerAxis = static_cast<uint32_t>(2 * renderDist + 1);
+	return chunksPerAxis * chunksPerAxis * chunksPerAxis;
+}
+
 void ChunkManager::ResetChunkMemory(const uint16_t index)
 {
 	//memset(&m_activeChunks[index], 0, sizeof(Chunk));
 	m_activeChunks.Remove(index);
 }
 
-const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& currentPlayerPosCS, const XMFLOAT3& prevPlayerPosCS, const int checkFlag)
+void ChunkManager::InitializeChunkAndNeighborVertexBuffers(Chunk* chunk)
+{
+	for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+	{
+		Chunk* neighbor = chunk->GetNeighbor(static_cast<ChunkNeighbor>(i));
+		if (neighbor) MeshChunk(neighbor);
+	}
+
+	// Current chunk
+	MeshChunk(chunk);
+}
+
+void ChunkManager::MeshChunk(Chunk* chunk)
+{
+	ChunkSnapshot snapshot;
+	chunk->TakeSnapshot(snapshot);
+
+	std::vector<BlockInstanceData> instances;
+	ChunkMesher::BuildMesh(snapshot, instances);
+	const ChunkFaceMask connectivity = ChunkConnectivity::Compute(snapshot);
+	const bool isOccluder = OcclusionRasterizer::IsOccluder(snapshot);
+	const bool isEmpty = ChunkMesher::IsEmpty(snapshot);
+
+	// Replacing the mesh moves other chunks' instances around in the vertex array, which the render
+	// thread uploads and builds its draw ranges from under this lock
+	m_canAccessVec.lock();
+	chunk->SetMesh(instances);
+	chunk->SetConnectivity(connectivity);
+	chunk->SetOccluder(isOccluder);
+	chunk->SetEmpty(isEmpty);
+	m_canAccessVec.unlock();
+}
+
+void ChunkManager::ApplyLateBlockWrites()
+{
+	std::vector<PendingBlockWrite> lateWrites;
+	TerrainGenerator::GetPipeline().GetPendingWrites().TakeLateWrites(lateWrites);
+	if (lateWrites.empty()) return;
+
+	// A chunk usually gets several writes at once (a whole tree), it only has to be re-meshed once
+	std::vector<ChunkCoord> targetChunks;
+	for (const auto& write : lateWrites)
+	{
+		if (std::find(targetChunks.begin(), targetChunks.end(), write.targetCS) == targetChunks.end()) targetChunks.push_back(write.targetCS);
+	}
+
+	PoolLightWorld lightWorld;
+	for (const auto& targetCS : targetChunks)
+	{
+		// Chunks that were unloaded in the meantime pick the writes up when they're loaded again
+		Chunk* chunk = GetChunkAtPos(targetCS);
+		if (!chunk) continue;
+
+		chunk->ApplyPendingWrites();
+
+		const BlockCoord chunkMinBS = Orange::Math::ChunkToBlockCoord(targetCS);
+		for (const auto& write : lateWrites)
+		{
+			if (write.targetCS != targetCS) continue;
+
+			// The write's index is laid out as [x][y][z]
+			const BlockCoord localPos(
+				static_cast<int32_t>(write.index >> (2 * CHUNK_SIZE_SHIFT)),
+				static_cast<int32_t>((write.index >> CHUNK_SIZE_SHIFT) & CHUNK_SIZE_MASK),
+				static_cast<int32_t>(write.index & CHUNK_SIZE_MASK));
+			LightEngine::UpdateBlock(lightWorld, chunkMinBS + localPos, m_relitChunks);
+		}
+
+		InitializeChunkAndNeighborVertexBuffers(chunk);
+	}
+}
+
+void ChunkManager::ApplyBlockEdits()
+{
+	std::vector<std::pair<BlockCoord, BlockType>> blockEdits;
+	{
+		std::lock_guard<std::mutex> lock(m_blockEditMutex);
+		blockEdits.swap(m_pendingBlockEdits);
+	}
+
+	PoolLightWorld lightWorld;
+	for (const auto& blockEdit : blockEdits)
+	{
+		// Edits in chunks that aren't loaded (anymore) are dropped
+		Chunk* chunk = GetChunkAtPos(Orange::Math::BlockToChunkCoord(blockEdit.first));
+		if (!chunk) continue;
+
+		const BlockCoord localPos = Orange::Math::BlockToLocalCoord(blockEdit.first);
+		Block* block = chunk->GetBlock(localPos.x, localPos.y, localPos.z);
+		if (block->GetType() == blockEdit.second) continue;
+
+		block->SetType(blockEdit.second);
+		LightEngine::UpdateBlock(lightWorld, blockEdit.first, m_relitChunks);
+
+		// The neighbors' faces bordering the block may have to be shown or hidden
+		InitializeChunkAndNeighborVertexBuffers(chunk);
+	}
+}
+
+void ChunkManager::MeshRelitChunks()
+{
+	// Light changes come in from all over the update, so the same chunk is usually in there more than once
+	std::sort(m_relitChunks.begin(), m_relitChunks.end(), [](const ChunkCoord& a, const ChunkCoord& b)
+	{
+		return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+	});
+	m_relitChunks.erase(std::unique(m_relitChunks.begin(), m_relitChunks.end()), m_relitChunks.end());
+
+	for (const auto& chunkPosCS : m_relitChunks)
+	{
+		Chunk* chunk = GetChunkAtPos(chunkPosCS);
+		if (chunk) MeshChunk(chunk);
+	}
+
+	m_relitChunks.clear();
+}
+
+void ChunkManager::TakePromotionRequests(std::unordered_map<uint64_t, ChunkCoord>& outRequestedChunks)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_promotionRequestMutex);
+		outRequestedChunks.clear();
+		outRequestedChunks.swap(m_promotionRequests);
+	}
+
+	// Edits in chunks that aren't in the pool are dropped, so demoted chunks that are about to be edited have to come back first
+	std::lock_guard<std::mutex> lock(m_blockEditMutex);
+	for (const auto& blockEdit : m_pendingBlockEdits)
+	{
+		ChunkCoord chunkPosCS = Orange::Math::BlockToChunkCoord(blockEdit.first);
+		outRequestedChunks.emplace(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS), chunkPosCS);
+	}
+}
+
+void ChunkManager::PromoteDemotedChunks(const ChunkCoord& playerPosCS, const std::unordered_map<uint64_t, ChunkCoord>& requestedChunks)
 {
+	if (m_demotedChunks.empty()) return;
+
+	OG_PROFILE_SCOPE_MODE("Promoting demoted chunks", 1);
+
+	struct PromotionCandidate
+	{
+		bool isRequested;
+		int32_t distance;
+		ChunkCoord posCS;
+	};
+
+	// Chunks that are out of range now are left to the deletion loop
+	std::vector<PromotionCandidate> promotionCandidates;
+	promotionCandidates.reserve(m_demotedChunks.size());
+	for (const auto& demotedChunk : m_demotedChunks)
+	{
+		int32_t distance = Orange::Math::ChunkDistance(demotedChunk.second, playerPosCS);
+		if (distance > m_renderDist) continue;
+
+		promotionCandidates.push_back({ requestedChunks.find(demotedChunk.first) != requestedChunks.end(), distance, demotedChunk.second });
+	}
+	std::sort(promotionCandidates.begin(), promotionCandidates.end(), [](const PromotionCandidate& a, const PromotionCandidate& b)
+	{
+		if (a.isRequested != b.isRequested) return a.isRequested;
+		return a.distance < b.distance;
+	});
+
+	// Requested chunks are promoted even if that puts us over the budget, EnforceMemoryBudget() demotes chunks further away to
+	// make room for them. The memory the vertex array holds on to is left out, since promoted meshes go there first
+	const uint64_t promotionLimit = static_cast<uint64_t>(ChunkResidencyManager::GetReclaimableBudget() * PROMOTION_BUDGET_THRESHOLD);
+
+	uint32_t numChunksPromoted = 0;
+	for (const auto& candidate : promotionCandidates)
+	{
+		if (numChunksPromoted >= MAX_RESIDENCY_CHANGES_PER_UPDATE) break;
+		if (!candidate.isRequested && ChunkResidencyManager::GetReclaimableMemory() - GetVertexArraySlack() >= promotionLimit) break;
+
+		m_demotedChunks.erase(Orange::Math::GetHashKeyFromChunkPosition(candidate.posCS));
+
+		Chunk* promotedChunk = LoadChunk(candidate.posCS);
+		OG_ASSERT(promotedChunk);
+		InitializeChunkAndNeighborVertexBuffers(promotedChunk);
+		numChunksPromoted++;
+	}
+}
+
+void ChunkManager::EnforceMemoryBudget(const ChunkCoord& playerPosCS, const std::unordered_map<uint64_t, ChunkCoord>& requestedChunks)
+{
+	OG_PROFILE_OUT(&ChunkManager_Data::enforcingMemoryBudget);
+
+	// The chunk pool and the instance buffer don't shrink when chunks are demoted, so only the memory that does
+	// is held against what's left of the budget. The render distance is capped so that there's always some left
+	const uint64_t reclaimableBudget = ChunkResidencyManager::GetReclaimableBudget();
+	uint64_t usedMemory = ChunkResidencyManager::GetReclaimableMemory();
+
+	if (usedMemory > reclaimableBudget)
+	{
+		// 1. Meshes that were erased (or replaced by smaller ones) leave their memory in the vertex array, so give that back first
+		usedMemory -= ShrinkVertexArray();
+
+		// 2. The compressed tier is the cheapest to evict, so spill it to disk next
+		if (usedMemory > reclaimableBudget)
+		{
+			usedMemory -= ChunkResidencyManager::SpillToDisk(playerPosCS, usedMemory - reclaimableBudget);
+		}
+
+		// 3. If that wasn't enough, demote the furthest chunks in the pool, but not the ones that were just promoted because something
+		// needed them. Their neighbors don't have to be re-initialized, since faces are only culled against chunks that exist
+		if (usedMemory > reclaimableBudget)
+		{
+			std::vector<std::pair<int32_t, ChunkCoord>> demotionCandidates;
+			for (uint32_t i = 0; i < m_activeChunks.Size(); i++)
+			{
+				ChunkCoord chunkPosCS = m_activeChunks[i]->GetPosition();
+				int32_t distance = Orange::Math::ChunkDistance(chunkPosCS, playerPosCS);
+				if (distance <= MIN_RESIDENT_DIST || requestedChunks.find(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)) != requestedChunks.end()) continue;
+
+				demotionCandidates.push_back({ distance, chunkPosCS });
+			}
+			std::sort(demotionCandidates.begin(), demotionCandidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+			uint32_t numChunksDemoted = 0;
+			for (const auto& candidate : demotionCandidates)
+			{
+				if (usedMemory <= reclaimableBudget || numChunksDemoted >= MAX_RESIDENCY_CHANGES_PER_UPDATE) break;
+
+				// Look the index up every time, since removing chunks from the pool moves other chunks around
+				uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(candidate.second);
+				UnloadChunk(m_poolMap[hashKey]);
+				m_poolMap.erase(hashKey);
+				m_demotedChunks[hashKey] = candidate.second;
+				numChunksDemoted++;
+
+				// The demoted meshes are only given back once the vertex array is shrunk below, which is done once for the whole batch
+				usedMemory = ChunkResidencyManager::GetReclaimableMemory() - GetVertexArraySlack();
+			}
+
+			ShrinkVertexArray();
+
+			// The chunks we just demoted are sitting in the compressed tier now
+			if (usedMemory > reclaimableBudget)
+			{
+				ChunkResidencyManager::SpillToDisk(playerPosCS, usedMemory - reclaimableBudget);
+			}
+		}
+	}
+
+	ChunkResidency_Data::memoryBudgetMB = static_cast<float>(ChunkResidencyManager::GetMemoryBudget()) / (1024.0f * 1024.0f);
+	ChunkResidency_Data::usedMemoryMB = static_cast<float>(ChunkResidencyManager::GetUsedMemory()) / (1024.0f * 1024.0f);
+	ChunkResidency_Data::compressedMemoryMB = static_cast<float>(ChunkResidencyManager::GetCompressedMemory()) / (1024.0f * 1024.0f);
+	ChunkResidency_Data::numDemotedChunks = static_cast<uint32_t>(m_demotedChunks.size());
+	ChunkResidency_Data::numCompressedChunks = ChunkResidencyManager::GetNumCompressedChunks();
+	ChunkResidency_Data::numChunksOnDisk = ChunkResidencyManager::GetNumChunksOnDisk();
+	ChunkResidency_Data::diskUsageMB = static_cast<float>(ChunkResidencyManager::GetDiskUsage()) / (1024.0f * 1024.0f);
+}
+
+const uint64_t ChunkManager::ShrinkVertexArray()
+{
+	// Shrinking reallocates the array, which the render thread may be copying into the instance buffer
+	std::lock_guard<std::mutex> lock(m_canAccessVec);
+
+	auto& vertexArray = ChunkBufferManager::GetVertexArray();
+	const uint64_t oldCapacity = vertexArray.capacity();
+	vertexArray.shrink_to_fit();
+
+	return (oldCapacity - vertexArray.capacity()) * sizeof(BlockInstanceData);
+}
+
+void ChunkManager::ApplyRenderDistance(const ChunkCoord& playerPosCS, const int32_t newRenderDist)
+{
+	OG_PROFILE_SCOPE_MODE("Applying render distance", 1);
+
+	if (newRenderDist < m_pendingRenderDist)
+	{
+		OG_LOG_WARNING("Render distance %i doesn't fit in the chunk memory budget, using %i instead", m_pendingRenderDist.load(), newRenderDist);
+	}
+
+	const int32_t oldRenderDist = m_renderDist;
+	const uint32_t newCapacity = GetNumChunksInRenderDistance(newRenderDist);
+
+	if (newRenderDist < oldRenderDist)
+	{
+		// Release every chunk that's out of range now. Unloading moves chunks around in the pool,
+		// so gather the positions first and look up their indices one at a time
+		std::vector<ChunkCoord> chunksToUnload;
+		for (uint32_t i = 0; i < m_activeChunks.Size(); i++)
+		{
+			ChunkCoord chunkPosCS = m_activeChunks[i]->GetPosition();
+			if (Orange::Math::ChunkDistance(chunkPosCS, playerPosCS) > newRenderDist) chunksToUnload.push_back(chunkPosCS);
+		}
+
+		for (const auto& chunkPosCS : chunksToUnload)
+		{
+			uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS);
+			UnloadChunk(m_poolMap[hashKey]);
+			m_poolMap.erase(hashKey);
+		}
+
+		for (auto iter = m_demotedChunks.begin(); iter != m_demotedChunks.end();)
+		{
+			if (Orange::Math::ChunkDistance(iter->second, playerPosCS) > newRenderDist) iter = m_demotedChunks.erase(iter);
+			else iter++;
+		}
+
+		ResizeChunkPool(newCapacity);
+		m_renderDist = newRenderDist;
+
+		OG_LOG_INFO("Render distance decreased from %i to %i, released %i chunks", oldRenderDist, newRenderDist, static_cast<int32_t>(chunksToUnload.size()));
+	}
+	else
+	{
+		ResizeChunkPool(newCapacity);
+		m_renderDist = newRenderDist;
+
+		// Stream in the new shell, from the inside out so that neighbors are mostly there already
+		int32_t numChunksLoaded = 0;
+		for (int32_t shell = oldRenderDist + 1; shell <= newRenderDist; shell++)
+		{
+			for (int32_t x = -shell; x <= shell; x++)
+			{
+				for (int32_t y = -shell; y <= shell; y++)
+				{
+					for (int32_t z = -shell; z <= shell; z++)
+					{
+						// Only the surface of the cube is new
+						if (abs(x) != shell && abs(y) != shell && abs(z) != shell) continue;
+
+						Chunk* newChunk = LoadChunk(playerPosCS + ChunkCoord(x, y, z));
+						if (!newChunk)
+						{
+							OG_LOG_WARNING("Potential new chunk skipped");
+							continue;
+						}
+						InitializeChunkAndNeighborVertexBuffers(newChunk);
+						numChunksLoaded++;
+					}
+				}
+			}
+		}
+
+		OG_LOG_INFO("Render distance increased from %i to %i, loaded %i chunks", oldRenderDist, newRenderDist, numChunksLoaded);
+	}
+
+	Renderer_Data::renderDist = newRenderDist;
+}
+
+void ChunkManager::ResizeChunkPool(const uint32_t newCapacity)
+{
+	// The render thread walks the pool, the maps and the neighbor links under this lock, so it has to see
+	// them all before or all after the chunks move
+	std::lock_guard<std::mutex> lock(m_canAccessVec);
+
+	m_activeChunks.Resize(newCapacity);
+	RebuildChunkMaps();
+}
+
+void ChunkManager::RebuildChunkMaps()
+{
+	// The chunks are all still in the maps, they're only somewhere else in memory. Overwriting the pointers in place
+	// (instead of clearing the maps) never leaves them empty for the game thread, which looks chunks up without the lock
+	OG_ASSERT(m_chunkMap.size() == m_activeChunks.Size() && m_poolMap.size() == m_activeChunks.Size());
+
+	for (uint32_t i = 0; i < m_activeChunks.Size(); i++)
+	{
+		Chunk* chunk = m_activeChunks[i];
+		uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunk->GetPosition());
+		m_chunkMap[hashKey] = chunk;
+		m_poolMap[hashKey] = i;
+	}
+
+	// The chunks may have moved to a new pool, so every link has to be re-established
+	for (uint32_t i = 0; i < m_activeChunks.Size(); i++)
+	{
+		LinkChunkNeighbors(m_activeChunks[i]);
+	}
+
+#ifdef OG_DEBUG
+	OG_ASSERT_MSG(ValidateNeighborLinks(), "Chunk neighbor links are out of sync after rebuilding the chunk maps");
+#endif
+}
+
+void ChunkManager::ReleaseRetiredChunks()
+{
+	std::lock_guard<std::mutex> lock(m_canAccessVec);
+	m_activeChunks.ReleaseRetiredPools();
+}
+
+void ChunkManager::LinkChunkNeighbors(Chunk* chunk)
+{
+	ChunkCoord chunkPosCS = chunk->GetPosition();
+	for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+	{
+		const ChunkNeighbor direction = static_cast<ChunkNeighbor>(i);
+		Chunk* neighbor = GetChunkAtPos(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[i]);
+
+		chunk->SetNeighbor(direction, neighbor);
+		if (neighbor) neighbor->SetNeighbor(GetOppositeNeighbor(direction), chunk);
+	}
+}
+
+void ChunkManager::UnlinkChunkNeighbors(Chunk* chunk)
+{
+	for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+	{
+		const ChunkNeighbor direction = static_cast<ChunkNeighbor>(i);
+		Chunk* neighbor = chunk->GetNeighbor(direction);
+
+		if (neighbor) neighbor->SetNeighbor(GetOppositeNeighbor(direction), nullptr);
+		chunk->SetNeighbor(direction, nullptr);
+	}
+}
+
+const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const ChunkCoord& currentPlayerPosCS, const ChunkCoord& prevPlayerPosCS, const int checkFlag)
+{
+	const int32_t renderDist = m_renderDist;
 	int32_t chunksUpdated = 0;
 
 	std::unordered_map<uint64_t, Chunk*> checkForDuplicateDeletions;
-	std::unordered_map<uint64_t, XMFLOAT3> checkForDuplicateCreations;
+	std::unordered_map<uint64_t, ChunkCoord> checkForDuplicateCreations;
 
 	OG_ASSERT(checkFlag == 0 || checkFlag == 1);
 
 	// X AXIS
 	if (prevPlayerPosCS.x != currentPlayerPosCS.x)
 	{
-		int32_t difference = static_cast<int32_t>(prevPlayerPosCS.x - currentPlayerPosCS.x);
+		int32_t difference = prevPlayerPosCS.x - currentPlayerPosCS.x;
 
 		// If deleting
 		int8_t sign = difference > 0 ? 1 : -1;
 
-		difference = sign * min(abs(difference), RENDER_DIST);
+		difference = sign * min(abs(difference), renderDist);
 
 		// If creating
 		if (checkFlag == 1) sign *= -1;
@@ -421,19 +1071,19 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 		// Loop through all the new chunks
 		for (int32_t x = 0; x < abs(difference); x++)
 		{
-			for (int32_t y = -RENDER_DIST; y <= RENDER_DIST; y++)
+			for (int32_t y = -renderDist; y <= renderDist; y++)
 			{
-				for (int32_t z = -RENDER_DIST; z <= RENDER_DIST; z++)
+				for (int32_t z = -renderDist; z <= renderDist; z++)
 				{
-					float newXPos = 0;
+					int32_t newXPos = 0;
 					if (checkFlag == 0) // unloading
-						newXPos = prevPlayerPosCS.x + sign * (RENDER_DIST + (abs(difference) - 1));
+						newXPos = prevPlayerPosCS.x + sign * (renderDist + (abs(difference) - 1));
 					else // loading
-						newXPos = currentPlayerPosCS.x + sign * (RENDER_DIST + (abs(difference) - 1));
+						newXPos = currentPlayerPosCS.x + sign * (renderDist + (abs(difference) - 1));
 
-					float newYPos = currentPlayerPosCS.y + y;
-					float newZPos = currentPlayerPosCS.z + z;
-					XMFLOAT3 chunkPos = { newXPos, newYPos, newZPos };
+					int32_t newYPos = currentPlayerPosCS.y + y;
+					int32_t newZPos = currentPlayerPosCS.z + z;
+					ChunkCoord chunkPos(newXPos, newYPos, newZPos);
 					uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkPos);
 					auto chunkToUpdate = m_chunkMap.find(hashKey);
 
@@ -448,6 +1098,11 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 								chunksUpdated++;
 							}
 						}
+						// Demoted chunks are already out of the pool, they just have to be forgotten
+						else if (m_demotedChunks.erase(hashKey) > 0)
+						{
+							chunksUpdated++;
+						}
 					}
 					else // checkFlag == 1
 					{
@@ -466,12 +1121,12 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 	// Y AXIS
 	if (prevPlayerPosCS.y != currentPlayerPosCS.y)
 	{
-		int32_t difference = static_cast<int32_t>(prevPlayerPosCS.y - currentPlayerPosCS.y);
+		int32_t difference = prevPlayerPosCS.y - currentPlayerPosCS.y;
 
 		// If deleting
 		int8_t sign = difference > 0 ? 1 : -1;
 
-		difference = sign * min(abs(difference), RENDER_DIST);
+		difference = sign * min(abs(difference), renderDist);
 
 		// If creating
 		if (checkFlag == 1) sign *= -1;
@@ -479,20 +1134,20 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 		// Loop through all the new chunks
 		for (int32_t y = 0; y < abs(difference); y++)
 		{
-			for (int32_t x = -RENDER_DIST; x <= RENDER_DIST; x++)
+			for (int32_t x = -renderDist; x <= renderDist; x++)
 			{
-				for (int32_t z = -RENDER_DIST; z <= RENDER_DIST; z++)
+				for (int32_t z = -renderDist; z <= renderDist; z++)
 				{
-					float newXPos = currentPlayerPosCS.x + x;
+					int32_t newXPos = currentPlayerPosCS.x + x;
 
-					float newYPos = 0;
+					int32_t newYPos = 0;
 					if (checkFlag == 0) // unloading
-						newYPos = prevPlayerPosCS.y + sign * (RENDER_DIST + (abs(difference) - 1));
+						newYPos = prevPlayerPosCS.y + sign * (renderDist + (abs(difference) - 1));
 					else // loading
-						newYPos = currentPlayerPosCS.y + sign * (RENDER_DIST + (abs(difference) - 1));
+						newYPos = currentPlayerPosCS.y + sign * (renderDist + (abs(difference) - 1));
 
-					float newZPos = currentPlayerPosCS.z + z;
-					XMFLOAT3 chunkPos = { newXPos, newYPos, newZPos };
+					int32_t newZPos = currentPlayerPosCS.z + z;
+					ChunkCoord chunkPos(newXPos, newYPos, newZPos);
 					uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkPos);
 					auto chunkToUpdate = m_chunkMap.find(hashKey);
 
@@ -507,6 +1162,11 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 								chunksUpdated++;
 							}
 						}
+						// Demoted chunks are already out of the pool, they just have to be forgotten
+						else if (m_demotedChunks.erase(hashKey) > 0)
+						{
+							chunksUpdated++;
+						}
 					}
 					else // checkFlag == 1
 					{
@@ -525,12 +1185,12 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 	// Z AXIS
 	if (prevPlayerPosCS.z != currentPlayerPosCS.z)
 	{
-		int32_t difference = static_cast<int32_t>(prevPlayerPosCS.z - currentPlayerPosCS.z);
+		int32_t difference = prevPlayerPosCS.z - currentPlayerPosCS.z;
 
 		// If deleting
 		int8_t sign = difference > 0 ? 1 : -1;
 
-		difference = sign * min(abs(difference), RENDER_DIST);
+		difference = sign * min(abs(difference), renderDist);
 
 		// If creating
 		if (checkFlag == 1) sign *= -1;
@@ -539,20 +1199,20 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 		// Loop through all the new chunks
 		for (int32_t z = 0; z < abs(difference); z++)
 		{
-			for (int32_t x = -RENDER_DIST; x <= RENDER_DIST; x++)
+			for (int32_t x = -renderDist; x <= renderDist; x++)
 			{
-				for (int32_t y = -RENDER_DIST; y <= RENDER_DIST; y++)
+				for (int32_t y = -renderDist; y <= renderDist; y++)
 				{
-					float newXPos = currentPlayerPosCS.x + x;
-					float newYPos = currentPlayerPosCS.y + y;
+					int32_t newXPos = currentPlayerPosCS.x + x;
+					int32_t newYPos = currentPlayerPosCS.y + y;
 
-					float newZPos = 0;
+					int32_t newZPos = 0;
 					if(checkFlag == 0) // unloading
-						newZPos = prevPlayerPosCS.z + sign * (RENDER_DIST + (abs(difference) - 1));
+						newZPos = prevPlayerPosCS.z + sign * (renderDist + (abs(difference) - 1));
 					else // loading
-						newZPos = currentPlayerPosCS.z + sign * (RENDER_DIST + (abs(difference) - 1));
+						newZPos = currentPlayerPosCS.z + sign * (renderDist + (abs(difference) - 1));
 
-					XMFLOAT3 chunkPos = { newXPos, newYPos, newZPos };
+					ChunkCoord chunkPos(newXPos, newYPos, newZPos);
 					uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkPos);
 					auto chunkToUpdate = m_chunkMap.find(hashKey);
 
@@ -567,10 +1227,15 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 								chunksUpdated++;
 							}
 						}
+						// Demoted chunks are already out of the pool, they just have to be forgotten
+						else if (m_demotedChunks.erase(hashKey) > 0)
+						{
+							chunksUpdated++;
+						}
 						else
 						{
 							//OG_ASSERT(false && "Attempting to delete chunk that doesn't exist");
-							OG_LOG_WARNING("Skipped deletion of chunk at position %2.2f, %2.2f, %2.2f", newXPos, newYPos, newZPos);
+							OG_LOG_WARNING("Skipped deletion of chunk at position %i, %i, %i", newXPos, newYPos, newZPos);
 						}
 					}
 					else // checkFlag == 1 (for creation)
@@ -591,7 +1256,7 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 		}
 	}
 
-	if (chunksUpdated % ((2 * RENDER_DIST + 1) * (2 * RENDER_DIST + 1)) != 0)
+	if (chunksUpdated % ((2 * renderDist + 1) * (2 * renderDist + 1)) != 0)
 	{
 		OG_LOG_WARNING("Did not update a uniform number of chunks (%i)", chunksUpdated);
 	}
@@ -599,16 +1264,17 @@ const int32_t ChunkManager::CheckForChunksToLoadOrUnload(const XMFLOAT3& current
 	return chunksUpdated;
 }
 
-void ChunkManager::InitChunksMultithreaded(const int32_t& startChunk, const int32_t& numChunksToInit, const XMFLOAT3& playerPosCS)
+void ChunkManager::InitChunksMultithreaded(const int32_t& startChunk, const int32_t& numChunksToInit, const ChunkCoord& playerPosCS)
 {
+	const int32_t renderDist = m_renderDist;
 	for(int32_t x = startChunk; x < startChunk + numChunksToInit; x++)
 	{
-		for (int32_t y = -RENDER_DIST; y <= RENDER_DIST; y++)
+		for (int32_t y = -renderDist; y <= renderDist; y++)
 		{
-			for (int32_t z = -RENDER_DIST; z <= RENDER_DIST; z++)
+			for (int32_t z = -renderDist; z <= renderDist; z++)
 			{
 				// A coordinate in chunk space
-				XMFLOAT3 newChunkPosCS = { playerPosCS.x + x, playerPosCS.y + y, playerPosCS.z + z };
+				ChunkCoord newChunkPosCS = playerPosCS + ChunkCoord(x, y, z);
 
 				LoadChunkMultithreaded(newChunkPosCS);
 			}
@@ -618,6 +1284,7 @@ void ChunkManager::InitChunksMultithreaded(const int32_t& startChunk, const int3
 
 void ChunkManager::InitChunkVertexBuffersMultithreaded(const uint32_t& startIndex, const uint32_t& numChunksToInit)
 {
+	std::vector<BlockInstanceData> instances;
 	for(uint32_t index = startIndex; index < startIndex + numChunksToInit; index++)
 	{
 		// Sanity check
@@ -628,25 +1295,43 @@ void ChunkManager::InitChunkVertexBuffersMultithreaded(const uint32_t& startInde
 		// Sanity check
 		OG_ASSERT(currChunk);
 
+		// None of the chunks change while the initial meshes are built, so only adding the instances
+		// to the shared vertex array has to be serialized
+		ChunkSnapshot snapshot;
+		currChunk->TakeSnapshot(snapshot);
+		ChunkMesher::BuildMesh(snapshot, instances);
+		const ChunkFaceMask connectivity = ChunkConnectivity::Compute(snapshot);
+		const bool isOccluder = OcclusionRasterizer::IsOccluder(snapshot);
+		const bool isEmpty = ChunkMesher::IsEmpty(snapshot);
+
 		m_canAccessVec.lock();
-		currChunk->InitializeVertexBuffer();
+		currChunk->SetMesh(instances);
+		currChunk->SetConnectivity(connectivity);
+		currChunk->SetOccluder(isOccluder);
+		currChunk->SetEmpty(isEmpty);
 		m_canAccessVec.unlock();
+
+		instances.clear();
 	}
 }
 
-Chunk* ChunkManager::LoadChunkMultithreaded(const DirectX::XMFLOAT3 chunkCS)
+Chunk* ChunkManager::LoadChunkMultithreaded(const ChunkCoord chunkCS)
 {
 
 	uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkCS);
 
 	Chunk chunk(chunkCS);
-	chunk.Init();
+	if (ChunkResidencyManager::Promote(&chunk)) chunk.ApplyPendingWrites();
+	else chunk.Init();
+	chunk.ComputeLight();
 
 	m_canAccessVec.lock();
 	Chunk* chunkPtr = m_activeChunks.Insert_Move(std::move(chunk));
 	if (m_chunkMap.size() > 0 && m_chunkMap.find(hashKey) != m_chunkMap.end()) OG_ASSERT(false);
 	m_chunkMap[hashKey] = chunkPtr;
 	m_poolMap[hashKey] = m_activeChunks.GetIndexFromPointer(chunkPtr);
+	LinkChunkNeighbors(chunkPtr);
+	m_culler.Add(chunkCS);
 	m_canAccessVec.unlock();
 
 	return chunkPtr;
@@ -654,21 +1339,84 @@ Chunk* ChunkManager::LoadChunkMultithreaded(const DirectX::XMFLOAT3 chunkCS)
 
 const bool ChunkManager::IsShuttingDown() { return m_isShuttingDown; }
 
-bool ChunkManager::CheckBlockRaycast(const DirectX::XMFLOAT3& pos)
+const uint32_t ChunkManager::GetNumDemotedChunks() { return static_cast<uint32_t>(m_demotedChunks.size()); }
+
+bool ChunkManager::GetUnloadedBlockType(const BlockCoord& posBS, BlockType& outType)
+{
+	ChunkCoord chunkPosCS = Orange::Math::BlockToChunkCoord(posBS);
+	if (!ChunkResidencyManager::GetBlockType(chunkPosCS, Orange::Math::BlockToLocalCoord(posBS), outType)) return false;
+
+	// Chunks that left the render distance are in the cold tiers as well, the updater only promotes the demoted ones
+	std::lock_guard<std::mutex> lock(m_promotionRequestMutex);
+	m_promotionRequests.emplace(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS), chunkPosCS);
+	return true;
+}
+
+void ChunkManager::SetBlock(const BlockCoord& posBS, const BlockType type)
+{
+	std::lock_guard<std::mutex> lock(m_blockEditMutex);
+	m_pendingBlockEdits.push_back({ posBS, type });
+}
+
+void ChunkManager::CullChunks(const Orange::Plane* frustumPlanes, std::vector<ChunkCoord>& outVisibleChunks)
+{
+	outVisibleChunks.clear();
+
+	m_canAccessVec.lock();
+	m_culler.Cull(frustumPlanes, outVisibleChunks);
+	m_canAccessVec.unlock();
+}
+
+bool ChunkManager::FindVisibleChunks(const DirectX::XMFLOAT3& cameraPosWS, const Orange::Plane* frustumPlanes, std::vector<ChunkCoord>& outVisibleChunks)
+{
+	PoolConnectivityWorld world;
+
+	m_canAccessVec.lock();
+	const bool foundCameraChunk = ChunkConnectivity::FindVisibleChunks(world, Orange::Math::WorldToChunkSpace(cameraPosWS), frustumPlanes, outVisibleChunks);
+	m_canAccessVec.unlock();
+
+	return foundCameraChunk;
+}
+
+void ChunkManager::GetOccluders(const std::vector<ChunkCoord>& chunks, std::vector<ChunkCoord>& outOccluders)
+{
+	outOccluders.clear();
+
+	m_canAccessVec.lock();
+	for (const auto& chunkPosCS : chunks)
+	{
+		Chunk* chunk = GetChunkAtPos(chunkPosCS);
+		if (chunk && chunk->IsOccluder()) outOccluders.push_back(chunkPosCS);
+	}
+	m_canAccessVec.unlock();
+}
+
+void ChunkManager::UploadDrawList(const std::vector<ChunkCoord>* chunks, const DirectX::XMFLOAT3& cameraPosWS, ChunkDrawList& outDrawList)
 {
-	// pos = 58, 17, 45
-	// posInCS = 48, 16, 32
-	XMFLOAT3 posInCS = Orange::Math::WorldToChunkSpace(pos);
-	Chunk* chunk = GetChunkAtPos(posInCS);
-	if (chunk)
+	outDrawList.Clear();
+
+	m_canAccessVec.lock();
+	ChunkBufferManager::UpdateBuffers();
+	if (chunks)
 	{
-		XMFLOAT3 chunkPosInWS = Orange::Math::ChunkToWorldSpace(posInCS);
-		Block* block = chunk->GetBlock(static_cast<unsigned int>(pos.x - chunkPosInWS.x), static_cast<unsigned int>(pos.y - chunkPosInWS.y), static_cast<unsigned int>(pos.z - chunkPosInWS.z));
-		if (block && block->GetType() != BlockType::Air)	return true;
-		else												return false;
+		for (const auto& chunkPosCS : *chunks)
+		{
+			Chunk* chunk = GetChunkAtPos(chunkPosCS);
+			if (!chunk) continue;
+
+			const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+			const float dx = minWS.x + DefaultChunkTraits::HALF_EXTENT - cameraPosWS.x;
+			const float dy = minWS.y + DefaultChunkTraits::HALF_EXTENT - cameraPosWS.y;
+			const float dz = minWS.z + DefaultChunkTraits::HALF_EXTENT - cameraPosWS.z;
+			outDrawList.AddChunk(chunk->GetVertexBufferStartIndex(), chunk->GetBlockCount(), dx * dx + dy * dy + dz * dz);
+		}
 	}
 	else
 	{
-		return false;
+		outDrawList.AddChunk(0, ChunkBufferManager::GetNumInstances(), 0.0f);
 	}
+	m_canAccessVec.unlock();
+
+	// Whatever didn't fit in the instance buffer is cut off
+	outDrawList.Build(ChunkBufferManager::GetNumInstances());
 }
\ No newline at end of file
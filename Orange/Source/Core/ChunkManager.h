@@ -1,6 +1,7 @@
 #ifndef _CHUNKMANAGER_H
 #define _CHUNKMANAGER_H
 
+#include <atomic>
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -9,8 +10,13 @@
 #include "../Utility/SortedPool.h"
 
 #include "Chunk.h"
+#include "ChunkCuller.h"
+#include "ChunkDrawList.h"
 
-constexpr int32_t RENDER_DIST = 8;
+// Render distance in chunks, in every direction. It can be changed at runtime through SetRenderDistance()
+constexpr int32_t DEFAULT_RENDER_DIST = 8;
+constexpr int32_t MIN_RENDER_DIST = 2;
+constexpr int32_t MAX_RENDER_DIST = 24;
 
 
 // This is a work in progress!!
@@ -22,7 +28,7 @@ public:
 
 	static void Shutdown();
 
-	static Chunk* LoadChunk(const DirectX::XMFLOAT3 chunkCS);
+	static Chunk* LoadChunk(const ChunkCoord chunkCS);
 
 	static void UnloadChunk(Chunk* chunk);
 	static void UnloadChunk(const uint32_t& index);
@@ -32,7 +38,14 @@ public:
 	static Chunk* GetChunkAtIndex(const uint16_t index);
 
 	// Returns chunk at "pos" CHUNK SPACE
-	static Chunk* GetChunkAtPos(const DirectX::XMFLOAT3 pos);
+	static Chunk* GetChunkAtPos(const ChunkCoord pos);
+
+	// Same as above, but if "pos" is "nearChunk" or one of its neighbors the chunk is found by following
+	// the neighbor links instead of a hash lookup. Useful when walking over blocks that are close together
+	static Chunk* GetChunkAtPos(const ChunkCoord pos, Chunk* nearChunk);
+
+	// Checks every chunk's neighbor links against the chunk map. Logs every mismatch and returns false if there were any
+	static const bool ValidateNeighborLinks();
 
 	static Orange::SortedPool<Chunk>& GetChunkPool();
 
@@ -40,17 +53,56 @@ public:
 
 	static void SetPlayerPos(DirectX::XMFLOAT3 playerPos);
 
+	// The new render distance is clamped to [MIN_RENDER_DIST, MAX_RENDER_DIST] and applied by the updater
+	// thread on its next update. If called before Initialize(), the initial chunks are loaded with it instead.
+	// Either way it's capped by the chunk memory budget (see ChunkResidencyManager::GetMaxRenderDistance())
+	static void SetRenderDistance(const int32_t renderDist);
+	static const int32_t GetRenderDistance();
+
+	// Frees the chunk pools the updater thread replaced when the render distance changed. Chunks the game thread found
+	// before that stay readable until then, so it must be called from the game thread while it isn't holding on to any
+	static void ReleaseRetiredChunks();
+
+	// Returns the number of chunks in a cube of "renderDist" chunks around the player
+	static const uint32_t GetNumChunksInRenderDistance(const int32_t renderDist);
+
 	// MULTI-THREADED METHODS
-	static void InitChunksMultithreaded(const int32_t &startChunk, const int32_t& numChunksToInit, const DirectX::XMFLOAT3& playerPosCS);
+	static void InitChunksMultithreaded(const int32_t &startChunk, const int32_t& numChunksToInit, const ChunkCoord& playerPosCS);
 
 	static void InitChunkVertexBuffersMultithreaded(const uint32_t& startIndex, const uint32_t& numChunksToInit);
 
-	static Chunk* LoadChunkMultithreaded(const DirectX::XMFLOAT3 chunkCS);
+	static Chunk* LoadChunkMultithreaded(const ChunkCoord chunkCS);
 
 	static const bool IsShuttingDown();
 
-	// TEMP UTILITY FOR TESTING PURPOSES
-	static bool CheckBlockRaycast(const DirectX::XMFLOAT3& pos);
+	// Returns the number of chunks within render distance that were demoted to stay within the memory budget
+	static const uint32_t GetNumDemotedChunks();
+
+	// Looks up the block at "posBS" (BLOCK SPACE) in a chunk that isn't in the chunk pool, from the cold tier it was unloaded
+	// or demoted to (see ChunkResidencyManager). Can be called from any thread. If the chunk was demoted while within render
+	// distance, the updater thread promotes it before anything else on its next update. Returns false if the chunk isn't in
+	// either tier, i.e. it was never loaded (or was dropped), in which case the terrain generator has the answer
+	static bool GetUnloadedBlockType(const BlockCoord& posBS, BlockType& outType);
+
+	// Changes the block at "posBS" (BLOCK SPACE). Can be called from any thread, the updater thread applies the
+	// edit on its next update, relights the blocks around it and re-meshes every chunk that changed
+	static void SetBlock(const BlockCoord& posBS, const BlockType type);
+
+	// Replaces "outVisibleChunks" with every loaded chunk that is at least partially inside the frustum. Can be
+	// called from any thread, chunks that are loaded or unloaded at the same time may or may not be part of it
+	static void CullChunks(const Orange::Plane* frustumPlanes, std::vector<ChunkCoord>& outVisibleChunks);
+
+	// Replaces "outVisibleChunks" with the chunks inside the frustum that can be seen from the camera's chunk through
+	// the chunks' connected faces (see ChunkConnectivity). Returns false, leaving it empty, if the camera's chunk isn't loaded
+	static bool FindVisibleChunks(const DirectX::XMFLOAT3& cameraPosWS, const Orange::Plane* frustumPlanes, std::vector<ChunkCoord>& outVisibleChunks);
+
+	// Replaces "outOccluders" with the loaded chunks in "chunks" that can hide other chunks (see Chunk::IsOccluder())
+	static void GetOccluders(const std::vector<ChunkCoord>& chunks, std::vector<ChunkCoord>& outOccluders);
+
+	// Uploads the chunks' meshes to the instance buffer and replaces "outDrawList" with the instances of every loaded chunk in
+	// "chunks", along with how far it is from "cameraPosWS". Re-meshing a chunk moves other chunks' instances around, so both
+	// happen under the same lock and the ranges always match what was uploaded. If "chunks" is nullptr everything uploaded is drawn
+	static void UploadDrawList(const std::vector<ChunkCoord>* chunks, const DirectX::XMFLOAT3& cameraPosWS, ChunkDrawList& outDrawList);
 
 private:
 
@@ -58,10 +110,58 @@ private:
 
 	static void ResetChunkMemory(const uint16_t index);
 
+	// Initializes the vertex buffers of a newly loaded chunk and re-initializes the ones of its neighbors,
+	// since their faces bordering the new chunk may be hidden now
+	static void InitializeChunkAndNeighborVertexBuffers(Chunk* chunk);
+
+	// Snapshots and meshes the chunk, then replaces its range in the vertex array under m_canAccessVec
+	static void MeshChunk(Chunk* chunk);
+
+	// Applies the blocks that newly generated chunks placed in chunks that were already loaded (e.g. the
+	// canopy of a tree at the border) and re-meshes them
+	static void ApplyLateBlockWrites();
+
+	// Applies the edits SetBlock() queued up since the last update
+	static void ApplyBlockEdits();
+
+	// Re-meshes every chunk whose light changed during the update (see m_relitChunks)
+	static void MeshRelitChunks();
+
+	// Replaces "outRequestedChunks" with the chunks that were looked up (see GetUnloadedBlockType()) or edited since the last update
+	static void TakePromotionRequests(std::unordered_map<uint64_t, ChunkCoord>& outRequestedChunks);
+
+	// Promotes the demoted chunks within render distance back into the pool. Requested chunks come first and are promoted
+	// even if we're over the memory budget, the rest go closest first while there's enough headroom
+	static void PromoteDemotedChunks(const ChunkCoord& playerPosCS, const std::unordered_map<uint64_t, ChunkCoord>& requestedChunks);
+
+	// Demotes the furthest chunks if we're over the memory budget, except for the requested ones. See ChunkResidencyManager
+	static void EnforceMemoryBudget(const ChunkCoord& playerPosCS, const std::unordered_map<uint64_t, ChunkCoord>& requestedChunks);
+
+	// Gives the memory that erased meshes left behind in the vertex array back, under m_canAccessVec. Returns the number of bytes freed
+	static const uint64_t ShrinkVertexArray();
+
+	// Grows or shrinks the chunk pool to fit "newRenderDist", then streams in the new
+	// shell of chunks or releases the chunks that are out of range now
+	static void ApplyRenderDistance(const ChunkCoord& playerPosCS, const int32_t newRenderDist);
+
+	// Reallocates the chunk pool and points everything at the chunks' new slots, all under m_canAccessVec. The old pool
+	// is kept around until ReleaseRetiredChunks(), since the game thread may still be reading chunks out of it
+	static void ResizeChunkPool(const uint32_t newCapacity);
+
+	// Points the chunk and pool maps and the neighbor links at the chunks' current slots, e.g. after the chunk pool was reallocated
+	static void RebuildChunkMaps();
+
+	// Links the chunk to all of its loaded neighbors and vice-versa. Also used to fix up the links
+	// of a chunk that was moved to a different slot of the chunk pool
+	static void LinkChunkNeighbors(Chunk* chunk);
+
+	// Clears the neighbors' links to this chunk, must be called before the chunk leaves the pool
+	static void UnlinkChunkNeighbors(Chunk* chunk);
+
 	// CHECKFLAG:
 	// 0 - deleting
 	// 1 - creating
-	static const int32_t CheckForChunksToLoadOrUnload(const DirectX::XMFLOAT3& currentPlayerPosCS, const DirectX::XMFLOAT3& prevPlayerPosCS, const int checkFlag);
+	static const int32_t CheckForChunksToLoadOrUnload(const ChunkCoord& currentPlayerPosCS, const ChunkCoord& prevPlayerPosCS, const int checkFlag);
 
 private:
 	
@@ -73,17 +173,40 @@ private:
 	static std::thread* m_updaterThread;
 	static bool m_runThreads;
 
-	static std::vector<DirectX::XMFLOAT3> m_newChunkList;
-	static std::vector<DirectX::XMFLOAT3> m_deletedChunkList;
+	static std::vector<ChunkCoord> m_newChunkList;
+	static std::vector<ChunkCoord> m_deletedChunkList;
 
 	static DirectX::XMFLOAT3 m_playerPos;
 
 	// Speeds up position lookup for Chunk*'s
 	static std::unordered_map<uint64_t, Chunk*> m_chunkMap;
+
+	// Centers of every loaded chunk, for frustum culling. Guarded by m_canAccessVec
+	static ChunkCuller m_culler;
 	static std::unordered_map<uint64_t, uint32_t> m_poolMap;
 
+	// Chunks within render distance that are NOT in the chunk pool because we were over the
+	// memory budget. They're promoted back by PromoteDemotedChunks() once they're looked up or there's room again
+	static std::unordered_map<uint64_t, ChunkCoord> m_demotedChunks;
+
+	// Chunks GetUnloadedBlockType() found in a cold tier since the last update, by hash key
+	static std::mutex m_promotionRequestMutex;
+	static std::unordered_map<uint64_t, ChunkCoord> m_promotionRequests;
+
+	// Chunks whose light (or the light bordering them) changed since they were last meshed. May hold
+	// the same chunk more than once, as well as chunks that aren't loaded
+	static std::vector<ChunkCoord> m_relitChunks;
+
+	static std::mutex m_blockEditMutex;
+	static std::vector<std::pair<BlockCoord, BlockType>> m_pendingBlockEdits;
+
 	static bool m_isShuttingDown;
 
+	// Only ever written by the updater thread (or Initialize()), so that the loading and unloading
+	// loops always see the same value during an update. Other threads request changes through m_pendingRenderDist
+	static std::atomic<int32_t> m_renderDist;
+	static std::atomic<int32_t> m_pendingRenderDist;
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "../Misc/pch.h"
+#include "ChunkMesher.h"
+#include "BlockRegistry.h"
+#include "LightEngine.h"
+
+using namespace DirectX;
+
+template<int32_t Size>
+uint32_t ChunkMesher::BuildMesh(const BasicChunkSnapshot<Size>& snapshot, std::vector<BlockInstanceData>& outInstances)
+{
+	using Snapshot = BasicChunkSnapshot<Size>;
+
+	OG_ASSERT_MSG(BlockRegistry::IsInitialized(), "The block registry has to be initialized before meshing chunks");
+
+	const BlockType* blocks = snapshot.blocks;
+	const uint8_t* light = snapshot.light;
+	const BlockCoord posBS = Orange::Math::ChunkToBlockCoord<Size>(snapshot.posCS);
+	const size_t initialSize = outInstances.size();
+
+	// Same traversal order as always, so the instances end up in the same order as before. The bounds
+	// and strides are compile-time constants, so the compiler is free to unroll the rows
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t y = Size - 1; y >= 0; y--)
+		{
+			uint32_t index = Snapshot::GetIndex(x + 1, y + 1, 1);
+			for (int32_t z = 0; z < Size; z++, index += Snapshot::Z_STRIDE)
+			{
+				const BlockType blockType = blocks[index];
+
+				// The apron guarantees every neighbor is inside the snapshot, so there's no special case for the chunk's edges.
+				// A face is visible unless the neighbor is opaque or the same (transparent) block
+				auto isFaceVisible = [&](const uint32_t neighborIndex)
+				{
+					const BlockType neighbor = blocks[neighborIndex];
+					return static_cast<uint32_t>(!BlockRegistry::IsOpaque(neighbor) & (neighbor != blockType));
+				};
+
+				uint32_t blockFaces =
+					(isFaceVisible(index + Snapshot::Y_STRIDE) * static_cast<uint32_t>(BlockFace::TOP))		|
+					(isFaceVisible(index - Snapshot::Y_STRIDE) * static_cast<uint32_t>(BlockFace::BOTTOM))	|
+					(isFaceVisible(index - Snapshot::X_STRIDE) * static_cast<uint32_t>(BlockFace::LEFT))		|
+					(isFaceVisible(index + Snapshot::X_STRIDE) * static_cast<uint32_t>(BlockFace::RIGHT))	|
+					(isFaceVisible(index - Snapshot::Z_STRIDE) * static_cast<uint32_t>(BlockFace::FRONT))	|
+					(isFaceVisible(index + Snapshot::Z_STRIDE) * static_cast<uint32_t>(BlockFace::BACK));
+
+				// Air never renders any faces
+				blockFaces *= static_cast<uint32_t>(BlockRegistry::IsVisible(blockType));
+
+				if (blockFaces != 0)
+				{
+					// Same order as the BlockFace bits
+					const uint8_t faceLight[] =
+					{
+						light[index + Snapshot::Y_STRIDE], light[index - Snapshot::Y_STRIDE],
+						light[index - Snapshot::X_STRIDE], light[index + Snapshot::X_STRIDE],
+						light[index - Snapshot::Z_STRIDE], light[index + Snapshot::Z_STRIDE]
+					};
+
+					BlockInstanceData currBlock;
+					currBlock.blockFaces = blockFaces;
+					currBlock.blockType = static_cast<uint32_t>(blockType);
+					currBlock.worldPos = (posBS + BlockCoord(x, y, z)).ToFloat3();
+					currBlock.skyLight = currBlock.blockLight = 0;
+					for (uint32_t face = 0; face < NUM_BLOCK_FACES; face++)
+					{
+						currBlock.skyLight |= static_cast<uint32_t>(LightEngine::GetLevel(faceLight[face], LightChannel::SKY)) << (4 * face);
+						currBlock.blockLight |= static_cast<uint32_t>(LightEngine::GetLevel(faceLight[face], LightChannel::BLOCK)) << (4 * face);
+					}
+
+					outInstances.emplace_back(currBlock);
+				}
+			}
+		}
+	}
+
+	return static_cast<uint32_t>(outInstances.size() - initialSize);
+}
+
+template<int32_t Size>
+void ChunkMesher::FillApron(BasicChunkSnapshot<Size>& snapshot, const BlockType* const* neighborBlocks)
+{
+	using Snapshot = BasicChunkSnapshot<Size>;
+	using Traits = ChunkTraits<Size>;
+
+	const BlockType* left = neighborBlocks[static_cast<uint8_t>(ChunkNeighbor::LEFT)];
+	const BlockType* right = neighborBlocks[static_cast<uint8_t>(ChunkNeighbor::RIGHT)];
+	const BlockType* bottom = neighborBlocks[static_cast<uint8_t>(ChunkNeighbor::BOTTOM)];
+	const BlockType* top = neighborBlocks[static_cast<uint8_t>(ChunkNeighbor::TOP)];
+	const BlockType* front = neighborBlocks[static_cast<uint8_t>(ChunkNeighbor::FRONT)];
+	const BlockType* back = neighborBlocks[static_cast<uint8_t>(ChunkNeighbor::BACK)];
+
+	for (int32_t a = 0; a < Size; a++)
+	{
+		for (int32_t b = 0; b < Size; b++)
+		{
+			// a = y, b = z
+			snapshot.blocks[Snapshot::GetIndex(0, a + 1, b + 1)] = left ? left[Traits::GetIndex(Size - 1, a, b)] : Snapshot::MISSING_NEIGHBOR_BLOCK;
+			snapshot.blocks[Snapshot::GetIndex(Size + 1, a + 1, b + 1)] = right ? right[Traits::GetIndex(0, a, b)] : Snapshot::MISSING_NEIGHBOR_BLOCK;
+
+			// a = x, b = z
+			snapshot.blocks[Snapshot::GetIndex(a + 1, 0, b + 1)] = bottom ? bottom[Traits::GetIndex(a, Size - 1, b)] : Snapshot::MISSING_NEIGHBOR_BLOCK;
+			snapshot.blocks[Snapshot::GetIndex(a + 1, Size + 1, b + 1)] = top ? top[Traits::GetIndex(a, 0, b)] : Snapshot::MISSING_NEIGHBOR_BLOCK;
+
+			// a = x, b = y
+			snapshot.blocks[Snapshot::GetIndex(a + 1, b + 1, 0)] = front ? front[Traits::GetIndex(a, b, Size - 1)] : Snapshot::MISSING_NEIGHBOR_BLOCK;
+			snapshot.blocks[Snapshot::GetIndex(a + 1, b + 1, Size + 1)] = back ? back[Traits::GetIndex(a, b, 0)] : Snapshot::MISSING_NEIGHBOR_BLOCK;
+		}
+	}
+}
+
+template<int32_t Size>
+bool ChunkMesher::IsEmpty(const BasicChunkSnapshot<Size>& snapshot)
+{
+	using Snapshot = BasicChunkSnapshot<Size>;
+
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t y = 0; y < Size; y++)
+		{
+			const BlockType* row = &snapshot.blocks[Snapshot::GetIndex(x + 1, y + 1, 1)];
+			for (int32_t z = 0; z < Size; z++)
+			{
+				if (BlockRegistry::IsVisible(row[z])) return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+template uint32_t ChunkMesher::BuildMesh<16>(const BasicChunkSnapshot<16>&, std::vector<BlockInstanceData>&);
+template uint32_t ChunkMesher::BuildMesh<32>(const BasicChunkSnapshot<32>&, std::vector<BlockInstanceData>&);
+template uint32_t ChunkMesher::BuildMesh<64>(const BasicChunkSnapshot<64>&, std::vector<BlockInstanceData>&);
+
+template void ChunkMesher::FillApron<16>(BasicChunkSnapshot<16>&, const BlockType* const*);
+template void ChunkMesher::FillApron<32>(BasicChunkSnapshot<32>&, const BlockType* const*);
+template void ChunkMesher::FillApron<64>(BasicChunkSnapshot<64>&, const BlockType* const*);
+
+template bool ChunkMesher::IsEmpty<16>(const BasicChunkSnapshot<16>&);
+template bool ChunkMesher::IsEmpty<32>(const BasicChunkSnapshot<32>&);
+template bool ChunkMesher::IsEmpty<64>(const BasicChunkSnapshot<64>&);
@@ -0,0 +1,65 @@
+#ifndef _CHUNKMESHER_H
+#define _CHUNKMESHER_H
+
+#include <vector>
+
+#include "Block.h"
+#include "ChunkCoord.h"
+
+// Immutable copy of everything needed to mesh a chunk, taken through Chunk::TakeSnapshot(). It's the chunk plus
+// a one block apron on every side, so PADDED_SIZE = Size + 2. The blocks are laid out as [x][y][z] in padded
+// coordinates, the chunk's own blocks go from 1 to Size on every axis. Only the faces of the apron are filled in
+// from the neighbors, its edges and corners are never read
+template<int32_t Size>
+struct BasicChunkSnapshot
+{
+	using Traits = ChunkTraits<Size>;
+
+	static constexpr int32_t PADDED_SIZE = Size + 2;
+	static constexpr uint32_t PADDED_VOLUME = static_cast<uint32_t>(PADDED_SIZE * PADDED_SIZE * PADDED_SIZE);
+
+	// Apron blocks of missing neighbors are filled with this, so that faces bordering unloaded chunks are culled
+	static constexpr BlockType MISSING_NEIGHBOR_BLOCK = BlockType::Stone;
+
+	static constexpr uint32_t X_STRIDE = PADDED_SIZE * PADDED_SIZE;
+	static constexpr uint32_t Y_STRIDE = PADDED_SIZE;
+	static constexpr uint32_t Z_STRIDE = 1;
+
+	// Takes PADDED coordinates, i.e. [0, PADDED_SIZE) on every axis
+	static constexpr uint32_t GetIndex(const int32_t x, const int32_t y, const int32_t z) { return x * X_STRIDE + y * Y_STRIDE + z * Z_STRIDE; }
+
+	ChunkCoord posCS;
+	BlockType blocks[PADDED_VOLUME];
+
+	// Packed like the chunk's light (see LightEngine), and laid out like the blocks. The apron's light
+	// is what the faces on the chunk's border are lit with
+	uint8_t light[PADDED_VOLUME];
+};
+
+using ChunkSnapshot = BasicChunkSnapshot<CHUNK_SIZE>;
+
+// Turns chunk snapshots into block instances. It only ever reads the snapshot, so any thread
+// can mesh any chunk without touching the chunk pool or the vertex array
+class ChunkMesher
+{
+public:
+
+	// Appends an instance for every visible block with at least one face that isn't hidden by its neighbor, lit
+	// by the blocks in front of its faces. Returns the number of instances that were appended. Instantiated for
+	// every size ChunkTraits supports
+	template<int32_t Size>
+	static uint32_t BuildMesh(const BasicChunkSnapshot<Size>& snapshot, std::vector<BlockInstanceData>& outInstances);
+
+	// Fills the snapshot's apron from [x][y][z] ordered neighbor blocks, any of which may be nullptr.
+	// The neighbors are indexed by ChunkNeighbor. Used where chunks only exist as plain block arrays
+	template<int32_t Size>
+	static void FillApron(BasicChunkSnapshot<Size>& snapshot, const BlockType* const* neighborBlocks);
+
+	// Returns true if none of the chunk's own blocks are visible (see BlockRegistry::IsVisible()), i.e. there's
+	// nothing in it to draw or for a ray to hit
+	template<int32_t Size>
+	static bool IsEmpty(const BasicChunkSnapshot<Size>& snapshot);
+
+};
+
+#endif
@@ -0,0 +1,389 @@
+#include "../Misc/pch.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "ChunkResidencyManager.h"
+#include "ChunkCoord.h"
+#include "ChunkManager.h"
+#include "ChunkSerializer.h"
+#include "ShaderBufferManagers/ChunkBufferManager.h"
+#include "../Utility/Utility.h"
+
+#if !defined(OG_WINDOWS)
+#include <unistd.h>
+#endif
+
+// How many chunks of distance one second in the compressed tier is worth when picking
+// which chunks to spill to disk. Higher values favour spilling chunks that were demoted long ago
+constexpr float SPILL_AGE_WEIGHT = 0.1f;
+
+// At most this fraction of the memory budget goes to the chunk pool and the instance buffer. The rest
+// is left for the chunk meshes and the compressed tier
+constexpr float FIXED_MEMORY_BUDGET_FRACTION = 0.5f;
+
+std::unordered_map<uint64_t, ChunkResidencyManager::CompressedChunk> ChunkResidencyManager::m_compressedChunks = std::unordered_map<uint64_t, ChunkResidencyManager::CompressedChunk>();
+std::unordered_map<uint64_t, ChunkResidencyManager::DiskChunk> ChunkResidencyManager::m_chunksOnDisk = std::unordered_map<uint64_t, ChunkResidencyManager::DiskChunk>();
+std::mutex ChunkResidencyManager::m_tierMutex;
+std::string ChunkResidencyManager::m_cacheDirectory = "";
+std::atomic<uint64_t> ChunkResidencyManager::m_memoryBudget = 0;
+std::atomic<uint64_t> ChunkResidencyManager::m_diskBudget = 0;
+uint64_t ChunkResidencyManager::m_compressedBytes = 0;
+uint64_t ChunkResidencyManager::m_diskBytes = 0;
+bool ChunkResidencyManager::m_isInitialized = false;
+
+void ChunkResidencyManager::Initialize(const uint64_t memoryBudgetInBytes, const uint64_t diskBudgetInBytes, const std::string& cacheDirectory)
+{
+	OG_ASSERT_MSG(!m_isInitialized, "ChunkResidencyManager was already initialized");
+
+#if defined(OG_WINDOWS)
+	const uint32_t processID = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+	const uint32_t processID = static_cast<uint32_t>(getpid());
+#endif
+
+	OG_ASSERT_MSG(IsMemoryBudgetLargeEnough(memoryBudgetInBytes), "The chunk memory budget doesn't fit the minimum render distance");
+
+	m_cacheDirectory = cacheDirectory + "/" + std::to_string(processID);
+	m_memoryBudget = memoryBudgetInBytes;
+	m_diskBudget = diskBudgetInBytes;
+	m_compressedBytes = 0;
+	m_diskBytes = 0;
+
+	// Anything left in here belongs to a previous process with the same ID that didn't shut down properly
+	std::error_code error;
+	std::filesystem::remove_all(m_cacheDirectory, error);
+	std::filesystem::create_directories(m_cacheDirectory, error);
+	if (error)
+	{
+		OG_LOG_ERROR("Failed to create chunk cache directory %s, chunks will not be spilled to disk", m_cacheDirectory.c_str());
+	}
+
+	m_isInitialized = true;
+}
+
+void ChunkResidencyManager::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_tierMutex);
+		m_compressedChunks.clear();
+		m_chunksOnDisk.clear();
+		m_compressedBytes = 0;
+		m_diskBytes = 0;
+	}
+
+	// The cache only lives as long as the process does
+	std::error_code error;
+	std::filesystem::remove_all(m_cacheDirectory, error);
+
+	m_isInitialized = false;
+}
+
+bool ChunkResidencyManager::SetMemoryBudget(const uint64_t memoryBudgetInBytes)
+{
+	if (!IsMemoryBudgetLargeEnough(memoryBudgetInBytes))
+	{
+		OG_LOG_ERROR("A chunk memory budget of %2.2f MB doesn't fit render distance %i, keeping %2.2f MB", static_cast<float>(memoryBudgetInBytes) / (1024.0f * 1024.0f),
+			MIN_RENDER_DIST, static_cast<float>(m_memoryBudget.load()) / (1024.0f * 1024.0f));
+		return false;
+	}
+
+	m_memoryBudget = memoryBudgetInBytes;
+	return true;
+}
+
+const uint64_t ChunkResidencyManager::GetMemoryBudget() { return m_memoryBudget; }
+
+void ChunkResidencyManager::SetDiskBudget(const uint64_t diskBudgetInBytes) { m_diskBudget = diskBudgetInBytes; }
+
+const uint64_t ChunkResidencyManager::GetDiskBudget() { return m_diskBudget; }
+
+const int32_t ChunkResidencyManager::GetMaxRenderDistance()
+{
+	const uint64_t fixedMemoryLimit = static_cast<uint64_t>(m_memoryBudget * FIXED_MEMORY_BUDGET_FRACTION);
+
+	int32_t renderDist = MIN_RENDER_DIST;
+	while (renderDist < MAX_RENDER_DIST && GetFixedMemory(renderDist + 1) <= fixedMemoryLimit) renderDist++;
+
+	return renderDist;
+}
+
+void ChunkResidencyManager::Demote(Chunk* chunk)
+{
+	OG_ASSERT(chunk);
+
+	BlockType blockTypes[BLOCKS_PER_CHUNK];
+	chunk->GetBlockTypes(blockTypes);
+
+	CompressedChunk compressedChunk;
+	compressedChunk.posCS = chunk->GetPosition();
+	compressedChunk.lastSeenTime = Clock::GetTimeSinceStart(Clock::TimePrecision::SECONDS);
+	ChunkSerializer::Compress(blockTypes, compressedChunk.data);
+	compressedChunk.data.shrink_to_fit();
+
+	uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(compressedChunk.posCS);
+
+	std::lock_guard<std::mutex> lock(m_tierMutex);
+
+	auto existingChunk = m_compressedChunks.find(hashKey);
+	if (existingChunk != m_compressedChunks.end())
+	{
+		m_compressedBytes -= GetCompressedChunkSize(existingChunk->second);
+	}
+
+	// If an older copy was spilled to disk it's stale now
+	RemoveFromDisk(hashKey);
+
+	m_compressedBytes += GetCompressedChunkSize(compressedChunk);
+	m_compressedChunks[hashKey] = std::move(compressedChunk);
+}
+
+bool ChunkResidencyManager::Promote(Chunk* chunk)
+{
+	OG_ASSERT(chunk);
+
+	ChunkCoord chunkPosCS = chunk->GetPosition();
+	uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS);
+
+	std::vector<uint8_t> compressedData;
+	{
+		std::lock_guard<std::mutex> lock(m_tierMutex);
+
+		auto compressedChunk = m_compressedChunks.find(hashKey);
+		if (compressedChunk != m_compressedChunks.end())
+		{
+			m_compressedBytes -= GetCompressedChunkSize(compressedChunk->second);
+			compressedData = std::move(compressedChunk->second.data);
+			m_compressedChunks.erase(compressedChunk);
+		}
+		else if (m_chunksOnDisk.find(hashKey) != m_chunksOnDisk.end())
+		{
+			ChunkCoord filePosCS;
+			const bool isFileValid = ChunkSerializer::ReadFromFile(GetChunkFilePath(chunkPosCS), filePosCS, compressedData) && filePosCS == chunkPosCS;
+			RemoveFromDisk(hashKey);
+
+			if (!isFileValid)
+			{
+				OG_LOG_WARNING("Failed to read chunk (%i, %i, %i) from disk, it will be regenerated", chunkPosCS.x, chunkPosCS.y, chunkPosCS.z);
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	BlockType blockTypes[BLOCKS_PER_CHUNK];
+	if (!ChunkSerializer::Decompress(compressedData, blockTypes))
+	{
+		OG_LOG_WARNING("Failed to decompress chunk (%i, %i, %i), it will be regenerated", chunkPosCS.x, chunkPosCS.y, chunkPosCS.z);
+		return false;
+	}
+
+	chunk->SetBlockTypes(blockTypes);
+	return true;
+}
+
+bool ChunkResidencyManager::GetBlockType(const ChunkCoord& chunkPosCS, const BlockCoord& localPos, BlockType& outType)
+{
+	uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS);
+
+	std::lock_guard<std::mutex> lock(m_tierMutex);
+
+	auto compressedChunk = m_compressedChunks.find(hashKey);
+	if (compressedChunk == m_compressedChunks.end())
+	{
+		if (m_chunksOnDisk.find(hashKey) == m_chunksOnDisk.end()) return false;
+
+		// Whatever is being looked up around here will most likely look up more blocks of the same chunk
+		CompressedChunk chunkFromDisk;
+		ChunkCoord filePosCS;
+		const bool isFileValid = ChunkSerializer::ReadFromFile(GetChunkFilePath(chunkPosCS), filePosCS, chunkFromDisk.data) && filePosCS == chunkPosCS;
+		RemoveFromDisk(hashKey);
+
+		if (!isFileValid)
+		{
+			OG_LOG_WARNING("Failed to read chunk (%i, %i, %i) from disk, it will be regenerated", chunkPosCS.x, chunkPosCS.y, chunkPosCS.z);
+			return false;
+		}
+
+		chunkFromDisk.posCS = chunkPosCS;
+		chunkFromDisk.data.shrink_to_fit();
+		m_compressedBytes += GetCompressedChunkSize(chunkFromDisk);
+		compressedChunk = m_compressedChunks.emplace(hashKey, std::move(chunkFromDisk)).first;
+	}
+
+	// Chunks that are still being looked at are the last ones that should be spilled
+	compressedChunk->second.lastSeenTime = Clock::GetTimeSinceStart(Clock::TimePrecision::SECONDS);
+
+	return ChunkSerializer::GetBlockType(compressedChunk->second.data, localPos, outType);
+}
+
+uint64_t ChunkResidencyManager::SpillToDisk(const ChunkCoord& playerPosCS, const uint64_t bytesToFree)
+{
+	if (bytesToFree == 0) return 0;
+
+	std::lock_guard<std::mutex> lock(m_tierMutex);
+
+	// Score every compressed chunk, the highest scores get spilled first
+	float currentTime = Clock::GetTimeSinceStart(Clock::TimePrecision::SECONDS);
+	std::vector<std::pair<float, uint64_t>> spillCandidates;
+	spillCandidates.reserve(m_compressedChunks.size());
+	for (const auto& compressedChunk : m_compressedChunks)
+	{
+		float distance = static_cast<float>(Orange::Math::ChunkDistance(compressedChunk.second.posCS, playerPosCS));
+		float timeUnseen = currentTime - compressedChunk.second.lastSeenTime;
+		spillCandidates.push_back({ distance + timeUnseen * SPILL_AGE_WEIGHT, compressedChunk.first });
+	}
+	std::sort(spillCandidates.begin(), spillCandidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	uint64_t bytesFreed = 0;
+	bool canWriteToDisk = true;
+	for (const auto& candidate : spillCandidates)
+	{
+		if (bytesFreed >= bytesToFree) break;
+
+		auto compressedChunk = m_compressedChunks.find(candidate.second);
+		OG_ASSERT(compressedChunk != m_compressedChunks.end());
+
+		// If the disk is full or the directory is gone the chunk is dropped anyway, since the compressed tier
+		// can't outgrow the memory budget. It's generated again if it's ever needed
+		const CompressedChunk& chunkToSpill = compressedChunk->second;
+		if (canWriteToDisk && ChunkSerializer::WriteToFile(GetChunkFilePath(chunkToSpill.posCS), chunkToSpill.posCS, chunkToSpill.data))
+		{
+			const uint64_t fileSize = ChunkSerializer::GetFileSize(chunkToSpill.data);
+			m_chunksOnDisk[candidate.second] = { chunkToSpill.posCS, fileSize };
+			m_diskBytes += fileSize;
+		}
+		else
+		{
+			// Don't bother writing the rest
+			canWriteToDisk = false;
+		}
+
+		uint64_t chunkSize = GetCompressedChunkSize(chunkToSpill);
+		m_compressedBytes -= chunkSize;
+		bytesFreed += chunkSize;
+
+		m_compressedChunks.erase(compressedChunk);
+	}
+
+	if (!canWriteToDisk)
+	{
+		OG_LOG_WARNING("Failed to spill chunks to disk, they were dropped and will be regenerated");
+	}
+
+	TrimDiskTier(playerPosCS);
+
+	return bytesFreed;
+}
+
+const uint64_t ChunkResidencyManager::GetUsedMemory() { return GetFixedMemory() + GetReclaimableMemory(); }
+
+const uint64_t ChunkResidencyManager::GetFixedMemory()
+{
+	// The chunk pool and the instance buffer are allocated up-front for the render distance
+	uint64_t chunkPoolBytes = static_cast<uint64_t>(ChunkManager::GetChunkPool().Capacity()) * sizeof(Chunk);
+	uint64_t instanceBufferBytes = ChunkBufferManager::GetInstanceBufferByteWidth();
+
+	return chunkPoolBytes + instanceBufferBytes;
+}
+
+const uint64_t ChunkResidencyManager::GetFixedMemory(const int32_t renderDist)
+{
+	uint64_t chunkPoolBytes = static_cast<uint64_t>(ChunkManager::GetNumChunksInRenderDistance(renderDist)) * sizeof(Chunk);
+	uint64_t instanceBufferBytes = ChunkBufferManager::GetInstanceBufferByteWidth(renderDist);
+
+	return chunkPoolBytes + instanceBufferBytes;
+}
+
+const uint64_t ChunkResidencyManager::GetReclaimableMemory()
+{
+	// Only the chunk meshes and the compressed tier change with the number of resident chunks. Erasing meshes
+	// doesn't give the vertex array's memory back, so it's counted by what it holds on to
+	uint64_t meshBytes = static_cast<uint64_t>(ChunkBufferManager::GetVertexArray().capacity()) * sizeof(BlockInstanceData);
+
+	return meshBytes + GetCompressedMemory();
+}
+
+const uint64_t ChunkResidencyManager::GetReclaimableBudget()
+{
+	const uint64_t memoryBudget = m_memoryBudget;
+	const uint64_t fixedMemory = GetFixedMemory();
+
+	return memoryBudget > fixedMemory ? memoryBudget - fixedMemory : 0;
+}
+
+const uint64_t ChunkResidencyManager::GetCompressedMemory()
+{
+	std::lock_guard<std::mutex> lock(m_tierMutex);
+	return m_compressedBytes;
+}
+
+const uint64_t ChunkResidencyManager::GetDiskUsage()
+{
+	std::lock_guard<std::mutex> lock(m_tierMutex);
+	return m_diskBytes;
+}
+
+const uint32_t ChunkResidencyManager::GetNumCompressedChunks()
+{
+	std::lock_guard<std::mutex> lock(m_tierMutex);
+	return static_cast<uint32_t>(m_compressedChunks.size());
+}
+
+const uint32_t ChunkResidencyManager::GetNumChunksOnDisk()
+{
+	std::lock_guard<std::mutex> lock(m_tierMutex);
+	return static_cast<uint32_t>(m_chunksOnDisk.size());
+}
+
+const uint64_t ChunkResidencyManager::GetCompressedChunkSize(const CompressedChunk& compressedChunk)
+{
+	// Include the bookkeeping so that lots of tiny (all air) chunks still add up
+	return sizeof(CompressedChunk) + sizeof(uint64_t) + compressedChunk.data.capacity();
+}
+
+const bool ChunkResidencyManager::IsMemoryBudgetLargeEnough(const uint64_t memoryBudgetInBytes)
+{
+	return GetFixedMemory(MIN_RENDER_DIST) <= static_cast<uint64_t>(memoryBudgetInBytes * FIXED_MEMORY_BUDGET_FRACTION);
+}
+
+void ChunkResidencyManager::RemoveFromDisk(const uint64_t hashKey)
+{
+	auto diskChunk = m_chunksOnDisk.find(hashKey);
+	if (diskChunk == m_chunksOnDisk.end()) return;
+
+	std::error_code error;
+	std::filesystem::remove(GetChunkFilePath(diskChunk->second.posCS), error);
+
+	m_diskBytes -= diskChunk->second.fileSize;
+	m_chunksOnDisk.erase(diskChunk);
+}
+
+void ChunkResidencyManager::TrimDiskTier(const ChunkCoord& playerPosCS)
+{
+	const uint64_t diskBudget = m_diskBudget;
+	if (m_diskBytes <= diskBudget) return;
+
+	// The chunks furthest away are the least likely to be needed again
+	std::vector<std::pair<int32_t, uint64_t>> evictionCandidates;
+	evictionCandidates.reserve(m_chunksOnDisk.size());
+	for (const auto& diskChunk : m_chunksOnDisk)
+	{
+		evictionCandidates.push_back({ Orange::Math::ChunkDistance(diskChunk.second.posCS, playerPosCS), diskChunk.first });
+	}
+	std::sort(evictionCandidates.begin(), evictionCandidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	for (const auto& candidate : evictionCandidates)
+	{
+		if (m_diskBytes <= diskBudget) break;
+		RemoveFromDisk(candidate.second);
+	}
+}
+
+const std::string ChunkResidencyManager::GetChunkFilePath(const ChunkCoord& chunkPosCS)
+{
+	return m_cacheDirectory + "/" + ChunkSerializer::GetFileName(chunkPosCS);
+}
@@ -0,0 +1,130 @@
+#ifndef _CHUNKRESIDENCYMANAGER_H
+#define _CHUNKRESIDENCYMANAGER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+
+// Keeps track of how much memory chunks are using and owns the "cold" tiers
+// a chunk can be demoted to once it leaves the chunk pool:
+//
+//		1. Compressed in memory (RLE block data, see ChunkSerializer)
+//		2. On disk, in a cache directory owned by this process
+//
+// ChunkManager decides WHICH chunks leave the pool, this class only stores them
+// and reports how far over (or under) the memory budget we are. Both tiers are
+// bounded: the compressed tier by the memory budget, the disk tier by its own budget
+//
+// The chunk pool and the instance buffer are sized by the render distance, so they're
+// a fixed cost that demoting chunks can never lower. The render distance is capped so
+// that they only take up part of the budget, and the rest is what demotion works with
+class ChunkResidencyManager
+{
+public:
+
+	// The cache directory is suffixed with the process ID, so several instances can run on the same host
+	static void Initialize(const uint64_t memoryBudgetInBytes, const uint64_t diskBudgetInBytes, const std::string& cacheDirectory);
+	static void Shutdown();
+
+	// Returns false and keeps the current budget if the chunk pool and instance buffer wouldn't fit in it even at
+	// MIN_RENDER_DIST, since nothing could keep the chunks under it then
+	static bool SetMemoryBudget(const uint64_t memoryBudgetInBytes);
+	static const uint64_t GetMemoryBudget();
+
+	// Chunks spilled past this many bytes on disk are deleted, furthest away first, and generated again if they're needed
+	static void SetDiskBudget(const uint64_t diskBudgetInBytes);
+	static const uint64_t GetDiskBudget();
+
+	// Returns the largest render distance whose chunk pool and instance buffer fit in FIXED_MEMORY_BUDGET_FRACTION
+	// of the memory budget. MIN_RENDER_DIST always fits, since smaller budgets are rejected
+	static const int32_t GetMaxRenderDistance();
+
+	// Compresses the chunk's blocks into the in-memory cold tier. The chunk is NOT removed
+	// from the chunk pool, that's up to the caller
+	static void Demote(Chunk* chunk);
+
+	// Restores the chunk's blocks (at the chunk's position) from either cold tier. Returns false
+	// if the chunk was never demoted, in which case it has to be generated from scratch
+	static bool Promote(Chunk* chunk);
+
+	// Looks up the block at "localPos" of a chunk in either cold tier, without promoting it. A chunk on disk is read back
+	// into the compressed tier first, so only the first lookup goes to disk. Returns false if the chunk is in neither tier
+	static bool GetBlockType(const ChunkCoord& chunkPosCS, const BlockCoord& localPos, BlockType& outType);
+
+	// Moves compressed chunks to disk, furthest away and longest unseen first, until at least
+	// "bytesToFree" bytes of memory were freed. Chunks that can't be written are dropped instead,
+	// and the disk tier is trimmed back to its budget afterwards. Returns the number of bytes freed
+	static uint64_t SpillToDisk(const ChunkCoord& playerPosCS, const uint64_t bytesToFree);
+
+	// Returns the bytes used by the chunk pool, the chunk meshes, the instance buffer and the compressed tier
+	static const uint64_t GetUsedMemory();
+
+	// Returns the bytes used by the chunk pool and the instance buffer, as they are now or at a given render distance
+	static const uint64_t GetFixedMemory();
+	static const uint64_t GetFixedMemory(const int32_t renderDist);
+
+	// Returns the bytes used by the chunk meshes and the compressed tier, the only memory demoting chunks can free.
+	// The meshes are counted by the vertex array's capacity, which only goes down once it's shrunk to fit
+	static const uint64_t GetReclaimableMemory();
+
+	// Returns what's left of the memory budget for the reclaimable memory
+	static const uint64_t GetReclaimableBudget();
+
+	static const uint64_t GetCompressedMemory();
+	static const uint64_t GetDiskUsage();
+
+	static const uint32_t GetNumCompressedChunks();
+	static const uint32_t GetNumChunksOnDisk();
+
+private:
+
+	struct CompressedChunk
+	{
+		ChunkCoord posCS;
+		float lastSeenTime;
+		std::vector<uint8_t> data;
+	};
+
+	struct DiskChunk
+	{
+		ChunkCoord posCS;
+		uint64_t fileSize;
+	};
+
+	static const uint64_t GetCompressedChunkSize(const CompressedChunk& compressedChunk);
+
+	// Whether the chunk pool and the instance buffer fit in FIXED_MEMORY_BUDGET_FRACTION of the budget at MIN_RENDER_DIST
+	static const bool IsMemoryBudgetLargeEnough(const uint64_t memoryBudgetInBytes);
+
+	// Deletes the chunk's file and forgets about it. m_tierMutex must be held
+	static void RemoveFromDisk(const uint64_t hashKey);
+
+	// Deletes the furthest chunks on disk until the disk tier is within its budget. m_tierMutex must be held
+	static void TrimDiskTier(const ChunkCoord& playerPosCS);
+
+	static const std::string GetChunkFilePath(const ChunkCoord& chunkPosCS);
+
+private:
+
+	static std::unordered_map<uint64_t, CompressedChunk> m_compressedChunks;
+	static std::unordered_map<uint64_t, DiskChunk> m_chunksOnDisk;
+
+	// Guards both cold tiers. Chunks are promoted from the initializer threads as well as the updater thread
+	static std::mutex m_tierMutex;
+
+	static std::string m_cacheDirectory;
+
+	static std::atomic<uint64_t> m_memoryBudget;
+	static std::atomic<uint64_t> m_diskBudget;
+	static uint64_t m_compressedBytes;
+	static uint64_t m_diskBytes;
+
+	static bool m_isInitialized;
+
+};
+
+#endif
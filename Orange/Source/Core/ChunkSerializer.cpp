@@ -0,0 +1,166 @@
+#include "../Misc/pch.h"
+
+#include <fstream>
+
+#include "ChunkSerializer.h"
+#include "../Utility/Utility.h"
+
+// On-disk header that precedes the RLE payload
+struct ChunkFileHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t chunkSize;
+	int32_t x, y, z;
+	uint32_t payloadSize;
+};
+
+void ChunkSerializer::Compress(const BlockType* blockTypes, std::vector<uint8_t>& outData)
+{
+	outData.clear();
+
+	BlockType runType = BlockType::Air;
+	uint16_t runLength = 0;
+
+	for (int32_t x = 0; x < CHUNK_SIZE; x++)
+	{
+		for (int32_t z = 0; z < CHUNK_SIZE; z++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			{
+				BlockType type = blockTypes[(x * CHUNK_SIZE + y) * CHUNK_SIZE + z];
+				if (runLength > 0 && type == runType)
+				{
+					runLength++;
+					continue;
+				}
+
+				if (runLength > 0)
+				{
+					outData.push_back(static_cast<uint8_t>(runType));
+					outData.push_back(static_cast<uint8_t>(runLength & 0xFF));
+					outData.push_back(static_cast<uint8_t>(runLength >> 8));
+				}
+
+				runType = type;
+				runLength = 1;
+			}
+		}
+	}
+
+	// Flush the last run
+	outData.push_back(static_cast<uint8_t>(runType));
+	outData.push_back(static_cast<uint8_t>(runLength & 0xFF));
+	outData.push_back(static_cast<uint8_t>(runLength >> 8));
+}
+
+bool ChunkSerializer::Decompress(const std::vector<uint8_t>& data, BlockType* outBlockTypes)
+{
+	if (data.size() % RUN_SIZE_IN_BYTES != 0) return false;
+
+	// Index in column order (Y innermost), see Compress()
+	uint32_t columnIndex = 0;
+	for (size_t i = 0; i < data.size(); i += RUN_SIZE_IN_BYTES)
+	{
+		BlockType type = static_cast<BlockType>(data[i]);
+		uint32_t runLength = static_cast<uint32_t>(data[i + 1]) | (static_cast<uint32_t>(data[i + 2]) << 8);
+
+		if (runLength == 0 || columnIndex + runLength > BLOCKS_PER_CHUNK) return false;
+
+		for (uint32_t j = 0; j < runLength; j++, columnIndex++)
+		{
+			uint32_t y = columnIndex % CHUNK_SIZE;
+			uint32_t z = (columnIndex / CHUNK_SIZE) % CHUNK_SIZE;
+			uint32_t x = columnIndex / (CHUNK_SIZE * CHUNK_SIZE);
+			outBlockTypes[(x * CHUNK_SIZE + y) * CHUNK_SIZE + z] = type;
+		}
+	}
+
+	return columnIndex == BLOCKS_PER_CHUNK;
+}
+
+bool ChunkSerializer::GetBlockType(const std::vector<uint8_t>& data, const BlockCoord& localPos, BlockType& outType)
+{
+	if (data.size() % RUN_SIZE_IN_BYTES != 0) return false;
+
+	// Index in column order (Y innermost), see Compress()
+	const uint32_t blockIndex = static_cast<uint32_t>((localPos.x * CHUNK_SIZE + localPos.z) * CHUNK_SIZE + localPos.y);
+
+	uint32_t columnIndex = 0;
+	for (size_t i = 0; i < data.size(); i += RUN_SIZE_IN_BYTES)
+	{
+		uint32_t runLength = static_cast<uint32_t>(data[i + 1]) | (static_cast<uint32_t>(data[i + 2]) << 8);
+		if (runLength == 0) return false;
+
+		columnIndex += runLength;
+		if (blockIndex < columnIndex)
+		{
+			outType = static_cast<BlockType>(data[i]);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ChunkSerializer::WriteToFile(const std::string& filePath, const ChunkCoord& chunkPosCS, const std::vector<uint8_t>& compressedData)
+{
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		OG_LOG_ERROR("Failed to open chunk file %s for writing", filePath.c_str());
+		return false;
+	}
+
+	ChunkFileHeader header;
+	header.magic = CHUNK_FILE_MAGIC;
+	header.version = CHUNK_FILE_VERSION;
+	header.chunkSize = static_cast<uint16_t>(CHUNK_SIZE);
+	header.x = chunkPosCS.x;
+	header.y = chunkPosCS.y;
+	header.z = chunkPosCS.z;
+	header.payloadSize = static_cast<uint32_t>(compressedData.size());
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(ChunkFileHeader));
+	file.write(reinterpret_cast<const char*>(compressedData.data()), compressedData.size());
+
+	return file.good();
+}
+
+bool ChunkSerializer::ReadFromFile(const std::string& filePath, ChunkCoord& outChunkPosCS, std::vector<uint8_t>& outCompressedData)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	ChunkFileHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(ChunkFileHeader));
+	if (!file.good()) return false;
+
+	if (header.magic != CHUNK_FILE_MAGIC || header.version != CHUNK_FILE_VERSION)
+	{
+		OG_LOG_WARNING("Chunk file %s has an invalid header", filePath.c_str());
+		return false;
+	}
+
+	// Files written with a different chunk size can't be decoded into this chunk layout
+	if (header.chunkSize != static_cast<uint16_t>(CHUNK_SIZE)) return false;
+
+	// A chunk can't take more than one run per block
+	if (header.payloadSize > BLOCKS_PER_CHUNK * RUN_SIZE_IN_BYTES) return false;
+
+	outChunkPosCS = ChunkCoord(header.x, header.y, header.z);
+	outCompressedData.resize(header.payloadSize);
+	file.read(reinterpret_cast<char*>(outCompressedData.data()), header.payloadSize);
+
+	return file.good();
+}
+
+uint64_t ChunkSerializer::GetFileSize(const std::vector<uint8_t>& compressedData)
+{
+	return sizeof(ChunkFileHeader) + compressedData.size();
+}
+
+std::string ChunkSerializer::GetFileName(const ChunkCoord& chunkPosCS)
+{
+	return std::to_string(chunkPosCS.x) + "_" + std::to_string(chunkPosCS.y) + "_" + std::to_string(chunkPosCS.z) + ".ogc";
+}
@@ -0,0 +1,47 @@
+#ifndef _CHUNKSERIALIZER_H
+#define _CHUNKSERIALIZER_H
+
+#include <string>
+#include <vector>
+
+#include "Chunk.h"
+
+// Converts a chunk's block data to and from a compact, run-length encoded
+// representation. The same payload is kept in memory by the ChunkResidencyManager's
+// cold tier and written to disk as-is, so the two never have to be converted
+class ChunkSerializer
+{
+public:
+
+	// "OGCH" in little-endian
+	static constexpr uint32_t CHUNK_FILE_MAGIC = 0x4843474F;
+	static constexpr uint16_t CHUNK_FILE_VERSION = 1;
+
+	// Encodes BLOCKS_PER_CHUNK block types laid out as [x][y][z]. The blocks are traversed
+	// column by column (Y innermost), since terrain mostly changes along the Y axis
+	static void Compress(const BlockType* blockTypes, std::vector<uint8_t>& outData);
+
+	// Returns false if the data is malformed or doesn't decode to exactly BLOCKS_PER_CHUNK blocks
+	static bool Decompress(const std::vector<uint8_t>& data, BlockType* outBlockTypes);
+
+	// Decodes only the runs up to the block at "localPos", for looking up a few blocks without decompressing the whole chunk.
+	// Returns false if the data is malformed or ends before the block
+	static bool GetBlockType(const std::vector<uint8_t>& data, const BlockCoord& localPos, BlockType& outType);
+
+	static bool WriteToFile(const std::string& filePath, const ChunkCoord& chunkPosCS, const std::vector<uint8_t>& compressedData);
+	static bool ReadFromFile(const std::string& filePath, ChunkCoord& outChunkPosCS, std::vector<uint8_t>& outCompressedData);
+
+	// Returns how many bytes WriteToFile() writes for the payload, header included
+	static uint64_t GetFileSize(const std::vector<uint8_t>& compressedData);
+
+	// Returns "<x>_<y>_<z>.ogc" for a position in CHUNK SPACE
+	static std::string GetFileName(const ChunkCoord& chunkPosCS);
+
+private:
+
+	// Every run is stored as one byte for the block type and two bytes for the length
+	static constexpr uint32_t RUN_SIZE_IN_BYTES = 3;
+
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "../Misc/pch.h"
 
 #include "Block.h"
+#include "BlockRegistry.h"
 #include "BlockUVs.h"
 #include "../Core/ShaderBufferManagers/ChunkBufferManager.h"
 #include "D3D.h"
@@ -78,7 +79,7 @@ namespace Orange
 
 	}
 
-	void DefaultBlockShader::Render(ID3D11ShaderResourceView* const* srvs)
+	void DefaultBlockShader::Render(ID3D11ShaderResourceView* const* srvs, const ChunkDrawList& drawList)
 	{
 		BlockShader_Data::debugVerts = 0;
 		BlockShader_Data::numDrawCalls = 0;
@@ -95,11 +96,14 @@ namespace Orange
 
 		BindVertexBuffers();
 
-		uint32_t size = static_cast<uint32_t>(ChunkBufferManager::GetVertexArray().size());
-		BlockShader_Data::debugVerts = size;
-		BlockShader_Data::numDrawCalls = 1;
+		const auto& ranges = drawList.GetRanges();
+		BlockShader_Data::debugVerts = static_cast<int>(drawList.GetNumInstances());
+		BlockShader_Data::numDrawCalls = static_cast<int>(ranges.size());
 
-		context->DrawInstanced(ARRAYSIZE(verts), size, 0, 0);
+		for (const auto& range : ranges)
+		{
+			context->DrawInstanced(ARRAYSIZE(verts), range.numInstances, 0, range.startInstance);
+		}
 	}
 
 	void DefaultBlockShader::Shutdown()
@@ -238,7 +242,7 @@ namespace Orange
 		uvBufferDesc.StructureByteStride = 0;
 
 		D3D11_SUBRESOURCE_DATA uvBufferData;
-		uvBufferData.pSysMem = uvs;
+		uvBufferData.pSysMem = BlockRegistry::GetUVTable();
 		uvBufferData.SysMemPitch = 0;
 		uvBufferData.SysMemSlicePitch = 0;
 
@@ -332,6 +336,8 @@ namespace Orange
 			{ "WORLDPOS", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
 			{ "BLOCKTYPE", 0, DXGI_FORMAT_R32_UINT, 1, 12, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
 			{ "BLOCKFACES", 0, DXGI_FORMAT_R32_UINT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "SKYLIGHT", 0, DXGI_FORMAT_R32_UINT, 1, 20, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "BLOCKLIGHT", 0, DXGI_FORMAT_R32_UINT, 1, 24, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
 		};
 
 		// Create the vertex input layout.
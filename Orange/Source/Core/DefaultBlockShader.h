@@ -34,7 +34,8 @@ namespace Orange
 
 		void Initialize(DirectX::XMMATRIX camViewMatrix);
 	
-		void Render(ID3D11ShaderResourceView* const* srvs);
+		// Draws every range in "drawList" with its own call, in the list's order
+		void Render(ID3D11ShaderResourceView* const* srvs, const ChunkDrawList& drawList);
 
 		void Shutdown();
 
@@ -1,9 +1,12 @@
 #include "../Misc/pch.h"
 
 #include "Application.h"
+#include "ChunkManager.h"
+#include "ChunkResidencyManager.h"
 #include "DefaultBlockShader.h"
 #include "EditorLayer.h"
 #include "../Utility/HeapOverrides.h"
+#include "../Utility/ImGuiDrawData.h"
 #include "../Utility/MathTypes.h"
 #include "Panels/MainViewportPanel.h"
 #include "UI/UIHelper.h"
@@ -124,6 +127,20 @@ void EditorLayer::Update(const float& dt)
 	UI::Checkbox(&tempTest, "Testing new checkbox! %i", (int)tempTest);
 	UI::Slider(&tempTest2, 0.0f, 1.0f, "Transparency", tempTest2);
 
+	static float renderDistance = static_cast<float>(ChunkManager::GetRenderDistance());
+	UI::Slider(&renderDistance, static_cast<float>(MIN_RENDER_DIST), static_cast<float>(MAX_RENDER_DIST), "Render distance: %i", static_cast<int32_t>(renderDistance));
+	ChunkManager::SetRenderDistance(static_cast<int32_t>(renderDistance));
+
+	static float chunkMemoryBudgetMB = static_cast<float>(ChunkResidencyManager::GetMemoryBudget()) / (1024.0f * 1024.0f);
+	UI::Slider(&chunkMemoryBudgetMB, 64.0f, 2048.0f, "Chunk memory budget: %.0f MB", chunkMemoryBudgetMB);
+	if (!ChunkResidencyManager::SetMemoryBudget(static_cast<uint64_t>(chunkMemoryBudgetMB) * 1024ull * 1024ull))
+	{
+		chunkMemoryBudgetMB = static_cast<float>(ChunkResidencyManager::GetMemoryBudget()) / (1024.0f * 1024.0f);
+	}
+	UI::Text("Chunk memory: %2.2f / %2.2f MB", ChunkResidency_Data::usedMemoryMB, ChunkResidency_Data::memoryBudgetMB);
+	UI::Text("Demoted chunks: %u, compressed: %u (%2.2f MB), on disk: %u (%2.2f MB)", ChunkResidency_Data::numDemotedChunks,
+		ChunkResidency_Data::numCompressedChunks, ChunkResidency_Data::compressedMemoryMB, ChunkResidency_Data::numChunksOnDisk, ChunkResidency_Data::diskUsageMB);
+
 
 	// TEST - DEBUG
 	/*uint32_t* data = (uint32_t*)globalTex.GetData();
@@ -83,8 +83,8 @@ namespace Orange
 	const AABB FrustumCulling::ConvertChunkPosToAABB(const XMFLOAT3 chunkPosWS)
 	{
 		AABB aabb;
-		aabb.center = { chunkPosWS.x + CHUNK_SIZE / 2.0f, chunkPosWS.y + CHUNK_SIZE / 2.0f, chunkPosWS.z + CHUNK_SIZE / 2.0f };
-		aabb.extent = { 8.0f, 8.0f, 8.0f };
+		aabb.center = { chunkPosWS.x + DefaultChunkTraits::HALF_EXTENT, chunkPosWS.y + DefaultChunkTraits::HALF_EXTENT, chunkPosWS.z + DefaultChunkTraits::HALF_EXTENT };
+		aabb.extent = { DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT, DefaultChunkTraits::HALF_EXTENT };
 		return aabb;
 	}
 
@@ -98,7 +98,7 @@ namespace Orange
 
 	int FrustumCulling::TestSphereAgainstPlane(const Sphere& sphere, const Plane& plane)
 	{
-		float sphereDist = XMVector3Dot(XMLoadFloat3(&sphere.center), XMLoadFloat3(&plane.normal)).m128_f32[0] - plane.point;
+		float sphereDist = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&sphere.center), XMLoadFloat3(&plane.normal))) - plane.point;
 
 		if (sphereDist > sphere.radius) return 1;
 		else if (sphereDist < -sphere.radius) return -1;
@@ -117,7 +117,7 @@ namespace Orange
 		XMStoreFloat3(&plane.normal, normal);
 
 		//The offset is the dot product between a triangle vertex and the normal
-		plane.point = XMVector3Dot(normal, b).m128_f32[0];
+		plane.point = XMVectorGetX(XMVector3Dot(normal, b));
 
 		return plane;
 	}
@@ -67,6 +67,7 @@ namespace Orange
 
 		// Returns TRUE is visible
 		// Returns FALSE is not visible
+		// Tests a single chunk, ChunkManager::CullChunks() tests every loaded chunk in batches
 		static bool CalculateChunkPosAgainstFrustum(const DirectX::XMFLOAT3 chunkPosWS);
 
 		static void CalculateFrustum(float FOV, float aspectRatio, float nearPlane, float farPlane, const DirectX::XMMATRIX& viewMatrix, const DirectX::XMFLOAT3& camPos);
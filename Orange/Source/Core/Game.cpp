@@ -26,9 +26,14 @@ namespace Orange
 
 	void Game::SetPrimaryPlayer(Player* player) { m_primaryPlayer = player; }
 
-	void Game::Update(const float dt)
+	void Game::Tick(const float dt)
+	{
+		m_primaryPlayer->Tick(dt);
+	}
+
+	void Game::Update(const float dt, const float interpolationAlpha)
 	{
 		// Update the primary player
-		m_primaryPlayer->Update(dt);
+		m_primaryPlayer->Update(dt, interpolationAlpha);
 	}
 }
\ No newline at end of file
@@ -21,7 +21,12 @@ namespace Orange
 
 		static void SetPrimaryPlayer(Player* player);
 
-		static void Update(const float dt);
+		// Simulates one fixed tick of "dt" seconds (see FixedTimestep)
+		static void Tick(const float dt);
+
+		// Called once a frame, after the frame's ticks. "interpolationAlpha" is how far the frame is between the
+		// last tick and the next, which is where things are drawn
+		static void Update(const float dt, const float interpolationAlpha);
 
 	private:
 
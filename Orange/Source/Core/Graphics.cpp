@@ -95,11 +95,14 @@ namespace Orange
 
 		m_texViewer = OG_NEW TextureViewer(nullptr, 5, 5, 0.15f);
 
+		m_occlusionCuller.Start();
+
 		return true;
 	}
 
 	void Graphics::Shutdown()
 	{
+		m_occlusionCuller.Stop();
 		ChunkManager::Shutdown();
 		ChunkBufferManager::Shutdown();
 		QuadBufferManager::Shutdown();
@@ -169,16 +172,49 @@ namespace Orange
 		Crosshair::Update(dt);
 
 		FrustumCulling::CalculateFrustum(XM_PIDIV4, (float)m_screenWidth / m_screenHeight, 
-			SCREEN_NEAR, SCREEN_FAR, player->GetCamera(CameraType::FirstPerson)->GetWorldMatrix(), player->GetPosition());
+			SCREEN_NEAR, SCREEN_FAR, player->GetCamera(CameraType::FirstPerson)->GetWorldMatrix(), player->GetRenderPosition());
+
+		{
+			OG_PROFILE_SCOPE("[UPDATE] Frustum Culling");
+			// Until the camera's chunk is loaded, there's nothing to start the visibility search from
+			const Frustum frustum = FrustumCulling::GetFrustum();
+			const bool foundVisibleChunks = BlockShader_Data::enableConnectivityCulling &&
+				ChunkManager::FindVisibleChunks(player->GetRenderPosition(), frustum.planes.data(), m_visibleChunks);
+			if (!foundVisibleChunks) ChunkManager::CullChunks(frustum.planes.data(), m_visibleChunks);
+
+			// Occlusion culling runs a frame behind. This frame's chunks are tested on the worker while the
+			// chunks the last frame's test found hidden are taken out
+			BlockShader_Data::numOccludedChunks = 0;
+			if (BlockShader_Data::enableOcclusionCulling)
+			{
+				const XMMATRIX cameraWorld = player->GetCamera(CameraType::FirstPerson)->GetWorldMatrix();
+				OcclusionView occlusionView;
+				occlusionView.position = player->GetRenderPosition();
+				XMStoreFloat3(&occlusionView.right, cameraWorld.r[0]);
+				XMStoreFloat3(&occlusionView.up, cameraWorld.r[1]);
+				XMStoreFloat3(&occlusionView.forward, cameraWorld.r[2]);
+				occlusionView.tanHalfFov = tanf(XM_PIDIV4 / 2.0f);
+				occlusionView.aspectRatio = (float)m_screenWidth / m_screenHeight;
+
+				ChunkManager::GetOccluders(m_visibleChunks, m_occluders);
+				m_occlusionCuller.Submit(occlusionView, m_occluders, m_visibleChunks);
+				BlockShader_Data::numOccludedChunks = static_cast<int>(m_occlusionCuller.RemoveHiddenChunks(m_visibleChunks));
+			}
+			BlockShader_Data::numVisibleChunks = static_cast<int>(m_visibleChunks.size());
+		}
 
 
 		// Update the position for the updater thread
 		ChunkManager::SetPlayerPos(player->GetPosition());
 
+		// The game's done with its chunks for this frame, so whatever pools the updater thread replaced can go
+		ChunkManager::ReleaseRetiredChunks();
+
 		{
 			OG_PROFILE_SCOPE("[UPDATE] Chunk Buffer Update");
-			// Update the vertices
-			ChunkBufferManager::UpdateBuffers();
+			// Upload the vertices. Only the visible chunks are drawn, unless culling is turned off, in which case it's everything that was uploaded
+			const std::vector<ChunkCoord>* chunksToDraw = BlockShader_Data::enableFrustumCulling ? &m_visibleChunks : nullptr;
+			ChunkManager::UploadDrawList(chunksToDraw, player->GetRenderPosition(), m_drawList);
 		}
 
 		// Update the day/night cycle
@@ -215,7 +251,7 @@ namespace Orange
 				OG_PROFILE_SCOPE("[RENDER] Chunk");
 				// Send the chunks to the shader and render
 				m_chunkShader->UpdateViewMatrices(player->GetCamera(player->GetSelectedCameraType())->GetViewMatrix(), XMMatrixIdentity());
-				m_chunkShader->Render(srvs);
+				m_chunkShader->Render(srvs, m_drawList);
 			}
 
 			{
@@ -249,7 +285,7 @@ namespace Orange
 		}
 
 		Renderer_Data::playerPos = player->GetPosition();
-		Renderer_Data::playerPosChunkSpace = Orange::Math::WorldToChunkSpace(player->GetPosition());
+		Renderer_Data::playerPosChunkSpace = Orange::Math::WorldToChunkSpace(player->GetPosition()).ToFloat3();
 		Renderer_Data::numActiveChunks = ChunkManager::GetNumActiveChunks();
 
 		//D3D::ClearDepthBuffer(1.0f); // Clear the depth buffer so GUI draws on top of everything
@@ -13,6 +13,9 @@
 #include "DayNightCycle.h"
 
 #include "Player.h"
+#include "ChunkCoord.h"
+#include "ChunkDrawList.h"
+#include "OcclusionCuller.h"
 
 // idk why it makes me include this here..again
 #include <windows.h>
@@ -61,6 +64,14 @@ namespace Orange
 
 		TextureViewer* m_texViewer = nullptr;
 
+		// Chunks inside the player's frustum this frame, kept around so that its memory is reused
+		std::vector<ChunkCoord> m_visibleChunks;
+		std::vector<ChunkCoord> m_occluders;
+
+		OcclusionCuller m_occlusionCuller;
+
+		ChunkDrawList m_drawList;
+
 		// Temporary
 		int m_screenWidth, m_screenHeight;
 	};
@@ -0,0 +1,475 @@
+#include "../Misc/pch.h"
+
+#include <algorithm>
+
+#include "LightEngine.h"
+#include "BlockRegistry.h"
+#include "ChunkLayout.h"
+
+// A block whose light is being taken away, along with the level it had
+struct LightRemoval
+{
+	BlockCoord posBS;
+	uint8_t level;
+};
+
+// Only one thread ever propagates light through the world (see LightEngine), so the queues are shared to keep their memory around
+static std::vector<BlockCoord> g_addQueue;
+static std::vector<LightRemoval> g_removeQueue;
+
+// Offset of every neighbor in BLOCK SPACE, indexed by ChunkNeighbor
+static const BlockCoord BLOCK_NEIGHBOR_OFFSETS[NUM_CHUNK_NEIGHBORS] =
+{
+	BlockCoord(-1, 0, 0), BlockCoord(1, 0, 0),
+	BlockCoord(0, -1, 0), BlockCoord(0, 1, 0),
+	BlockCoord(0, 0, -1), BlockCoord(0, 0, 1)
+};
+
+// Returns the level light has after moving one block, downwards or not
+static inline uint8_t GetPropagatedLevel(const uint8_t level, const LightChannel channel, const bool isDownwards)
+{
+	if (channel == LightChannel::SKY && isDownwards && level == MAX_LIGHT_LEVEL) return MAX_LIGHT_LEVEL;
+	return level > 0 ? level - 1 : 0;
+}
+
+// Returns the local coordinates of the two blocks that face each other across a chunk's face, "a" and "b"
+// going over the face. "outOwn" is inside the chunk and "outNeighbor" inside the neighbor in that direction
+static void GetFacingBlocks(const ChunkNeighbor face, const int32_t a, const int32_t b, BlockCoord& outOwn, BlockCoord& outNeighbor)
+{
+	constexpr int32_t last = CHUNK_SIZE - 1;
+	switch (face)
+	{
+	case ChunkNeighbor::LEFT:	outOwn = BlockCoord(0, a, b);		outNeighbor = BlockCoord(last, a, b);	break;
+	case ChunkNeighbor::RIGHT:	outOwn = BlockCoord(last, a, b);	outNeighbor = BlockCoord(0, a, b);		break;
+	case ChunkNeighbor::BOTTOM:	outOwn = BlockCoord(a, 0, b);		outNeighbor = BlockCoord(a, last, b);	break;
+	case ChunkNeighbor::TOP:	outOwn = BlockCoord(a, last, b);	outNeighbor = BlockCoord(a, 0, b);		break;
+	case ChunkNeighbor::FRONT:	outOwn = BlockCoord(a, b, 0);		outNeighbor = BlockCoord(a, b, last);	break;
+	case ChunkNeighbor::BACK:	outOwn = BlockCoord(a, b, last);	outNeighbor = BlockCoord(a, b, 0);		break;
+	}
+}
+
+static inline uint32_t GetLayoutIndex(const BlockCoord& localPos) { return ChunkBlockLayout::GetIndex(localPos.x, localPos.y, localPos.z); }
+
+// Looks blocks up through the world, remembering the last chunk since light mostly travels within one
+class LightWorldCursor
+{
+public:
+
+	LightWorldCursor(LightWorld& world) : m_world(world), m_chunkPosCS(), m_view(), m_isValid(false), m_isLoaded(false) {}
+
+	// Returns false if the block's chunk isn't loaded
+	bool Find(const BlockCoord& posBS, LightChunkView& outView, uint32_t& outIndex)
+	{
+		const ChunkCoord chunkPosCS = Orange::Math::BlockToChunkCoord(posBS);
+		if (!m_isValid || chunkPosCS != m_chunkPosCS)
+		{
+			m_chunkPosCS = chunkPosCS;
+			m_isLoaded = m_world.GetChunk(chunkPosCS, m_view);
+			m_isValid = true;
+		}
+
+		if (!m_isLoaded) return false;
+
+		outView = m_view;
+		outIndex = GetLayoutIndex(Orange::Math::BlockToLocalCoord(posBS));
+		return true;
+	}
+
+private:
+
+	LightWorld& m_world;
+	ChunkCoord m_chunkPosCS;
+	LightChunkView m_view;
+	bool m_isValid;
+	bool m_isLoaded;
+};
+
+// Adds the block's chunk, and the neighbors that mesh the faces bordering it, to the changed chunks
+static void MarkChanged(const BlockCoord& posBS, std::vector<ChunkCoord>& outChangedChunks)
+{
+	const ChunkCoord chunkPosCS = Orange::Math::BlockToChunkCoord(posBS);
+	const BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+
+	// Light changes come in runs within the same chunk, so only repeats of the last chunk are filtered out
+	auto add = [&](const ChunkCoord& changedCS)
+	{
+		if (outChangedChunks.empty() || outChangedChunks.back() != changedCS) outChangedChunks.push_back(changedCS);
+	};
+
+	add(chunkPosCS);
+	if (localPos.x == 0)				add(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::LEFT)]);
+	if (localPos.x == CHUNK_SIZE - 1)	add(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::RIGHT)]);
+	if (localPos.y == 0)				add(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::BOTTOM)]);
+	if (localPos.y == CHUNK_SIZE - 1)	add(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::TOP)]);
+	if (localPos.z == 0)				add(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::FRONT)]);
+	if (localPos.z == CHUNK_SIZE - 1)	add(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::BACK)]);
+}
+
+// Returns the level the block has on its own. Sky light starts at the top of every chunk without a loaded chunk above it
+static uint8_t GetSourceLevel(LightWorld& world, const BlockCoord& posBS, const BlockType type, const LightChannel channel)
+{
+	if (channel == LightChannel::BLOCK) return BlockRegistry::GetLightEmission(type);
+
+	if (BlockRegistry::IsOpaque(type) || Orange::Math::BlockToLocalCoord(posBS).y != CHUNK_SIZE - 1) return 0;
+
+	LightChunkView above;
+	return world.GetChunk(Orange::Math::BlockToChunkCoord(posBS) + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::TOP)], above) ? 0 : MAX_LIGHT_LEVEL;
+}
+
+// Takes the block's light away (down to what it emits on its own) and queues the removal for its neighbors
+static void ClearLevel(LightWorld& world, const BlockCoord& posBS, const LightChunkView& view, const uint32_t index, const LightChannel channel, std::vector<ChunkCoord>& outChangedChunks)
+{
+	const uint8_t level = LightEngine::GetLevel(view.light[index], channel);
+	const uint8_t sourceLevel = GetSourceLevel(world, posBS, view.blocks[index].GetType(), channel);
+
+	view.light[index] = LightEngine::SetLevel(view.light[index], channel, sourceLevel);
+	if (sourceLevel > 0) g_addQueue.push_back(posBS);
+
+	g_removeQueue.push_back({ posBS, level });
+	MarkChanged(posBS, outChangedChunks);
+}
+
+// Spreads the light of every block in the add queue to its neighbors, and theirs, until it stops getting brighter
+static void PropagateAdd(LightWorld& world, const LightChannel channel, std::vector<ChunkCoord>& outChangedChunks)
+{
+	LightWorldCursor cursor(world);
+	for (size_t head = 0; head < g_addQueue.size(); head++)
+	{
+		const BlockCoord posBS = g_addQueue[head];
+
+		LightChunkView view;
+		uint32_t index;
+		if (!cursor.Find(posBS, view, index)) continue;
+
+		const uint8_t level = LightEngine::GetLevel(view.light[index], channel);
+		if (level == 0) continue;
+
+		for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+		{
+			const BlockCoord neighborPosBS = posBS + BLOCK_NEIGHBOR_OFFSETS[i];
+
+			LightChunkView neighborView;
+			uint32_t neighborIndex;
+			if (!cursor.Find(neighborPosBS, neighborView, neighborIndex)) continue;
+			if (BlockRegistry::IsOpaque(neighborView.blocks[neighborIndex].GetType())) continue;
+
+			const uint8_t propagatedLevel = GetPropagatedLevel(level, channel, i == static_cast<uint32_t>(ChunkNeighbor::BOTTOM));
+			if (LightEngine::GetLevel(neighborView.light[neighborIndex], channel) >= propagatedLevel) continue;
+
+			neighborView.light[neighborIndex] = LightEngine::SetLevel(neighborView.light[neighborIndex], channel, propagatedLevel);
+			g_addQueue.push_back(neighborPosBS);
+			MarkChanged(neighborPosBS, outChangedChunks);
+		}
+	}
+
+	g_addQueue.clear();
+}
+
+// Takes away the light that may have come from the blocks in the remove queue. Neighbors that are at least as
+// bright as the removed block got their light from somewhere else, they're queued to fill the gap back in
+static void PropagateRemove(LightWorld& world, const LightChannel channel, std::vector<ChunkCoord>& outChangedChunks)
+{
+	LightWorldCursor cursor(world);
+	for (size_t head = 0; head < g_removeQueue.size(); head++)
+	{
+		const LightRemoval removal = g_removeQueue[head];
+
+		for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+		{
+			const BlockCoord neighborPosBS = removal.posBS + BLOCK_NEIGHBOR_OFFSETS[i];
+
+			LightChunkView neighborView;
+			uint32_t neighborIndex;
+			if (!cursor.Find(neighborPosBS, neighborView, neighborIndex)) continue;
+
+			const uint8_t level = LightEngine::GetLevel(neighborView.light[neighborIndex], channel);
+			if (level == 0) continue;
+
+			const bool isDownwards = i == static_cast<uint32_t>(ChunkNeighbor::BOTTOM);
+			if (level < removal.level || (isDownwards && GetPropagatedLevel(removal.level, channel, true) == level))
+			{
+				ClearLevel(world, neighborPosBS, neighborView, neighborIndex, channel, outChangedChunks);
+			}
+			else
+			{
+				g_addQueue.push_back(neighborPosBS);
+			}
+		}
+	}
+
+	g_removeQueue.clear();
+}
+
+// Removes whatever is in the remove queue, then fills the gaps (and anything else in the add queue) back in
+static void Relight(LightWorld& world, const LightChannel channel, std::vector<ChunkCoord>& outChangedChunks)
+{
+	PropagateRemove(world, channel, outChangedChunks);
+	PropagateAdd(world, channel, outChangedChunks);
+}
+
+template<int32_t Size>
+void LightEngine::ComputeChunkLight(const BlockType* blockTypes, uint8_t* outLight)
+{
+	using Traits = ChunkTraits<Size>;
+
+	constexpr uint32_t X_STRIDE = Size * Size;
+	constexpr uint32_t Y_STRIDE = Size;
+	constexpr uint32_t Z_STRIDE = 1;
+	constexpr uint8_t SKY_LIT = MAX_LIGHT_LEVEL << static_cast<uint8_t>(LightChannel::SKY);
+
+	std::fill(outLight, outLight + Traits::VOLUME, static_cast<uint8_t>(0));
+
+	// 1. Sky light falls down every column until it hits an opaque block
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t z = 0; z < Size; z++)
+		{
+			for (int32_t y = Size - 1; y >= 0; y--)
+			{
+				const uint32_t index = Traits::GetIndex(x, y, z);
+				if (BlockRegistry::IsOpaque(blockTypes[index])) break;
+				outLight[index] = SKY_LIT;
+			}
+		}
+	}
+
+	std::vector<uint32_t> queue;
+
+	// 2. Lit columns only spread sideways where they border a darker block that light can get into, everywhere
+	// else their neighbors are lit columns as well. Emitters spread their light no matter what
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t y = 0; y < Size; y++)
+		{
+			for (int32_t z = 0; z < Size; z++)
+			{
+				const uint32_t index = Traits::GetIndex(x, y, z);
+
+				const uint8_t emission = BlockRegistry::GetLightEmission(blockTypes[index]);
+				if (emission > 0) outLight[index] = SetLevel(outLight[index], LightChannel::BLOCK, emission);
+
+				bool bordersDarkness = false;
+				if (outLight[index] >= SKY_LIT)
+				{
+					auto isDark = [&](const uint32_t neighborIndex) { return outLight[neighborIndex] < SKY_LIT && !BlockRegistry::IsOpaque(blockTypes[neighborIndex]); };
+					bordersDarkness =
+						(x > 0 && isDark(index - X_STRIDE)) || (x < Size - 1 && isDark(index + X_STRIDE)) ||
+						(z > 0 && isDark(index - Z_STRIDE)) || (z < Size - 1 && isDark(index + Z_STRIDE));
+				}
+
+				if (emission > 0 || bordersDarkness) queue.push_back(index);
+			}
+		}
+	}
+
+	// 3. Flood fill both channels at once. Blocks are queued again whenever they get brighter, so the
+	// order in which the sky and the emitters reach a block doesn't matter
+	for (size_t head = 0; head < queue.size(); head++)
+	{
+		const uint32_t index = queue[head];
+		const int32_t x = static_cast<int32_t>(index >> (2 * Traits::SHIFT));
+		const int32_t y = static_cast<int32_t>((index >> Traits::SHIFT) & Traits::MASK);
+		const int32_t z = static_cast<int32_t>(index & Traits::MASK);
+
+		const uint8_t skyLevel = GetLevel(outLight[index], LightChannel::SKY);
+		const uint8_t blockLevel = GetLevel(outLight[index], LightChannel::BLOCK);
+
+		auto spreadTo = [&](const uint32_t neighborIndex, const bool isDownwards)
+		{
+			if (BlockRegistry::IsOpaque(blockTypes[neighborIndex])) return;
+
+			const uint8_t neighborLight = outLight[neighborIndex];
+			const uint8_t neighborSkyLevel = max(GetLevel(neighborLight, LightChannel::SKY), GetPropagatedLevel(skyLevel, LightChannel::SKY, isDownwards));
+			const uint8_t neighborBlockLevel = max(GetLevel(neighborLight, LightChannel::BLOCK), GetPropagatedLevel(blockLevel, LightChannel::BLOCK, isDownwards));
+			const uint8_t newLight = SetLevel(SetLevel(0, LightChannel::SKY, neighborSkyLevel), LightChannel::BLOCK, neighborBlockLevel);
+			if (newLight == neighborLight) return;
+
+			outLight[neighborIndex] = newLight;
+			queue.push_back(neighborIndex);
+		};
+
+		if (x > 0)			spreadTo(index - X_STRIDE, false);
+		if (x < Size - 1)	spreadTo(index + X_STRIDE, false);
+		if (y > 0)			spreadTo(index - Y_STRIDE, true);
+		if (y < Size - 1)	spreadTo(index + Y_STRIDE, false);
+		if (z > 0)			spreadTo(index - Z_STRIDE, false);
+		if (z < Size - 1)	spreadTo(index + Z_STRIDE, false);
+	}
+}
+
+void LightEngine::StitchChunk(LightWorld& world, const ChunkCoord& chunkPosCS, std::vector<ChunkCoord>& outChangedChunks)
+{
+	LightChunkView chunk;
+	if (!world.GetChunk(chunkPosCS, chunk)) return;
+
+	const BlockCoord minBS = Orange::Math::ChunkToBlockCoord(chunkPosCS);
+	const BlockCoord localTop(0, CHUNK_SIZE - 1, 0);
+
+	// 1. The chunk was lit as if it was open to the sky. A full strength sky column is only right if the chunk above continues it
+	LightChunkView above;
+	if (world.GetChunk(chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::TOP)], above))
+	{
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
+			{
+				const uint32_t index = GetLayoutIndex(BlockCoord(x, CHUNK_SIZE - 1, z));
+				const uint32_t aboveIndex = GetLayoutIndex(BlockCoord(x, 0, z));
+				if (GetLevel(chunk.light[index], LightChannel::SKY) == MAX_LIGHT_LEVEL && GetLevel(above.light[aboveIndex], LightChannel::SKY) != MAX_LIGHT_LEVEL)
+				{
+					ClearLevel(world, minBS + localTop + BlockCoord(x, 0, z), chunk, index, LightChannel::SKY, outChangedChunks);
+				}
+			}
+		}
+
+		Relight(world, LightChannel::SKY, outChangedChunks);
+	}
+
+	// 2. The same goes for the chunk below, which was open to the sky until now
+	LightChunkView below;
+	const ChunkCoord belowPosCS = chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::BOTTOM)];
+	if (world.GetChunk(belowPosCS, below))
+	{
+		const BlockCoord belowMinBS = Orange::Math::ChunkToBlockCoord(belowPosCS);
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
+			{
+				const uint32_t belowIndex = GetLayoutIndex(BlockCoord(x, CHUNK_SIZE - 1, z));
+				const uint32_t index = GetLayoutIndex(BlockCoord(x, 0, z));
+				if (GetLevel(below.light[belowIndex], LightChannel::SKY) == MAX_LIGHT_LEVEL && GetLevel(chunk.light[index], LightChannel::SKY) != MAX_LIGHT_LEVEL)
+				{
+					ClearLevel(world, belowMinBS + localTop + BlockCoord(x, 0, z), below, belowIndex, LightChannel::SKY, outChangedChunks);
+				}
+			}
+		}
+
+		Relight(world, LightChannel::SKY, outChangedChunks);
+	}
+
+	// 3. Light flows across every face with a loaded chunk on the other side, in both directions
+	const LightChannel channels[] = { LightChannel::SKY, LightChannel::BLOCK };
+	for (const LightChannel channel : channels)
+	{
+		for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+		{
+			const ChunkNeighbor face = static_cast<ChunkNeighbor>(i);
+			const ChunkCoord neighborPosCS = chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[i];
+
+			LightChunkView neighbor;
+			if (!world.GetChunk(neighborPosCS, neighbor)) continue;
+
+			const BlockCoord neighborMinBS = Orange::Math::ChunkToBlockCoord(neighborPosCS);
+			for (int32_t a = 0; a < CHUNK_SIZE; a++)
+			{
+				for (int32_t b = 0; b < CHUNK_SIZE; b++)
+				{
+					BlockCoord ownPos, neighborPos;
+					GetFacingBlocks(face, a, b, ownPos, neighborPos);
+
+					const uint32_t ownIndex = GetLayoutIndex(ownPos);
+					const uint32_t neighborIndex = GetLayoutIndex(neighborPos);
+					const uint8_t ownLevel = GetLevel(chunk.light[ownIndex], channel);
+					const uint8_t neighborLevel = GetLevel(neighbor.light[neighborIndex], channel);
+
+					if (!BlockRegistry::IsOpaque(neighbor.blocks[neighborIndex].GetType()) && GetPropagatedLevel(ownLevel, channel, face == ChunkNeighbor::BOTTOM) > neighborLevel)
+					{
+						g_addQueue.push_back(minBS + ownPos);
+					}
+					else if (!BlockRegistry::IsOpaque(chunk.blocks[ownIndex].GetType()) && GetPropagatedLevel(neighborLevel, channel, face == ChunkNeighbor::TOP) > ownLevel)
+					{
+						g_addQueue.push_back(neighborMinBS + neighborPos);
+					}
+				}
+			}
+		}
+
+		PropagateAdd(world, channel, outChangedChunks);
+	}
+}
+
+void LightEngine::RemoveChunk(LightWorld& world, const ChunkCoord& chunkPosCS, const LightChunkView& unloaded, std::vector<ChunkCoord>& outChangedChunks)
+{
+	const LightChannel channels[] = { LightChannel::SKY, LightChannel::BLOCK };
+	for (const LightChannel channel : channels)
+	{
+		// 1. Every block across the faces that may have gotten its light from the unloaded chunk loses it
+		for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++)
+		{
+			const ChunkNeighbor face = static_cast<ChunkNeighbor>(i);
+			const ChunkCoord neighborPosCS = chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[i];
+
+			LightChunkView neighbor;
+			if (!world.GetChunk(neighborPosCS, neighbor)) continue;
+
+			const BlockCoord neighborMinBS = Orange::Math::ChunkToBlockCoord(neighborPosCS);
+			for (int32_t a = 0; a < CHUNK_SIZE; a++)
+			{
+				for (int32_t b = 0; b < CHUNK_SIZE; b++)
+				{
+					BlockCoord unloadedPos, neighborPos;
+					GetFacingBlocks(face, a, b, unloadedPos, neighborPos);
+
+					const uint32_t neighborIndex = GetLayoutIndex(neighborPos);
+					const uint8_t unloadedLevel = GetLevel(unloaded.light[GetLayoutIndex(unloadedPos)], channel);
+					const uint8_t neighborLevel = GetLevel(neighbor.light[neighborIndex], channel);
+					if (neighborLevel == 0) continue;
+
+					if (neighborLevel < unloadedLevel || (face == ChunkNeighbor::BOTTOM && GetPropagatedLevel(unloadedLevel, channel, true) == neighborLevel))
+					{
+						ClearLevel(world, neighborMinBS + neighborPos, neighbor, neighborIndex, channel, outChangedChunks);
+					}
+				}
+			}
+		}
+
+		PropagateRemove(world, channel, outChangedChunks);
+
+		// 2. Nothing is above the chunk below anymore, so its top is open to the sky
+		LightChunkView below;
+		const ChunkCoord belowPosCS = chunkPosCS + CHUNK_NEIGHBOR_OFFSETS[static_cast<uint8_t>(ChunkNeighbor::BOTTOM)];
+		if (channel == LightChannel::SKY && world.GetChunk(belowPosCS, below))
+		{
+			const BlockCoord belowMinBS = Orange::Math::ChunkToBlockCoord(belowPosCS);
+			for (int32_t x = 0; x < CHUNK_SIZE; x++)
+			{
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				{
+					const BlockCoord localPos(x, CHUNK_SIZE - 1, z);
+					const uint32_t index = GetLayoutIndex(localPos);
+					if (BlockRegistry::IsOpaque(below.blocks[index].GetType()) || GetLevel(below.light[index], LightChannel::SKY) == MAX_LIGHT_LEVEL) continue;
+
+					below.light[index] = SetLevel(below.light[index], LightChannel::SKY, MAX_LIGHT_LEVEL);
+					g_addQueue.push_back(belowMinBS + localPos);
+					MarkChanged(belowMinBS + localPos, outChangedChunks);
+				}
+			}
+		}
+
+		PropagateAdd(world, channel, outChangedChunks);
+	}
+}
+
+void LightEngine::UpdateBlock(LightWorld& world, const BlockCoord& posBS, std::vector<ChunkCoord>& outChangedChunks)
+{
+	LightChunkView view;
+	if (!world.GetChunk(Orange::Math::BlockToChunkCoord(posBS), view)) return;
+
+	const uint32_t index = GetLayoutIndex(Orange::Math::BlockToLocalCoord(posBS));
+
+	const LightChannel channels[] = { LightChannel::SKY, LightChannel::BLOCK };
+	for (const LightChannel channel : channels)
+	{
+		// Whatever the block had before, its light starts over from what it emits on its own...
+		ClearLevel(world, posBS, view, index, channel, outChangedChunks);
+
+		// ...and whatever its neighbors still have after the removal, if the block lets light through now
+		for (uint32_t i = 0; i < NUM_CHUNK_NEIGHBORS; i++) g_addQueue.push_back(posBS + BLOCK_NEIGHBOR_OFFSETS[i]);
+
+		Relight(world, channel, outChangedChunks);
+	}
+}
+
+template void LightEngine::ComputeChunkLight<16>(const BlockType*, uint8_t*);
+template void LightEngine::ComputeChunkLight<32>(const BlockType*, uint8_t*);
+template void LightEngine::ComputeChunkLight<64>(const BlockType*, uint8_t*);
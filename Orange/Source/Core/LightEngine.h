@@ -0,0 +1,74 @@
+#ifndef _LIGHTENGINE_H
+#define _LIGHTENGINE_H
+
+#include <vector>
+
+#include "Block.h"
+#include "ChunkCoord.h"
+
+// Light levels go from 0 (dark) to MAX_LIGHT_LEVEL and lose one level per block they travel, except for
+// sky light at full strength, which goes straight down without losing any. Opaque blocks stop light
+constexpr uint8_t MAX_LIGHT_LEVEL = 15;
+
+// Every block's light is packed into a byte, sky light in the high nibble and block light in the low one
+enum class LightChannel : uint8_t
+{
+	SKY = 4,
+	BLOCK = 0
+};
+
+// A loaded chunk as the light engine sees it. Both arrays hold BLOCKS_PER_CHUNK elements, laid out as ChunkBlockLayout says
+struct LightChunkView
+{
+	const Block* blocks;
+	uint8_t* light;
+};
+
+// The chunks the light engine propagates light through. Light only ever travels between loaded chunks
+class LightWorld
+{
+public:
+
+	virtual ~LightWorld() = default;
+
+	// Returns false if the chunk isn't loaded
+	virtual bool GetChunk(const ChunkCoord& chunkPosCS, LightChunkView& outView) = 0;
+
+};
+
+// Computes sky light and block light (from the emission in BlockRegistry) per block with BFS flood fills.
+// Chunks are lit on their own when they're generated, then stitched into the world once they're loaded,
+// and every change after that (loading, unloading, editing blocks) only touches the blocks whose light
+// actually changes. The light is kept with the chunk's blocks and meshed with them, so it costs nothing per frame.
+//
+// Chunks without a loaded chunk above them are lit as if they were open to the sky. Everything but
+// ComputeChunkLight() works on shared chunks, so it must only ever be called from one thread at a time
+class LightEngine
+{
+public:
+
+	static inline uint8_t GetLevel(const uint8_t light, const LightChannel channel) { return (light >> static_cast<uint8_t>(channel)) & 0x0F; }
+	static inline uint8_t SetLevel(const uint8_t light, const LightChannel channel, const uint8_t level)
+	{
+		const uint8_t shift = static_cast<uint8_t>(channel);
+		return static_cast<uint8_t>((light & ~(0x0F << shift)) | (level << shift));
+	}
+
+	// Lights a chunk on its own, as if it had open sky above it and darkness on every other side. Both arrays
+	// are laid out as [x][y][z]. Only reads the arrays it's given, so any thread can light any chunk
+	template<int32_t Size>
+	static void ComputeChunkLight(const BlockType* blockTypes, uint8_t* outLight);
+
+	// Propagates light between a newly loaded chunk, which was lit through ComputeChunkLight(), and its loaded neighbors
+	static void StitchChunk(LightWorld& world, const ChunkCoord& chunkPosCS, std::vector<ChunkCoord>& outChangedChunks);
+
+	// Takes the light that came from "unloaded" out of its neighbors. The chunk must not be in "world" anymore,
+	// but its view still has to be valid. The chunk below it (if any) is open to the sky from now on
+	static void RemoveChunk(LightWorld& world, const ChunkCoord& chunkPosCS, const LightChunkView& unloaded, std::vector<ChunkCoord>& outChangedChunks);
+
+	// Relights everything around a block that changed type. Must be called after the block changed
+	static void UpdateBlock(LightWorld& world, const BlockCoord& posBS, std::vector<ChunkCoord>& outChangedChunks);
+
+};
+
+#endif
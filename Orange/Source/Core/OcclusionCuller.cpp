@@ -0,0 +1,425 @@
+#include "../Misc/pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "OcclusionCuller.h"
+#include "BlockRegistry.h"
+#include "../Utility/SimdBatch.h"
+
+using namespace Orange::Simd;
+
+// Occluders are clipped against it, and boxes crossing it are always visible. In WORLD SPACE
+constexpr float OCCLUSION_NEAR_PLANE = 0.1f;
+
+// Boxes are tested as if they were this much closer, so that a box facing the camera isn't hidden by its own faces
+constexpr float OCCLUSION_DEPTH_BIAS = 1.001f;
+
+// How far outside a triangle's edges a pixel center can be and still be drawn. In PIXELS
+constexpr float OCCLUSION_EDGE_BIAS = 1.0f / 256.0f;
+
+constexpr uint32_t NUM_TILES_X = OCCLUSION_BUFFER_WIDTH / OCCLUSION_TILE_SIZE;
+constexpr uint32_t NUM_TILES_Y = OCCLUSION_BUFFER_HEIGHT / OCCLUSION_TILE_SIZE;
+
+static_assert(OCCLUSION_BUFFER_WIDTH % BATCH_SIZE == 0, "Rows have to be made up of whole batches");
+static_assert(OCCLUSION_BUFFER_WIDTH % OCCLUSION_TILE_SIZE == 0 && OCCLUSION_BUFFER_HEIGHT % OCCLUSION_TILE_SIZE == 0, "The buffer has to be made up of whole tiles");
+
+static inline float Dot(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// Returns the pixel that contains "coord", clamped to the buffer
+static inline int32_t ToPixel(const float coord, const uint32_t size)
+{
+	return static_cast<int32_t>(floorf(min(max(coord, 0.0f), static_cast<float>(size - 1))));
+}
+
+OcclusionRasterizer::OcclusionRasterizer() : m_view(), m_depth(OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT, 0.0f), m_tileDepth(NUM_TILES_X * NUM_TILES_Y, 0.0f)
+{
+}
+
+void OcclusionRasterizer::Begin(const OcclusionView& view)
+{
+	m_view = view;
+	std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+}
+
+void OcclusionRasterizer::DrawOccluder(const DirectX::XMFLOAT3& minWS, const DirectX::XMFLOAT3& maxWS)
+{
+	const DirectX::XMFLOAT3& cameraPos = m_view.position;
+	DirectX::XMFLOAT3 cornersVS[4];
+
+	// Only the faces on the camera's side of the box can be seen, which is at most one per axis
+	if (cameraPos.x < minWS.x || cameraPos.x > maxWS.x)
+	{
+		const float x = cameraPos.x < minWS.x ? minWS.x : maxWS.x;
+		cornersVS[0] = ToViewSpace({ x, minWS.y, minWS.z });
+		cornersVS[1] = ToViewSpace({ x, maxWS.y, minWS.z });
+		cornersVS[2] = ToViewSpace({ x, maxWS.y, maxWS.z });
+		cornersVS[3] = ToViewSpace({ x, minWS.y, maxWS.z });
+		DrawQuad(cornersVS);
+	}
+
+	if (cameraPos.y < minWS.y || cameraPos.y > maxWS.y)
+	{
+		const float y = cameraPos.y < minWS.y ? minWS.y : maxWS.y;
+		cornersVS[0] = ToViewSpace({ minWS.x, y, minWS.z });
+		cornersVS[1] = ToViewSpace({ maxWS.x, y, minWS.z });
+		cornersVS[2] = ToViewSpace({ maxWS.x, y, maxWS.z });
+		cornersVS[3] = ToViewSpace({ minWS.x, y, maxWS.z });
+		DrawQuad(cornersVS);
+	}
+
+	if (cameraPos.z < minWS.z || cameraPos.z > maxWS.z)
+	{
+		const float z = cameraPos.z < minWS.z ? minWS.z : maxWS.z;
+		cornersVS[0] = ToViewSpace({ minWS.x, minWS.y, z });
+		cornersVS[1] = ToViewSpace({ maxWS.x, minWS.y, z });
+		cornersVS[2] = ToViewSpace({ maxWS.x, maxWS.y, z });
+		cornersVS[3] = ToViewSpace({ minWS.x, maxWS.y, z });
+		DrawQuad(cornersVS);
+	}
+}
+
+void OcclusionRasterizer::End()
+{
+	for (uint32_t tileY = 0; tileY < NUM_TILES_Y; tileY++)
+	{
+		for (uint32_t tileX = 0; tileX < NUM_TILES_X; tileX++)
+		{
+			float furthestDepth = m_depth[tileY * OCCLUSION_TILE_SIZE * OCCLUSION_BUFFER_WIDTH + tileX * OCCLUSION_TILE_SIZE];
+			for (uint32_t y = 0; y < OCCLUSION_TILE_SIZE; y++)
+			{
+				const float* row = &m_depth[(tileY * OCCLUSION_TILE_SIZE + y) * OCCLUSION_BUFFER_WIDTH + tileX * OCCLUSION_TILE_SIZE];
+				for (uint32_t x = 0; x < OCCLUSION_TILE_SIZE; x++) furthestDepth = min(furthestDepth, row[x]);
+			}
+
+			m_tileDepth[tileY * NUM_TILES_X + tileX] = furthestDepth;
+		}
+	}
+}
+
+bool OcclusionRasterizer::IsBoxVisible(const DirectX::XMFLOAT3& minWS, const DirectX::XMFLOAT3& maxWS) const
+{
+	float minX = static_cast<float>(OCCLUSION_BUFFER_WIDTH), maxX = -1.0f;
+	float minY = static_cast<float>(OCCLUSION_BUFFER_HEIGHT), maxY = -1.0f;
+	float closestDepth = 0.0f;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		const DirectX::XMFLOAT3 cornerWS = { (i & 1) ? maxWS.x : minWS.x, (i & 2) ? maxWS.y : minWS.y, (i & 4) ? maxWS.z : minWS.z };
+		const DirectX::XMFLOAT3 cornerVS = ToViewSpace(cornerWS);
+		if (cornerVS.z < OCCLUSION_NEAR_PLANE) return true;
+
+		const ScreenVertex corner = Project(cornerVS);
+		minX = min(minX, corner.x);
+		maxX = max(maxX, corner.x);
+		minY = min(minY, corner.y);
+		maxY = max(maxY, corner.y);
+		closestDepth = max(closestDepth, corner.depth);
+	}
+
+	// Boxes off the screen are left to frustum culling
+	if (maxX < 0.0f || minX >= OCCLUSION_BUFFER_WIDTH || maxY < 0.0f || minY >= OCCLUSION_BUFFER_HEIGHT) return true;
+
+	const float testDepth = closestDepth * OCCLUSION_DEPTH_BIAS;
+	const int32_t x0 = ToPixel(minX, OCCLUSION_BUFFER_WIDTH), x1 = ToPixel(maxX, OCCLUSION_BUFFER_WIDTH);
+	const int32_t y0 = ToPixel(minY, OCCLUSION_BUFFER_HEIGHT), y1 = ToPixel(maxY, OCCLUSION_BUFFER_HEIGHT);
+
+	for (int32_t tileY = y0 / OCCLUSION_TILE_SIZE; tileY <= y1 / static_cast<int32_t>(OCCLUSION_TILE_SIZE); tileY++)
+	{
+		for (int32_t tileX = x0 / OCCLUSION_TILE_SIZE; tileX <= x1 / static_cast<int32_t>(OCCLUSION_TILE_SIZE); tileX++)
+		{
+			// Everything drawn in the tile is in front of the box
+			if (m_tileDepth[tileY * NUM_TILES_X + tileX] > testDepth) continue;
+
+			const int32_t startY = max(y0, tileY * static_cast<int32_t>(OCCLUSION_TILE_SIZE));
+			const int32_t endY = min(y1, (tileY + 1) * static_cast<int32_t>(OCCLUSION_TILE_SIZE) - 1);
+			const int32_t startX = max(x0, tileX * static_cast<int32_t>(OCCLUSION_TILE_SIZE));
+			const int32_t endX = min(x1, (tileX + 1) * static_cast<int32_t>(OCCLUSION_TILE_SIZE) - 1);
+			for (int32_t y = startY; y <= endY; y++)
+			{
+				const float* row = &m_depth[y * OCCLUSION_BUFFER_WIDTH];
+				for (int32_t x = startX; x <= endX; x++)
+				{
+					if (row[x] <= testDepth) return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+const std::vector<float>& OcclusionRasterizer::GetDepthBuffer() const { return m_depth; }
+
+template<int32_t Size>
+bool OcclusionRasterizer::IsOccluder(const BasicChunkSnapshot<Size>& snapshot)
+{
+	using Snapshot = BasicChunkSnapshot<Size>;
+
+	// Whole rows along Z for the left and right faces, and the first and last block of every other row
+	for (int32_t x = 0; x < Size; x++)
+	{
+		const bool isSideFace = x == 0 || x == Size - 1;
+		for (int32_t y = 0; y < Size; y++)
+		{
+			const BlockType* row = &snapshot.blocks[Snapshot::GetIndex(x + 1, y + 1, 1)];
+			if (isSideFace || y == 0 || y == Size - 1)
+			{
+				for (int32_t z = 0; z < Size; z++)
+				{
+					if (!BlockRegistry::IsOpaque(row[z])) return false;
+				}
+			}
+			else if (!BlockRegistry::IsOpaque(row[0]) || !BlockRegistry::IsOpaque(row[Size - 1]))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+DirectX::XMFLOAT3 OcclusionRasterizer::ToViewSpace(const DirectX::XMFLOAT3& posWS) const
+{
+	const DirectX::XMFLOAT3 offset = { posWS.x - m_view.position.x, posWS.y - m_view.position.y, posWS.z - m_view.position.z };
+	return { Dot(offset, m_view.right), Dot(offset, m_view.up), Dot(offset, m_view.forward) };
+}
+
+OcclusionRasterizer::ScreenVertex OcclusionRasterizer::Project(const DirectX::XMFLOAT3& posVS) const
+{
+	const float depth = 1.0f / posVS.z;
+	const float ndcX = posVS.x * depth / (m_view.tanHalfFov * m_view.aspectRatio);
+	const float ndcY = posVS.y * depth / m_view.tanHalfFov;
+	return { (ndcX * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH, (0.5f - ndcY * 0.5f) * OCCLUSION_BUFFER_HEIGHT, depth };
+}
+
+void OcclusionRasterizer::DrawQuad(const DirectX::XMFLOAT3* cornersVS)
+{
+	// Clipping a quad against a single plane leaves at most 5 corners
+	DirectX::XMFLOAT3 clipped[5];
+	uint32_t numClipped = 0;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const DirectX::XMFLOAT3& current = cornersVS[i];
+		const DirectX::XMFLOAT3& next = cornersVS[(i + 1) % 4];
+		const bool isCurrentInside = current.z >= OCCLUSION_NEAR_PLANE;
+		const bool isNextInside = next.z >= OCCLUSION_NEAR_PLANE;
+
+		if (isCurrentInside) clipped[numClipped++] = current;
+		if (isCurrentInside != isNextInside)
+		{
+			const float t = (OCCLUSION_NEAR_PLANE - current.z) / (next.z - current.z);
+			clipped[numClipped++] = { current.x + (next.x - current.x) * t, current.y + (next.y - current.y) * t, OCCLUSION_NEAR_PLANE };
+		}
+	}
+
+	if (numClipped < 3) return;
+
+	ScreenVertex projected[5];
+	for (uint32_t i = 0; i < numClipped; i++) projected[i] = Project(clipped[i]);
+	for (uint32_t i = 1; i + 1 < numClipped; i++) DrawTriangle(projected[0], projected[i], projected[i + 1]);
+}
+
+void OcclusionRasterizer::DrawTriangle(const ScreenVertex& a, const ScreenVertex& _b, const ScreenVertex& _c)
+{
+	// Winds the triangle so that the edge functions are positive inside it
+	float area = (_b.x - a.x) * (_c.y - a.y) - (_b.y - a.y) * (_c.x - a.x);
+	if (area == 0.0f) return;
+
+	const ScreenVertex& b = area > 0.0f ? _b : _c;
+	const ScreenVertex& c = area > 0.0f ? _c : _b;
+	area = fabsf(area);
+
+	const float minX = min(min(a.x, b.x), c.x), maxX = max(max(a.x, b.x), c.x);
+	const float minY = min(min(a.y, b.y), c.y), maxY = max(max(a.y, b.y), c.y);
+	if (maxX < 0.0f || minX >= OCCLUSION_BUFFER_WIDTH || maxY < 0.0f || minY >= OCCLUSION_BUFFER_HEIGHT) return;
+
+	// Edge function of the edge from "p" to "q" is stepX * x + stepY * y + offset
+	struct Edge
+	{
+		float stepX, stepY, offset;
+	};
+	auto makeEdge = [](const ScreenVertex& p, const ScreenVertex& q) -> Edge
+	{
+		return { -(q.y - p.y), q.x - p.x, (q.y - p.y) * p.x - (q.x - p.x) * p.y };
+	};
+	const Edge edges[3] = { makeEdge(a, b), makeEdge(b, c), makeEdge(c, a) };
+
+	// Depth is interpolated with the barycentric coordinates, each of which is the opposite edge's function over the area
+	const float depthStepX = (edges[1].stepX * a.depth + edges[2].stepX * b.depth + edges[0].stepX * c.depth) / area;
+	const float depthStepY = (edges[1].stepY * a.depth + edges[2].stepY * b.depth + edges[0].stepY * c.depth) / area;
+	const float depthOffset = (edges[1].offset * a.depth + edges[2].offset * b.depth + edges[0].offset * c.depth) / area;
+
+	// Pixel centers right on the edge shared by two triangles can round to the outside of both, leaving cracks along the
+	// diagonal of every quad. Every edge is pushed out by a sliver of a pixel so that they land inside at least one of them
+	float edgeBias[3];
+	for (uint32_t i = 0; i < 3; i++) edgeBias[i] = -OCCLUSION_EDGE_BIAS * sqrtf(edges[i].stepX * edges[i].stepX + edges[i].stepY * edges[i].stepY);
+
+	const int32_t x0 = ToPixel(minX, OCCLUSION_BUFFER_WIDTH) & ~static_cast<int32_t>(BATCH_SIZE - 1);
+	const int32_t x1 = ToPixel(maxX, OCCLUSION_BUFFER_WIDTH);
+	const int32_t y0 = ToPixel(minY, OCCLUSION_BUFFER_HEIGHT);
+	const int32_t y1 = ToPixel(maxY, OCCLUSION_BUFFER_HEIGHT);
+
+	float laneOffsets[BATCH_SIZE];
+	for (uint32_t i = 0; i < BATCH_SIZE; i++) laneOffsets[i] = static_cast<float>(i) + 0.5f;
+	const FloatBatch pixelOffsets = LoadBatch(laneOffsets);
+	const FloatBatch bias0 = Broadcast(edgeBias[0]), bias1 = Broadcast(edgeBias[1]), bias2 = Broadcast(edgeBias[2]);
+
+	const FloatBatch stepX0 = Broadcast(edges[0].stepX), stepX1 = Broadcast(edges[1].stepX), stepX2 = Broadcast(edges[2].stepX);
+	const FloatBatch depthStep = Broadcast(depthStepX);
+
+	for (int32_t y = y0; y <= y1; y++)
+	{
+		const float pixelY = static_cast<float>(y) + 0.5f;
+		const FloatBatch rowOffset0 = Broadcast(edges[0].stepY * pixelY + edges[0].offset);
+		const FloatBatch rowOffset1 = Broadcast(edges[1].stepY * pixelY + edges[1].offset);
+		const FloatBatch rowOffset2 = Broadcast(edges[2].stepY * pixelY + edges[2].offset);
+		const FloatBatch rowDepth = Broadcast(depthStepY * pixelY + depthOffset);
+
+		float* row = &m_depth[y * OCCLUSION_BUFFER_WIDTH];
+		for (int32_t x = x0; x <= x1; x += BATCH_SIZE)
+		{
+			const FloatBatch pixelX = Add(Broadcast(static_cast<float>(x)), pixelOffsets);
+			const MaskBatch isInside = And(And(GreaterEqual(MultiplyAdd(stepX0, pixelX, rowOffset0), bias0),
+				GreaterEqual(MultiplyAdd(stepX1, pixelX, rowOffset1), bias1)), GreaterEqual(MultiplyAdd(stepX2, pixelX, rowOffset2), bias2));
+			if (GetLaneMask(isInside) == 0) continue;
+
+			const FloatBatch depth = MultiplyAdd(depthStep, pixelX, rowDepth);
+			const FloatBatch current = LoadBatch(&row[x]);
+			StoreBatch(&row[x], Select(isInside, Max(current, depth), current));
+		}
+	}
+}
+
+void OcclusionCuller::Start()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_isRunning) return;
+
+	m_isRunning = true;
+	m_worker = std::thread(&OcclusionCuller::WorkerEntryPoint, this);
+}
+
+void OcclusionCuller::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_isRunning) return;
+
+		m_isRunning = false;
+		m_hasWork = false;
+	}
+
+	m_wakeUp.notify_all();
+	m_worker.join();
+	m_hiddenChunks.clear();
+}
+
+void OcclusionCuller::Submit(const OcclusionView& view, const std::vector<ChunkCoord>& occluders, const std::vector<ChunkCoord>& chunks)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pendingView = view;
+		m_pendingOccluders.assign(occluders.begin(), occluders.end());
+		m_pendingChunks.assign(chunks.begin(), chunks.end());
+		m_hasWork = true;
+	}
+
+	m_wakeUp.notify_all();
+}
+
+uint32_t OcclusionCuller::RemoveHiddenChunks(std::vector<ChunkCoord>& inOutChunks)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_hiddenChunks.empty()) return 0;
+
+	const size_t numChunks = inOutChunks.size();
+	inOutChunks.erase(std::remove_if(inOutChunks.begin(), inOutChunks.end(), [this](const ChunkCoord& chunkPosCS)
+	{
+		return m_hiddenChunks.count(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS)) > 0;
+	}), inOutChunks.end());
+
+	return static_cast<uint32_t>(numChunks - inOutChunks.size());
+}
+
+void OcclusionCuller::WaitForResults()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_wakeUp.wait(lock, [this]() { return !m_isRunning || (!m_hasWork && !m_isWorking); });
+}
+
+void OcclusionCuller::WorkerEntryPoint()
+{
+	// Swapped with the pending work and the results, so their memory goes back and forth instead of being reallocated
+	OcclusionView view;
+	std::vector<ChunkCoord> occluders, chunks;
+	std::unordered_set<uint64_t> hiddenChunks;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [this]() { return m_hasWork || !m_isRunning; });
+			if (!m_isRunning) return;
+
+			view = m_pendingView;
+			occluders.swap(m_pendingOccluders);
+			chunks.swap(m_pendingChunks);
+			m_hasWork = false;
+			m_isWorking = true;
+		}
+
+		Run(view, occluders, chunks, hiddenChunks);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_hiddenChunks.swap(hiddenChunks);
+			m_isWorking = false;
+		}
+		m_wakeUp.notify_all();
+	}
+}
+
+void OcclusionCuller::Run(const OcclusionView& view, std::vector<ChunkCoord>& occluders, const std::vector<ChunkCoord>& chunks, std::unordered_set<uint64_t>& outHiddenChunks)
+{
+	auto getDistanceSq = [&view](const ChunkCoord& chunkPosCS)
+	{
+		const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+		const float dx = minWS.x + DefaultChunkTraits::HALF_EXTENT - view.position.x;
+		const float dy = minWS.y + DefaultChunkTraits::HALF_EXTENT - view.position.y;
+		const float dz = minWS.z + DefaultChunkTraits::HALF_EXTENT - view.position.z;
+		return dx * dx + dy * dy + dz * dz;
+	};
+
+	if (occluders.size() > MAX_OCCLUDERS)
+	{
+		std::nth_element(occluders.begin(), occluders.begin() + MAX_OCCLUDERS, occluders.end(), [&](const ChunkCoord& a, const ChunkCoord& b)
+		{
+			return getDistanceSq(a) < getDistanceSq(b);
+		});
+		occluders.resize(MAX_OCCLUDERS);
+	}
+
+	constexpr float chunkExtent = static_cast<float>(CHUNK_SIZE);
+	m_rasterizer.Begin(view);
+	for (const auto& chunkPosCS : occluders)
+	{
+		const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+		m_rasterizer.DrawOccluder(minWS, { minWS.x + chunkExtent, minWS.y + chunkExtent, minWS.z + chunkExtent });
+	}
+	m_rasterizer.End();
+
+	outHiddenChunks.clear();
+	for (const auto& chunkPosCS : chunks)
+	{
+		const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+		if (!m_rasterizer.IsBoxVisible(minWS, { minWS.x + chunkExtent, minWS.y + chunkExtent, minWS.z + chunkExtent }))
+		{
+			outHiddenChunks.insert(Orange::Math::GetHashKeyFromChunkPosition(chunkPosCS));
+		}
+	}
+}
+
+template bool OcclusionRasterizer::IsOccluder<16>(const BasicChunkSnapshot<16>& snapshot);
+template bool OcclusionRasterizer::IsOccluder<32>(const BasicChunkSnapshot<32>& snapshot);
+template bool OcclusionRasterizer::IsOccluder<64>(const BasicChunkSnapshot<64>& snapshot);
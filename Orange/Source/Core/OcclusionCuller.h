@@ -0,0 +1,136 @@
+#ifndef _OCCLUSIONCULLER_H
+#define _OCCLUSIONCULLER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "ChunkCoord.h"
+#include "ChunkMesher.h"
+
+// Resolution of the occlusion depth buffer, much lower than the screen's. The width has to be a multiple of
+// Orange::Simd::BATCH_SIZE, and both have to be multiples of the tile size
+constexpr uint32_t OCCLUSION_BUFFER_WIDTH = 256;
+constexpr uint32_t OCCLUSION_BUFFER_HEIGHT = 128;
+constexpr uint32_t OCCLUSION_TILE_SIZE = 8;
+
+// Camera the occluders are drawn from, in WORLD SPACE. The axes have to be orthonormal
+struct OcclusionView
+{
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 right;
+	DirectX::XMFLOAT3 up;
+	DirectX::XMFLOAT3 forward;
+
+	// tan(FOV / 2), vertically
+	float tanHalfFov;
+	float aspectRatio;
+};
+
+// Draws solid boxes into a small depth buffer and tests boxes against it. Depth is stored as 1 / distance along the
+// view direction, which can be interpolated linearly across the screen, so bigger is closer and 0 is nothing drawn.
+//
+// Boxes are tested against 8x8 tiles first, each of which keeps the furthest depth in it. A box is hidden in a tile
+// if it's behind the tile's furthest depth, and only tiles it isn't hidden in are tested pixel by pixel
+class OcclusionRasterizer
+{
+public:
+
+	OcclusionRasterizer();
+
+	// Clears the depth buffer
+	void Begin(const OcclusionView& view);
+
+	// Draws the faces of a box that face the camera. The box has to be entirely solid
+	void DrawOccluder(const DirectX::XMFLOAT3& minWS, const DirectX::XMFLOAT3& maxWS);
+
+	// Builds the tiles, has to be called after drawing the occluders and before testing any boxes
+	void End();
+
+	// Returns false if the box is entirely behind the occluders. Boxes crossing the near plane are always visible
+	bool IsBoxVisible(const DirectX::XMFLOAT3& minWS, const DirectX::XMFLOAT3& maxWS) const;
+
+	// OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT depths, row by row from the top of the screen
+	const std::vector<float>& GetDepthBuffer() const;
+
+	// Returns true if every block on the snapshot's faces is opaque, so that its chunk can be drawn as a solid box.
+	// Whatever is inside can't be seen from outside the chunk. Instantiated for every size ChunkTraits supports
+	template<int32_t Size>
+	static bool IsOccluder(const BasicChunkSnapshot<Size>& snapshot);
+
+private:
+
+	struct ScreenVertex
+	{
+		float x, y, depth;
+	};
+
+	DirectX::XMFLOAT3 ToViewSpace(const DirectX::XMFLOAT3& posWS) const;
+	ScreenVertex Project(const DirectX::XMFLOAT3& posVS) const;
+
+	// Takes a quad in VIEW SPACE, clips it against the near plane and draws what's left
+	void DrawQuad(const DirectX::XMFLOAT3* cornersVS);
+	void DrawTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c);
+
+private:
+
+	OcclusionView m_view;
+
+	std::vector<float> m_depth;
+
+	// Furthest (smallest) depth in every tile
+	std::vector<float> m_tileDepth;
+};
+
+// Runs occlusion culling for the chunks on a worker thread. Every frame the renderer hands over its camera, the chunks
+// it's about to draw and the solid ones among them, and gets back the chunks the previous frame's work found hidden.
+// Chunks that weren't part of the previous frame are never hidden, so nothing is culled without being tested first
+class OcclusionCuller
+{
+public:
+
+	void Start();
+	void Stop();
+
+	// Queues a frame's work, replacing any work the worker hasn't picked up yet
+	void Submit(const OcclusionView& view, const std::vector<ChunkCoord>& occluders, const std::vector<ChunkCoord>& chunks);
+
+	// Removes the chunks the last finished frame found hidden from "inOutChunks". Returns the number of chunks removed
+	uint32_t RemoveHiddenChunks(std::vector<ChunkCoord>& inOutChunks);
+
+	// Blocks until the worker is done with all the work that was submitted
+	void WaitForResults();
+
+	// Only the closest occluders are drawn, the further ones rarely hide anything the closer ones don't
+	static constexpr uint32_t MAX_OCCLUDERS = 512;
+
+private:
+
+	void WorkerEntryPoint();
+
+	// Draws the occluders and tests the chunks on the calling thread
+	void Run(const OcclusionView& view, std::vector<ChunkCoord>& occluders, const std::vector<ChunkCoord>& chunks, std::unordered_set<uint64_t>& outHiddenChunks);
+
+private:
+
+	OcclusionRasterizer m_rasterizer;
+	std::thread m_worker;
+
+	// Guards everything below
+	std::mutex m_mutex;
+	std::condition_variable m_wakeUp;
+	bool m_isRunning = false;
+	bool m_hasWork = false;
+	bool m_isWorking = false;
+
+	OcclusionView m_pendingView;
+	std::vector<ChunkCoord> m_pendingOccluders;
+	std::vector<ChunkCoord> m_pendingChunks;
+
+	// Hash keys of the chunks the last finished frame found hidden
+	std::unordered_set<uint64_t> m_hiddenChunks;
+};
+
+#endif
@@ -1,7 +1,9 @@
 #include "../Misc/pch.h"
 #include "Physics.h"
 
-#include "ChunkManager.h"
+#include "BlockRegistry.h"
+#include "Chunk.h"
+#include "TerrainQuery.h"
 #include "../Utility/Utility.h"
 #include "../Utility/Math.h"
 
@@ -56,31 +58,19 @@ namespace Orange
 	const bool Physics::DetectCollision(const DirectX::XMFLOAT3& pos)
 	{
 
-		XMFLOAT3 posCS = Orange::Math::WorldToChunkSpace(pos);
-		XMFLOAT3 chunkPosWS = Orange::Math::ChunkToWorldSpace(posCS);
-
-		Chunk* chunk = ChunkManager::GetChunkAtPos(posCS);
-		OG_ASSERT(chunk != nullptr);
-	
-		uint32_t x, y, z;
-		x = static_cast<uint32_t>(pos.x - chunkPosWS.x);
-		y = static_cast<uint32_t>(pos.y - chunkPosWS.y);
-		z = static_cast<uint32_t>(pos.z - chunkPosWS.z);
-		BlockType blockType = chunk->GetBlock(x, y, z)->GetType();
+		// Positions in chunks that aren't loaded (yet) are answered by the terrain generator
+		BlockType blockType = TerrainQuery::GetBlockType(pos);
 	
-		if (blockType != BlockType::Air) return true;
+		if (BlockRegistry::IsCollidable(blockType)) return true;
 		else return false;
 	}
 
-	// out_collisionPositions contains a list of all intersected blocks. This means that it will keep checking for collisions even after
-	// it finds a collision, so in that sense it's inefficient. However, it's sometimes useful to know the positions of the blocks we hit
-	const bool Physics::DetectCollision(const AABB& aabb, std::vector<XMFLOAT3>* out_collisionPositions)
+	const bool Physics::DetectCollision(const AABB& aabb)
 	{
 		XMFLOAT3 aabbMin = { aabb.center.x - aabb.extent.x, aabb.center.y - aabb.extent.y, aabb.center.z - aabb.extent.z };
 		XMFLOAT3 aabbMax = { aabb.center.x + aabb.extent.x, aabb.center.y + aabb.extent.y, aabb.center.z + aabb.extent.z };
 
-		// for each axis, find the range
-		// after finding the range for each axis, find the position of included blocks
+		// The number of blocks the AABB covers along every axis
 		XMFLOAT3 range = 
 		{ 
 			static_cast<float>(abs(floor(aabbMax.x) - floor(aabbMin.x)) + 1),
@@ -93,43 +83,7 @@ namespace Orange
 		PlayerPhysics_Data::AABBCollisionRange = range;
 		//
 
-		bool collisionHappened = false;
-		for (uint32_t x = 0; x < range.x; x++)
-		{
-			for (uint32_t y = 0; y < range.y; y++)
-			{
-				for (uint32_t z = 0; z < range.z; z++)
-				{
-					// intersected block pos in world space
-					XMFLOAT3 intersectedBlockPos = { floor(aabbMin.x) + x, floor(aabbMin.y) + y, floor(aabbMin.z) + z };
-
-					XMFLOAT3 posCS = Orange::Math::WorldToChunkSpace(intersectedBlockPos);
-					XMFLOAT3 chunkPosWS = Orange::Math::ChunkToWorldSpace(posCS);
-
-					Chunk* chunk = ChunkManager::GetChunkAtPos(posCS);
-					OG_ASSERT(chunk != nullptr);
-
-					uint32_t localX, localY, localZ;
-					localX = static_cast<uint32_t>(intersectedBlockPos.x - chunkPosWS.x);
-					localY = static_cast<uint32_t>(intersectedBlockPos.y - chunkPosWS.y);
-					localZ = static_cast<uint32_t>(intersectedBlockPos.z - chunkPosWS.z);
-					BlockType blockType = chunk->GetBlock(localX, localY, localZ)->GetType();
-
-					//if(blockType != BlockType::Air)
-					//	DebugRenderer::DrawAABB({ intersectedBlockPos.x + 0.5f, intersectedBlockPos.y + 0.5f, intersectedBlockPos.z + 0.5f }, { 0.5f, 0.5f, 0.5f }, { 1.0f, 0.0f, 1.0f, 1.0f });
-					//else
-					//	DebugRenderer::DrawAABB({ intersectedBlockPos.x + 0.5f, intersectedBlockPos.y + 0.5f, intersectedBlockPos.z + 0.5f }, { 0.5f, 0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f });
-
-					if (blockType != BlockType::Air)
-					{
-						if(out_collisionPositions) out_collisionPositions->push_back(intersectedBlockPos);
-						collisionHappened = true;
-					}
-				}
-			}
-		}
-
-		return collisionHappened;
-
+		TerrainCollisionQuery query;
+		return OverlapsSolid(aabb, query);
 	}
 }
@@ -1,8 +1,14 @@
 #ifndef _PHYSICS_H
 #define _PHYSICS_H
 
+#include <cmath>
 #include <DirectXMath.h>
 
+#include "ChunkCoord.h"
+
+// Block faces closer than this (in world units) to an AABB's face are touching it, not overlapping it
+constexpr float COLLISION_SKIN = 0.0001f;
+
 namespace Orange
 {
 	struct Sphere
@@ -23,6 +29,20 @@ namespace Orange
 		float point;
 	};
 
+	// What Physics::SweepAABB() found
+	struct SweepResult
+	{
+		// How far the AABB got along every axis before it hit something
+		DirectX::XMFLOAT3 motion;
+
+		// The share of the motion along every axis that was made, 1 on every axis that didn't hit anything
+		DirectX::XMFLOAT3 timeOfImpact;
+
+		// Points out of the face the AABB hit on every axis, and is 0 on the ones that didn't hit anything. E.g. landing
+		// on the ground is (0, 1, 0)
+		BlockCoord normal;
+	};
+
 	// Helper physics class
 	class Physics
 	{
@@ -38,11 +58,120 @@ namespace Orange
 
 		static const bool DetectCollision(const DirectX::XMFLOAT3& pos);
 
-		static const bool DetectCollision(const AABB& aabb, std::vector<DirectX::XMFLOAT3>* out_collisionPositions = nullptr);
+		// Returns true if the AABB overlaps any collidable block. Blocks it only touches don't count
+		static const bool DetectCollision(const AABB& aabb);
+
+		// Moves the AABB by "motion" through the blocks, one axis at a time (Y, then X, then Z), stopping on every axis
+		// where it would go into a block. Every block layer along the way is checked, so it can't go through blocks
+		// however fast it's moving, and blocks it already overlaps don't stop it, so it can't get stuck in them.
+		// "query" decides what's solid:
+		//
+		//		bool IsSolid(const BlockCoord& posBS)
+		//
+		// It's asked about blocks next to each other, so it can hold on to the chunk it found last. Nothing is allocated
+		template<typename Query>
+		static void SweepAABB(const AABB& aabb, const DirectX::XMFLOAT3& motion, Query& query, SweepResult& outResult);
+
+		// Same as DetectCollision(), for any query SweepAABB() takes
+		template<typename Query>
+		static bool OverlapsSolid(const AABB& aabb, Query& query);
 
 	private:
 
+		// Returns how far the box can move along "axis", up to "distance"
+		template<typename Query>
+		static float SweepAxis(const float* boxMin, const float* boxMax, const uint32_t axis, const float distance, Query& query);
+
 	};
+
+	template<typename Query>
+	inline void Physics::SweepAABB(const AABB& aabb, const DirectX::XMFLOAT3& motion, Query& query, SweepResult& outResult)
+	{
+		// Vertical first, so that landing on a block's edge doesn't count as walking into its side
+		constexpr uint32_t axisOrder[3] = { 1, 0, 2 };
+
+		float boxMin[3] = { aabb.center.x - aabb.extent.x, aabb.center.y - aabb.extent.y, aabb.center.z - aabb.extent.z };
+		float boxMax[3] = { aabb.center.x + aabb.extent.x, aabb.center.y + aabb.extent.y, aabb.center.z + aabb.extent.z };
+		const float distances[3] = { motion.x, motion.y, motion.z };
+
+		float moved[3] = { 0.0f, 0.0f, 0.0f };
+		float timeOfImpact[3] = { 1.0f, 1.0f, 1.0f };
+		int32_t normal[3] = { 0, 0, 0 };
+		for (const uint32_t axis : axisOrder)
+		{
+			if (distances[axis] == 0.0f) continue;
+
+			moved[axis] = SweepAxis(boxMin, boxMax, axis, distances[axis], query);
+			if (moved[axis] != distances[axis])
+			{
+				timeOfImpact[axis] = max(moved[axis] / distances[axis], 0.0f);
+				normal[axis] = distances[axis] > 0.0f ? -1 : 1;
+			}
+
+			boxMin[axis] += moved[axis];
+			boxMax[axis] += moved[axis];
+		}
+
+		outResult.motion = { moved[0], moved[1], moved[2] };
+		outResult.timeOfImpact = { timeOfImpact[0], timeOfImpact[1], timeOfImpact[2] };
+		outResult.normal = BlockCoord(normal[0], normal[1], normal[2]);
+	}
+
+	template<typename Query>
+	inline bool Physics::OverlapsSolid(const AABB& aabb, Query& query)
+	{
+		const BlockCoord minBS = Orange::Math::WorldToBlockCoord({ aabb.center.x - aabb.extent.x + COLLISION_SKIN, aabb.center.y - aabb.extent.y + COLLISION_SKIN, aabb.center.z - aabb.extent.z + COLLISION_SKIN });
+		const BlockCoord maxBS = Orange::Math::WorldToBlockCoord({ aabb.center.x + aabb.extent.x - COLLISION_SKIN, aabb.center.y + aabb.extent.y - COLLISION_SKIN, aabb.center.z + aabb.extent.z - COLLISION_SKIN });
+		for (int32_t x = minBS.x; x <= maxBS.x; x++)
+		{
+			for (int32_t y = minBS.y; y <= maxBS.y; y++)
+			{
+				for (int32_t z = minBS.z; z <= maxBS.z; z++)
+				{
+					if (query.IsSolid(BlockCoord(x, y, z))) return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	template<typename Query>
+	inline float Physics::SweepAxis(const float* boxMin, const float* boxMax, const uint32_t axis, const float distance, Query& query)
+	{
+		// The blocks the box covers on the other two axes
+		const uint32_t axisU = (axis + 1) % 3;
+		const uint32_t axisV = (axis + 2) % 3;
+		const int32_t minU = static_cast<int32_t>(floorf(boxMin[axisU] + COLLISION_SKIN));
+		const int32_t maxU = static_cast<int32_t>(floorf(boxMax[axisU] - COLLISION_SKIN));
+		const int32_t minV = static_cast<int32_t>(floorf(boxMin[axisV] + COLLISION_SKIN));
+		const int32_t maxV = static_cast<int32_t>(floorf(boxMax[axisV] - COLLISION_SKIN));
+
+		// Every layer of blocks in front of the box's leading face that it reaches, closest first
+		const int32_t step = distance > 0.0f ? 1 : -1;
+		const int32_t firstLayer = distance > 0.0f ? static_cast<int32_t>(ceilf(boxMax[axis] - COLLISION_SKIN)) : static_cast<int32_t>(floorf(boxMin[axis] + COLLISION_SKIN)) - 1;
+		const int32_t lastLayer = distance > 0.0f ? static_cast<int32_t>(ceilf(boxMax[axis] + distance)) - 1 : static_cast<int32_t>(floorf(boxMin[axis] + distance));
+
+		int32_t block[3];
+		for (int32_t layer = firstLayer; layer * step <= lastLayer * step; layer += step)
+		{
+			block[axis] = layer;
+			for (int32_t u = minU; u <= maxU; u++)
+			{
+				block[axisU] = u;
+				for (int32_t v = minV; v <= maxV; v++)
+				{
+					block[axisV] = v;
+					if (!query.IsSolid(BlockCoord(block[0], block[1], block[2]))) continue;
+
+					// Up to the layer's face. Within the skin of it this can be a hair backwards
+					return distance > 0.0f ? static_cast<float>(layer) - boxMax[axis] : static_cast<float>(layer + 1) - boxMin[axis];
+				}
+			}
+		}
+
+		return distance;
+	}
 }
 
 
@@ -12,6 +12,9 @@ namespace Orange
 	Player::Player() :	m_acceleration({0.0f, 0.0f, 0.0f}), m_velocity({0.0f, 0.0f, 0.0f}), m_FPSCamera(nullptr), m_debugCamera(nullptr), m_selectedCameraType(CameraType::FirstPerson),
 						m_movementSpeed(7.0f), m_position({ -4.0f, 150.0f, -10.0f }), m_rotation({ 0.0f, 0.0f, 0.0f }), m_allowJump(false), m_interactionRange(7.0f)
 	{
+		m_previousPosition = m_position;
+		m_renderPosition = m_position;
+
 		m_FPSCamera = OG_NEW Camera(0.4f, 20.0f);
 		m_FPSCamera->ConstructMatrix(m_position, m_rotation);
 
@@ -71,7 +74,9 @@ namespace Orange
 	void Player::SetVelocity(const DirectX::XMFLOAT3 vel) { m_velocity = vel; }
 
 	DirectX::XMFLOAT3 Player::GetPosition() const { return m_position; }
-	void Player::SetPosition(const DirectX::XMFLOAT3 pos) { m_position = pos; }
+	void Player::SetPosition(const DirectX::XMFLOAT3 pos) { m_position = pos; m_previousPosition = pos; }
+
+	DirectX::XMFLOAT3 Player::GetRenderPosition() const { return m_renderPosition; }
 
 	float Player::GetInteractionRange() { return m_interactionRange; }
 	void Player::SetInteractionRange(float interactionRange) { m_interactionRange = interactionRange; }
@@ -85,8 +90,16 @@ namespace Orange
 	CameraType Player::GetSelectedCameraType() const { return m_selectedCameraType; }
 	void Player::SetSelectedCameraType(const CameraType cameraType) { m_selectedCameraType = cameraType; }
 
-	void Player::Update(const float& dt)
+	void Player::Tick(const float& dt)
+	{
+		m_previousPosition = m_position;
+		PlayerController::Tick(dt, this);
+	}
+
+	void Player::Update(const float& dt, const float interpolationAlpha)
 	{
+		XMStoreFloat3(&m_renderPosition, XMVectorLerp(XMLoadFloat3(&m_previousPosition), XMLoadFloat3(&m_position), interpolationAlpha));
+
 		// Change the selected camera type
 		if (Input::IsKeyDown(KeyCode::G))
 		{
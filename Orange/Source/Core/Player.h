@@ -38,6 +38,9 @@ namespace Orange
 		DirectX::XMFLOAT3 GetPosition() const;
 		void SetPosition(const DirectX::XMFLOAT3 pos);
 
+		// The position between the last two ticks the current frame is at, which is where the camera is
+		DirectX::XMFLOAT3 GetRenderPosition() const;
+
 		float GetInteractionRange();
 		void SetInteractionRange(float interactionRange);
 
@@ -50,7 +53,11 @@ namespace Orange
 		CameraType GetSelectedCameraType() const;
 		void SetSelectedCameraType(const CameraType cameraType);
 
-		void Update(const float& dt);
+		// Moves the player through one fixed simulation tick
+		void Tick(const float& dt);
+
+		// Picks the camera and places it between the last two ticks, once a frame
+		void Update(const float& dt, const float interpolationAlpha);
 
 	private:
 
@@ -61,6 +68,8 @@ namespace Orange
 		DirectX::XMFLOAT3 m_acceleration;
 		DirectX::XMFLOAT3 m_velocity;
 		DirectX::XMFLOAT3 m_position;
+		DirectX::XMFLOAT3 m_previousPosition;
+		DirectX::XMFLOAT3 m_renderPosition;
 		DirectX::XMFLOAT3 m_rotation; // in degrees
 
 		AABB m_hitbox;
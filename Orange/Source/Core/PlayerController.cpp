@@ -8,6 +8,7 @@
 #include "Physics.h"
 #include "../Utility/Math.h"
 #include "ChunkManager.h"
+#include "TerrainQuery.h"
 #include "BlockSelectionIndicator.h"
 
 // DEBUG
@@ -29,22 +30,16 @@ namespace Orange
 	constexpr float INITIAL_JUMP_VELOCITY = (2.0f * JUMP_HEIGHT) / JUMP_TIME;		// 2h / t
 	constexpr float TERMINAL_VELOCITY = 4.0f * -GRAVITY;
 
-	void PlayerController::Update(const float& dt, Orange::Player* player)
+	void PlayerController::Tick(const float& dt, Orange::Player* player)
 	{
-		// DEBUG
-		static bool isColliding = false;
-		//
-
 		int32_t numberOfCurveSamples = 15;
 		static XMFLOAT3 startingLerpValues = { 0.0f, 0.0f, 0.0f };
 		static XMFLOAT3 stoppingLerpValues = { 0.0f, 0.0f, 0.0f };
 
-		switch (player->GetSelectedCameraType())
-		{
-		case CameraType::FirstPerson:
+		// Only the first person player is simulated, the debug camera flies around on its own every frame
+		if (player->GetSelectedCameraType() == CameraType::FirstPerson)
 		{
 			XMFLOAT3 deltaTranslation = { 0.0f, 0.0f, 0.0f };
-			XMFLOAT3 deltaRotation = { 0.0f, 0.0f, 0.0f };
 			XMFLOAT3 currentVelocity = { 0.0f, player->m_velocity.y, 0.0f };
 			std::function<float(float)> startFunction = [=](const float val) { return POW2(val); };
 			std::function<float(float)> stopFunction = [=](const float val) 
@@ -137,23 +132,6 @@ namespace Orange
 			// Use Euler integration to get the translation
 			Physics::ApplyVelocity(deltaTranslation, currentVelocity, dt);
 
-			// Update rotation only if LMB is held down
-			if (Input::IsMouseDown(MouseCode::LBUTTON))
-			{
-				// Rotation around the X axis (look up/down)
-				deltaRotation.x = Input::GetMouseDelta().y * player->m_FPSCamera->GetRotationSpeed();
-				// Rotation around the Y axis (look left/right)
-				deltaRotation.y = Input::GetMouseDelta().x * player->m_FPSCamera->GetRotationSpeed();
-			}
-
-			// X Rotation
-			player->m_rotation.y += deltaRotation.y;
-			Orange::Math::Wrap(player->m_rotation.y, 0.0f, 360.0f);
-
-			// Y Rotation
-			player->m_rotation.x += deltaRotation.x;
-			Orange::Math::Clamp(player->m_rotation.x, -89.9f, 89.9f);
-
 			// we have rotations for x and y
 			// create two rotation matrices, and translate along those axis for "newPos"
 			XMFLOAT3 currentPlayerPos = player->m_hitbox.center;
@@ -183,12 +161,12 @@ namespace Orange
 			XMFLOAT3 horizontalCollision = CheckForHorizontalCollision(newPosHorizontal, prevPosHorizontal);
 			finalTranslatedPosition = newPosHorizontal.center;
 			// Cancel out velocity on axes of collision
-			if (horizontalCollision.x == 1.0f)
+			if (horizontalCollision.x != 0.0f)
 			{
 				startingLerpValues.x = 0.0f;
 				currentVelocity.x = 0.0f;
 			}
-			if (horizontalCollision.z == 1.0f)
+			if (horizontalCollision.z != 0.0f)
 			{
 				startingLerpValues.z = 0.0f;
 				currentVelocity.z = 0.0f;
@@ -209,10 +187,12 @@ namespace Orange
 			AABB newPosVertical = { finalTranslatedPosition, player->m_hitbox.extent };
 			XMFLOAT3 verticalCollision = CheckForVerticalCollision(newPosVertical, prevPosVertical);
 			finalTranslatedPosition = newPosVertical.center;
-			if (verticalCollision.y == 1.0f)
+			if (verticalCollision.y != 0.0f)
 			{
 				currentVelocity.y = 0.0f;
-				player->m_allowJump = true;
+
+				// Only landing lets the player jump again, not bumping their head
+				if (verticalCollision.y > 0.0f) player->m_allowJump = true;
 			}
 
 			// Allow the player to jump
@@ -222,7 +202,11 @@ namespace Orange
 				{
 					// Apply an initial vertical velocity
 					currentVelocity.y += INITIAL_JUMP_VELOCITY;
-					Physics::ApplyVelocity(finalTranslatedPosition, { 0.0f, currentVelocity.y, 0.0f }, dt);
+					AABB prevPosJump = { finalTranslatedPosition, player->m_hitbox.extent };
+					AABB newPosJump = prevPosJump;
+					Physics::ApplyVelocity(newPosJump.center, { 0.0f, currentVelocity.y, 0.0f }, dt);
+					if (CheckForVerticalCollision(newPosJump, prevPosJump).y != 0.0f) currentVelocity.y = 0.0f;
+					finalTranslatedPosition = newPosJump.center;
 					player->m_allowJump = false;
 				}
 			}
@@ -233,11 +217,42 @@ namespace Orange
 			player->m_position = { finalTranslatedPosition.x, finalTranslatedPosition.y + 1.0f, finalTranslatedPosition.z };
 			player->m_velocity = currentVelocity;
 			player->m_hitbox.center = finalTranslatedPosition;
-			DebugRenderer::DrawAABB(player->m_hitbox.center, player->m_hitbox.extent, { 1.0f, 0.0f, 0.0f, 1.0f });
+		}
+	}
+
+	void PlayerController::Update(const float& dt, Orange::Player* player)
+	{
+		// DEBUG
+		static bool isColliding = false;
+		//
+
+		switch (player->GetSelectedCameraType())
+		{
+		case CameraType::FirstPerson:
+		{
+			XMFLOAT3 deltaRotation = { 0.0f, 0.0f, 0.0f };
+
+			// Update rotation only if LMB is held down
+			if (Input::IsMouseDown(MouseCode::LBUTTON))
+			{
+				// Rotation around the X axis (look up/down)
+				deltaRotation.x = Input::GetMouseDelta().y * player->m_FPSCamera->GetRotationSpeed();
+				// Rotation around the Y axis (look left/right)
+				deltaRotation.y = Input::GetMouseDelta().x * player->m_FPSCamera->GetRotationSpeed();
+			}
+
+			// X Rotation
+			player->m_rotation.y += deltaRotation.y;
+			Orange::Math::Wrap(player->m_rotation.y, 0.0f, 360.0f);
+
+			// Y Rotation
+			player->m_rotation.x += deltaRotation.x;
+			Orange::Math::Clamp(player->m_rotation.x, -89.9f, 89.9f);
 
 			BlockSelectionIndicator::Update(dt);
 
-			player->m_FPSCamera->SetCameraParameters(player->m_position, player->m_rotation);
+			// Between the last two ticks, so the camera moves smoothly however far apart they are
+			player->m_FPSCamera->SetCameraParameters(player->m_renderPosition, player->m_rotation);
 			player->m_FPSCamera->Update(dt);
 
 			break;
@@ -318,93 +333,26 @@ namespace Orange
 
 	XMFLOAT3 PlayerController::CheckForHorizontalCollision(AABB& newPos, const AABB& prevPos)
 	{
+		// Swept from the previous position, so the player can't skip over a block between two frames
+		TerrainCollisionQuery query;
+		SweepResult result;
+		Physics::SweepAABB(prevPos, { newPos.center.x - prevPos.center.x, 0.0f, newPos.center.z - prevPos.center.z }, query, result);
 
-		float epsilon = 0.0001f;
-		bool isCollidingWithWall = Physics::DetectCollision(newPos);
-		PlayerPhysics_Data::isCollidingWall = isCollidingWithWall;
-		XMFLOAT3 axesOfCollision = { 0.0f, 0.0f, 0.0f };
-
-		// We have "moved into collision", so revert enough distance to resolve AABB to AABB collision
-		if (isCollidingWithWall)
-		{
-			XMFLOAT3 velocityToAdd = { newPos.center.x - prevPos.center.x, newPos.center.y - prevPos.center.y, newPos.center.z - prevPos.center.z };
-
-			// Only check X and Z axis
-			for (uint32_t axis = 0; axis <= 2; axis += 2)
-			{
-				AABB currentPos;
-				currentPos.center = prevPos.center;
-				currentPos.extent = prevPos.extent;
-				XMFLOAT3_BRACKET_OP_32(currentPos.center, axis) += XMFLOAT3_BRACKET_OP_32(velocityToAdd, axis);
-				if (XMFLOAT3_BRACKET_OP_32(velocityToAdd, axis) == 0.0f) continue;
-
-				if (Physics::DetectCollision(currentPos))
-				{
-					float overlap = 0.0f;
-					if (XMFLOAT3_BRACKET_OP_32(velocityToAdd, axis) > 0)
-					{
-						XMFLOAT3 aabbMax = { newPos.center.x + newPos.extent.x, newPos.center.y + newPos.extent.y, newPos.center.z + newPos.extent.z };
-						overlap = XMFLOAT3_BRACKET_OP_32(aabbMax, axis) - floor(XMFLOAT3_BRACKET_OP_32(aabbMax, axis)) + epsilon;
-					}
-					else if (XMFLOAT3_BRACKET_OP_32(velocityToAdd, axis) < 0)
-					{
-						XMFLOAT3 aabbMin = { newPos.center.x - newPos.extent.x, newPos.center.y - newPos.extent.y, newPos.center.z - newPos.extent.z };
-						overlap = ceil(XMFLOAT3_BRACKET_OP_32(aabbMin, axis)) - XMFLOAT3_BRACKET_OP_32(aabbMin, axis);
-					}
-
-					XMFLOAT3_BRACKET_OP_32(velocityToAdd, axis) = Orange::Math::Sign(XMFLOAT3_BRACKET_OP_32(velocityToAdd, axis)) * (abs(XMFLOAT3_BRACKET_OP_32(velocityToAdd, axis)) - overlap);
-					OG_ASSERT(overlap > 0);
-
-					// Set collision flag to true on current axis
-					XMFLOAT3_BRACKET_OP_32(axesOfCollision, axis) = 1.0f;
-				
-				}
-			}
+		newPos.center = { prevPos.center.x + result.motion.x, newPos.center.y, prevPos.center.z + result.motion.z };
+		PlayerPhysics_Data::isCollidingWall = result.normal.x != 0 || result.normal.z != 0;
 
-			newPos.center = { prevPos.center.x + velocityToAdd.x, newPos.center.y, prevPos.center.z + velocityToAdd.z };
-
-			OG_ASSERT((abs(velocityToAdd.x) >= 0 && abs(velocityToAdd.x) < 1));
-			OG_ASSERT((abs(velocityToAdd.z) >= 0 && abs(velocityToAdd.z) < 1));
-		}
-
-		return axesOfCollision;
+		return result.normal.ToFloat3();
 	}
 
 	XMFLOAT3 PlayerController::CheckForVerticalCollision(AABB& newPos, const AABB& prevPos)
 	{
-		bool isCollidingWithFloor = Physics::DetectCollision(newPos);
-		XMFLOAT3 axesOfCollision = { 0.0f, 0.0f, 0.0f };
-
-		// DEBUG
-		PlayerPhysics_Data::isCollidingFloor = isCollidingWithFloor;
-		static XMFLOAT3 uniqueCollisionPos = { 0.0f, 0.0f, 0.0f };
-		//
-
-		float velocityToAddOnY = newPos.center.y - prevPos.center.y;
-
-		// If collision is detected after applying gravity, revert
-		if (isCollidingWithFloor)
-		{
-			float overlap = 0;
-			if (velocityToAddOnY > 0)
-			{
-				XMFLOAT3 aabbMax = { newPos.center.x + newPos.extent.x, newPos.center.y + newPos.extent.y, newPos.center.z + newPos.extent.z };
-				overlap = aabbMax.y - floor(aabbMax.y);
-			}
-			else if (velocityToAddOnY < 0)
-			{
-				XMFLOAT3 aabbMin = { newPos.center.x - newPos.extent.x, newPos.center.y - newPos.extent.y, newPos.center.z - newPos.extent.z };
-				overlap = ceil(aabbMin.y) - aabbMin.y;
-			}
-			OG_ASSERT(overlap > 0);
-			velocityToAddOnY = Orange::Math::Sign(velocityToAddOnY) * (abs(velocityToAddOnY) - overlap);
-			newPos.center.y = prevPos.center.y + velocityToAddOnY;
+		TerrainCollisionQuery query;
+		SweepResult result;
+		Physics::SweepAABB(prevPos, { 0.0f, newPos.center.y - prevPos.center.y, 0.0f }, query, result);
 
-			// Set collision flag to true on Y axis
-			axesOfCollision.y = 1.0f;
-
-		}
+		newPos.center.y = prevPos.center.y + result.motion.y;
+		PlayerPhysics_Data::isCollidingFloor = result.normal.y != 0;
 
-		return axesOfCollision;
+		return result.normal.ToFloat3();
 	}
 }
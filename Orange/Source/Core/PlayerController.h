@@ -17,10 +17,16 @@ namespace Orange
 		PlayerController(const PlayerController& other) = default;
 		~PlayerController() = default;
 
+		// Moves the player through one fixed simulation tick of "dt" seconds
+		static void Tick(const float& dt, Orange::Player* player);
+
+		// Looks around and moves the cameras, once a frame
 		static void Update(const float& dt, Orange::Player* player);
 
 	private:
 
+		// Move "newPos" back as far as it has to go to not run into any blocks on the way from "prevPos". Return the
+		// contact normal on every axis where it hit something (see SweepResult::normal)
 		static DirectX::XMFLOAT3 CheckForHorizontalCollision(AABB& newPos, const AABB& prevPos);
 		static DirectX::XMFLOAT3 CheckForVerticalCollision(AABB& newPos, const AABB& prevPos);
 
@@ -5,16 +5,22 @@
 #include "../../Utility/Utility.h"
 
 #include "../Chunk.h"					// for CHUNK_SIZE
-#include "../ChunkManager.h"			// for RENDER_DIST
+#include "../ChunkManager.h"			// for GetRenderDistance()
 
 using namespace DirectX;
 
-constexpr int32_t NUM_BLOCK_VERTS = static_cast<int32_t>((CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * (RENDER_DIST + 1) * (RENDER_DIST + 1) * (RENDER_DIST + 1)) * 0.75f);
+// Returns how many block instances the instance buffer should fit for a given render distance
+static uint32_t GetInstanceCapacityForRenderDistance(const int32_t renderDist)
+{
+	return static_cast<uint32_t>((CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * (renderDist + 1) * (renderDist + 1) * (renderDist + 1)) * 0.75f);
+}
 
 std::vector<BlockInstanceData> ChunkBufferManager::m_vertices = std::vector<BlockInstanceData>();
 
 ID3D11Buffer* ChunkBufferManager::m_blockVertexBuffer = nullptr;
 ID3D11Buffer* ChunkBufferManager::m_blockInstanceBuffer = nullptr;
+uint32_t ChunkBufferManager::m_instanceCapacity = 0;
+uint32_t ChunkBufferManager::m_numInstances = 0;
 
 void ChunkBufferManager::Initialize()
 {
@@ -39,16 +45,7 @@ void ChunkBufferManager::Initialize()
 
 
 	// Create the block instance buffer
-	D3D11_BUFFER_DESC instanceBufferDesc;
-	instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	instanceBufferDesc.ByteWidth = NUM_BLOCK_VERTS * sizeof(BlockInstanceData);
-	instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	instanceBufferDesc.MiscFlags = 0;
-	instanceBufferDesc.StructureByteStride = 0;
-
-	hr = D3D::GetDevice()->CreateBuffer(&instanceBufferDesc, nullptr, &m_blockInstanceBuffer);
-	OG_ASSERT(!FAILED(hr));
+	CreateInstanceBuffer(GetInstanceCapacityForRenderDistance(ChunkManager::GetRenderDistance()));
 }
 
 void ChunkBufferManager::Shutdown()
@@ -66,13 +63,24 @@ void ChunkBufferManager::Shutdown()
 	}
 
 	m_vertices.clear();
+	m_instanceCapacity = 0;
+	m_numInstances = 0;
 }
 
 void ChunkBufferManager::UpdateBuffers()
 {
+	// The render distance may have changed since the last frame, in which case
+	// the instance buffer is recreated to fit the new number of chunks
+	uint32_t requiredCapacity = GetInstanceCapacityForRenderDistance(ChunkManager::GetRenderDistance());
+	if (requiredCapacity != m_instanceCapacity)
+	{
+		CreateInstanceBuffer(requiredCapacity);
+	}
+
+	m_numInstances = 0;
 	if (m_vertices.size() <= 0) return;
 
-	OG_ASSERT(m_vertices.size() < NUM_BLOCK_VERTS);
+	OG_ASSERT(m_vertices.size() < m_instanceCapacity);
 
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 
@@ -82,7 +90,9 @@ void ChunkBufferManager::UpdateBuffers()
 		D3D::GetDeviceContext()->Map(m_blockInstanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 		{
 			OG_PROFILE_SCOPE("[UPDATE] Updating mapped resource");
-			int64_t numBytes = (int64_t)sizeof(decltype(m_vertices[0])) * m_vertices.size();
+			// Never write past the end of the instance buffer, even if the chunks outgrow it
+			m_numInstances = min(static_cast<uint32_t>(m_vertices.size()), m_instanceCapacity);
+			int64_t numBytes = (int64_t)sizeof(decltype(m_vertices[0])) * m_numInstances;
 			//ImGui::Begin("Timing Panel");
 			//ImGui::Text("Number of bytes copied: %i", numBytes);
 			//ImGui::End();
@@ -99,4 +109,33 @@ ID3D11Buffer* ChunkBufferManager::GetVertexBuffer() { return m_blockVertexBuffer
 
 ID3D11Buffer* ChunkBufferManager::GetInstanceBuffer() { return m_blockInstanceBuffer; }
 
+const uint64_t ChunkBufferManager::GetInstanceBufferByteWidth() { return static_cast<uint64_t>(m_instanceCapacity) * sizeof(BlockInstanceData); }
+
+const uint64_t ChunkBufferManager::GetInstanceBufferByteWidth(const int32_t renderDist) { return static_cast<uint64_t>(GetInstanceCapacityForRenderDistance(renderDist)) * sizeof(BlockInstanceData); }
+
+const uint32_t ChunkBufferManager::GetNumInstances() { return m_numInstances; }
+
+void ChunkBufferManager::CreateInstanceBuffer(const uint32_t instanceCapacity)
+{
+	if (m_blockInstanceBuffer)
+	{
+		m_blockInstanceBuffer->Release();
+		m_blockInstanceBuffer = nullptr;
+	}
+
+	D3D11_BUFFER_DESC instanceBufferDesc;
+	instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	instanceBufferDesc.ByteWidth = instanceCapacity * sizeof(BlockInstanceData);
+	instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	instanceBufferDesc.MiscFlags = 0;
+	instanceBufferDesc.StructureByteStride = 0;
+
+	HRESULT hr = D3D::GetDevice()->CreateBuffer(&instanceBufferDesc, nullptr, &m_blockInstanceBuffer);
+	OG_ASSERT(!FAILED(hr));
+
+	m_instanceCapacity = instanceCapacity;
+	m_numInstances = 0;
+}
+
 std::vector<BlockInstanceData>& ChunkBufferManager::GetVertexArray() { return m_vertices; }
\ No newline at end of file
@@ -24,8 +24,21 @@ public:
 	static ID3D11Buffer* GetVertexBuffer();
 	static ID3D11Buffer* GetInstanceBuffer();
 
+	// Returns the size of the instance buffer in bytes. It's sized for the current render distance
+	static const uint64_t GetInstanceBufferByteWidth();
+
+	// Returns the size the instance buffer would have at "renderDist", in bytes
+	static const uint64_t GetInstanceBufferByteWidth(const int32_t renderDist);
+
+	// Returns the number of block instances that were copied into the instance buffer by the last UpdateBuffers()
+	static const uint32_t GetNumInstances();
+
 	static std::vector<BlockInstanceData>& GetVertexArray();
 
+private: 
+
+	static void CreateInstanceBuffer(const uint32_t instanceCapacity);
+
 private: 
 
 	static std::vector<BlockInstanceData> m_vertices;
@@ -33,6 +46,9 @@ private:
 	static ID3D11Buffer* m_blockVertexBuffer;
 	static ID3D11Buffer* m_blockInstanceBuffer;
 
+	static uint32_t m_instanceCapacity;
+	static uint32_t m_numInstances;
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "../Misc/pch.h"
+
+#include <cmath>
+
+#include "ShadowCascades.h"
+
+// The bounding spheres' radii are rounded up to this, so that rounding doesn't change their size from frame to frame
+constexpr float SHADOW_RADIUS_STEP = 1.0f / 16.0f;
+
+static inline float Dot(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline DirectX::XMFLOAT3 Cross(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+{
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static inline DirectX::XMFLOAT3 Normalize(const DirectX::XMFLOAT3& v)
+{
+	const float length = sqrtf(Dot(v, v));
+	return { v.x / length, v.y / length, v.z / length };
+}
+
+static inline DirectX::XMFLOAT3 Scale(const DirectX::XMFLOAT3& v, const float s)
+{
+	return { v.x * s, v.y * s, v.z * s };
+}
+
+static inline DirectX::XMFLOAT3 Add(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+{
+	return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+void ShadowCascades::SetLightDirection(const DirectX::XMFLOAT3& lightDirection)
+{
+	m_lightForward = Normalize(lightDirection);
+
+	// Same basis XMMatrixLookToLH() builds, with world up as the up vector unless the light comes straight down it
+	const DirectX::XMFLOAT3 worldUp = fabsf(m_lightForward.y) > 0.99f ? DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f) : DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
+	m_lightRight = Normalize(Cross(worldUp, m_lightForward));
+	m_lightUp = Cross(m_lightForward, m_lightRight);
+}
+
+void ShadowCascades::Fit(const ShadowCameraView& camera, const float shadowDistance, const uint32_t resolution)
+{
+	const std::array<float, NUM_SHADOW_CASCADES> splitDepths = GetSplitDepths(camera.nearDepth, shadowDistance);
+
+	// A slice's corners are this far off its center at a depth of 1, squared
+	const float tanHalfWidth = camera.tanHalfFov * camera.aspectRatio;
+	const float cornerOffsetSq = camera.tanHalfFov * camera.tanHalfFov + tanHalfWidth * tanHalfWidth;
+
+	float splitNear = camera.nearDepth;
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+	{
+		ShadowCascade& cascade = m_cascades[i];
+		const float splitFar = splitDepths[i];
+		cascade.splitNear = splitNear;
+		cascade.splitFar = splitFar;
+
+		// The smallest sphere around the slice is centered on the camera's forward axis, where the near and far corners
+		// are equally far away. Wide slices have it past the far plane, in which case the far corners alone bound it
+		float centerDepth = min((splitFar + splitNear) * (1.0f + cornerOffsetSq) / 2.0f, splitFar);
+		const float nearRadiusSq = (centerDepth - splitNear) * (centerDepth - splitNear) + splitNear * splitNear * cornerOffsetSq;
+		const float farRadiusSq = (splitFar - centerDepth) * (splitFar - centerDepth) + splitFar * splitFar * cornerOffsetSq;
+		const float radius = ceilf(sqrtf(max(nearRadiusSq, farRadiusSq)) / SHADOW_RADIUS_STEP) * SHADOW_RADIUS_STEP;
+
+		const DirectX::XMFLOAT3 centerLS = ToLightSpace(Add(camera.position, Scale(camera.forward, centerDepth)));
+
+		// Whole texels only, so the same world position always lands on the same texel
+		cascade.texelSize = 2.0f * radius / resolution;
+		const float centerX = floorf(centerLS.x / cascade.texelSize) * cascade.texelSize;
+		const float centerY = floorf(centerLS.y / cascade.texelSize) * cascade.texelSize;
+
+		// Snapping moves the center by up to a texel, which the box makes up for
+		cascade.minLS = { centerX - radius - cascade.texelSize, centerY - radius - cascade.texelSize, centerLS.z - radius };
+		cascade.maxLS = { centerX + radius + cascade.texelSize, centerY + radius + cascade.texelSize, centerLS.z + radius };
+		BuildCasterPlanes(cascade);
+
+		splitNear = splitFar;
+	}
+}
+
+void ShadowCascades::FitCasterDepth(const uint32_t cascadeIndex, const std::vector<ChunkCoord>& casters)
+{
+	OG_ASSERT_MSG(cascadeIndex < NUM_SHADOW_CASCADES, "There's no such cascade");
+	ShadowCascade& cascade = m_cascades[cascadeIndex];
+
+	const float extent = DefaultChunkTraits::HALF_EXTENT * (fabsf(m_lightForward.x) + fabsf(m_lightForward.y) + fabsf(m_lightForward.z));
+	for (const auto& chunkPosCS : casters)
+	{
+		const DirectX::XMFLOAT3 minWS = Orange::Math::ChunkToWorldSpace(chunkPosCS);
+		const DirectX::XMFLOAT3 centerWS = { minWS.x + DefaultChunkTraits::HALF_EXTENT, minWS.y + DefaultChunkTraits::HALF_EXTENT, minWS.z + DefaultChunkTraits::HALF_EXTENT };
+		cascade.minLS.z = min(cascade.minLS.z, Dot(centerWS, m_lightForward) - extent);
+	}
+}
+
+const ShadowCascade& ShadowCascades::GetCascade(const uint32_t cascadeIndex) const
+{
+	OG_ASSERT_MSG(cascadeIndex < NUM_SHADOW_CASCADES, "There's no such cascade");
+	return m_cascades[cascadeIndex];
+}
+
+DirectX::XMFLOAT3 ShadowCascades::ToLightSpace(const DirectX::XMFLOAT3& posWS) const
+{
+	return { Dot(posWS, m_lightRight), Dot(posWS, m_lightUp), Dot(posWS, m_lightForward) };
+}
+
+DirectX::XMFLOAT3 ShadowCascades::GetLightPosition(const uint32_t cascadeIndex) const
+{
+	const ShadowCascade& cascade = GetCascade(cascadeIndex);
+	const float centerX = (cascade.minLS.x + cascade.maxLS.x) / 2.0f;
+	const float centerY = (cascade.minLS.y + cascade.maxLS.y) / 2.0f;
+	return Add(Add(Scale(m_lightRight, centerX), Scale(m_lightUp, centerY)), Scale(m_lightForward, cascade.minLS.z));
+}
+
+const DirectX::XMFLOAT3& ShadowCascades::GetLightRight() const { return m_lightRight; }
+
+const DirectX::XMFLOAT3& ShadowCascades::GetLightUp() const { return m_lightUp; }
+
+const DirectX::XMFLOAT3& ShadowCascades::GetLightForward() const { return m_lightForward; }
+
+std::array<float, NUM_SHADOW_CASCADES> ShadowCascades::GetSplitDepths(const float nearDepth, const float shadowDistance)
+{
+	std::array<float, NUM_SHADOW_CASCADES> splitDepths;
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; i++)
+	{
+		const float t = static_cast<float>(i + 1) / NUM_SHADOW_CASCADES;
+		const float logSplit = nearDepth * powf(shadowDistance / nearDepth, t);
+		const float evenSplit = nearDepth + (shadowDistance - nearDepth) * t;
+		splitDepths[i] = SHADOW_SPLIT_BLEND * logSplit + (1.0f - SHADOW_SPLIT_BLEND) * evenSplit;
+	}
+
+	// Exactly the shadow distance, whatever rounding did to it
+	splitDepths[NUM_SHADOW_CASCADES - 1] = shadowDistance;
+	return splitDepths;
+}
+
+void ShadowCascades::BuildCasterPlanes(ShadowCascade& cascade) const
+{
+	const DirectX::XMFLOAT3 left = Scale(m_lightRight, -1.0f);
+	const DirectX::XMFLOAT3 down = Scale(m_lightUp, -1.0f);
+	const DirectX::XMFLOAT3 back = Scale(m_lightForward, -1.0f);
+
+	cascade.casterPlanes[0] = { m_lightRight, cascade.minLS.x };
+	cascade.casterPlanes[1] = { left, -cascade.maxLS.x };
+	cascade.casterPlanes[2] = { m_lightUp, cascade.minLS.y };
+	cascade.casterPlanes[3] = { down, -cascade.maxLS.y };
+	cascade.casterPlanes[4] = { back, -cascade.maxLS.z };
+	cascade.casterPlanes[5] = cascade.casterPlanes[4];
+}
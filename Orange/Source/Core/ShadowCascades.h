@@ -0,0 +1,95 @@
+#ifndef _SHADOWCASCADES_H
+#define _SHADOWCASCADES_H
+
+#include <array>
+#include <vector>
+
+#include "ChunkCoord.h"
+#include "ChunkCuller.h"
+
+constexpr uint32_t NUM_SHADOW_CASCADES = 4;
+
+// How the splits are spread between the camera's near plane and the shadow distance, from evenly (0) to
+// logarithmically (1). Logarithmic splits give every cascade about the same texel density on screen
+constexpr float SHADOW_SPLIT_BLEND = 0.75f;
+
+// Camera the cascades are fitted to, in WORLD SPACE. The axes have to be orthonormal
+struct ShadowCameraView
+{
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 right;
+	DirectX::XMFLOAT3 up;
+	DirectX::XMFLOAT3 forward;
+
+	// tan(FOV / 2), vertically
+	float tanHalfFov;
+	float aspectRatio;
+	float nearDepth;
+};
+
+// One slice of the camera frustum and the light-space box that covers it
+struct ShadowCascade
+{
+	// Depth range of the slice along the camera's forward axis
+	float splitNear;
+	float splitFar;
+
+	// The box, in LIGHT SPACE (see ShadowCascades::ToLightSpace()). It's the slice's bounding sphere, so it doesn't
+	// change size as the camera turns, and its X and Y are snapped to whole texels so that it doesn't shimmer as the
+	// camera moves. The near Z is pulled towards the light by FitCasterDepth() to take in every caster
+	DirectX::XMFLOAT3 minLS;
+	DirectX::XMFLOAT3 maxLS;
+
+	// World units per shadow map texel
+	float texelSize;
+
+	// The box's sides and its far end, pointing inwards, as ChunkCuller takes them. There's no plane on the light's side,
+	// since a chunk anywhere between the light and the box can cast a shadow into it. The far plane is in there twice
+	std::array<Orange::Plane, NUM_CULLING_PLANES> casterPlanes;
+};
+
+// Fits cascaded shadow maps to the camera. Every cascade covers a slice of the camera frustum, nearer slices being
+// shorter, and comes with the planes that find the chunks casting shadows into it. Those include chunks outside the
+// camera's view, so they have to be culled from every loaded chunk, not the visible ones
+class ShadowCascades
+{
+public:
+
+	// The direction the light travels in, doesn't have to be normalized
+	void SetLightDirection(const DirectX::XMFLOAT3& lightDirection);
+
+	// Splits the camera frustum between its near plane and "shadowDistance" and fits a cascade to every slice, for
+	// a shadow map of "resolution" x "resolution" texels
+	void Fit(const ShadowCameraView& camera, const float shadowDistance, const uint32_t resolution);
+
+	// Moves the cascade's near Z to the closest of "casters" (the chunks its caster planes found), so the depth
+	// range is no longer than it has to be
+	void FitCasterDepth(const uint32_t cascadeIndex, const std::vector<ChunkCoord>& casters);
+
+	const ShadowCascade& GetCascade(const uint32_t cascadeIndex) const;
+
+	// X and Y across the shadow map, Z along the light's direction. Matches XMMatrixLookToLH() from the origin
+	DirectX::XMFLOAT3 ToLightSpace(const DirectX::XMFLOAT3& posWS) const;
+
+	// A point on the light's side of the cascade, for sorting its casters front to back
+	DirectX::XMFLOAT3 GetLightPosition(const uint32_t cascadeIndex) const;
+
+	const DirectX::XMFLOAT3& GetLightRight() const;
+	const DirectX::XMFLOAT3& GetLightUp() const;
+	const DirectX::XMFLOAT3& GetLightForward() const;
+
+	// Returns the view depth every cascade ends at
+	static std::array<float, NUM_SHADOW_CASCADES> GetSplitDepths(const float nearDepth, const float shadowDistance);
+
+private:
+
+	void BuildCasterPlanes(ShadowCascade& cascade) const;
+
+	DirectX::XMFLOAT3 m_lightRight = { 1.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 m_lightUp = { 0.0f, 0.0f, 1.0f };
+	DirectX::XMFLOAT3 m_lightForward = { 0.0f, -1.0f, 0.0f };
+
+	std::array<ShadowCascade, NUM_SHADOW_CASCADES> m_cascades;
+};
+
+#endif
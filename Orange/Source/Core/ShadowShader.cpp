@@ -67,7 +67,7 @@ void ShadowShader::Render()
 
 	BindVertexBuffers();
 
-	uint32_t size = static_cast<uint32_t>(ChunkBufferManager::GetVertexArray().size());
+	uint32_t size = ChunkBufferManager::GetNumInstances();
 	context->Draw(size, 0);
 
 }
@@ -0,0 +1,101 @@
+#include "../Misc/pch.h"
+
+#include "TerrainQuery.h"
+#include "BlockRegistry.h"
+#include "ChunkManager.h"
+#include "WorldGen/TerrainGenerator.h"
+
+// Loaded chunks may have trees (or anything else) on top of the generated surface. The tallest tree is
+// 6 blocks of trunk plus 2 of leaves
+constexpr int32_t SURFACE_FEATURE_HEIGHT = 8;
+
+// How far below the generated surface a loaded column is searched before giving up, e.g. if it was dug out
+constexpr int32_t SURFACE_SEARCH_DEPTH = 64;
+
+// Columns without any solid block above this (which only happens with caves in density terrain) report it as their surface
+constexpr int32_t MIN_SURFACE_HEIGHT = -64;
+
+BlockType TerrainQuery::GetBlockType(const BlockCoord& posBS)
+{
+	Chunk* nearChunk = nullptr;
+	return GetBlockType(posBS, nearChunk);
+}
+
+BlockType TerrainQuery::GetBlockType(const DirectX::XMFLOAT3& posWS)
+{
+	return GetBlockType(Orange::Math::WorldToBlockCoord(posWS));
+}
+
+BlockType TerrainQuery::GetBlockType(const BlockCoord& posBS, Chunk*& nearChunk)
+{
+	Chunk* chunk = ChunkManager::GetChunkAtPos(Orange::Math::BlockToChunkCoord(posBS), nearChunk);
+	if (chunk)
+	{
+		nearChunk = chunk;
+
+		BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+		return chunk->GetBlock(localPos.x, localPos.y, localPos.z)->GetType();
+	}
+
+	return GetUnloadedBlockType(posBS);
+}
+
+BlockType TerrainQuery::GetUnloadedBlockType(const BlockCoord& posBS)
+{
+	// Chunks that were unloaded or demoted keep their blocks (edits included) in the cold tiers
+	BlockType blockType;
+	if (ChunkManager::GetUnloadedBlockType(posBS, blockType)) return blockType;
+
+	return TerrainGenerator::QueryBlock(posBS);
+}
+
+int32_t TerrainQuery::GetSurfaceHeight(const int32_t x, const int32_t z)
+{
+	int32_t generatedHeight;
+	if (!TerrainGenerator::QuerySurfaceHeight(x, z, MIN_SURFACE_HEIGHT, generatedHeight)) return MIN_SURFACE_HEIGHT;
+
+	// Loaded chunks may differ from the generated terrain, so the column is walked down through them
+	int32_t height;
+	if (FindFirstSolidBlock(x, z, generatedHeight + SURFACE_FEATURE_HEIGHT, generatedHeight - SURFACE_SEARCH_DEPTH, height)) return height;
+
+	return generatedHeight;
+}
+
+bool TerrainQuery::FindFirstSolidBlock(const int32_t x, const int32_t z, const int32_t fromY, const int32_t toY, int32_t& outY)
+{
+	// Not every block is collidable (the definitions file decides), so the generator's first non-air block isn't necessarily the answer
+	Chunk* nearChunk = nullptr;
+	for (int32_t y = fromY; y >= toY; y--)
+	{
+		if (BlockRegistry::IsCollidable(GetBlockType(BlockCoord(x, y, z), nearChunk)))
+		{
+			outY = y;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool TerrainCollisionQuery::IsSolid(const BlockCoord& posBS)
+{
+	return BlockRegistry::IsCollidable(TerrainQuery::GetBlockType(posBS, m_nearChunk));
+}
+
+bool TerrainRaycastQuery::IsChunkEmpty(const ChunkCoord& chunkPosCS)
+{
+	// Rays go from neighbor to neighbor, so the last loaded chunk is usually a link away
+	m_chunk = ChunkManager::GetChunkAtPos(chunkPosCS, m_lastLoadedChunk);
+	if (!m_chunk) return false;
+
+	m_lastLoadedChunk = m_chunk;
+	return m_chunk->IsEmpty();
+}
+
+bool TerrainRaycastQuery::IsHit(const BlockCoord& posBS)
+{
+	if (!m_chunk) return BlockRegistry::IsVisible(TerrainQuery::GetUnloadedBlockType(posBS));
+
+	const BlockCoord localPos = Orange::Math::BlockToLocalCoord(posBS);
+	return BlockRegistry::IsVisible(m_chunk->GetBlock(localPos.x, localPos.y, localPos.z)->GetType());
+}
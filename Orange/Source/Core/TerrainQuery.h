@@ -0,0 +1,70 @@
+#ifndef _TERRAINQUERY_H
+#define _TERRAINQUERY_H
+
+#include <DirectXMath.h>
+
+#include "Block.h"
+#include "ChunkCoord.h"
+
+class Chunk;
+
+// Answers questions about the terrain anywhere in the world, whether the chunks are loaded or not. Loaded
+// chunks answer for themselves, so the answers include trees and anything else that changed their blocks.
+// So do chunks that were unloaded or demoted, from the blocks ChunkResidencyManager kept (which also gets
+// demoted chunks promoted back). Everywhere else the terrain generator works the answer out for just that
+// block or column, which is far cheaper than generating the chunk but leaves out trees (see TerrainGenerator::QueryBlock()).
+//
+// Uses the ChunkManager's chunks the same way the rest of the game thread does, so it's meant to be called from there
+class TerrainQuery
+{
+public:
+
+	static BlockType GetBlockType(const BlockCoord& posBS);
+	static BlockType GetBlockType(const DirectX::XMFLOAT3& posWS);
+
+	// Same as above, but "nearChunk" is checked (and updated) first. For lots of queries close to each other
+	static BlockType GetBlockType(const BlockCoord& posBS, Chunk*& nearChunk);
+
+	// Answers for a block whose chunk isn't in the chunk pool, from the cold tiers or the terrain generator
+	static BlockType GetUnloadedBlockType(const BlockCoord& posBS);
+
+	// Returns the highest collidable block of the column
+	static int32_t GetSurfaceHeight(const int32_t x, const int32_t z);
+
+	// Walks down the column from "fromY" to "toY" (both inclusive) and returns the first collidable block
+	static bool FindFirstSolidBlock(const int32_t x, const int32_t z, const int32_t fromY, const int32_t toY, int32_t& outY);
+
+};
+
+// Query for Orange::Physics::SweepAABB() that collides with every collidable block, the same way TerrainQuery answers.
+// The chunk of the last block is kept, so the blocks around an AABB only look up the chunks they cross into
+class TerrainCollisionQuery
+{
+public:
+
+	bool IsSolid(const BlockCoord& posBS);
+
+private:
+
+	Chunk* m_nearChunk = nullptr;
+};
+
+// Query for Orange::Math::Raycast() (see VoxelRaycast.h) that hits every visible block, the same way TerrainQuery answers.
+// Loaded chunks without any visible blocks are skipped whole, and the chunk the ray is in is kept between blocks, so
+// only crossing into another chunk looks one up
+class TerrainRaycastQuery
+{
+public:
+
+	bool IsChunkEmpty(const ChunkCoord& chunkPosCS);
+
+	bool IsHit(const BlockCoord& posBS);
+
+private:
+
+	// nullptr while the ray is in a chunk that isn't loaded, which TerrainQuery::GetUnloadedBlockType() answers for instead
+	Chunk* m_chunk = nullptr;
+	Chunk* m_lastLoadedChunk = nullptr;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef _BIOME_H
+#define _BIOME_H
+
+#include "../Block.h"
+
+enum class Biome : uint8_t
+{
+	PLAINS = 0,
+	HILLS,
+	MOUNTAINS
+};
+
+constexpr uint32_t NUM_BIOMES = 3;
+
+// Everything the generation stages need to know about a biome. The height parameters are blended
+// between neighboring biomes, so the terrain doesn't jump at biome borders
+struct BiomeDefinition
+{
+	const char* name;
+
+	// The surface lies between baseHeight and baseHeight + heightRange
+	float baseHeight;
+	float heightRange;
+
+	// The top block of every column, and the blocks right below it. Everything further down is stone
+	BlockType surfaceBlock;
+	BlockType subsurfaceBlock;
+	int32_t subsurfaceDepth;
+
+	// Chance that a tree grows on a surface block the decoration stage picked
+	float treeChance;
+};
+
+// Indexed by Biome
+constexpr BiomeDefinition BIOME_DEFINITIONS[NUM_BIOMES] =
+{
+	{ "Plains",		80.0f,	30.0f,	BlockType::Grass,	BlockType::Dirt,	3,	0.15f },
+	{ "Hills",		80.0f,	60.0f,	BlockType::Grass,	BlockType::Dirt,	2,	0.40f },
+	{ "Mountains",	90.0f,	110.0f,	BlockType::Stone,	BlockType::Stone,	0,	0.0f }
+};
+
+inline const BiomeDefinition& GetBiomeDefinition(const Biome biome) { return BIOME_DEFINITIONS[static_cast<uint8_t>(biome)]; }
+
+#endif
@@ -0,0 +1,150 @@
+#include "../../Misc/pch.h"
+
+#include "DensityField.h"
+
+// The terrain's surface sits around DENSITY_BASE_HEIGHT. The vertical falloff pulls the density
+// down by 1 every DENSITY_HEIGHT_FALLOFF blocks, the noise (roughly [-1, 1]) pushes the surface
+// up or down by about as much and carves out overhangs where it changes quickly
+constexpr float DENSITY_BASE_HEIGHT = 105.0f;
+constexpr float DENSITY_HEIGHT_FALLOFF = 25.0f;
+static_assert(DENSITY_BASE_HEIGHT + DENSITY_HEIGHT_FALLOFF <= DensityField::MAX_SOLID_HEIGHT, "MAX_SOLID_HEIGHT is too low");
+
+constexpr uint32_t DENSITY_NUM_OCTAVES = 4;
+
+static const WorldNoise s_densityNoise(0.012f, 0.5f, DENSITY_NUM_OCTAVES, 0x5D3E1A27u);
+
+float DensityField::Sample(const NoiseContext& noise, const float x, const float y, const float z)
+{
+	return (DENSITY_BASE_HEIGHT - y) / DENSITY_HEIGHT_FALLOFF + s_densityNoise.Sample(noise, x, y, z);
+}
+
+template<int32_t Size>
+void DensityField::SampleInterpolated(const DirectX::XMFLOAT3& minNS, const NoiseContext& noise, float* outDensity)
+{
+	SampleInterpolated<Size>(minNS, noise, &Sample, outDensity);
+}
+
+template<int32_t Size>
+void DensityField::SampleInterpolated(const DirectX::XMFLOAT3& minNS, const NoiseContext& noise, SampleFunction sampleFunction, float* outDensity)
+{
+	using LatticeT = Lattice<Size>;
+	using SamplesT = Samples<Size>;
+
+	constexpr float latticeStep = static_cast<float>(LATTICE_SPACING);
+	constexpr float invLatticeStep = 1.0f / latticeStep;
+
+	float lattice[LatticeT::VOLUME];
+	for (int32_t x = 0; x < LatticeT::SIZE; x++)
+	{
+		for (int32_t y = 0; y < LatticeT::SIZE; y++)
+		{
+			for (int32_t z = 0; z < LatticeT::SIZE; z++)
+			{
+				lattice[LatticeT::GetIndex(x, y, z)] = sampleFunction(noise, minNS.x + x * latticeStep, minNS.y + y * latticeStep, minNS.z + z * latticeStep);
+			}
+		}
+	}
+
+	// Interpolated along X and Y first, one row of lattice samples at a time. The Z axis is
+	// interpolated last over contiguous rows, which the compiler turns into SIMD loops
+	float latticeRow[LatticeT::SIZE];
+	float deltaRow[LatticeT::SIZE];
+	for (int32_t x = 0; x < Size; x++)
+	{
+		const int32_t cellX = x / LATTICE_SPACING;
+		const float tx = (x % LATTICE_SPACING) * invLatticeStep;
+
+		for (int32_t y = 0; y < SamplesT::HEIGHT; y++)
+		{
+			// The extra layer at y = Size sits exactly on the last lattice sample
+			const int32_t cellY = min(y / LATTICE_SPACING, LatticeT::SIZE - 2);
+			const float ty = (y - cellY * LATTICE_SPACING) * invLatticeStep;
+
+			const float* row00 = &lattice[LatticeT::GetIndex(cellX, cellY, 0)];
+			const float* row10 = &lattice[LatticeT::GetIndex(cellX + 1, cellY, 0)];
+			const float* row01 = &lattice[LatticeT::GetIndex(cellX, cellY + 1, 0)];
+			const float* row11 = &lattice[LatticeT::GetIndex(cellX + 1, cellY + 1, 0)];
+			for (int32_t z = 0; z < LatticeT::SIZE; z++)
+			{
+				const float bottom = row00[z] + (row10[z] - row00[z]) * tx;
+				const float top = row01[z] + (row11[z] - row01[z]) * tx;
+				latticeRow[z] = bottom + (top - bottom) * ty;
+			}
+
+			for (int32_t z = 0; z < LatticeT::SIZE - 1; z++)
+			{
+				deltaRow[z] = (latticeRow[z + 1] - latticeRow[z]) * invLatticeStep;
+			}
+
+			float* outRow = &outDensity[SamplesT::GetIndex(x, y, 0)];
+			for (int32_t z = 0; z < Size; z++)
+			{
+				const int32_t cellZ = z / LATTICE_SPACING;
+				outRow[z] = latticeRow[cellZ] + deltaRow[cellZ] * static_cast<float>(z % LATTICE_SPACING);
+			}
+		}
+	}
+}
+
+float DensityField::SampleInterpolatedAt(const BlockCoord& posBS, const DirectX::XMFLOAT3& noiseOffset, const NoiseContext& noise, SampleFunction sampleFunction)
+{
+	constexpr float latticeStep = static_cast<float>(LATTICE_SPACING);
+	constexpr float invLatticeStep = 1.0f / latticeStep;
+	constexpr int32_t latticeMask = LATTICE_SPACING - 1;
+
+	const BlockCoord localPos(posBS.x & latticeMask, posBS.y & latticeMask, posBS.z & latticeMask);
+	const DirectX::XMFLOAT3 cellNS(
+		static_cast<float>(posBS.x - localPos.x) + noiseOffset.x,
+		static_cast<float>(posBS.y - localPos.y) + noiseOffset.y,
+		static_cast<float>(posBS.z - localPos.z) + noiseOffset.z);
+
+	// The same operations in the same order as SampleInterpolated(), X and Y first and then Z
+	const float tx = localPos.x * invLatticeStep;
+	const float ty = localPos.y * invLatticeStep;
+
+	float latticeRow[2];
+	for (int32_t z = 0; z < 2; z++)
+	{
+		const float cellZ = cellNS.z + z * latticeStep;
+		const float sample00 = sampleFunction(noise, cellNS.x, cellNS.y, cellZ);
+		const float sample10 = sampleFunction(noise, cellNS.x + latticeStep, cellNS.y, cellZ);
+		const float sample01 = sampleFunction(noise, cellNS.x, cellNS.y + latticeStep, cellZ);
+		const float sample11 = sampleFunction(noise, cellNS.x + latticeStep, cellNS.y + latticeStep, cellZ);
+
+		const float bottom = sample00 + (sample10 - sample00) * tx;
+		const float top = sample01 + (sample11 - sample01) * tx;
+		latticeRow[z] = bottom + (top - bottom) * ty;
+	}
+
+	const float delta = (latticeRow[1] - latticeRow[0]) * invLatticeStep;
+	return latticeRow[0] + delta * static_cast<float>(localPos.z);
+}
+
+template<int32_t Size>
+void DensityField::SampleFullResolution(const DirectX::XMFLOAT3& minNS, const NoiseContext& noise, float* outDensity)
+{
+	using SamplesT = Samples<Size>;
+
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t y = 0; y < SamplesT::HEIGHT; y++)
+		{
+			for (int32_t z = 0; z < Size; z++)
+			{
+				outDensity[SamplesT::GetIndex(x, y, z)] = Sample(noise, minNS.x + x, minNS.y + y, minNS.z + z);
+			}
+		}
+	}
+}
+
+template void DensityField::SampleInterpolated<16>(const DirectX::XMFLOAT3&, const NoiseContext&, float*);
+template void DensityField::SampleInterpolated<32>(const DirectX::XMFLOAT3&, const NoiseContext&, float*);
+template void DensityField::SampleInterpolated<64>(const DirectX::XMFLOAT3&, const NoiseContext&, float*);
+
+template void DensityField::SampleInterpolated<16>(const DirectX::XMFLOAT3&, const NoiseContext&, SampleFunction, float*);
+template void DensityField::SampleInterpolated<32>(const DirectX::XMFLOAT3&, const NoiseContext&, SampleFunction, float*);
+template void DensityField::SampleInterpolated<64>(const DirectX::XMFLOAT3&, const NoiseContext&, SampleFunction, float*);
+
+template void DensityField::SampleFullResolution<16>(const DirectX::XMFLOAT3&, const NoiseContext&, float*);
+template void DensityField::SampleFullResolution<32>(const DirectX::XMFLOAT3&, const NoiseContext&, float*);
+template void DensityField::SampleFullResolution<64>(const DirectX::XMFLOAT3&, const NoiseContext&, float*);
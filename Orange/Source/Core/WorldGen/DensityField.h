@@ -0,0 +1,77 @@
+#ifndef _DENSITYFIELD_H
+#define _DENSITYFIELD_H
+
+#include <DirectXMath.h>
+
+#include "WorldNoise.h"
+#include "../ChunkCoord.h"
+
+// 3D terrain as a density field: a block is solid wherever the density is above zero, which allows
+// overhangs and caves that a heightmap can't represent. 3D fractal noise is too expensive to evaluate
+// for every block, so it's sampled on a coarse lattice (every LATTICE_SPACING blocks) and trilinearly
+// interpolated to full resolution instead
+class DensityField
+{
+public:
+
+	static constexpr int32_t LATTICE_SPACING = 4;
+
+	// The noise is in [-1, 1], so the density is negative everywhere above this height
+	static constexpr int32_t MAX_SOLID_HEIGHT = 130;
+
+	// The density of every block in a chunk, plus one extra layer at y = Size so that the surface
+	// of the chunk can be found without sampling the chunk above. Laid out as [x][y][z]
+	template<int32_t Size>
+	struct Samples
+	{
+		static constexpr int32_t HEIGHT = Size + 1;
+		static constexpr uint32_t VOLUME = static_cast<uint32_t>(Size * HEIGHT * Size);
+
+		static constexpr uint32_t GetIndex(const int32_t x, const int32_t y, const int32_t z)
+		{
+			return static_cast<uint32_t>((x * HEIGHT + y) * Size + z);
+		}
+	};
+
+	// Noise samples at every LATTICE_SPACING blocks, including both chunk borders. Laid out as [x][y][z]
+	template<int32_t Size>
+	struct Lattice
+	{
+		static_assert(Size % LATTICE_SPACING == 0, "The chunk size has to be a multiple of the lattice spacing");
+
+		static constexpr int32_t SIZE = Size / LATTICE_SPACING + 1;
+		static constexpr uint32_t VOLUME = static_cast<uint32_t>(SIZE * SIZE * SIZE);
+
+		static constexpr uint32_t GetIndex(const int32_t x, const int32_t y, const int32_t z)
+		{
+			return static_cast<uint32_t>((x * SIZE + y) * SIZE + z);
+		}
+	};
+
+	// Any 3D field that's cheap to interpolate, in NOISE SPACE. Called once per lattice point
+	using SampleFunction = float(*)(const NoiseContext& noise, const float x, const float y, const float z);
+
+	// Returns the density at a position in NOISE SPACE (world space shifted by the seed's offset)
+	static float Sample(const NoiseContext& noise, const float x, const float y, const float z);
+
+	// Fills "outDensity" (Samples<Size>::VOLUME values) for the chunk whose minimum corner is at "minNS", in NOISE SPACE.
+	// Both are instantiated for every size ChunkTraits supports
+	template<int32_t Size>
+	static void SampleInterpolated(const DirectX::XMFLOAT3& minNS, const NoiseContext& noise, float* outDensity);
+
+	// Same as above, but interpolates "sampleFunction" instead of the terrain's density (e.g. for carving caves)
+	template<int32_t Size>
+	static void SampleInterpolated(const DirectX::XMFLOAT3& minNS, const NoiseContext& noise, SampleFunction sampleFunction, float* outDensity);
+
+	// The value SampleInterpolated() produces for the block at "posBS", without sampling the rest of the chunk.
+	// "noiseOffset" is the difference between NOISE SPACE and WORLD SPACE. The lattice lines up with every
+	// chunk size, so this matches the chunk's value up to rounding at the top layer of a chunk
+	static float SampleInterpolatedAt(const BlockCoord& posBS, const DirectX::XMFLOAT3& noiseOffset, const NoiseContext& noise, SampleFunction sampleFunction);
+
+	// Samples the noise for every block. Only meant as the reference for SampleInterpolated()
+	template<int32_t Size>
+	static void SampleFullResolution(const DirectX::XMFLOAT3& minNS, const NoiseContext& noise, float* outDensity);
+
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "../../Misc/pch.h"
+
+#include "PendingWriteStore.h"
+
+// Higher priorities win when two writes (or a write and the chunk's own block) meet
+static uint32_t GetWritePriority(const BlockType type)
+{
+	switch (type)
+	{
+	case BlockType::Air:	return 0;
+	case BlockType::Leaves:	return 1;
+	case BlockType::Wood:	return 2;
+	default:				return 3;
+	}
+}
+
+BlockType PendingWriteStore::MergeBlock(const BlockType current, const BlockType write)
+{
+	return GetWritePriority(write) > GetWritePriority(current) ? write : current;
+}
+
+void PendingWriteStore::Submit(const std::vector<PendingBlockWrite>& writes)
+{
+	if (writes.empty()) return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (const auto& write : writes)
+	{
+		TargetChunk& target = m_targetChunks[{ write.targetCS, write.chunkSize }];
+
+		auto existingWrite = target.writes.find(write.index);
+		if (existingWrite == target.writes.end()) target.writes.emplace(write.index, write.type);
+		else existingWrite->second = MergeBlock(existingWrite->second, write.type);
+
+		if (target.isResident) m_lateWrites.push_back(write);
+	}
+}
+
+uint32_t PendingWriteStore::ApplyAndMarkResident(const ChunkCoord& chunkPosCS, const int32_t chunkSize, BlockType* blocks)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	TargetChunk& target = m_targetChunks[{ chunkPosCS, chunkSize }];
+	target.isResident = true;
+
+	for (const auto& write : target.writes)
+	{
+		blocks[write.first] = MergeBlock(blocks[write.first], write.second);
+	}
+
+	return static_cast<uint32_t>(target.writes.size());
+}
+
+void PendingWriteStore::MarkEvicted(const ChunkCoord& chunkPosCS, const int32_t chunkSize)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto target = m_targetChunks.find({ chunkPosCS, chunkSize });
+	if (target == m_targetChunks.end()) return;
+
+	// Nothing to keep around for chunks that never received any writes
+	if (target->second.writes.empty()) m_targetChunks.erase(target);
+	else target->second.isResident = false;
+}
+
+void PendingWriteStore::TakeLateWrites(std::vector<PendingBlockWrite>& outWrites)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	outWrites.insert(outWrites.end(), m_lateWrites.begin(), m_lateWrites.end());
+	m_lateWrites.clear();
+}
+
+void PendingWriteStore::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_targetChunks.clear();
+	m_lateWrites.clear();
+}
+
+const uint32_t PendingWriteStore::GetNumTargetChunks() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return static_cast<uint32_t>(m_targetChunks.size());
+}
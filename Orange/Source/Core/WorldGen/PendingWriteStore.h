@@ -0,0 +1,83 @@
+#ifndef _PENDINGWRITESTORE_H
+#define _PENDINGWRITESTORE_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../Block.h"
+#include "../ChunkCoord.h"
+
+// A block a chunk's generation wants to place in another chunk, e.g. the top of a tree
+struct PendingBlockWrite
+{
+	ChunkCoord targetCS;
+	int32_t chunkSize;
+
+	// Index into the target chunk's blocks, laid out as [x][y][z]
+	uint32_t index;
+	BlockType type;
+};
+
+// Collects the blocks that features (trees, ...) place outside of the chunk they're generated in. Writes
+// to a chunk are kept for as long as the world exists and applied every time the chunk's blocks are
+// created, whether it's generated or brought back from the residency tiers. Writes to a chunk that is
+// resident at the time are queued as "late" writes as well, so whoever owns the chunk can apply them.
+//
+// Writes are combined with MergeBlock(), which doesn't care about order, so the world comes out the
+// same no matter which threads generate which chunks in which order
+class PendingWriteStore
+{
+public:
+
+	// Features never replace terrain, and trunks win over leaves. Commutative and idempotent
+	static BlockType MergeBlock(const BlockType current, const BlockType write);
+
+	void Submit(const std::vector<PendingBlockWrite>& writes);
+
+	// Merges every write recorded for the chunk into "blocks" (ChunkTraits<size>::VOLUME block types)
+	// and marks the chunk as resident. Returns the number of writes applied
+	uint32_t ApplyAndMarkResident(const ChunkCoord& chunkPosCS, const int32_t chunkSize, BlockType* blocks);
+
+	// The chunk's blocks are gone, writes to it are only recorded from now on
+	void MarkEvicted(const ChunkCoord& chunkPosCS, const int32_t chunkSize);
+
+	// Moves the writes that reached resident chunks into "outWrites"
+	void TakeLateWrites(std::vector<PendingBlockWrite>& outWrites);
+
+	void Clear();
+
+	const uint32_t GetNumTargetChunks() const;
+
+private:
+
+	struct ChunkKey
+	{
+		ChunkCoord posCS;
+		int32_t size;
+
+		bool operator==(const ChunkKey& other) const { return posCS == other.posCS && size == other.size; }
+	};
+
+	struct ChunkKeyHasher
+	{
+		size_t operator()(const ChunkKey& key) const
+		{
+			return static_cast<size_t>(Orange::Math::GetHashKeyFromChunkPosition(key.posCS) ^ static_cast<uint64_t>(key.size));
+		}
+	};
+
+	struct TargetChunk
+	{
+		// Block index -> merged block type
+		std::unordered_map<uint32_t, BlockType> writes;
+		bool isResident = false;
+	};
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<ChunkKey, TargetChunk, ChunkKeyHasher> m_targetChunks;
+	std::vector<PendingBlockWrite> m_lateWrites;
+
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include "../../Misc/pch.h"
+
+#include "TerrainGenerator.h"
+#include "WorldGenStages.h"
+#include "DensityField.h"
+#include "../../Utility/Utility.h"
+
+// How far (in blocks) the seed can move the sampled region of the noise. Kept well below
+// the point where floats stop being able to represent every block position
+constexpr uint32_t MAX_NOISE_OFFSET = 1 << 20;
+
+uint64_t TerrainGenerator::m_seed = TerrainGenerator::DEFAULT_SEED;
+TerrainShape TerrainGenerator::m_terrainShape = TerrainShape::HEIGHTMAP;
+NoiseBackend TerrainGenerator::m_noiseBackend = NoiseBackend::SIMPLEX;
+float TerrainGenerator::m_noiseOffsetX = 0.0f;
+float TerrainGenerator::m_noiseOffsetZ = 0.0f;
+WorldGenPipeline TerrainGenerator::m_pipeline;
+bool TerrainGenerator::m_isPipelineBuilt = false;
+
+// splitmix64, spreads nearby seeds far apart
+static uint64_t MixSeed(uint64_t seed)
+{
+	seed += 0x9E3779B97F4A7C15ull;
+	seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+	seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+	return seed ^ (seed >> 31);
+}
+
+void TerrainGenerator::SetSeed(const uint64_t seed)
+{
+	m_seed = seed;
+
+	ApplySeed();
+	if (!m_isPipelineBuilt) BuildPipeline();
+}
+
+const uint64_t TerrainGenerator::GetSeed() { return m_seed; }
+
+void TerrainGenerator::SetTerrainShape(const TerrainShape shape)
+{
+	m_terrainShape = shape;
+	BuildPipeline();
+}
+
+const TerrainShape TerrainGenerator::GetTerrainShape() { return m_terrainShape; }
+
+void TerrainGenerator::SetNoiseBackend(const NoiseBackend backend)
+{
+	m_noiseBackend = backend;
+
+	// Also clears the region cache, which was generated with the old noise
+	ApplySeed();
+	BuildPipeline();
+}
+
+const NoiseBackend TerrainGenerator::GetNoiseBackend() { return m_noiseBackend; }
+
+template<int32_t Size>
+DirectX::XMFLOAT3 TerrainGenerator::GetChunkNoiseOrigin(const ChunkCoord& chunkPosCS)
+{
+	DirectX::XMFLOAT3 posWS = Orange::Math::ChunkToWorldSpace<Size>(chunkPosCS);
+	return { posWS.x + m_noiseOffsetX, posWS.y, posWS.z + m_noiseOffsetZ };
+}
+
+template<int32_t Size>
+void TerrainGenerator::GenerateChunk(const ChunkCoord& chunkPosCS, BlockType* outBlockTypes)
+{
+	OG_ASSERT_MSG(m_isPipelineBuilt, "SetSeed() has to be called before generating chunks");
+	m_pipeline.GenerateChunk<Size>(chunkPosCS, outBlockTypes);
+}
+
+BlockType TerrainGenerator::QueryBlock(const BlockCoord& posBS)
+{
+	OG_ASSERT_MSG(m_isPipelineBuilt, "SetSeed() has to be called before querying the terrain");
+	return m_pipeline.QueryBlock(posBS);
+}
+
+bool TerrainGenerator::QuerySurfaceHeight(const int32_t x, const int32_t z, const int32_t minY, int32_t& outHeight)
+{
+	OG_ASSERT_MSG(m_isPipelineBuilt, "SetSeed() has to be called before querying the terrain");
+
+	// The heightmap is cached with the region. Caves fade out well below the lowest surface, so they never change it
+	int32_t height;
+	if (m_pipeline.QueryColumnHeight(x, z, height))
+	{
+		if (height < minY) return false;
+
+		outHeight = height;
+		return true;
+	}
+
+	// Without a heightmap the column has to be walked down, starting where the terrain can't be solid anymore
+	int32_t maxHeight = INT32_MIN;
+	switch (m_terrainShape)
+	{
+	case TerrainShape::DENSITY:
+		maxHeight = DensityField::MAX_SOLID_HEIGHT;
+		break;
+	default:
+		OG_ASSERT_MSG(false, "No upper bound for the terrain's height");
+		return false;
+	}
+
+	return m_pipeline.QueryFirstSolidBlock(x, z, maxHeight, minY, outHeight);
+}
+
+bool TerrainGenerator::QueryFirstSolidBlock(const int32_t x, const int32_t z, const int32_t fromY, const int32_t toY, int32_t& outY)
+{
+	OG_ASSERT_MSG(m_isPipelineBuilt, "SetSeed() has to be called before querying the terrain");
+	return m_pipeline.QueryFirstSolidBlock(x, z, fromY, toY, outY);
+}
+
+WorldGenPipeline& TerrainGenerator::GetPipeline() { return m_pipeline; }
+
+void TerrainGenerator::BuildPipeline()
+{
+	m_pipeline.Clear();
+
+	AddStage(std::make_unique<ClimateStage>());
+	AddStage(std::make_unique<BiomeStage>());
+
+	switch (m_terrainShape)
+	{
+	case TerrainShape::HEIGHTMAP:
+		AddStage(std::make_unique<HeightStage>());
+		AddStage(std::make_unique<SurfaceStage>());
+		break;
+	case TerrainShape::DENSITY:
+		AddStage(std::make_unique<DensityTerrainStage>());
+		break;
+	default:
+		OG_ASSERT_MSG(false, "Unknown terrain shape");
+		break;
+	}
+
+	AddStage(std::make_unique<CaveStage>());
+	AddStage(std::make_unique<DecorationStage>());
+
+	m_isPipelineBuilt = true;
+}
+
+void TerrainGenerator::AddStage(std::unique_ptr<WorldGenStage> stage)
+{
+	stage->SetNoiseBackend(m_noiseBackend);
+	m_pipeline.AddStage(std::move(stage));
+}
+
+void TerrainGenerator::ApplySeed()
+{
+	if (m_seed == DEFAULT_SEED || m_noiseBackend == NoiseBackend::HASH)
+	{
+		m_noiseOffsetX = m_noiseOffsetZ = 0.0f;
+	}
+	else
+	{
+		uint64_t mixedSeed = MixSeed(m_seed);
+		m_noiseOffsetX = static_cast<float>(static_cast<int32_t>(mixedSeed % (2 * MAX_NOISE_OFFSET)) - static_cast<int32_t>(MAX_NOISE_OFFSET));
+		m_noiseOffsetZ = static_cast<float>(static_cast<int32_t>((mixedSeed >> 32) % (2 * MAX_NOISE_OFFSET)) - static_cast<int32_t>(MAX_NOISE_OFFSET));
+	}
+
+	m_pipeline.SetSeed(m_seed, m_noiseOffsetX, m_noiseOffsetZ);
+}
+
+template DirectX::XMFLOAT3 TerrainGenerator::GetChunkNoiseOrigin<16>(const ChunkCoord&);
+template DirectX::XMFLOAT3 TerrainGenerator::GetChunkNoiseOrigin<32>(const ChunkCoord&);
+template DirectX::XMFLOAT3 TerrainGenerator::GetChunkNoiseOrigin<64>(const ChunkCoord&);
+
+template void TerrainGenerator::GenerateChunk<16>(const ChunkCoord&, BlockType*);
+template void TerrainGenerator::GenerateChunk<32>(const ChunkCoord&, BlockType*);
+template void TerrainGenerator::GenerateChunk<64>(const ChunkCoord&, BlockType*);
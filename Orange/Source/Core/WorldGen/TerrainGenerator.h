@@ -0,0 +1,88 @@
+#ifndef _TERRAINGENERATOR_H
+#define _TERRAINGENERATOR_H
+
+#include "WorldGenPipeline.h"
+#include "../Chunk.h"
+
+// How the shape of the terrain is generated
+enum class TerrainShape : uint8_t
+{
+	HEIGHTMAP,	// 2D noise, one surface height per column
+	DENSITY		// 3D density field (see DensityField), allows overhangs
+};
+
+// Generates the block data for a single chunk. This doesn't touch the GPU or any of
+// the ChunkManager's state, so it's safe to call from any thread and it's shared between
+// the game and the headless tools. The actual work is done by a WorldGenPipeline:
+//
+//		HEIGHTMAP:	Climate -> Biome -> Height -> Surface -> Caves -> Decoration
+//		DENSITY:	Climate -> Biome -> Density -> Caves -> Decoration
+class TerrainGenerator
+{
+public:
+
+	// Seed 0 samples the noise without any offset
+	static constexpr uint64_t DEFAULT_SEED = 0;
+
+	// Must be called before any chunks are generated (this also sets up the pipeline), changing it afterwards
+	// makes the new chunks not line up with the old ones
+	static void SetSeed(const uint64_t seed);
+	static const uint64_t GetSeed();
+
+	// Same as the seed, has to be picked before any chunks are generated
+	static void SetTerrainShape(const TerrainShape shape);
+	static const TerrainShape GetTerrainShape();
+
+	// The noise every stage samples, has to be picked before any chunks are generated as well. Single stages
+	// can be switched through the pipeline (see WorldGenPipeline::SetStageNoiseBackend())
+	static void SetNoiseBackend(const NoiseBackend backend);
+	static const NoiseBackend GetNoiseBackend();
+
+	// Returns the minimum corner of the chunk in NOISE SPACE, which is world space shifted by the seed
+	template<int32_t Size = CHUNK_SIZE>
+	static DirectX::XMFLOAT3 GetChunkNoiseOrigin(const ChunkCoord& chunkPosCS);
+
+	// Fills "outBlockTypes" with ChunkTraits<Size>::VOLUME block types laid out as [x][y][z], for the chunk
+	// at "chunkPosCS" (in CHUNK SPACE of that chunk size). Instantiated for every size ChunkTraits supports
+	template<int32_t Size = CHUNK_SIZE>
+	static void GenerateChunk(const ChunkCoord& chunkPosCS, BlockType* outBlockTypes);
+
+	// The terrain at a single block or column, worked out without generating any chunks (see WorldGenPipeline::QueryBlock()).
+	// Trees aren't included, they need the terrain around them. Safe to call from any thread
+	static BlockType QueryBlock(const BlockCoord& posBS);
+
+	// Returns the highest block of the column that isn't air, or false if there's none above "minY"
+	static bool QuerySurfaceHeight(const int32_t x, const int32_t z, const int32_t minY, int32_t& outHeight);
+
+	// Walks down the column from "fromY" to "toY" (both inclusive) and returns the first block that isn't air
+	static bool QueryFirstSolidBlock(const int32_t x, const int32_t z, const int32_t fromY, const int32_t toY, int32_t& outY);
+
+	// For the per-stage timings and the writes chunks make to each other (see PendingWriteStore)
+	static WorldGenPipeline& GetPipeline();
+
+private:
+
+	static void BuildPipeline();
+
+	static void AddStage(std::unique_ptr<WorldGenStage> stage);
+
+	// Derives the noise offset from the seed and hands both to the pipeline
+	static void ApplySeed();
+
+private:
+
+	static uint64_t m_seed;
+	static TerrainShape m_terrainShape;
+	static NoiseBackend m_noiseBackend;
+
+	// SimplexNoise has no seed of its own, so the seed is applied by sampling a different region
+	// of the noise instead. HashNoise takes the seed directly, so these stay 0. In WORLD SPACE
+	static float m_noiseOffsetX;
+	static float m_noiseOffsetZ;
+
+	static WorldGenPipeline m_pipeline;
+	static bool m_isPipelineBuilt;
+
+};
+
+#endif
@@ -0,0 +1,300 @@
+#include "../../Misc/pch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "WorldGenPipeline.h"
+
+// Each region is roughly 26 KB. 256 of them cover a 1024 x 1024 block area, more than the maximum render distance
+constexpr uint32_t MAX_CACHED_REGIONS = 256;
+
+WorldGenPipeline::WorldGenPipeline() : m_stages(), m_stageTimings(), m_availableLayers(WORLDGEN_LAYER_NONE), m_seed(0), m_noiseSeed(0), m_noiseOffsetX(0.0f), m_noiseOffsetZ(0.0f),
+	m_pendingWrites(), m_cacheMutex(), m_regionCache(), m_cacheClock(0)
+{
+}
+
+void WorldGenPipeline::AddStage(std::unique_ptr<WorldGenStage> stage)
+{
+	OG_ASSERT(stage);
+	OG_ASSERT_MSG((stage->GetInputs() & ~m_availableLayers) == 0, "A world generation stage needs a layer that none of the previous stages produce");
+	OG_ASSERT_MSG(stage->GetScope() == WorldGenStageScope::CHUNK || m_stages.empty() || m_stages.back()->GetScope() == WorldGenStageScope::REGION,
+		"Region stages have to be added before any chunk stages");
+	OG_ASSERT_MSG(stage->GetScope() == WorldGenStageScope::CHUNK || (stage->GetOutputs() & WORLDGEN_LAYER_BLOCKS) == 0,
+		"Region stages can't produce blocks");
+
+	m_availableLayers |= stage->GetOutputs();
+	m_stages.push_back(std::move(stage));
+	m_stageTimings.push_back(std::make_unique<StageTiming>());
+
+	// Regions generated so far are missing the new stage's output
+	std::unique_lock<std::shared_mutex> lock(m_cacheMutex);
+	m_regionCache.clear();
+}
+
+void WorldGenPipeline::Clear()
+{
+	m_stages.clear();
+	m_stageTimings.clear();
+	m_availableLayers = WORLDGEN_LAYER_NONE;
+
+	std::unique_lock<std::shared_mutex> lock(m_cacheMutex);
+	m_regionCache.clear();
+}
+
+void WorldGenPipeline::SetSeed(const uint64_t seed, const float noiseOffsetX, const float noiseOffsetZ)
+{
+	m_seed = seed;
+	m_noiseSeed = WorldNoise::GetNoiseSeed(seed);
+	m_noiseOffsetX = noiseOffsetX;
+	m_noiseOffsetZ = noiseOffsetZ;
+
+	m_pendingWrites.Clear();
+
+	std::unique_lock<std::shared_mutex> lock(m_cacheMutex);
+	m_regionCache.clear();
+}
+
+bool WorldGenPipeline::SetStageNoiseBackend(const char* stageName, const NoiseBackend backend)
+{
+	for (auto& stage : m_stages)
+	{
+		if (strcmp(stage->GetName(), stageName) != 0) continue;
+
+		stage->SetNoiseBackend(backend);
+
+		std::unique_lock<std::shared_mutex> lock(m_cacheMutex);
+		m_regionCache.clear();
+		return true;
+	}
+
+	return false;
+}
+
+template<int32_t Size>
+void WorldGenPipeline::GenerateChunk(const ChunkCoord& chunkPosCS, BlockType* outBlockTypes)
+{
+	static_assert(WorldGenRegion::SIZE % Size == 0, "Chunks can't straddle two regions");
+
+	OG_ASSERT_MSG((m_availableLayers & WORLDGEN_LAYER_BLOCKS) != 0, "None of the world generation stages produce blocks");
+
+	WorldGenChunk chunk;
+	chunk.posCS = chunkPosCS;
+	chunk.size = Size;
+	chunk.minBS = Orange::Math::ChunkToBlockCoord<Size>(chunkPosCS);
+	chunk.originNS = { static_cast<float>(chunk.minBS.x) + m_noiseOffsetX, static_cast<float>(chunk.minBS.y), static_cast<float>(chunk.minBS.z) + m_noiseOffsetZ };
+	chunk.blocks = outBlockTypes;
+	chunk.seed = m_seed;
+	chunk.noiseSeed = m_noiseSeed;
+
+	thread_local std::vector<PendingBlockWrite> outgoingWrites;
+	outgoingWrites.clear();
+	chunk.outgoingWrites = &outgoingWrites;
+
+	// Keeps the region alive even if it's evicted while this chunk is being generated
+	const int32_t regionX = chunk.minBS.x >> WorldGenRegion::SHIFT;
+	const int32_t regionZ = chunk.minBS.z >> WorldGenRegion::SHIFT;
+	std::shared_ptr<const WorldGenRegion> region = GetRegion(regionX, regionZ);
+	chunk.region = region.get();
+	chunk.regionOffsetX = chunk.minBS.x - (regionX << WorldGenRegion::SHIFT);
+	chunk.regionOffsetZ = chunk.minBS.z - (regionZ << WorldGenRegion::SHIFT);
+
+	std::fill(outBlockTypes, outBlockTypes + ChunkTraits<Size>::VOLUME, BlockType::Air);
+
+	for (size_t i = 0; i < m_stages.size(); i++)
+	{
+		if (m_stages[i]->GetScope() != WorldGenStageScope::CHUNK) continue;
+
+		auto start = std::chrono::steady_clock::now();
+		m_stages[i]->GenerateChunk(chunk);
+		AddStageTime(i, start);
+	}
+
+	// Only after every stage ran, so that the stages only ever see the chunk's own blocks. Otherwise
+	// the result would depend on the order the chunks were generated in
+	m_pendingWrites.Submit(outgoingWrites);
+	m_pendingWrites.ApplyAndMarkResident(chunkPosCS, Size, outBlockTypes);
+}
+
+BlockType WorldGenPipeline::QueryBlock(const BlockCoord& posBS)
+{
+	WorldGenBlockQuery query;
+	std::shared_ptr<const WorldGenRegion> region = PrepareColumnQuery(posBS.x, posBS.z, query);
+	query.posBS.y = posBS.y;
+
+	return RunQueryStages(query);
+}
+
+bool WorldGenPipeline::QueryColumnHeight(const int32_t x, const int32_t z, int32_t& outHeight)
+{
+	if ((m_availableLayers & WORLDGEN_LAYER_HEIGHT) == 0) return false;
+
+	WorldGenBlockQuery query;
+	std::shared_ptr<const WorldGenRegion> region = PrepareColumnQuery(x, z, query);
+	outHeight = region->height[WorldGenRegion::GetIndex(query.regionOffsetX, query.regionOffsetZ)];
+	return true;
+}
+
+bool WorldGenPipeline::QueryFirstSolidBlock(const int32_t x, const int32_t z, const int32_t fromY, const int32_t toY, int32_t& outY)
+{
+	WorldGenBlockQuery query;
+	std::shared_ptr<const WorldGenRegion> region = PrepareColumnQuery(x, z, query);
+
+	for (int32_t y = fromY; y >= toY; y--)
+	{
+		query.posBS.y = y;
+		if (RunQueryStages(query) != BlockType::Air)
+		{
+			outY = y;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::vector<WorldGenStageStats> WorldGenPipeline::GetStageStats() const
+{
+	std::vector<WorldGenStageStats> stats;
+	stats.reserve(m_stages.size());
+	for (size_t i = 0; i < m_stages.size(); i++)
+	{
+		WorldGenStageStats stageStats;
+		stageStats.name = m_stages[i]->GetName();
+		stageStats.scope = m_stages[i]->GetScope();
+		stageStats.numInvocations = m_stageTimings[i]->numInvocations;
+		stageStats.totalMs = static_cast<float>(m_stageTimings[i]->nanoseconds.load() / 1000000.0);
+		stats.push_back(stageStats);
+	}
+
+	return stats;
+}
+
+void WorldGenPipeline::ResetStageStats()
+{
+	for (auto& timing : m_stageTimings)
+	{
+		timing->nanoseconds = 0;
+		timing->numInvocations = 0;
+	}
+}
+
+void WorldGenPipeline::LogStageStats() const
+{
+	for (const auto& stats : GetStageStats())
+	{
+		OG_LOG_INFO("World generation stage %s: %llu %s in %2.3f ms (%2.2f us each)", stats.name, stats.numInvocations,
+			stats.scope == WorldGenStageScope::REGION ? "regions" : "chunks", stats.totalMs,
+			stats.numInvocations > 0 ? stats.totalMs * 1000.0f / stats.numInvocations : 0.0f);
+	}
+}
+
+const uint32_t WorldGenPipeline::GetNumCachedRegions() const
+{
+	std::shared_lock<std::shared_mutex> lock(m_cacheMutex);
+	return static_cast<uint32_t>(m_regionCache.size());
+}
+
+PendingWriteStore& WorldGenPipeline::GetPendingWrites() { return m_pendingWrites; }
+
+std::shared_ptr<const WorldGenRegion> WorldGenPipeline::PrepareColumnQuery(const int32_t x, const int32_t z, WorldGenBlockQuery& outQuery)
+{
+	OG_ASSERT_MSG((m_availableLayers & WORLDGEN_LAYER_BLOCKS) != 0, "None of the world generation stages produce blocks");
+
+	const int32_t regionX = x >> WorldGenRegion::SHIFT;
+	const int32_t regionZ = z >> WorldGenRegion::SHIFT;
+	std::shared_ptr<const WorldGenRegion> region = GetRegion(regionX, regionZ);
+
+	outQuery.posBS = BlockCoord(x, 0, z);
+	outQuery.noiseOffset = { m_noiseOffsetX, 0.0f, m_noiseOffsetZ };
+	outQuery.region = region.get();
+	outQuery.regionOffsetX = x - (regionX << WorldGenRegion::SHIFT);
+	outQuery.regionOffsetZ = z - (regionZ << WorldGenRegion::SHIFT);
+	outQuery.seed = m_seed;
+	outQuery.noiseSeed = m_noiseSeed;
+
+	return region;
+}
+
+BlockType WorldGenPipeline::RunQueryStages(const WorldGenBlockQuery& query) const
+{
+	BlockType type = BlockType::Air;
+	for (const auto& stage : m_stages)
+	{
+		if (stage->GetScope() == WorldGenStageScope::CHUNK) type = stage->QueryBlock(query, type);
+	}
+
+	return type;
+}
+
+std::shared_ptr<const WorldGenRegion> WorldGenPipeline::GetRegion(const int32_t regionX, const int32_t regionZ)
+{
+	const uint64_t hashKey = Orange::Math::GetHashKeyFromChunkPosition(ChunkCoord(regionX, 0, regionZ));
+
+	{
+		std::shared_lock<std::shared_mutex> lock(m_cacheMutex);
+		auto cachedRegion = m_regionCache.find(hashKey);
+		if (cachedRegion != m_regionCache.end())
+		{
+			cachedRegion->second.lastUsed = m_cacheClock++;
+			return cachedRegion->second.region;
+		}
+	}
+
+	// Generated without holding the lock. If another thread generates the same region in the
+	// meantime, one of the two copies is thrown away. Both are identical
+	std::shared_ptr<const WorldGenRegion> region = GenerateRegion(regionX, regionZ);
+
+	std::unique_lock<std::shared_mutex> lock(m_cacheMutex);
+
+	auto insertResult = m_regionCache.try_emplace(hashKey);
+	CachedRegion& cachedRegion = insertResult.first->second;
+	if (insertResult.second) cachedRegion.region = region;
+	cachedRegion.lastUsed = m_cacheClock++;
+
+	if (m_regionCache.size() > MAX_CACHED_REGIONS)
+	{
+		auto leastRecentlyUsed = m_regionCache.end();
+		for (auto it = m_regionCache.begin(); it != m_regionCache.end(); it++)
+		{
+			if (it->first == hashKey) continue;
+			if (leastRecentlyUsed == m_regionCache.end() || it->second.lastUsed < leastRecentlyUsed->second.lastUsed) leastRecentlyUsed = it;
+		}
+
+		m_regionCache.erase(leastRecentlyUsed);
+	}
+
+	return cachedRegion.region;
+}
+
+std::shared_ptr<const WorldGenRegion> WorldGenPipeline::GenerateRegion(const int32_t regionX, const int32_t regionZ)
+{
+	std::shared_ptr<WorldGenRegion> region = std::make_shared<WorldGenRegion>();
+	region->x = regionX;
+	region->z = regionZ;
+	region->originX = static_cast<float>(regionX << WorldGenRegion::SHIFT) + m_noiseOffsetX;
+	region->originZ = static_cast<float>(regionZ << WorldGenRegion::SHIFT) + m_noiseOffsetZ;
+	region->noiseSeed = m_noiseSeed;
+	region->minHeight = region->maxHeight = 0;
+
+	for (size_t i = 0; i < m_stages.size(); i++)
+	{
+		if (m_stages[i]->GetScope() != WorldGenStageScope::REGION) continue;
+
+		auto start = std::chrono::steady_clock::now();
+		m_stages[i]->GenerateRegion(*region);
+		AddStageTime(i, start);
+	}
+
+	return region;
+}
+
+void WorldGenPipeline::AddStageTime(const size_t stageIndex, const std::chrono::steady_clock::time_point& start)
+{
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	m_stageTimings[stageIndex]->nanoseconds += static_cast<uint64_t>(elapsed.count());
+	m_stageTimings[stageIndex]->numInvocations++;
+}
+
+template void WorldGenPipeline::GenerateChunk<16>(const ChunkCoord&, BlockType*);
+template void WorldGenPipeline::GenerateChunk<32>(const ChunkCoord&, BlockType*);
+template void WorldGenPipeline::GenerateChunk<64>(const ChunkCoord&, BlockType*);
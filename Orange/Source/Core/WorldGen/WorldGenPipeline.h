@@ -0,0 +1,294 @@
+#ifndef _WORLDGENPIPELINE_H
+#define _WORLDGENPIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Biome.h"
+#include "PendingWriteStore.h"
+#include "WorldNoise.h"
+#include "../ChunkCoord.h"
+
+// The data generation stages read and write. Every stage declares which of these it needs
+// and which it produces, so the pipeline can check that the stages were added in a valid order
+enum WorldGenLayer : uint32_t
+{
+	WORLDGEN_LAYER_NONE		= 0,
+	WORLDGEN_LAYER_CLIMATE	= OG_BIT(0),	// Temperature and humidity, per region
+	WORLDGEN_LAYER_BIOME	= OG_BIT(1),	// Biome weights and the dominant biome of every column, per region
+	WORLDGEN_LAYER_HEIGHT	= OG_BIT(2),	// Surface height of every column, per region
+	WORLDGEN_LAYER_BLOCKS	= OG_BIT(3)		// The block types of a chunk
+};
+
+// The 2D layers of a square region of columns. Regions are generated once and shared by every chunk
+// in them, no matter the chunk's height. Coarse layers are sampled every SAMPLE_SPACING blocks, including
+// both borders, so that the layers of neighboring regions line up
+struct WorldGenRegion
+{
+	// A multiple of every chunk size, so chunks never straddle two regions
+	static constexpr int32_t SHIFT = 6;
+	static constexpr int32_t SIZE = 1 << SHIFT;
+	static constexpr uint32_t AREA = static_cast<uint32_t>(SIZE * SIZE);
+
+	static constexpr int32_t SAMPLE_SPACING = 4;
+	static constexpr int32_t NUM_COARSE_SAMPLES = SIZE / SAMPLE_SPACING + 1;
+	static constexpr uint32_t COARSE_AREA = static_cast<uint32_t>(NUM_COARSE_SAMPLES * NUM_COARSE_SAMPLES);
+
+	// Both are laid out as [x][z]
+	static constexpr uint32_t GetIndex(const int32_t x, const int32_t z) { return static_cast<uint32_t>((x << SHIFT) | z); }
+	static constexpr uint32_t GetCoarseIndex(const int32_t x, const int32_t z) { return static_cast<uint32_t>(x * NUM_COARSE_SAMPLES + z); }
+
+	// Position in REGION SPACE (x and z only)
+	int32_t x, z;
+
+	// Minimum corner in NOISE SPACE (x and z only)
+	float originX, originZ;
+
+	// See NoiseContext
+	uint32_t noiseSeed;
+
+	// WORLDGEN_LAYER_CLIMATE, coarse. Both are in [0, 1]
+	float temperature[COARSE_AREA];
+	float humidity[COARSE_AREA];
+
+	// WORLDGEN_LAYER_BIOME. The weights are coarse and add up to 1 for every sample
+	float biomeWeights[COARSE_AREA][NUM_BIOMES];
+	Biome biome[AREA];
+
+	// WORLDGEN_LAYER_HEIGHT, in BLOCK SPACE. The highest block of every column and the range over the whole region
+	int32_t height[AREA];
+	int32_t minHeight, maxHeight;
+};
+
+// A chunk that's being generated, handed from one chunk stage to the next
+struct WorldGenChunk
+{
+	ChunkCoord posCS;
+	int32_t size;
+
+	// Minimum corner in BLOCK SPACE and in NOISE SPACE
+	BlockCoord minBS;
+	DirectX::XMFLOAT3 originNS;
+
+	// The region the chunk's columns are in, and where in that region the chunk's minimum corner is
+	const WorldGenRegion* region;
+	int32_t regionOffsetX, regionOffsetZ;
+
+	// size^3 block types laid out as [x][y][z], all air before the first stage runs
+	BlockType* blocks;
+
+	// The world's seed, for stages that need random numbers rather than noise
+	uint64_t seed;
+
+	// See NoiseContext
+	uint32_t noiseSeed;
+
+	// Blocks the stages place outside of this chunk. They're handed to the pipeline's PendingWriteStore
+	// after the last stage ran, so stages never touch other chunks directly
+	std::vector<PendingBlockWrite>* outgoingWrites;
+};
+
+// A single block that's queried without generating its chunk, see WorldGenPipeline::QueryBlock()
+struct WorldGenBlockQuery
+{
+	BlockCoord posBS;
+
+	// The difference between NOISE SPACE and WORLD SPACE
+	DirectX::XMFLOAT3 noiseOffset;
+
+	// The region the block's column is in, and where in that region the column is
+	const WorldGenRegion* region;
+	int32_t regionOffsetX, regionOffsetZ;
+
+	// See WorldGenChunk
+	uint64_t seed;
+	uint32_t noiseSeed;
+};
+
+enum class WorldGenStageScope : uint8_t
+{
+	REGION,		// 2D, runs once per region and the result is cached
+	CHUNK		// 3D, runs for every chunk
+};
+
+// A single step of the world generation. Stages hold no per-chunk state, so a pipeline can generate
+// chunks on any number of threads at once
+class WorldGenStage
+{
+public:
+
+	virtual ~WorldGenStage() = default;
+
+	virtual const char* GetName() const = 0;
+	virtual const WorldGenStageScope GetScope() const = 0;
+
+	// WorldGenLayer flags
+	virtual const uint32_t GetInputs() const = 0;
+	virtual const uint32_t GetOutputs() const = 0;
+
+	// Only the one that matches the stage's scope is ever called
+	virtual void GenerateRegion(WorldGenRegion& region) const { UNUSED(region); }
+	virtual void GenerateChunk(WorldGenChunk& chunk) const { UNUSED(chunk); }
+
+	// Chunk stages that can work out a single block on their own override this, so that blocks can be queried
+	// without generating their chunk. "current" is the block the stages before this one produced. Stages that
+	// need the rest of the chunk (e.g. decorations) leave the block as it is
+	virtual BlockType QueryBlock(const WorldGenBlockQuery& query, const BlockType current) const { UNUSED(query); return current; }
+
+	// Only matters for stages that sample noise
+	void SetNoiseBackend(const NoiseBackend backend) { m_noiseBackend = backend; }
+	const NoiseBackend GetNoiseBackend() const { return m_noiseBackend; }
+
+protected:
+
+	NoiseContext GetNoiseContext(const uint32_t noiseSeed) const { return { m_noiseBackend, noiseSeed }; }
+
+private:
+
+	NoiseBackend m_noiseBackend = NoiseBackend::SIMPLEX;
+
+};
+
+class RegionStage : public WorldGenStage
+{
+public:
+
+	const WorldGenStageScope GetScope() const override { return WorldGenStageScope::REGION; }
+
+};
+
+// Chunk stages implement "template<int32_t Size> void Generate(WorldGenChunk& chunk) const" instead of GenerateChunk(),
+// so their loops are specialised for every chunk size like the rest of the generation code
+template<typename Derived>
+class ChunkStage : public WorldGenStage
+{
+public:
+
+	const WorldGenStageScope GetScope() const override { return WorldGenStageScope::CHUNK; }
+
+	void GenerateChunk(WorldGenChunk& chunk) const override
+	{
+		switch (chunk.size)
+		{
+		case 16: static_cast<const Derived*>(this)->template Generate<16>(chunk); break;
+		case 32: static_cast<const Derived*>(this)->template Generate<32>(chunk); break;
+		case 64: static_cast<const Derived*>(this)->template Generate<64>(chunk); break;
+		default: OG_ASSERT_MSG(false, "Unsupported chunk size"); break;
+		}
+	}
+
+};
+
+struct WorldGenStageStats
+{
+	const char* name;
+	WorldGenStageScope scope;
+	uint64_t numInvocations;
+	float totalMs;
+};
+
+// Runs a list of stages to generate chunks. The 2D (region) stages are only run the first time a region
+// is needed, and the result is cached and shared between all threads generating chunks
+class WorldGenPipeline
+{
+public:
+
+	WorldGenPipeline();
+	WorldGenPipeline(const WorldGenPipeline& other) = delete;
+	WorldGenPipeline& operator=(const WorldGenPipeline& other) = delete;
+
+	// Stages run in the order they're added, all region stages before any chunk stages. Must not be called while chunks are being generated
+	void AddStage(std::unique_ptr<WorldGenStage> stage);
+
+	// Removes every stage and clears the region cache
+	void Clear();
+
+	// The seed, and where the world is sampled in NOISE SPACE because of it. Clears the region cache and the pending writes
+	void SetSeed(const uint64_t seed, const float noiseOffsetX, const float noiseOffsetZ);
+
+	// Switches the noise of a single stage, e.g. to compare both backends. Returns false if there's no
+	// stage called "stageName". Clears the region cache, must not be called while chunks are being generated
+	bool SetStageNoiseBackend(const char* stageName, const NoiseBackend backend);
+
+	// Fills "outBlockTypes" with ChunkTraits<Size>::VOLUME block types laid out as [x][y][z], including the writes
+	// other chunks made to it so far. Safe to call from multiple threads at once. Instantiated for every size ChunkTraits supports
+	template<int32_t Size>
+	void GenerateChunk(const ChunkCoord& chunkPosCS, BlockType* outBlockTypes);
+
+	// Returns the block at "posBS" as the stages would generate it, without generating the chunk. Only the region
+	// is generated (and cached) if it has to be. Blocks placed by stages that need the whole chunk, and by other
+	// chunks (see PendingWriteStore), aren't included. Safe to call from multiple threads at once
+	BlockType QueryBlock(const BlockCoord& posBS);
+
+	// Returns the surface height of the column from the height layer, or false if no stage produces one
+	bool QueryColumnHeight(const int32_t x, const int32_t z, int32_t& outHeight);
+
+	// Walks down the column from "fromY" to "toY" (both inclusive) and returns the first block that isn't air
+	bool QueryFirstSolidBlock(const int32_t x, const int32_t z, const int32_t fromY, const int32_t toY, int32_t& outY);
+
+	// Total time spent in every stage so far, in the order the stages run
+	std::vector<WorldGenStageStats> GetStageStats() const;
+	void ResetStageStats();
+
+	void LogStageStats() const;
+
+	const uint32_t GetNumCachedRegions() const;
+
+	PendingWriteStore& GetPendingWrites();
+
+private:
+
+	// Returns the cached region, or generates (and caches) it
+	std::shared_ptr<const WorldGenRegion> GetRegion(const int32_t regionX, const int32_t regionZ);
+
+	std::shared_ptr<const WorldGenRegion> GenerateRegion(const int32_t regionX, const int32_t regionZ);
+
+	void AddStageTime(const size_t stageIndex, const std::chrono::steady_clock::time_point& start);
+
+	// Fills in everything but the position's Y, the rest is the same for the whole column
+	std::shared_ptr<const WorldGenRegion> PrepareColumnQuery(const int32_t x, const int32_t z, WorldGenBlockQuery& outQuery);
+
+	BlockType RunQueryStages(const WorldGenBlockQuery& query) const;
+
+private:
+
+	struct StageTiming
+	{
+		std::atomic<uint64_t> nanoseconds = 0;
+		std::atomic<uint64_t> numInvocations = 0;
+	};
+
+	struct CachedRegion
+	{
+		std::shared_ptr<const WorldGenRegion> region;
+
+		// Compared against m_cacheClock to evict the least recently used region
+		std::atomic<uint64_t> lastUsed = 0;
+	};
+
+	std::vector<std::unique_ptr<WorldGenStage>> m_stages;
+	std::vector<std::unique_ptr<StageTiming>> m_stageTimings;
+
+	// WorldGenLayer flags produced by the stages so far
+	uint32_t m_availableLayers;
+
+	uint64_t m_seed;
+	uint32_t m_noiseSeed;
+	float m_noiseOffsetX;
+	float m_noiseOffsetZ;
+
+	PendingWriteStore m_pendingWrites;
+
+	// Regions are looked up far more often than they're added, so lookups only take a shared lock
+	mutable std::shared_mutex m_cacheMutex;
+	std::unordered_map<uint64_t, CachedRegion> m_regionCache;
+	std::atomic<uint64_t> m_cacheClock;
+
+};
+
+#endif
@@ -0,0 +1,417 @@
+#include "../../Misc/pch.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "WorldGenStages.h"
+#include "DensityField.h"
+
+// Climate changes over thousands of blocks. Temperature and humidity sample different regions of the same noise
+constexpr uint32_t CLIMATE_NUM_OCTAVES = 2;
+static const WorldNoise s_climateNoise(0.0015f, 0.5f, CLIMATE_NUM_OCTAVES, 0x1B873593u);
+constexpr float TEMPERATURE_NOISE_OFFSET = 10000.0f;
+constexpr float HUMIDITY_NOISE_OFFSET = -10000.0f;
+
+// Temperatures below the lower bound are all mountains, above the upper bound there are none. Humidity
+// picks between plains and hills the same way
+constexpr float MOUNTAINS_MIN_TEMPERATURE = 0.25f;
+constexpr float MOUNTAINS_MAX_TEMPERATURE = 0.40f;
+constexpr float HILLS_MIN_HUMIDITY = 0.50f;
+constexpr float HILLS_MAX_HUMIDITY = 0.65f;
+
+constexpr uint32_t HEIGHT_NUM_OCTAVES = 4;
+static const WorldNoise s_heightNoise(0.010f, 0.3f, HEIGHT_NUM_OCTAVES, 0xE6546B64u);
+
+// Caves are squashed vertically and fade out above CAVE_FADE_START_HEIGHT, so they rarely break through the surface
+constexpr uint32_t CAVE_NUM_OCTAVES = 2;
+static const WorldNoise s_caveNoise(0.03f, 0.5f, CAVE_NUM_OCTAVES, 0x85EBCA6Bu);
+constexpr float CAVE_VERTICAL_SCALE = 2.0f;
+constexpr float CAVE_THRESHOLD = 0.45f;
+constexpr float CAVE_FADE_START_HEIGHT = 60.0f;
+constexpr float CAVE_FADE_RANGE = 20.0f;
+constexpr int32_t CAVE_MAX_HEIGHT = static_cast<int32_t>(CAVE_FADE_START_HEIGHT + CAVE_FADE_RANGE);
+
+// Trees are attempted a few times in every cell of the world. An attempt only grows a tree if it finds a grass
+// block with air above it inside the cell, so underground and sky cells don't get any
+constexpr int32_t DECORATION_CELL_SHIFT = 4;
+constexpr int32_t DECORATION_CELL_SIZE = 1 << DECORATION_CELL_SHIFT;
+constexpr uint32_t TREE_ATTEMPTS_PER_CELL = 3;
+constexpr int32_t MIN_TREE_TRUNK_HEIGHT = 4;
+constexpr int32_t MAX_TREE_TRUNK_HEIGHT = 6;
+constexpr int32_t TREE_CANOPY_RADIUS = 2;
+
+// splitmix64. The same sequence on every platform, unlike the standard library's distributions
+class DecorationRandom
+{
+public:
+
+	explicit DecorationRandom(const uint64_t seed) : m_state(seed) {}
+
+	uint64_t Next()
+	{
+		uint64_t value = (m_state += 0x9E3779B97F4A7C15ull);
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+
+	// Returns a value in [0, range)
+	uint32_t NextInt(const uint32_t range) { return static_cast<uint32_t>(((Next() >> 32) * range) >> 32); }
+
+	// Returns a value in [0, 1)
+	float NextFloat() { return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f); }
+
+private:
+
+	uint64_t m_state;
+
+};
+
+static float SmoothStep(const float edge0, const float edge1, const float x)
+{
+	float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+static float SampleCave(const NoiseContext& noise, const float x, const float y, const float z)
+{
+	float fade = max(y - CAVE_FADE_START_HEIGHT, 0.0f) / CAVE_FADE_RANGE;
+	return s_caveNoise.Sample(noise, x, y * CAVE_VERTICAL_SCALE, z) - fade;
+}
+
+void ClimateStage::GenerateRegion(WorldGenRegion& region) const
+{
+	constexpr float spacing = static_cast<float>(WorldGenRegion::SAMPLE_SPACING);
+
+	const NoiseContext noise = GetNoiseContext(region.noiseSeed);
+	for (int32_t x = 0; x < WorldGenRegion::NUM_COARSE_SAMPLES; x++)
+	{
+		for (int32_t z = 0; z < WorldGenRegion::NUM_COARSE_SAMPLES; z++)
+		{
+			const float sampleX = region.originX + x * spacing;
+			const float sampleZ = region.originZ + z * spacing;
+			const uint32_t index = WorldGenRegion::GetCoarseIndex(x, z);
+
+			region.temperature[index] = s_climateNoise.Sample(noise, sampleX + TEMPERATURE_NOISE_OFFSET, sampleZ) * 0.5f + 0.5f;
+			region.humidity[index] = s_climateNoise.Sample(noise, sampleX + HUMIDITY_NOISE_OFFSET, sampleZ) * 0.5f + 0.5f;
+		}
+	}
+}
+
+void BiomeStage::GenerateRegion(WorldGenRegion& region) const
+{
+	for (uint32_t i = 0; i < WorldGenRegion::COARSE_AREA; i++)
+	{
+		float* weights = region.biomeWeights[i];
+
+		const float mountains = 1.0f - SmoothStep(MOUNTAINS_MIN_TEMPERATURE, MOUNTAINS_MAX_TEMPERATURE, region.temperature[i]);
+		const float hills = (1.0f - mountains) * SmoothStep(HILLS_MIN_HUMIDITY, HILLS_MAX_HUMIDITY, region.humidity[i]);
+
+		weights[static_cast<uint8_t>(Biome::MOUNTAINS)] = mountains;
+		weights[static_cast<uint8_t>(Biome::HILLS)] = hills;
+		weights[static_cast<uint8_t>(Biome::PLAINS)] = 1.0f - mountains - hills;
+	}
+
+	// Every column takes the dominant biome of the closest sample
+	for (int32_t x = 0; x < WorldGenRegion::SIZE; x++)
+	{
+		const int32_t sampleX = (x + WorldGenRegion::SAMPLE_SPACING / 2) / WorldGenRegion::SAMPLE_SPACING;
+		for (int32_t z = 0; z < WorldGenRegion::SIZE; z++)
+		{
+			const int32_t sampleZ = (z + WorldGenRegion::SAMPLE_SPACING / 2) / WorldGenRegion::SAMPLE_SPACING;
+			const float* weights = region.biomeWeights[WorldGenRegion::GetCoarseIndex(sampleX, sampleZ)];
+
+			uint32_t dominantBiome = 0;
+			for (uint32_t biome = 1; biome < NUM_BIOMES; biome++)
+			{
+				if (weights[biome] > weights[dominantBiome]) dominantBiome = biome;
+			}
+
+			region.biome[WorldGenRegion::GetIndex(x, z)] = static_cast<Biome>(dominantBiome);
+		}
+	}
+}
+
+void HeightStage::GenerateRegion(WorldGenRegion& region) const
+{
+	constexpr float spacing = static_cast<float>(WorldGenRegion::SAMPLE_SPACING);
+	constexpr float invSpacing = 1.0f / spacing;
+
+	const NoiseContext noise = GetNoiseContext(region.noiseSeed);
+	float coarseHeight[WorldGenRegion::COARSE_AREA];
+	for (int32_t x = 0; x < WorldGenRegion::NUM_COARSE_SAMPLES; x++)
+	{
+		for (int32_t z = 0; z < WorldGenRegion::NUM_COARSE_SAMPLES; z++)
+		{
+			const uint32_t index = WorldGenRegion::GetCoarseIndex(x, z);
+
+			float baseHeight = 0.0f;
+			float heightRange = 0.0f;
+			for (uint32_t biome = 0; biome < NUM_BIOMES; biome++)
+			{
+				baseHeight += region.biomeWeights[index][biome] * BIOME_DEFINITIONS[biome].baseHeight;
+				heightRange += region.biomeWeights[index][biome] * BIOME_DEFINITIONS[biome].heightRange;
+			}
+
+			float sampledNoise = s_heightNoise.Sample(noise, region.originX + x * spacing, region.originZ + z * spacing);
+			coarseHeight[index] = baseHeight + (sampledNoise * 0.5f + 0.5f) * heightRange;
+		}
+	}
+
+	region.minHeight = INT32_MAX;
+	region.maxHeight = INT32_MIN;
+	for (int32_t x = 0; x < WorldGenRegion::SIZE; x++)
+	{
+		const int32_t cellX = x / WorldGenRegion::SAMPLE_SPACING;
+		const float tx = (x % WorldGenRegion::SAMPLE_SPACING) * invSpacing;
+		for (int32_t z = 0; z < WorldGenRegion::SIZE; z++)
+		{
+			const int32_t cellZ = z / WorldGenRegion::SAMPLE_SPACING;
+			const float tz = (z % WorldGenRegion::SAMPLE_SPACING) * invSpacing;
+
+			const float h00 = coarseHeight[WorldGenRegion::GetCoarseIndex(cellX, cellZ)];
+			const float h10 = coarseHeight[WorldGenRegion::GetCoarseIndex(cellX + 1, cellZ)];
+			const float h01 = coarseHeight[WorldGenRegion::GetCoarseIndex(cellX, cellZ + 1)];
+			const float h11 = coarseHeight[WorldGenRegion::GetCoarseIndex(cellX + 1, cellZ + 1)];
+			const float front = h00 + (h10 - h00) * tx;
+			const float back = h01 + (h11 - h01) * tx;
+
+			const int32_t height = static_cast<int32_t>(floorf(front + (back - front) * tz));
+			region.height[WorldGenRegion::GetIndex(x, z)] = height;
+			region.minHeight = min(region.minHeight, height);
+			region.maxHeight = max(region.maxHeight, height);
+		}
+	}
+}
+
+BlockType SurfaceStage::QueryBlock(const WorldGenBlockQuery& query, const BlockType current) const
+{
+	const uint32_t columnIndex = WorldGenRegion::GetIndex(query.regionOffsetX, query.regionOffsetZ);
+	const int32_t height = query.region->height[columnIndex];
+	if (query.posBS.y > height) return current;
+
+	const BiomeDefinition& biome = GetBiomeDefinition(query.region->biome[columnIndex]);
+	if (query.posBS.y == height) return biome.surfaceBlock;
+	if (query.posBS.y > height - biome.subsurfaceDepth) return biome.subsurfaceBlock;
+	return BlockType::Stone;
+}
+
+template<int32_t Size>
+void SurfaceStage::Generate(WorldGenChunk& chunk) const
+{
+	using Traits = ChunkTraits<Size>;
+
+	const WorldGenRegion& region = *chunk.region;
+
+	// Entirely above the surface, the chunk stays air
+	if (chunk.minBS.y > region.maxHeight) return;
+
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t z = 0; z < Size; z++)
+		{
+			const uint32_t columnIndex = WorldGenRegion::GetIndex(chunk.regionOffsetX + x, chunk.regionOffsetZ + z);
+			const int32_t height = region.height[columnIndex];
+			const BiomeDefinition& biome = GetBiomeDefinition(region.biome[columnIndex]);
+
+			const int32_t topY = min(height - chunk.minBS.y, Size - 1);
+			for (int32_t y = 0; y <= topY; y++)
+			{
+				const int32_t posY = chunk.minBS.y + y;
+
+				BlockType type = BlockType::Stone;
+				if (posY == height) type = biome.surfaceBlock;
+				else if (posY > height - biome.subsurfaceDepth) type = biome.subsurfaceBlock;
+
+				chunk.blocks[Traits::GetIndex(x, y, z)] = type;
+			}
+		}
+	}
+}
+
+BlockType DensityTerrainStage::QueryBlock(const WorldGenBlockQuery& query, const BlockType current) const
+{
+	const NoiseContext noise = GetNoiseContext(query.noiseSeed);
+	if (DensityField::SampleInterpolatedAt(query.posBS, query.noiseOffset, noise, &DensityField::Sample) <= 0.0f) return current;
+
+	const BlockCoord abovePosBS = query.posBS + BlockCoord(0, 1, 0);
+	if (DensityField::SampleInterpolatedAt(abovePosBS, query.noiseOffset, noise, &DensityField::Sample) > 0.0f) return BlockType::Stone;
+
+	return GetBiomeDefinition(query.region->biome[WorldGenRegion::GetIndex(query.regionOffsetX, query.regionOffsetZ)]).surfaceBlock;
+}
+
+template<int32_t Size>
+void DensityTerrainStage::Generate(WorldGenChunk& chunk) const
+{
+	using Traits = ChunkTraits<Size>;
+	using Samples = DensityField::Samples<Size>;
+
+	// Up to 1 MB for 64 block chunks, so it's kept around instead of living on the stack
+	thread_local std::vector<float> density;
+	density.resize(Samples::VOLUME);
+
+	DensityField::SampleInterpolated<Size>(chunk.originNS, GetNoiseContext(chunk.noiseSeed), density.data());
+
+	const WorldGenRegion& region = *chunk.region;
+
+	// Solid blocks with air above them get the biome's surface block, the rest is stone. The extra
+	// layer at the top of the density samples is the bottom layer of the chunk above
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t z = 0; z < Size; z++)
+		{
+			const BiomeDefinition& biome = GetBiomeDefinition(region.biome[WorldGenRegion::GetIndex(chunk.regionOffsetX + x, chunk.regionOffsetZ + z)]);
+			for (int32_t y = 0; y < Size; y++)
+			{
+				if (density[Samples::GetIndex(x, y, z)] <= 0.0f) continue;
+
+				chunk.blocks[Traits::GetIndex(x, y, z)] = (density[Samples::GetIndex(x, y + 1, z)] > 0.0f) ? BlockType::Stone : biome.surfaceBlock;
+			}
+		}
+	}
+}
+
+BlockType CaveStage::QueryBlock(const WorldGenBlockQuery& query, const BlockType current) const
+{
+	if (current == BlockType::Air || query.posBS.y > CAVE_MAX_HEIGHT) return current;
+
+	const float cave = DensityField::SampleInterpolatedAt(query.posBS, query.noiseOffset, GetNoiseContext(query.noiseSeed), &SampleCave);
+	return (cave > CAVE_THRESHOLD) ? BlockType::Air : current;
+}
+
+template<int32_t Size>
+void CaveStage::Generate(WorldGenChunk& chunk) const
+{
+	using Traits = ChunkTraits<Size>;
+	using Samples = DensityField::Samples<Size>;
+
+	// Caves have faded out completely above CAVE_MAX_HEIGHT
+	if (chunk.minBS.y > CAVE_MAX_HEIGHT) return;
+
+	// Nothing to carve in chunks that are all air, which is most chunks above the surface
+	const BlockType* firstSolid = std::find_if(chunk.blocks, chunk.blocks + Traits::VOLUME, [](const BlockType type) { return type != BlockType::Air; });
+	if (firstSolid == chunk.blocks + Traits::VOLUME) return;
+
+	thread_local std::vector<float> caves;
+	caves.resize(Samples::VOLUME);
+
+	DensityField::SampleInterpolated<Size>(chunk.originNS, GetNoiseContext(chunk.noiseSeed), &SampleCave, caves.data());
+
+	for (int32_t x = 0; x < Size; x++)
+	{
+		for (int32_t y = 0; y < Size; y++)
+		{
+			const float* row = &caves[Samples::GetIndex(x, y, 0)];
+			BlockType* blocks = &chunk.blocks[Traits::GetIndex(x, y, 0)];
+			for (int32_t z = 0; z < Size; z++)
+			{
+				if (row[z] > CAVE_THRESHOLD) blocks[z] = BlockType::Air;
+			}
+		}
+	}
+}
+
+template<int32_t Size>
+void DecorationStage::Generate(WorldGenChunk& chunk) const
+{
+	using Traits = ChunkTraits<Size>;
+
+	constexpr int32_t cellsPerAxis = Size / DECORATION_CELL_SIZE;
+
+	const WorldGenRegion& region = *chunk.region;
+
+	// Find every tree first and only then place them, so that no tree's surface check sees another tree.
+	// That keeps the result the same whether two cells are in the same chunk or not
+	struct Tree { int32_t x, y, z, trunkHeight; };
+	Tree trees[cellsPerAxis * cellsPerAxis * cellsPerAxis * TREE_ATTEMPTS_PER_CELL];
+	uint32_t numTrees = 0;
+
+	for (int32_t cellX = 0; cellX < cellsPerAxis; cellX++)
+	{
+		for (int32_t cellY = 0; cellY < cellsPerAxis; cellY++)
+		{
+			for (int32_t cellZ = 0; cellZ < cellsPerAxis; cellZ++)
+			{
+				const BlockCoord cellMin(cellX * DECORATION_CELL_SIZE, cellY * DECORATION_CELL_SIZE, cellZ * DECORATION_CELL_SIZE);
+				const ChunkCoord cellPos(
+					(chunk.minBS.x + cellMin.x) >> DECORATION_CELL_SHIFT,
+					(chunk.minBS.y + cellMin.y) >> DECORATION_CELL_SHIFT,
+					(chunk.minBS.z + cellMin.z) >> DECORATION_CELL_SHIFT);
+
+				DecorationRandom random(chunk.seed ^ Orange::Math::GetHashKeyFromChunkPosition(cellPos));
+				for (uint32_t attempt = 0; attempt < TREE_ATTEMPTS_PER_CELL; attempt++)
+				{
+					// Every attempt draws the same numbers whether it succeeds or not, so the attempts don't affect each other
+					const int32_t x = cellMin.x + static_cast<int32_t>(random.NextInt(DECORATION_CELL_SIZE));
+					const int32_t z = cellMin.z + static_cast<int32_t>(random.NextInt(DECORATION_CELL_SIZE));
+					const int32_t trunkHeight = MIN_TREE_TRUNK_HEIGHT + static_cast<int32_t>(random.NextInt(MAX_TREE_TRUNK_HEIGHT - MIN_TREE_TRUNK_HEIGHT + 1));
+					const float chance = random.NextFloat();
+
+					const Biome biome = region.biome[WorldGenRegion::GetIndex(chunk.regionOffsetX + x, chunk.regionOffsetZ + z)];
+					if (chance >= GetBiomeDefinition(biome).treeChance) continue;
+
+					for (int32_t y = cellMin.y + DECORATION_CELL_SIZE - 2; y >= cellMin.y; y--)
+					{
+						if (chunk.blocks[Traits::GetIndex(x, y, z)] == BlockType::Grass && chunk.blocks[Traits::GetIndex(x, y + 1, z)] == BlockType::Air)
+						{
+							trees[numTrees++] = { x, y + 1, z, trunkHeight };
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	auto placeBlock = [&chunk](const int32_t x, const int32_t y, const int32_t z, const BlockType type)
+	{
+		if (x >= 0 && x < Size && y >= 0 && y < Size && z >= 0 && z < Size)
+		{
+			BlockType& block = chunk.blocks[Traits::GetIndex(x, y, z)];
+			block = PendingWriteStore::MergeBlock(block, type);
+			return;
+		}
+
+		const BlockCoord posBS = chunk.minBS + BlockCoord(x, y, z);
+		const BlockCoord localPos = Orange::Math::BlockToLocalCoord<Size>(posBS);
+		chunk.outgoingWrites->push_back({ Orange::Math::BlockToChunkCoord<Size>(posBS), Size, Traits::GetIndex(localPos.x, localPos.y, localPos.z), type });
+	};
+
+	for (uint32_t i = 0; i < numTrees; i++)
+	{
+		const Tree& tree = trees[i];
+		const int32_t topY = tree.y + tree.trunkHeight - 1;
+
+		for (int32_t y = tree.y; y <= topY; y++) placeBlock(tree.x, y, tree.z, BlockType::Wood);
+
+		// Two wide layers around the top of the trunk, then two narrow ones on top of it. The corners are left out
+		for (int32_t dy = -2; dy <= 1; dy++)
+		{
+			const int32_t radius = (dy < 0) ? TREE_CANOPY_RADIUS : TREE_CANOPY_RADIUS - 1;
+			for (int32_t dx = -radius; dx <= radius; dx++)
+			{
+				for (int32_t dz = -radius; dz <= radius; dz++)
+				{
+					if (abs(dx) == radius && abs(dz) == radius && (radius == TREE_CANOPY_RADIUS || dy == 1)) continue;
+					placeBlock(tree.x + dx, topY + dy, tree.z + dz, BlockType::Leaves);
+				}
+			}
+		}
+	}
+}
+
+template void SurfaceStage::Generate<16>(WorldGenChunk&) const;
+template void SurfaceStage::Generate<32>(WorldGenChunk&) const;
+template void SurfaceStage::Generate<64>(WorldGenChunk&) const;
+
+template void DensityTerrainStage::Generate<16>(WorldGenChunk&) const;
+template void DensityTerrainStage::Generate<32>(WorldGenChunk&) const;
+template void DensityTerrainStage::Generate<64>(WorldGenChunk&) const;
+
+template void CaveStage::Generate<16>(WorldGenChunk&) const;
+template void CaveStage::Generate<32>(WorldGenChunk&) const;
+template void CaveStage::Generate<64>(WorldGenChunk&) const;
+
+template void DecorationStage::Generate<16>(WorldGenChunk&) const;
+template void DecorationStage::Generate<32>(WorldGenChunk&) const;
+template void DecorationStage::Generate<64>(WorldGenChunk&) const;
@@ -0,0 +1,112 @@
+#ifndef _WORLDGENSTAGES_H
+#define _WORLDGENSTAGES_H
+
+#include "WorldGenPipeline.h"
+
+// The stages the game's terrain is built from, see TerrainGenerator for the order they run in
+
+// Low frequency temperature and humidity noise
+class ClimateStage : public RegionStage
+{
+public:
+
+	const char* GetName() const override { return "Climate"; }
+	const uint32_t GetInputs() const override { return WORLDGEN_LAYER_NONE; }
+	const uint32_t GetOutputs() const override { return WORLDGEN_LAYER_CLIMATE; }
+
+	void GenerateRegion(WorldGenRegion& region) const override;
+
+};
+
+// Turns the climate into a blend of biomes. Cold climates are mountains, humid ones are hills and the rest are plains
+class BiomeStage : public RegionStage
+{
+public:
+
+	const char* GetName() const override { return "Biome"; }
+	const uint32_t GetInputs() const override { return WORLDGEN_LAYER_CLIMATE; }
+	const uint32_t GetOutputs() const override { return WORLDGEN_LAYER_BIOME; }
+
+	void GenerateRegion(WorldGenRegion& region) const override;
+
+};
+
+// Surface height from 2D noise, scaled by the blended biome heights
+class HeightStage : public RegionStage
+{
+public:
+
+	const char* GetName() const override { return "Height"; }
+	const uint32_t GetInputs() const override { return WORLDGEN_LAYER_BIOME; }
+	const uint32_t GetOutputs() const override { return WORLDGEN_LAYER_HEIGHT; }
+
+	void GenerateRegion(WorldGenRegion& region) const override;
+
+};
+
+// Fills every column up to its surface height with the biome's blocks
+class SurfaceStage : public ChunkStage<SurfaceStage>
+{
+public:
+
+	const char* GetName() const override { return "Surface"; }
+	const uint32_t GetInputs() const override { return WORLDGEN_LAYER_BIOME | WORLDGEN_LAYER_HEIGHT; }
+	const uint32_t GetOutputs() const override { return WORLDGEN_LAYER_BLOCKS; }
+
+	BlockType QueryBlock(const WorldGenBlockQuery& query, const BlockType current) const override;
+
+	template<int32_t Size>
+	void Generate(WorldGenChunk& chunk) const;
+
+};
+
+// 3D terrain with overhangs from the density field, instead of the height and surface stages
+class DensityTerrainStage : public ChunkStage<DensityTerrainStage>
+{
+public:
+
+	const char* GetName() const override { return "Density"; }
+	const uint32_t GetInputs() const override { return WORLDGEN_LAYER_BIOME; }
+	const uint32_t GetOutputs() const override { return WORLDGEN_LAYER_BLOCKS; }
+
+	BlockType QueryBlock(const WorldGenBlockQuery& query, const BlockType current) const override;
+
+	template<int32_t Size>
+	void Generate(WorldGenChunk& chunk) const;
+
+};
+
+// Carves caves out of the solid blocks with interpolated 3D noise
+class CaveStage : public ChunkStage<CaveStage>
+{
+public:
+
+	const char* GetName() const override { return "Caves"; }
+	const uint32_t GetInputs() const override { return WORLDGEN_LAYER_BLOCKS; }
+	const uint32_t GetOutputs() const override { return WORLDGEN_LAYER_BLOCKS; }
+
+	BlockType QueryBlock(const WorldGenBlockQuery& query, const BlockType current) const override;
+
+	template<int32_t Size>
+	void Generate(WorldGenChunk& chunk) const;
+
+};
+
+// Grows trees on the surface. Trees are placed per 16 block cell of the world from a random stream derived
+// from the seed and the cell's position, so they come out the same for every chunk size. Blocks that
+// land outside of the chunk go to the chunk's outgoing writes. Block queries don't include trees, since
+// finding a tree's spot needs the terrain around it
+class DecorationStage : public ChunkStage<DecorationStage>
+{
+public:
+
+	const char* GetName() const override { return "Decoration"; }
+	const uint32_t GetInputs() const override { return WORLDGEN_LAYER_BIOME | WORLDGEN_LAYER_BLOCKS; }
+	const uint32_t GetOutputs() const override { return WORLDGEN_LAYER_BLOCKS; }
+
+	template<int32_t Size>
+	void Generate(WorldGenChunk& chunk) const;
+
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include "../../Misc/pch.h"
+
+#include "WorldNoise.h"
+
+WorldNoise::WorldNoise(const float frequency, const float persistence, const uint32_t numOctaves, const uint32_t salt) :
+	m_simplexNoise(frequency, 1.0f, 2.0f, persistence), m_hashNoise(frequency, 1.0f, 2.0f, persistence), m_numOctaves(numOctaves), m_salt(salt)
+{
+}
+
+float WorldNoise::Sample(const NoiseContext& context, const float x, const float y) const
+{
+	if (context.backend == NoiseBackend::HASH) return m_hashNoise.Fractal(context.seed ^ m_salt, m_numOctaves, x, y);
+
+	return m_simplexNoise.fractal(m_numOctaves, x, y);
+}
+
+float WorldNoise::Sample(const NoiseContext& context, const float x, const float y, const float z) const
+{
+	if (context.backend == NoiseBackend::HASH) return m_hashNoise.Fractal(context.seed ^ m_salt, m_numOctaves, x, y, z);
+
+	return m_simplexNoise.fractal(m_numOctaves, x, y, z);
+}
+
+uint32_t WorldNoise::GetNoiseSeed(const uint64_t seed)
+{
+	return static_cast<uint32_t>(seed) ^ static_cast<uint32_t>(seed >> 32);
+}
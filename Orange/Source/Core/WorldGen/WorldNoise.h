@@ -0,0 +1,48 @@
+#ifndef _WORLDNOISE_H
+#define _WORLDNOISE_H
+
+#include <cstdint>
+
+#include "../../Utility/HashNoise.h"
+#include "../../Utility/SimplexNoise.h"
+
+// The noise the world generation stages sample. Every stage picks its own (see WorldGenStage::SetNoiseBackend())
+enum class NoiseBackend : uint8_t
+{
+	SIMPLEX,	// SimplexNoise. It has no seed, so the seed only moves the region of the noise that's sampled
+	HASH		// HashNoise, seeded with the world's seed
+};
+
+// Everything a stage needs to sample noise for a chunk or region
+struct NoiseContext
+{
+	NoiseBackend backend;
+
+	// The world's seed folded into 32 bits, only used by NoiseBackend::HASH
+	uint32_t seed;
+};
+
+// Fractal noise with the same frequency and octaves on both backends. The salt is mixed into the seed,
+// so that different kinds of noise (e.g. height and caves) aren't the same noise at different frequencies
+class WorldNoise
+{
+public:
+
+	WorldNoise(const float frequency, const float persistence, const uint32_t numOctaves, const uint32_t salt);
+
+	float Sample(const NoiseContext& context, const float x, const float y) const;
+	float Sample(const NoiseContext& context, const float x, const float y, const float z) const;
+
+	// Folds a 64 bit world seed into the 32 bit seed HashNoise takes
+	static uint32_t GetNoiseSeed(const uint64_t seed);
+
+private:
+
+	SimplexNoise m_simplexNoise;
+	HashNoise m_hashNoise;
+	uint32_t m_numOctaves;
+	uint32_t m_salt;
+
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include "../Utility/HeapOverrides.h"
 
 #include "Application.h"
+#include "ChunkManager.h"
 #include "../Utility/Utility.h"
 #include "../Utility/MemoryUtilities.h"
 
@@ -16,9 +17,16 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 {
 	UNUSED(hInstance);
 	UNUSED(hPrevInstance);
-	UNUSED(pScmdline);
 	UNUSED(iCmdshow);
 
+	// "-renderdist <chunks>" overrides the default render distance, so it can be
+	// scaled to the machine without having to rebuild
+	const char* renderDistArg = pScmdline ? strstr(pScmdline, "-renderdist ") : nullptr;
+	if (renderDistArg)
+	{
+		ChunkManager::SetRenderDistance(atoi(renderDistArg + strlen("-renderdist ")));
+	}
+
 	{
 
 #ifdef OG_DEBUG
@@ -5,6 +5,8 @@ struct GeometryIn
     float2 uv : TEXCOORD0;
     float4 lightPos : TEXCOORD1;
     uint blockFaces : BLOCKFACES1;
+    uint skyLight : SKYLIGHT1;
+    uint blockLight : BLOCKLIGHT1;
     uint vertexID : ID1;
     float3 worldPos : POS0;
 };
@@ -15,8 +17,17 @@ struct GeometryOut
     float3 norm : NORMAL0;
     float2 uv : TEXCOORD0;
     float4 lightPos : TEXCOORD1;
+    
+    // Sky and block light of the face, from 0 to 1
+    float2 lightLevels : TEXCOORD2;
 };
 
+// Every light level is 80% as bright as the one above it, level 0 is no light at all
+float GetLightIntensity(uint level)
+{
+    return level == 0 ? 0.0f : pow(0.8f, 15.0f - level);
+}
+
 [maxvertexcount(3)]
 void main(triangle GeometryIn input[3], inout TriangleStream<GeometryOut> output)
 {
@@ -35,6 +46,13 @@ void main(triangle GeometryIn input[3], inout TriangleStream<GeometryOut> output
     // we don't need smooth shading anyway
     float3 triNorm = normalize(cross(ptTwo, ptOne));
     
+    // The instance holds 4 bits of light per face
+    float2 lightLevels =
+    {
+        GetLightIntensity((input[0].skyLight >> (faceIndex * 4)) & 0xF),
+        GetLightIntensity((input[0].blockLight >> (faceIndex * 4)) & 0xF)
+    };
+    
 	for (uint i = 0; i < 3; i++)
 	{
         GeometryOut element;
@@ -45,6 +63,7 @@ void main(triangle GeometryIn input[3], inout TriangleStream<GeometryOut> output
         element.uv = input[i].uv;
         
         element.norm = triNorm;
+        element.lightLevels = lightLevels;
         
 		output.Append(element);
 	}
@@ -17,8 +17,15 @@ struct PixelIn
     float3 norm : NORMAL0;
     float2 uv : TEXCOORD0;
     float4 lightPos : TEXCOORD1;
+    float2 lightLevels : TEXCOORD2;
 };
 
+// Torches and the like are a warm white
+static const float4 blockLightColor = { 1.0f, 0.9f, 0.75f, 1.0f };
+
+// Keeps caves from going pitch black
+static const float minAmbientLight = 0.05f;
+
 float4 main(PixelIn input) : SV_TARGET
 {
     
@@ -29,7 +36,12 @@ float4 main(PixelIn input) : SV_TARGET
     // Sample the block texture
     float4 diffuse = blockTexture.Sample(sampWrap, input.uv);
     
-    float4 finalColor = diffuse * diffuseAmbient;
+    // The sun and the moon only reach as far as the sky light does, block light comes on top of it
+    float skyLight = input.lightLevels.x;
+    float blockLight = input.lightLevels.y;
+    
+    float4 blockLightContribution = blockLightColor * blockLight;
+    float4 finalColor = diffuse * diffuseAmbient * max(max(skyLight, blockLight), minAmbientLight);
     
     input.lightPos.xyz /= input.lightPos.w; // Re-homogenize the coordinates
     float2 shadowUV;
@@ -41,7 +53,7 @@ float4 main(PixelIn input) : SV_TARGET
         float mapDepth = shadowMapTexture.Sample(sampClamp, shadowUV).x;
         float pointDepth = input.lightPos.z - bias;
         
-        if (mapDepth < pointDepth) return finalColor; // Pixel is shadowed
+        if (mapDepth < pointDepth) return finalColor + diffuse * blockLightContribution; // Pixel is shadowed
         // else pixel is not shadowed and we calculate the pixel color
     }
     
@@ -54,9 +66,11 @@ float4 main(PixelIn input) : SV_TARGET
     
         // Calculate the final color
         float4 lightContribution = lightCol[i] * lightIntensity + lightAmbient[i].x;
-        finalColor += lightContribution;
+        finalColor += lightContribution * skyLight;
     }
     
+    finalColor += blockLightContribution;
+    
     finalColor *= diffuse;
     
     return finalColor;
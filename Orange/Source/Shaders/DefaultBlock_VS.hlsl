@@ -20,6 +20,8 @@ struct VertexIn
     float3 wpos : WORLDPOS0;
     uint blockType : BLOCKTYPE0;
     uint blockFaces : BLOCKFACES0;
+    uint skyLight : SKYLIGHT0;
+    uint blockLight : BLOCKLIGHT0;
 };
 
 
@@ -29,6 +31,8 @@ struct VertexOut
     float2 uv : TEXCOORD0;
     float4 lightPos : TEXCOORD1;
     uint blockFaces : BLOCKFACES1;
+    uint skyLight : SKYLIGHT1;
+    uint blockLight : BLOCKLIGHT1;
     uint vertexID : ID1;
     float3 worldPos : POS0;
 };
@@ -56,6 +60,8 @@ VertexOut main(VertexIn input)
     output.uv = blockUVs[input.blockType][input.vertexID].xy;
     
     output.blockFaces = input.blockFaces;
+    output.skyLight = input.skyLight;
+    output.blockLight = input.blockLight;
     
 	return output;
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "../Misc/pch.h"
+
+#include <cmath>
+
+#include "FixedTimestep.h"
+#include "Utility.h"
+
+FixedTimestep::FixedTimestep(const float tickRate, const uint32_t maxTicksPerFrame) :
+	m_tickRate(0.0f), m_tickDuration(0.0f), m_maxTicksPerFrame(1)
+{
+	SetTickRate(tickRate);
+	SetMaxTicksPerFrame(maxTicksPerFrame);
+}
+
+void FixedTimestep::SetTickRate(const float tickRate)
+{
+	OG_ASSERT_MSG(tickRate > 0.0f, "The tick rate must be positive");
+	if (tickRate == m_tickRate) return;
+
+	m_tickRate = tickRate;
+	m_tickDuration = 1.0f / tickRate;
+}
+
+const float FixedTimestep::GetTickRate() const { return m_tickRate; }
+
+void FixedTimestep::SetMaxTicksPerFrame(const uint32_t maxTicksPerFrame) { m_maxTicksPerFrame = max(maxTicksPerFrame, 1u); }
+
+const uint32_t FixedTimestep::GetMaxTicksPerFrame() const { return m_maxTicksPerFrame; }
+
+const float FixedTimestep::GetTickDuration() const { return m_tickDuration; }
+
+uint32_t FixedTimestep::Advance(const float frameTime)
+{
+	// The clock can hand back nonsense on the first frame, or after the system's been suspended
+	m_frameTime = (frameTime > 0.0f && std::isfinite(frameTime)) ? frameTime : 0.0f;
+	m_accumulator += m_frameTime;
+
+	uint32_t numTicks = 0;
+	while (m_accumulator >= m_tickDuration && numTicks < m_maxTicksPerFrame)
+	{
+		m_accumulator -= m_tickDuration;
+		numTicks++;
+	}
+
+	// Whole ticks that didn't fit in the frame are dropped, what's left of the next one is kept
+	if (m_accumulator >= m_tickDuration)
+	{
+		const float dropped = m_accumulator - fmodf(m_accumulator, m_tickDuration);
+		m_accumulator -= dropped;
+		m_frameTime -= dropped;
+		m_droppedTime += dropped;
+	}
+
+	m_numTicks += numTicks;
+	return numTicks;
+}
+
+const float FixedTimestep::GetInterpolationAlpha() const { return min(max(m_accumulator / m_tickDuration, 0.0f), 1.0f); }
+
+const float FixedTimestep::GetFrameTime() const { return m_frameTime; }
+
+const uint64_t FixedTimestep::GetNumTicks() const { return m_numTicks; }
+
+const double FixedTimestep::GetDroppedTime() const { return m_droppedTime; }
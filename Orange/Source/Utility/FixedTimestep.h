@@ -0,0 +1,58 @@
+#ifndef _FIXEDTIMESTEP_H
+#define _FIXEDTIMESTEP_H
+
+#include <cstdint>
+
+// Turns frames of any length into a whole number of simulation ticks, all of the same length. The time a frame leaves
+// over carries on to the next one, and how far it is into the next tick is what rendering blends the last two ticks by.
+// It's only ever handed time and never reads a clock, so a simulation can be run faster than real time by handing it
+// whatever it likes (see the "simcheck" headless mode)
+class FixedTimestep
+{
+public:
+
+	static constexpr float DEFAULT_TICK_RATE = 60.0f;
+
+	// A frame that would take more ticks than this only gets this many, and the rest of its time is dropped. Otherwise
+	// a long hitch (like dragging the window around) makes the next frames take longer to simulate, and so on
+	static constexpr uint32_t DEFAULT_MAX_TICKS_PER_FRAME = 8;
+
+	FixedTimestep(const float tickRate = DEFAULT_TICK_RATE, const uint32_t maxTicksPerFrame = DEFAULT_MAX_TICKS_PER_FRAME);
+
+	// In ticks per second. The time that's already been handed over is kept, in seconds
+	void SetTickRate(const float tickRate);
+	const float GetTickRate() const;
+
+	void SetMaxTicksPerFrame(const uint32_t maxTicksPerFrame);
+	const uint32_t GetMaxTicksPerFrame() const;
+
+	// What every tick has to be simulated with, in seconds
+	const float GetTickDuration() const;
+
+	// Hands over a frame's time, in seconds, and returns how many ticks to simulate for it
+	uint32_t Advance(const float frameTime);
+
+	// How far the time left over is into the next tick, from 0 to 1
+	const float GetInterpolationAlpha() const;
+
+	// The last frame's time, less whatever was dropped. Anything that isn't simulated in ticks should move by this
+	const float GetFrameTime() const;
+
+	// Ticks and time dropped (in seconds) since the timestep was created
+	const uint64_t GetNumTicks() const;
+	const double GetDroppedTime() const;
+
+private:
+
+	float m_tickRate;
+	float m_tickDuration;
+	uint32_t m_maxTicksPerFrame;
+
+	float m_accumulator = 0.0f;
+	float m_frameTime = 0.0f;
+
+	uint64_t m_numTicks = 0;
+	double m_droppedTime = 0.0;
+};
+
+#endif
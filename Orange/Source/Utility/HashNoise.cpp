@@ -0,0 +1,169 @@
+#include "../Misc/pch.h"
+
+#include "HashNoise.h"
+
+// Large odd constants to spread the lattice coordinates over all 32 bits before they're mixed
+constexpr uint32_t HASH_PRIME_X = 0x8DA6B343u;
+constexpr uint32_t HASH_PRIME_Y = 0xD8163841u;
+constexpr uint32_t HASH_PRIME_Z = 0xCB1AB31Fu;
+
+// Keeps the origin of seed 0 from hashing to 0
+constexpr uint32_t HASH_OFFSET = 0x27D4EB2Fu;
+
+// Added to the seed for every octave of fractal noise (the golden ratio, like splitmix)
+constexpr uint32_t OCTAVE_SEED_STEP = 0x9E3779B9u;
+
+// Gradient noise spends more time close to 0 than simplex noise does. These scale it up to the same spread (RMS)
+// as SimplexNoise, so the thresholds the world generation was tuned with work for both. The few values that end
+// up outside of [-1, 1] are clamped
+constexpr float NOISE_2D_SCALE = 1.14f;
+constexpr float NOISE_3D_SCALE = 1.58f;
+
+// lowbias32 finalizer by Chris Wellons, every input bit affects every output bit
+static inline uint32_t Mix(uint32_t hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x7FEB352Du;
+	hash ^= hash >> 15;
+	hash *= 0x846CA68Bu;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+// Truncating is faster than floorf(), and exact for every value the noise is sampled at
+static inline int32_t FastFloor(const float value)
+{
+	const int32_t truncated = static_cast<int32_t>(value);
+	return (value < static_cast<float>(truncated)) ? truncated - 1 : truncated;
+}
+
+static inline float Fade(const float t)
+{
+	return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline float ClampUnit(const float value)
+{
+	return (value < -1.0f) ? -1.0f : ((value > 1.0f) ? 1.0f : value);
+}
+
+static inline float Lerp(const float a, const float b, const float t)
+{
+	return a + (b - a) * t;
+}
+
+// One of 8 gradients, (+-1, +-2) and (+-2, +-1). Written with selects rather than a table so it vectorises
+static inline float Gradient(const uint32_t hash, const float x, const float y)
+{
+	const uint32_t h = hash >> 29;
+	const float u = (h < 4) ? x : y;
+	const float v = (h < 4) ? y : x;
+	return ((h & 1) ? -u : u) + ((h & 2) ? -2.0f * v : 2.0f * v);
+}
+
+// One of the 12 edges of a cube (Perlin's improved noise), 4 of them twice to get to 16
+static inline float Gradient(const uint32_t hash, const float x, const float y, const float z)
+{
+	const uint32_t h = hash >> 28;
+	const float u = (h < 8) ? x : y;
+	const float v = (h < 4) ? y : ((h == 12 || h == 14) ? x : z);
+	return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+uint32_t HashNoise::Hash(const uint32_t seed, const int32_t x, const int32_t y)
+{
+	return Mix((seed ^ (static_cast<uint32_t>(x) * HASH_PRIME_X) ^ (static_cast<uint32_t>(y) * HASH_PRIME_Y)) + HASH_OFFSET);
+}
+
+uint32_t HashNoise::Hash(const uint32_t seed, const int32_t x, const int32_t y, const int32_t z)
+{
+	return Mix((seed ^ (static_cast<uint32_t>(x) * HASH_PRIME_X) ^ (static_cast<uint32_t>(y) * HASH_PRIME_Y) ^ (static_cast<uint32_t>(z) * HASH_PRIME_Z)) + HASH_OFFSET);
+}
+
+float HashNoise::Noise(const uint32_t seed, const float x, const float y)
+{
+	const int32_t x0 = FastFloor(x);
+	const int32_t y0 = FastFloor(y);
+	const float fx = x - static_cast<float>(x0);
+	const float fy = y - static_cast<float>(y0);
+
+	const float n00 = Gradient(Hash(seed, x0, y0), fx, fy);
+	const float n10 = Gradient(Hash(seed, x0 + 1, y0), fx - 1.0f, fy);
+	const float n01 = Gradient(Hash(seed, x0, y0 + 1), fx, fy - 1.0f);
+	const float n11 = Gradient(Hash(seed, x0 + 1, y0 + 1), fx - 1.0f, fy - 1.0f);
+
+	const float u = Fade(fx);
+	return ClampUnit(Lerp(Lerp(n00, n10, u), Lerp(n01, n11, u), Fade(fy)) * NOISE_2D_SCALE);
+}
+
+float HashNoise::Noise(const uint32_t seed, const float x, const float y, const float z)
+{
+	const int32_t x0 = FastFloor(x);
+	const int32_t y0 = FastFloor(y);
+	const int32_t z0 = FastFloor(z);
+	const float fx = x - static_cast<float>(x0);
+	const float fy = y - static_cast<float>(y0);
+	const float fz = z - static_cast<float>(z0);
+
+	const float n000 = Gradient(Hash(seed, x0, y0, z0), fx, fy, fz);
+	const float n100 = Gradient(Hash(seed, x0 + 1, y0, z0), fx - 1.0f, fy, fz);
+	const float n010 = Gradient(Hash(seed, x0, y0 + 1, z0), fx, fy - 1.0f, fz);
+	const float n110 = Gradient(Hash(seed, x0 + 1, y0 + 1, z0), fx - 1.0f, fy - 1.0f, fz);
+	const float n001 = Gradient(Hash(seed, x0, y0, z0 + 1), fx, fy, fz - 1.0f);
+	const float n101 = Gradient(Hash(seed, x0 + 1, y0, z0 + 1), fx - 1.0f, fy, fz - 1.0f);
+	const float n011 = Gradient(Hash(seed, x0, y0 + 1, z0 + 1), fx, fy - 1.0f, fz - 1.0f);
+	const float n111 = Gradient(Hash(seed, x0 + 1, y0 + 1, z0 + 1), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+
+	const float u = Fade(fx);
+	const float v = Fade(fy);
+	const float front = Lerp(Lerp(n000, n100, u), Lerp(n010, n110, u), v);
+	const float back = Lerp(Lerp(n001, n101, u), Lerp(n011, n111, u), v);
+	return ClampUnit(Lerp(front, back, Fade(fz)) * NOISE_3D_SCALE);
+}
+
+HashNoise::HashNoise(const float frequency, const float amplitude, const float lacunarity, const float persistence) :
+	m_frequency(frequency), m_amplitude(amplitude), m_lacunarity(lacunarity), m_persistence(persistence)
+{
+}
+
+float HashNoise::Fractal(const uint32_t seed, const uint32_t octaves, const float x, const float y) const
+{
+	float output = 0.0f;
+	float denominator = 0.0f;
+	float frequency = m_frequency;
+	float amplitude = m_amplitude;
+	uint32_t octaveSeed = seed;
+
+	for (uint32_t i = 0; i < octaves; i++)
+	{
+		output += amplitude * Noise(octaveSeed, x * frequency, y * frequency);
+		denominator += amplitude;
+
+		frequency *= m_lacunarity;
+		amplitude *= m_persistence;
+		octaveSeed += OCTAVE_SEED_STEP;
+	}
+
+	return output / denominator;
+}
+
+float HashNoise::Fractal(const uint32_t seed, const uint32_t octaves, const float x, const float y, const float z) const
+{
+	float output = 0.0f;
+	float denominator = 0.0f;
+	float frequency = m_frequency;
+	float amplitude = m_amplitude;
+	uint32_t octaveSeed = seed;
+
+	for (uint32_t i = 0; i < octaves; i++)
+	{
+		output += amplitude * Noise(octaveSeed, x * frequency, y * frequency, z * frequency);
+		denominator += amplitude;
+
+		frequency *= m_lacunarity;
+		amplitude *= m_persistence;
+		octaveSeed += OCTAVE_SEED_STEP;
+	}
+
+	return output / denominator;
+}
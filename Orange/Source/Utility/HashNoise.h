@@ -0,0 +1,43 @@
+#ifndef _HASHNOISE_H
+#define _HASHNOISE_H
+
+#include <cstdint>
+
+// Gradient (Perlin) noise that picks the gradient of every lattice point by hashing its coordinates together
+// with a seed, instead of looking it up in a permutation table like SimplexNoise does. Every seed gives
+// unrelated noise, there's no state shared between calls, and there are no table lookups, so a loop over
+// samples can be vectorised without gathers.
+//
+// Only integer math and float adds, multiplies and compares are used, so the same seed gives the same values
+// on every thread and platform, as long as the compiler doesn't fuse multiplies and adds (off by default on
+// MSVC, -ffp-contract=off on GCC and Clang)
+class HashNoise
+{
+public:
+
+	// Returns 32 well mixed bits for the lattice point
+	static uint32_t Hash(const uint32_t seed, const int32_t x, const int32_t y);
+	static uint32_t Hash(const uint32_t seed, const int32_t x, const int32_t y, const int32_t z);
+
+	// In [-1, 1] with about the same spread as SimplexNoise, and 0 on every integer coordinate
+	static float Noise(const uint32_t seed, const float x, const float y);
+	static float Noise(const uint32_t seed, const float x, const float y, const float z);
+
+	// Same parameters as SimplexNoise's fractal noise
+	explicit HashNoise(const float frequency = 1.0f, const float amplitude = 1.0f, const float lacunarity = 2.0f, const float persistence = 0.5f);
+
+	// Sum of "octaves" layers of noise, normalized to the same range as a single layer. Every octave is
+	// seeded differently, otherwise the lattice points of all octaves would line up at the origin
+	float Fractal(const uint32_t seed, const uint32_t octaves, const float x, const float y) const;
+	float Fractal(const uint32_t seed, const uint32_t octaves, const float x, const float y, const float z) const;
+
+private:
+
+	float m_frequency;
+	float m_amplitude;
+	float m_lacunarity;
+	float m_persistence;
+
+};
+
+#endif
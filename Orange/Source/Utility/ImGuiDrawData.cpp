@@ -1,5 +1,6 @@
 #include "../Misc/pch.h"
 #include "ImGuiDrawData.h"
+#include "FixedTimestep.h"
 
 //
 //	CYCLE_DATA
@@ -22,7 +23,11 @@ const char* Cycle_Data::time = "";
 //
 int BlockShader_Data::debugVerts = 0;
 int BlockShader_Data::numDrawCalls = 0;
-bool BlockShader_Data::enableFrustumCulling = false;
+int BlockShader_Data::numVisibleChunks = 0;
+int BlockShader_Data::numOccludedChunks = 0;
+bool BlockShader_Data::enableFrustumCulling = true;
+bool BlockShader_Data::enableConnectivityCulling = true;
+bool BlockShader_Data::enableOcclusionCulling = true;
 
 //
 //	RENDERER_DATA
@@ -54,6 +59,27 @@ float ChunkManager_Data::deletionLoop = 0.0f;
 float ChunkManager_Data::creationLoop = 0.0f;
 float ChunkManager_Data::deletingChunks = 0.0f;
 float ChunkManager_Data::creatingChunks = 0.0f;
+float ChunkManager_Data::enforcingMemoryBudget = 0.0f;
+
+//
+// CHUNKRESIDENCY_DATA
+//
+float ChunkResidency_Data::memoryBudgetMB = 0.0f;
+float ChunkResidency_Data::usedMemoryMB = 0.0f;
+float ChunkResidency_Data::compressedMemoryMB = 0.0f;
+uint32_t ChunkResidency_Data::numDemotedChunks = 0;
+uint32_t ChunkResidency_Data::numCompressedChunks = 0;
+uint32_t ChunkResidency_Data::numChunksOnDisk = 0;
+float ChunkResidency_Data::diskUsageMB = 0.0f;
+
+
+//
+// SIMULATION_DATA
+//
+float Simulation_Data::tickRate = FixedTimestep::DEFAULT_TICK_RATE;
+uint32_t Simulation_Data::maxTicksPerFrame = FixedTimestep::DEFAULT_MAX_TICKS_PER_FRAME;
+uint32_t Simulation_Data::numTicks = 0;
+float Simulation_Data::interpolationAlpha = 0.0f;
 
 
 //
@@ -31,7 +31,11 @@ struct BlockShader_Data
 
 	static int debugVerts;
 	static int numDrawCalls;
+	static int numVisibleChunks;
+	static int numOccludedChunks;
 	static bool enableFrustumCulling;
+	static bool enableConnectivityCulling;
+	static bool enableOcclusionCulling;
 
 };
 
@@ -66,6 +70,26 @@ struct ChunkManager_Data
 	static float creationLoop;
 	static float deletingChunks;
 	static float creatingChunks;
+	static float enforcingMemoryBudget;
+};
+
+struct ChunkResidency_Data
+{
+	static float memoryBudgetMB;
+	static float usedMemoryMB;
+	static float compressedMemoryMB;
+	static uint32_t numDemotedChunks;
+	static uint32_t numCompressedChunks;
+	static uint32_t numChunksOnDisk;
+	static float diskUsageMB;
+};
+
+struct Simulation_Data
+{
+	static float tickRate;
+	static uint32_t maxTicksPerFrame;
+	static uint32_t numTicks;
+	static float interpolationAlpha;
 };
 
 struct GraphicsTimer_Data
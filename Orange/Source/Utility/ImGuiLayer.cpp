@@ -140,6 +140,16 @@ void ImGuiLayer::Draw()
 //
 //#pragma endregion
 //
+//#pragma region SIMULATION_DATA
+//
+//	ImGui::Begin("Debug Panel");
+//	ImGui::SliderFloat("Tick Rate", &Simulation_Data::tickRate, 10.0f, 240.0f);
+//	ImGui::Text("Ticks This Frame: %u (max %u)", Simulation_Data::numTicks, Simulation_Data::maxTicksPerFrame);
+//	ImGui::Text("Interpolation Alpha: %2.2f", Simulation_Data::interpolationAlpha);
+//	ImGui::End();
+//
+//#pragma endregion
+//
 //#pragma region GRAPHICSTIMER_DATA
 //
 //	ImGui::Begin("Timing Panel");
@@ -0,0 +1,99 @@
+#ifndef _SIMDBATCH_H
+#define _SIMDBATCH_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Every x64 CPU has SSE2. MSVC doesn't define __SSE2__ for x64 builds, but it does define __AVX__ with /arch:AVX
+#if defined(__AVX__)
+#define OG_SIMD_BATCH_SIZE 8
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OG_SIMD_BATCH_SIZE 4
+#include <emmintrin.h>
+#else
+#define OG_SIMD_BATCH_SIZE 1
+#endif
+
+namespace Orange
+{
+	// The same handful of float operations for every batch size, so that code working on
+	// OG_SIMD_BATCH_SIZE floats at a time is written once for AVX, SSE and plain floats
+	namespace Simd
+	{
+		constexpr uint32_t BATCH_SIZE = OG_SIMD_BATCH_SIZE;
+
+#if OG_SIMD_BATCH_SIZE == 8
+
+		using FloatBatch = __m256;
+		using MaskBatch = __m256;
+
+		inline FloatBatch LoadBatch(const float* values) { return _mm256_loadu_ps(values); }
+		inline void StoreBatch(float* outValues, const FloatBatch a) { _mm256_storeu_ps(outValues, a); }
+		inline FloatBatch Broadcast(const float value) { return _mm256_set1_ps(value); }
+		inline FloatBatch Add(const FloatBatch a, const FloatBatch b) { return _mm256_add_ps(a, b); }
+		inline FloatBatch Multiply(const FloatBatch a, const FloatBatch b) { return _mm256_mul_ps(a, b); }
+		inline FloatBatch MultiplyAdd(const FloatBatch a, const FloatBatch b, const FloatBatch c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+		inline FloatBatch Max(const FloatBatch a, const FloatBatch b) { return _mm256_max_ps(a, b); }
+		inline MaskBatch GreaterEqual(const FloatBatch a, const FloatBatch b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+		inline MaskBatch Less(const FloatBatch a, const FloatBatch b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		inline MaskBatch And(const MaskBatch a, const MaskBatch b) { return _mm256_and_ps(a, b); }
+		inline FloatBatch Select(const MaskBatch mask, const FloatBatch a, const FloatBatch b) { return _mm256_blendv_ps(b, a, mask); }
+		inline uint32_t GetLaneMask(const MaskBatch mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+
+#elif OG_SIMD_BATCH_SIZE == 4
+
+		using FloatBatch = __m128;
+		using MaskBatch = __m128;
+
+		inline FloatBatch LoadBatch(const float* values) { return _mm_loadu_ps(values); }
+		inline void StoreBatch(float* outValues, const FloatBatch a) { _mm_storeu_ps(outValues, a); }
+		inline FloatBatch Broadcast(const float value) { return _mm_set1_ps(value); }
+		inline FloatBatch Add(const FloatBatch a, const FloatBatch b) { return _mm_add_ps(a, b); }
+		inline FloatBatch Multiply(const FloatBatch a, const FloatBatch b) { return _mm_mul_ps(a, b); }
+		inline FloatBatch MultiplyAdd(const FloatBatch a, const FloatBatch b, const FloatBatch c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+		inline FloatBatch Max(const FloatBatch a, const FloatBatch b) { return _mm_max_ps(a, b); }
+		inline MaskBatch GreaterEqual(const FloatBatch a, const FloatBatch b) { return _mm_cmpge_ps(a, b); }
+		inline MaskBatch Less(const FloatBatch a, const FloatBatch b) { return _mm_cmplt_ps(a, b); }
+		inline MaskBatch And(const MaskBatch a, const MaskBatch b) { return _mm_and_ps(a, b); }
+		inline FloatBatch Select(const MaskBatch mask, const FloatBatch a, const FloatBatch b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+		inline uint32_t GetLaneMask(const MaskBatch mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+
+#else
+
+		using FloatBatch = float;
+		using MaskBatch = bool;
+
+		inline FloatBatch LoadBatch(const float* values) { return *values; }
+		inline void StoreBatch(float* outValues, const FloatBatch a) { *outValues = a; }
+		inline FloatBatch Broadcast(const float value) { return value; }
+		inline FloatBatch Add(const FloatBatch a, const FloatBatch b) { return a + b; }
+		inline FloatBatch Multiply(const FloatBatch a, const FloatBatch b) { return a * b; }
+		inline FloatBatch MultiplyAdd(const FloatBatch a, const FloatBatch b, const FloatBatch c) { return a * b + c; }
+		inline FloatBatch Max(const FloatBatch a, const FloatBatch b) { return a > b ? a : b; }
+		inline MaskBatch GreaterEqual(const FloatBatch a, const FloatBatch b) { return a >= b; }
+		inline MaskBatch Less(const FloatBatch a, const FloatBatch b) { return a < b; }
+		inline MaskBatch And(const MaskBatch a, const MaskBatch b) { return a && b; }
+		inline FloatBatch Select(const MaskBatch mask, const FloatBatch a, const FloatBatch b) { return mask ? a : b; }
+		inline uint32_t GetLaneMask(const MaskBatch mask) { return mask ? 1 : 0; }
+
+#endif
+
+		// Index of the lowest set bit, "value" must not be 0
+		inline uint32_t CountTrailingZeros(const uint32_t value)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return static_cast<uint32_t>(index);
+#else
+			return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+		}
+	}
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef _SORTEDPOOL_H
 #define _SORTEDPOOL_H
 
+#include <vector>
+
 #include "../Utility/HeapOverrides.h"
 #include "Utility.h"
 
@@ -39,6 +41,7 @@ namespace Orange
 			if (m_ownsPool)
 			{
 				if (m_pool) delete[] m_pool;
+				ReleaseRetiredPools();
 			}
 			m_size = 0;
 			m_capacity = 0;
@@ -74,14 +77,15 @@ namespace Orange
 			return &m_pool[m_size - 1];
 		}
 
-		// Returns a ptr to the new T object that replaced "index"
+		// Returns a ptr to the new T object that replaced "index". The removed object is moved out and destroyed,
+		// and the last object is moved into its slot, so the slot left behind past Size() only holds a moved-from T
 		T* Remove(const uint32_t& index)
 		{
 			if (index >= m_size || m_size <= 0) return nullptr;
 
-			T temp = m_pool[index];
-			m_pool[index] = m_pool[m_size - 1];
-			m_pool[m_size - 1] = temp;
+			T removed;
+			removed = std::move(m_pool[index]);
+			if (index != m_size - 1) m_pool[index] = std::move(m_pool[m_size - 1]);
 
 			m_size--;
 
@@ -89,6 +93,39 @@ namespace Orange
 
 		}
 
+		// Reallocates the pool with a new capacity, moving the current objects over. The new
+		// capacity can't be smaller than the number of objects in the pool. Pointers to objects
+		// in the pool are stale afterwards but stay readable, since the old pool is only retired,
+		// until ReleaseRetiredPools() is called. Indices stay valid
+		void Resize(const uint32_t& newCapacity)
+		{
+			OG_ASSERT_MSG(m_ownsPool, "Only the owner of the pool can resize it");
+			OG_ASSERT_MSG(newCapacity >= m_size, "Resizing the pool would discard objects");
+
+			if (newCapacity == m_capacity) return;
+
+			T* newPool = OG_NEW T[newCapacity];
+			for (uint32_t i = 0; i < m_size; i++)
+			{
+				newPool[i] = std::move(m_pool[i]);
+			}
+
+			m_retiredPools.push_back(m_pool);
+			m_pool = newPool;
+			m_capacity = newCapacity;
+		}
+
+		// Frees every pool that was retired by Resize(). Nothing may still point into them
+		void ReleaseRetiredPools()
+		{
+			OG_ASSERT_MSG(m_ownsPool, "Only the owner of the pool can release the retired pools");
+
+			for (T* retiredPool : m_retiredPools) delete[] retiredPool;
+			m_retiredPools.clear();
+		}
+
+		const bool HasRetiredPools() { return !m_retiredPools.empty(); }
+
 		void Clear()
 		{
 			memset(&m_pool[0], 0, sizeof(T) * m_capacity);
@@ -126,6 +163,9 @@ namespace Orange
 
 		bool m_ownsPool = true;
 
+		// Pools that were replaced by Resize(), but may still be read through stale pointers
+		std::vector<T*> m_retiredPools;
+
 	};
 }
 
@@ -0,0 +1,193 @@
+#ifndef _VOXELRAYCAST_H
+#define _VOXELRAYCAST_H
+
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "../Core/ChunkCoord.h"
+
+namespace Orange
+{
+	namespace Math
+	{
+		// A ray in WORLD SPACE. The direction doesn't have to be normalized, distances are measured in world units either way
+		struct Ray
+		{
+			DirectX::XMFLOAT3 origin;
+			DirectX::XMFLOAT3 direction;
+			float maxDistance;
+		};
+
+		struct RaycastHit
+		{
+			// The block that was hit, in BLOCK SPACE
+			BlockCoord blockPosBS;
+
+			// Points out of the face the ray went in through, so "blockPosBS + normal" is the block in front of it. It's
+			// all zeroes if the ray started inside the block
+			BlockCoord normal;
+
+			// Where the ray went into the block, and how far along the ray that is
+			DirectX::XMFLOAT3 posWS;
+			float distance;
+		};
+
+		// Walks the blocks along the ray in order (Amanatides & Woo), without allocating anything. "query" decides what's hit:
+		//
+		//		bool IsChunkEmpty(const ChunkCoord& chunkPosCS)		Called whenever the ray goes into a chunk. If it returns
+		//															true, the ray goes straight through to the next chunk
+		//		bool IsHit(const BlockCoord& blockPosBS)			Called for every block the ray goes through in the other chunks
+		//
+		// IsHit() is only ever called for blocks of the chunk IsChunkEmpty() was last called for, so the query can hold on to
+		// that chunk instead of looking it up for every block. Returns false if nothing was hit within the ray's max distance
+		template<int32_t Size = CHUNK_SIZE, typename Query>
+		inline bool Raycast(const Ray& ray, Query& query, RaycastHit& outHit)
+		{
+			using Traits = ChunkTraits<Size>;
+			constexpr float infinity = std::numeric_limits<float>::infinity();
+
+			const float length = sqrtf(ray.direction.x * ray.direction.x + ray.direction.y * ray.direction.y + ray.direction.z * ray.direction.z);
+			if (length == 0.0f) return false;
+
+			const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+			const float direction[3] = { ray.direction.x / length, ray.direction.y / length, ray.direction.z / length };
+
+			int32_t block[3] = { static_cast<int32_t>(floorf(origin[0])), static_cast<int32_t>(floorf(origin[1])), static_cast<int32_t>(floorf(origin[2])) };
+			int32_t step[3];
+
+			// Distance along the ray to the next block boundary on every axis, and between two boundaries
+			float nextBoundary[3];
+			float boundaryDistance[3];
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				step[i] = direction[i] > 0.0f ? 1 : (direction[i] < 0.0f ? -1 : 0);
+				boundaryDistance[i] = step[i] != 0 ? 1.0f / fabsf(direction[i]) : infinity;
+				if (step[i] > 0)		nextBoundary[i] = (static_cast<float>(block[i] + 1) - origin[i]) * boundaryDistance[i];
+				else if (step[i] < 0)	nextBoundary[i] = (origin[i] - static_cast<float>(block[i])) * boundaryDistance[i];
+				else					nextBoundary[i] = infinity;
+			}
+
+			float distance = 0.0f;
+			int32_t enteredAxis = -1;
+
+			ChunkCoord chunkPosCS = BlockToChunkCoord<Size>(BlockCoord(block[0], block[1], block[2]));
+			bool isChunkEmpty = query.IsChunkEmpty(chunkPosCS);
+
+			while (true)
+			{
+				if (isChunkEmpty)
+				{
+					// Straight to the first block past the chunk's boundary. The axis whose boundary is closest is the one the
+					// ray leaves through, the others are wherever the ray is at that point (kept inside the chunk, in case
+					// rounding put them just past a boundary the ray leaves through at the same time)
+					const int32_t chunkPos[3] = { chunkPosCS.x, chunkPosCS.y, chunkPosCS.z };
+					float exitDistance = infinity;
+					int32_t exitAxis = -1;
+					for (uint32_t i = 0; i < 3; i++)
+					{
+						if (step[i] == 0) continue;
+
+						const int32_t boundary = step[i] > 0 ? (chunkPos[i] + 1) * Size : chunkPos[i] * Size;
+						const float boundaryDist = (static_cast<float>(boundary) - origin[i]) * step[i] * boundaryDistance[i];
+						if (boundaryDist < exitDistance)
+						{
+							exitDistance = boundaryDist;
+							exitAxis = static_cast<int32_t>(i);
+						}
+					}
+
+					if (exitAxis < 0 || exitDistance > ray.maxDistance) return false;
+
+					for (uint32_t i = 0; i < 3; i++)
+					{
+						const int32_t minBlock = chunkPos[i] * Size;
+						if (static_cast<int32_t>(i) == exitAxis) block[i] = step[i] > 0 ? minBlock + Size : minBlock - 1;
+						else
+						{
+							block[i] = static_cast<int32_t>(floorf(origin[i] + direction[i] * exitDistance));
+							block[i] = max(min(block[i], minBlock + Traits::MASK), minBlock);
+						}
+
+						if (step[i] > 0)		nextBoundary[i] = (static_cast<float>(block[i] + 1) - origin[i]) * boundaryDistance[i];
+						else if (step[i] < 0)	nextBoundary[i] = (origin[i] - static_cast<float>(block[i])) * boundaryDistance[i];
+					}
+
+					distance = max(exitDistance, distance);
+					enteredAxis = exitAxis;
+				}
+				else if (query.IsHit(BlockCoord(block[0], block[1], block[2])))
+				{
+					outHit.blockPosBS = BlockCoord(block[0], block[1], block[2]);
+					int32_t normal[3] = { 0, 0, 0 };
+					if (enteredAxis >= 0) normal[enteredAxis] = -step[enteredAxis];
+					outHit.normal = BlockCoord(normal[0], normal[1], normal[2]);
+					outHit.posWS = { origin[0] + direction[0] * distance, origin[1] + direction[1] * distance, origin[2] + direction[2] * distance };
+					outHit.distance = distance;
+					return true;
+				}
+				else
+				{
+					// Into the next block along whichever axis has the closest boundary
+					const int32_t axis = nextBoundary[0] < nextBoundary[1] ?
+						(nextBoundary[0] < nextBoundary[2] ? 0 : 2) :
+						(nextBoundary[1] < nextBoundary[2] ? 1 : 2);
+
+					distance = nextBoundary[axis];
+					if (distance > ray.maxDistance) return false;
+
+					block[axis] += step[axis];
+					nextBoundary[axis] += boundaryDistance[axis];
+					enteredAxis = axis;
+
+					// Only the axis that was stepped along can have moved the ray into another chunk
+					const int32_t chunkPos[3] = { chunkPosCS.x, chunkPosCS.y, chunkPosCS.z };
+					if ((block[axis] >> Traits::SHIFT) == chunkPos[axis]) continue;
+				}
+
+				chunkPosCS = BlockToChunkCoord<Size>(BlockCoord(block[0], block[1], block[2]));
+				isChunkEmpty = query.IsChunkEmpty(chunkPosCS);
+			}
+		}
+
+		// Casts "numRays" rays on up to "numThreads" threads (all of the hardware's if it's 0), each with its own copy of
+		// "query", so the query has to be safe to copy and to call from any thread. "outIsHit" and "outHits" must hold
+		// "numRays" elements, a hit is only written for the rays that hit something
+		template<int32_t Size = CHUNK_SIZE, typename Query>
+		inline void RaycastBatch(const Ray* rays, const uint32_t numRays, const Query& query, bool* outIsHit, RaycastHit* outHits, uint32_t numThreads = 0)
+		{
+			// Threads aren't worth starting for less than this many rays each
+			constexpr uint32_t minRaysPerThread = 64;
+
+			if (numThreads == 0) numThreads = max(std::thread::hardware_concurrency(), 1u);
+			numThreads = min(numThreads, max((numRays + minRaysPerThread - 1) / minRaysPerThread, 1u));
+
+			auto castRange = [&](const uint32_t start, const uint32_t end)
+			{
+				Query threadQuery = query;
+				for (uint32_t i = start; i < end; i++) outIsHit[i] = Raycast<Size>(rays[i], threadQuery, outHits[i]);
+			};
+
+			if (numThreads <= 1)
+			{
+				castRange(0, numRays);
+				return;
+			}
+
+			// The calling thread takes the last range
+			std::vector<std::thread> threads;
+			threads.reserve(numThreads - 1);
+			const uint32_t raysPerThread = (numRays + numThreads - 1) / numThreads;
+			for (uint32_t i = 0; i < numThreads - 1; i++)
+			{
+				threads.emplace_back(castRange, min(i * raysPerThread, numRays), min((i + 1) * raysPerThread, numRays));
+			}
+			castRange(min((numThreads - 1) * raysPerThread, numRays), numRays);
+
+			for (auto& thread : threads) thread.join();
+		}
+	}
+}
+
+#endif
@@ -83,6 +83,88 @@ project "Orange"
 		defines "OG_RELEASE"
 		optimize "On"
 
+	filter "configurations:Distribution"
+		defines "OG_DISTRIBUTION"
+		optimize "On"
+
+-- GPU-free command-line tools that only need the world generation code (see Headless/main.cpp) --
+project "OrangeHeadless"
+	location "Generated"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	warnings "Extra"
+
+	targetdir ("Generated/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("Generated/bin/intermediate/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"./Headless/**.h",
+		"./Headless/**.cpp",
+		"./Source/Core/WorldGen/**.h",
+		"./Source/Core/WorldGen/**.cpp",
+		"./Source/Core/Block.h",
+		"./Source/Core/Block.cpp",
+		"./Source/Core/BlockRegistry.h",
+		"./Source/Core/BlockRegistry.cpp",
+		"./Source/Core/BlockUVs.h",
+		"./Source/Core/Chunk.h",
+		"./Source/Core/ChunkConnectivity.h",
+		"./Source/Core/ChunkConnectivity.cpp",
+		"./Source/Core/ChunkCoord.h",
+		"./Source/Core/ChunkCuller.h",
+		"./Source/Core/ChunkCuller.cpp",
+		"./Source/Core/ChunkDrawList.h",
+		"./Source/Core/ChunkDrawList.cpp",
+		"./Source/Core/ChunkLayout.h",
+		"./Source/Core/ChunkMesher.h",
+		"./Source/Core/ChunkMesher.cpp",
+		"./Source/Core/ChunkSerializer.h",
+		"./Source/Core/ChunkSerializer.cpp",
+		"./Source/Core/LightEngine.h",
+		"./Source/Core/LightEngine.cpp",
+		"./Source/Core/OcclusionCuller.h",
+		"./Source/Core/OcclusionCuller.cpp",
+		"./Source/Core/Physics.h",
+		"./Source/Core/ShadowCascades.h",
+		"./Source/Core/ShadowCascades.cpp",
+		"./Source/Misc/pch.h",
+		"./Source/Utility/Clock.h",
+		"./Source/Utility/Clock.cpp",
+		"./Source/Utility/FixedTimestep.h",
+		"./Source/Utility/FixedTimestep.cpp",
+		"./Source/Utility/HashNoise.h",
+		"./Source/Utility/HashNoise.cpp",
+		"./Source/Utility/Log.h",
+		"./Source/Utility/Log.cpp",
+		"./Source/Utility/ScopeTimer.h",
+		"./Source/Utility/ScopeTimer.cpp",
+		"./Source/Utility/SimdBatch.h",
+		"./Source/Utility/SimplexNoise.h",
+		"./Source/Utility/SimplexNoise.cpp",
+		"./Source/Utility/VoxelRaycast.h"
+	}
+
+	-- System filters --
+	filter "system:Windows"
+		systemversion "latest"
+
+		defines
+		{
+			"OG_WINDOWS",
+			"_SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING"
+		}
+
+	-- Configuration filters --
+	filter "configurations:Debug"
+		defines "OG_DEBUG"
+		symbols "On"
+		
+	filter "configurations:Release"
+		defines "OG_RELEASE"
+		optimize "On"
+
 	filter "configurations:Distribution"
 		defines "OG_DISTRIBUTION"
 		optimize "On"
\ No newline at end of file